@@ -1,6 +1,7 @@
 package com.prio.app.feature.briefing
 
 import com.prio.core.ai.model.AiContext
+import com.prio.core.ai.model.AiQos
 import com.prio.core.ai.model.AiRequest
 import com.prio.core.ai.model.AiRequestOptions
 import com.prio.core.ai.model.AiRequestType
@@ -80,9 +81,13 @@ class BriefingGenerator @Inject constructor(
      * - Generates in <3 seconds (spec timing target)
      *
      * @param userName User's display name for greeting
+     * @param qos [AiQos.BACKGROUND] when prefetched from a worker rather than opened by the user
      * @return Complete morning briefing data
      */
-    suspend fun generateMorningBriefing(userName: String? = null): MorningBriefingData =
+    suspend fun generateMorningBriefing(
+        userName: String? = null,
+        qos: AiQos = AiQos.INTERACTIVE
+    ): MorningBriefingData =
         withContext(Dispatchers.IO) {
             val startTime = System.currentTimeMillis()
 
@@ -175,7 +180,8 @@ class BriefingGenerator @Inject constructor(
                 topGoalTitle = goalSpotlight?.title,
                 topGoalProgress = goalSpotlight?.progress,
                 dayOfWeek = dayOfWeek,
-                yesterdayCompleted = yesterdayCompleted
+                yesterdayCompleted = yesterdayCompleted,
+                qos = qos
             )
 
             // Greeting based on time of day per 1.1.5 spec
@@ -213,9 +219,10 @@ class BriefingGenerator @Inject constructor(
      * Per 1.1.7 spec:
      * - Accomplishments, Not Done (with move-to-tomorrow), Goal Progress, Tomorrow Preview, AI Reflection
      *
+     * @param qos [AiQos.BACKGROUND] when prefetched from a worker rather than opened by the user
      * @return Complete evening summary data
      */
-    suspend fun generateEveningSummary(): EveningSummaryData =
+    suspend fun generateEveningSummary(qos: AiQos = AiQos.INTERACTIVE): EveningSummaryData =
         withContext(Dispatchers.IO) {
             val startTime = System.currentTimeMillis()
 
@@ -306,7 +313,8 @@ class BriefingGenerator @Inject constructor(
                 goalProgressDelta = null, // TODO: Track intra-day delta
                 spotlightGoalTitle = goalSpotlight?.title,
                 meetingCount = todayMeetings.size,
-                dayOfWeek = dayOfWeek
+                dayOfWeek = dayOfWeek,
+                qos = qos
             )
 
             val elapsed = System.currentTimeMillis() - startTime
@@ -437,7 +445,8 @@ class BriefingGenerator @Inject constructor(
         topGoalTitle: String?,
         topGoalProgress: Int?,
         dayOfWeek: String,
-        yesterdayCompleted: Int
+        yesterdayCompleted: Int,
+        qos: AiQos
     ): String {
         // Rule-based is always the fallback (and fast <50ms)
         val ruleBasedInsight = BriefingPrompts.getRuleBasedMorningInsight(
@@ -480,7 +489,8 @@ class BriefingGenerator @Inject constructor(
                     maxTokens = 100,
                     temperature = 0.7f,
                     useLlm = true,
-                    fallbackToRuleBased = true
+                    fallbackToRuleBased = true,
+                    qos = qos
                 )
             )
 
@@ -509,7 +519,8 @@ class BriefingGenerator @Inject constructor(
         goalProgressDelta: String?,
         spotlightGoalTitle: String?,
         meetingCount: Int,
-        dayOfWeek: String
+        dayOfWeek: String,
+        qos: AiQos
     ): String {
         val ruleBasedReflection = BriefingPrompts.getRuleBasedEveningReflection(
             tasksCompleted = tasksCompleted,
@@ -544,7 +555,8 @@ class BriefingGenerator @Inject constructor(
                     maxTokens = 150,
                     temperature = 0.7f,
                     useLlm = true,
-                    fallbackToRuleBased = true
+                    fallbackToRuleBased = true,
+                    qos = qos
                 )
             )
 
@@ -1,6 +1,8 @@
 package com.prio.core.aiprovider.di
 
 import com.prio.core.ai.provider.AiProvider
+import com.prio.core.ai.registry.FileHasher
+import com.prio.core.aiprovider.llm.NativeFileHasher
 import com.prio.core.aiprovider.nano.GeminiNanoProvider
 import com.prio.core.aiprovider.provider.OnDeviceAiProvider
 import com.prio.core.aiprovider.provider.RuleBasedFallbackProvider
@@ -144,4 +146,12 @@ abstract class AiProviderBindingsModule {
     abstract fun bindGeminiNanoProvider(
         provider: GeminiNanoProvider
     ): AiProvider
+    
+    /**
+     * Verify model downloads with the native, hardware-accelerated SHA-256.
+     */
+    @Binds
+    abstract fun bindFileHasher(
+        hasher: NativeFileHasher
+    ): FileHasher
 }
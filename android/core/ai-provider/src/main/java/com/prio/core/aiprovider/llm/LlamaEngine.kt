@@ -1,16 +1,30 @@
 package com.prio.core.aiprovider.llm
 
+import android.content.ComponentCallbacks2
 import android.content.Context
+import android.content.res.Configuration
+import android.os.Build
+import dalvik.annotation.optimization.CriticalNative
+import dalvik.annotation.optimization.FastNative
+import com.prio.core.ai.registry.DeviceCapabilities
 import dagger.hilt.android.qualifiers.ApplicationContext
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
+import kotlinx.coroutines.launch
 import kotlinx.coroutines.sync.Mutex
 import kotlinx.coroutines.sync.withLock
 import kotlinx.coroutines.withContext
 import timber.log.Timber
 import java.io.File
+import java.nio.ByteBuffer
+import java.util.concurrent.atomic.AtomicBoolean
 import javax.inject.Inject
 import javax.inject.Singleton
 
@@ -37,26 +51,71 @@ class LlamaEngine @Inject constructor(
     
     private var modelHandle: Long = 0
     private val mutex = Mutex()
+    /** Serializes loads and unloads; [mutex] is only held to publish a handle. */
+    private val loadMutex = Mutex()
     private var isInitialized = false
     
     private val _state = MutableStateFlow(LlamaEngineState())
     val state: StateFlow<LlamaEngineState> = _state.asStateFlow()
     
+    private val trimScope = CoroutineScope(SupervisorJob() + Dispatchers.IO)
+    
+    init {
+        // Trim instead of waiting for the low-memory killer to take the whole process
+        context.registerComponentCallbacks(object : ComponentCallbacks2 {
+            override fun onTrimMemory(level: Int) {
+                val trimLevel = TrimLevel.fromTrimMemory(level) ?: return
+                trimScope.launch { trimMemory(trimLevel) }
+            }
+            
+            override fun onConfigurationChanged(newConfig: Configuration) {}
+            
+            @Deprecated("Deprecated in Java")
+            override fun onLowMemory() {
+                trimScope.launch { trimMemory(TrimLevel.RELEASE_ALL) }
+            }
+        })
+    }
+    
     companion object {
         private const val TAG = "LlamaEngine"
         
-        const val DEFAULT_CONTEXT_SIZE = 2048
+        /** Initial context; grows on demand when elastic sizing is enabled. */
+        const val DEFAULT_CONTEXT_SIZE = 512
+        const val DEFAULT_IDLE_SHRINK_MS = 30_000L
+        /** Fallback when CPU topology cannot be read. */
         const val DEFAULT_THREADS = 4
         const val DEFAULT_TEMPERATURE = 0.3f
         const val DEFAULT_TOP_P = 0.9f
         const val DEFAULT_MAX_TOKENS = 256
+        const val DEFAULT_BATCH_SIZE = 512
+        const val MIN_CONTEXT_SIZE = 64
+        const val MAX_SEQUENCES = 64
+        const val DEFAULT_THREADPOOL_POLL = 50
+        const val DEFAULT_THROTTLE_WINDOW = 8
+        const val DEFAULT_MAX_THROTTLE_PAUSE_MS = 200L
+        const val DEFAULT_AUTOTUNE_PROMPT_TOKENS = 256
+        const val DEFAULT_AUTOTUNE_GEN_TOKENS = 16
+        const val AUTOTUNE_STORE_FILE = "llama_autotune.tsv"
+        const val REPACK_CACHE_DIR = "llama_repack"
+        const val DEFAULT_PROBE_BUDGET_MS = 600
+        const val HASH_PROGRESS_INTERVAL_MS = 100L
         
         private var libraryLoaded = false
         private var libraryError: String? = null
         
+        /**
+         * Time System.loadLibrary took for llama_jni and its shared dependencies
+         * (ggml-base); the CPU backend variant loads later, see [CpuBackend.loadTimeMs].
+         */
+        var libraryLoadTimeMs = 0L
+            private set
+        
         init {
             try {
+                val start = System.nanoTime()
                 System.loadLibrary("llama_jni")
+                libraryLoadTimeMs = (System.nanoTime() - start) / 1_000_000
                 libraryLoaded = true
                 Timber.tag(TAG).i("llama_jni native library loaded successfully")
             } catch (e: UnsatisfiedLinkError) {
@@ -69,26 +128,143 @@ class LlamaEngine @Inject constructor(
          * Check if the native library is available.
          */
         fun isNativeLibraryAvailable(): Boolean = libraryLoaded
+        
+        // Metric getters polled by the UI. @CriticalNative skips the JNI
+        // transition entirely; they are bound in JNI_OnLoad, so they must stay
+        // static with primitive arguments only.
+        @JvmStatic @CriticalNative
+        private external fun getMemoryUsage(handle: Long): Long
+        @JvmStatic @CriticalNative
+        private external fun getContextSize(handle: Long): Int
+        @JvmStatic @CriticalNative
+        private external fun getLoadTimeMs(handle: Long): Long
+        @JvmStatic @CriticalNative
+        private external fun getLastInferenceTimeMs(handle: Long): Long
+        @JvmStatic @CriticalNative
+        private external fun getLastTokenCount(handle: Long): Int
+        @JvmStatic @CriticalNative
+        private external fun isStubImplementation(handle: Long): Boolean
     }
     
     // Native method declarations - will use stub if library not loaded
-    private external fun initBackend()
-    private external fun nativeLoadModel(modelPath: String, contextSize: Int, nThreads: Int): Long
+    /** [libDir] null finds the CPU backend variants by soname in the app's library path. */
+    private external fun initBackend(libDir: String? = null)
+    private external fun nativeLoadModel(
+        modelPath: String,
+        contextSize: Int,
+        nThreads: Int,
+        memoryBudgetBytes: Long,
+        nThreadsBatch: Int,
+        nBatch: Int,
+        nUbatch: Int,
+        nSeqMax: Int,
+        typeK: Int,
+        typeV: Int,
+        flashAttn: Int
+    ): Long
     private external fun nativeGenerate(
         handle: Long,
         prompt: String,
         maxTokens: Int,
         temperature: Float,
-        topP: Float
+        topP: Float,
+        qos: Int,
+        enqueuedNanos: Long,
+        stats: LongArray
     ): String
+    private external fun nativeGenerateUtf8(
+        handle: Long,
+        prompt: ByteBuffer,
+        promptLength: Int,
+        output: ByteBuffer,
+        maxTokens: Int,
+        temperature: Float,
+        topP: Float,
+        qos: Int,
+        enqueuedNanos: Long,
+        stats: LongArray
+    ): Int
+    private external fun nativeGenerateTokens(
+        handle: Long,
+        prompt: IntArray,
+        maxTokens: Int,
+        temperature: Float,
+        topP: Float,
+        qos: Int,
+        enqueuedNanos: Long,
+        stats: LongArray
+    ): IntArray?
+    private external fun nativeTokenize(handle: Long, text: ByteBuffer, length: Int, addSpecial: Boolean): IntArray?
+    private external fun nativeDetokenize(handle: Long, tokens: IntArray, output: ByteBuffer): Int
     private external fun nativeUnloadModel(handle: Long)
-    private external fun getMemoryUsage(handle: Long): Long
-    private external fun getLoadTimeMs(handle: Long): Long
-    private external fun getLastInferenceTimeMs(handle: Long): Long
-    private external fun getLastTokenCount(handle: Long): Int
-    private external fun isStubImplementation(handle: Long): Boolean
+    private external fun nativeWarmUpModel(handle: Long): Long
+    private external fun nativeSwapModels(handle: Long, other: Long): Boolean
+    @FastNative
+    private external fun nativeGetHandleStats(): LongArray
+    private external fun nativeCountCancelled(qos: Int)
+    private external fun nativeGetPerfSnapshot(reset: Boolean): LongArray
+    private external fun nativeGetMemoryBreakdown(handle: Long): LongArray
+    private external fun nativeConfigureElasticContext(handle: Long, maxContextSize: Int, idleShrinkMs: Long): Int
+    private external fun nativeGetContextMetrics(handle: Long): LongArray
+    private external fun nativeSetModelCacheBudget(budgetBytes: Long)
+    private external fun nativeEvictIdleModels(): Long
+    private external fun nativeTrimMemory(handle: Long, level: Int): LongArray
+    private external fun nativeGetTeardownReport(): LongArray
+    private external fun nativeConfigureThreadPool(
+        nThreads: Int, nThreadsBatch: Int, poll: Int, separateBatchPool: Boolean, cpuPolicy: Int
+    ): Boolean
+    private external fun nativeGetThreadPoolStats(): LongArray
+    private external fun nativeGetCpuBackend(): LongArray
+    private external fun nativeGetBuildProfile(): String
+    private external fun nativeIsArchitectureBuiltIn(arch: String): Boolean
+    private external fun nativeConfigureRepackCache(dir: String?)
+    private external fun nativeGetRepackCacheStats(): LongArray
+    private external fun nativeSelectRequantType(): Int
+    private external fun nativeRequantize(input: String, output: String, targetType: Int, threads: Int): Int
+    private external fun nativeCancelRequantize()
+    @FastNative
+    private external fun nativeGetRequantizeProgress(): LongArray
+    private external fun nativeSha256File(path: String, readers: Int): String?
+    private external fun nativeCancelFileHash()
+    @FastNative
+    private external fun nativeGetFileHashProgress(): LongArray
+    private external fun nativeSetBackgroundPaused(paused: Boolean)
+    private external fun nativeGetCpuTopology(sysfsRoot: String?): LongArray
+    private external fun nativeConfigureAdaptiveThreads(
+        handle: Long, enabled: Boolean, targetTokensPerSec: Float, maxTempC: Float,
+        minThreads: Int, windowTokens: Int, maxPauseMs: Long
+    ): Boolean
+    private external fun nativeGetThrottleReport(): LongArray
+    private external fun nativeConfigureProfiler(handle: Long, sampleRate: Float): Boolean
+    private external fun nativeGetComputeProfile(): String?
+    private external fun nativeConfigureAutotune(storePath: String?, deviceKey: String)
+    private external fun nativeAutotune(
+        handle: Long, prompt: String?, promptTokens: Int, genTokens: Int, threads: IntArray,
+        threadsBatch: IntArray, batchSizes: IntArray, kvTypes: IntArray, save: Boolean
+    ): LongArray
+    private external fun nativeProbeDevice(threads: Int, budgetMs: Int): LongArray
     private external fun cleanupBackend()
     
+    private fun nativeLoadModelWithParams(
+        modelPath: String,
+        contextSize: Int,
+        threads: Int?,
+        memoryBudgetBytes: Long,
+        params: ContextParams
+    ): Long = nativeLoadModel(
+        modelPath,
+        contextSize,
+        threads ?: 0,
+        memoryBudgetBytes,
+        params.threadsBatch,
+        params.batchSize ?: 0,
+        params.ubatchSize ?: 0,
+        params.maxSequences,
+        params.kvCacheTypeK?.ggmlType ?: 0,
+        params.kvCacheTypeV?.ggmlType ?: 0,
+        params.flashAttention.nativeValue
+    )
+    
     /**
      * Initialize the llama.cpp backend. Call once on app startup.
      */
@@ -108,9 +284,13 @@ class LlamaEngine @Inject constructor(
                 
                 try {
                     initBackend()
+                    // Loads pick up configurations tuned on this device
+                    configureAutotune()
+                    // Repacked weights are mapped from disk after the first load
+                    configureRepackCache()
                     isInitialized = true
                     _state.value = _state.value.copy(isInitialized = true)
-                    Timber.tag(TAG).i("LlamaEngine initialized")
+                    Timber.tag(TAG).i("LlamaEngine initialized, CPU backend ${getCpuBackend()}")
                     Result.success(Unit)
                 } catch (e: Exception) {
                     val error = "Failed to initialize llama.cpp backend: ${e.message}"
@@ -127,44 +307,68 @@ class LlamaEngine @Inject constructor(
     /**
      * Load a GGUF model from the given path.
      * 
+     * With a model already loaded this is a hot swap: the new model loads and
+     * warms up while the current one keeps serving, then replaces it without
+     * a window where [generate] fails. Both models are resident meanwhile, so
+     * [unload] first when memory is tight. If the new model fails to load the
+     * current one stays loaded.
+     * 
      * @param modelPath Absolute path to the .gguf model file
-     * @param contextSize Context window size (default 2048)
-     * @param threads Number of CPU threads to use (default 4)
+     * @param contextSize Initial context window size (default 512)
+     * @param threads Number of CPU threads to use; null takes the autotuned count for this
+     *   device and model, else one per performance core
+     * @param memoryBudgetBytes Budget for weights + KV cache + compute buffers; the native
+     *   side shrinks context, KV type and batch size to fit. 0 disables the budget.
+     * @param params KV cache types, flash attention and batch/sequence limits
+     * @param elasticContext Grow the context past [contextSize] on demand and shrink it
+     *   back when idle; null keeps a fixed context
      * @return LoadResult with success status and timing info
      */
     suspend fun loadModel(
         modelPath: String,
         contextSize: Int = DEFAULT_CONTEXT_SIZE,
-        threads: Int = DEFAULT_THREADS
+        threads: Int? = null,
+        memoryBudgetBytes: Long = 0L,
+        params: ContextParams = ContextParams(),
+        elasticContext: ElasticContext? = ElasticContext()
     ): LoadResult = withContext(Dispatchers.IO) {
-        mutex.withLock {
+        loadMutex.withLock {
             _state.value = _state.value.copy(isLoading = true, error = null)
             
             // Initialize if needed
-            if (!isInitialized) {
-                if (!libraryLoaded) {
-                    val result = LoadResult(
-                        success = false,
-                        loadTimeMs = 0,
-                        memoryBytes = 0,
-                        isStub = true,
-                        error = "Native library not available"
-                    )
-                    _state.value = _state.value.copy(
-                        isLoading = false,
-                        isStubMode = true,
-                        error = result.error
-                    )
-                    return@withContext result
+            val initialized = mutex.withLock {
+                if (!isInitialized && libraryLoaded) {
+                    initBackend()
+                    isInitialized = true
                 }
-                initBackend()
-                isInitialized = true
+                isInitialized
+            }
+            if (!initialized) {
+                val result = LoadResult(
+                    success = false,
+                    loadTimeMs = 0,
+                    memoryBytes = 0,
+                    isStub = true,
+                    error = "Native library not available"
+                )
+                _state.value = _state.value.copy(
+                    isLoading = false,
+                    isStubMode = true,
+                    error = result.error
+                )
+                return@withContext result
             }
             
-            // Unload existing model
-            if (modelHandle != 0L) {
-                nativeUnloadModel(modelHandle)
-                modelHandle = 0
+            params.validate(contextSize, threads)?.let { error ->
+                Timber.tag(TAG).e("Invalid context params: $error")
+                _state.value = _state.value.copy(isLoading = false, error = error)
+                return@withContext LoadResult(
+                    success = false,
+                    loadTimeMs = 0,
+                    memoryBytes = 0,
+                    isStub = true,
+                    error = error
+                )
             }
             
             val file = File(modelPath)
@@ -182,12 +386,13 @@ class LlamaEngine @Inject constructor(
                 return@withContext result
             }
             
-            Timber.tag(TAG).i("Loading model: $modelPath (context=$contextSize, threads=$threads)")
+            // A loaded model keeps serving until the new one replaces it
+            Timber.tag(TAG).i("Loading model: $modelPath (context=$contextSize, threads=$threads, $params)")
             
             try {
-                modelHandle = nativeLoadModel(modelPath, contextSize, threads)
+                val handle = nativeLoadModelWithParams(modelPath, contextSize, threads, memoryBudgetBytes, params)
                 
-                if (modelHandle == 0L) {
+                if (handle == 0L) {
                     val error = "Failed to load model - native call returned null handle"
                     _state.value = _state.value.copy(isLoading = false, error = error)
                     return@withContext LoadResult(
@@ -199,12 +404,39 @@ class LlamaEngine @Inject constructor(
                     )
                 }
                 
-                val loadTime = getLoadTimeMs(modelHandle)
-                val memoryUsage = getMemoryUsage(modelHandle)
-                val isStub = isStubImplementation(modelHandle)
+                elasticContext?.let {
+                    nativeConfigureElasticContext(handle, it.maxContextSize, it.idleShrinkMs)
+                }
+                
+                val loadTime = getLoadTimeMs(handle)
+                val memoryUsage = getMemoryUsage(handle)
+                val isStub = isStubImplementation(handle)
+                val loadedContextSize = getContextSize(handle)
+                val breakdown = MemoryBreakdown.fromArray(nativeGetMemoryBreakdown(handle))
+                
+                val swapped = modelHandle != 0L
+                var warmUpMs = 0L
+                if (swapped) {
+                    warmUpMs = hotSwap(handle) ?: run {
+                        val error = "Replacement model failed to warm up"
+                        _state.value = _state.value.copy(isLoading = false, error = error)
+                        return@withContext LoadResult(
+                            success = false,
+                            loadTimeMs = loadTime,
+                            memoryBytes = 0,
+                            isStub = isStub,
+                            error = error
+                        )
+                    }
+                } else {
+                    mutex.withLock { modelHandle = handle }
+                }
                 
                 Timber.tag(TAG).i(
-                    "Model loaded in ${loadTime}ms, memory: ${memoryUsage / 1_000_000}MB, stub: $isStub"
+                    "Model loaded in ${loadTime}ms, memory: ${memoryUsage / 1_000_000}MB " +
+                        "(kv=${breakdown.kvCacheBytes / 1_000_000}MB, rss=${breakdown.processRssBytes / 1_000_000}MB), " +
+                        "context: $loadedContextSize, stub: $isStub" +
+                        if (swapped) ", hot-swapped after ${warmUpMs}ms warm-up" else ""
                 )
                 
                 _state.value = _state.value.copy(
@@ -213,7 +445,8 @@ class LlamaEngine @Inject constructor(
                     isStubMode = isStub,
                     loadedModelPath = modelPath,
                     loadTimeMs = loadTime,
-                    memoryUsageBytes = memoryUsage
+                    memoryUsageBytes = memoryUsage,
+                    memoryBreakdown = breakdown
                 )
                 
                 LoadResult(
@@ -221,7 +454,11 @@ class LlamaEngine @Inject constructor(
                     loadTimeMs = loadTime,
                     memoryBytes = memoryUsage,
                     isStub = isStub,
-                    error = null
+                    error = null,
+                    contextSize = loadedContextSize,
+                    memoryBreakdown = breakdown,
+                    swapped = swapped,
+                    warmUpMs = warmUpMs
                 )
             } catch (e: Exception) {
                 val error = "Exception loading model: ${e.message}"
@@ -238,6 +475,32 @@ class LlamaEngine @Inject constructor(
         }
     }
     
+    /**
+     * Put the freshly loaded [replacement] behind [modelHandle]: warm it up
+     * while the current model serves, exchange the two engines natively, then
+     * unload the previous model once its in-flight requests have finished.
+     * Caller holds [loadMutex].
+     * 
+     * @return Warm-up time, or null if the replacement failed and was unloaded
+     */
+    private suspend fun hotSwap(replacement: Long): Long? {
+        val warmUpMs = try {
+            nativeWarmUpModel(replacement)
+        } catch (e: UnsatisfiedLinkError) {
+            Timber.tag(TAG).w(e, "Warm-up not supported by native library")
+            0L
+        }
+        val exchanged = warmUpMs >= 0 && try {
+            mutex.withLock { nativeSwapModels(modelHandle, replacement) }
+        } catch (e: UnsatisfiedLinkError) {
+            Timber.tag(TAG).w(e, "Hot swap not supported by native library")
+            false
+        }
+        // After an exchange [replacement] refers to the previous model
+        nativeUnloadModel(replacement)
+        return if (exchanged) warmUpMs else null
+    }
+    
     /**
      * Generate text completion for the given prompt.
      * 
@@ -245,66 +508,234 @@ class LlamaEngine @Inject constructor(
      * @param maxTokens Maximum number of tokens to generate
      * @param temperature Temperature for sampling (0.0-2.0)
      * @param topP Top-p nucleus sampling parameter
+     * @param qos [Qos.BACKGROUND] for work nobody is waiting on (briefing prefetch, workers)
      * @return GenerateResult with generated text and timing info
      */
     suspend fun generate(
         prompt: String,
         maxTokens: Int = DEFAULT_MAX_TOKENS,
         temperature: Float = DEFAULT_TEMPERATURE,
-        topP: Float = DEFAULT_TOP_P
+        topP: Float = DEFAULT_TOP_P,
+        qos: Qos = Qos.INTERACTIVE
     ): GenerateResult = withContext(Dispatchers.IO) {
-        mutex.withLock {
-            if (modelHandle == 0L) {
-                return@withContext GenerateResult(
-                    text = "",
-                    inferenceTimeMs = 0,
-                    tokensGenerated = 0,
-                    tokensPerSecond = 0.0,
-                    error = "Model not loaded"
-                )
+        val enqueuedNanos = System.nanoTime()
+        withGenerateLock(qos) { handle ->
+            if (handle == 0L) {
+                return@withContext generateError("Model not loaded")
             }
             
-            Timber.tag(TAG).d("Generating (maxTokens=$maxTokens, temp=$temperature, topP=$topP)")
+            Timber.tag(TAG).d("Generating (maxTokens=$maxTokens, temp=$temperature, topP=$topP, qos=$qos)")
             
             try {
-                val result = nativeGenerate(modelHandle, prompt, maxTokens, temperature, topP)
-                val inferenceTime = getLastInferenceTimeMs(modelHandle)
-                val tokenCount = getLastTokenCount(modelHandle)
-                
-                val tokensPerSec = if (inferenceTime > 0) {
-                    tokenCount.toDouble() / (inferenceTime.toDouble() / 1000.0)
-                } else {
-                    0.0
-                }
-                
-                Timber.tag(TAG).d("Generated $tokenCount tokens in ${inferenceTime}ms (${String.format("%.1f", tokensPerSec)} t/s)")
-                
-                _state.value = _state.value.copy(
-                    lastInferenceTimeMs = inferenceTime,
-                    lastTokensGenerated = tokenCount
-                )
-                
-                GenerateResult(
-                    text = result,
-                    inferenceTimeMs = inferenceTime,
-                    tokensGenerated = tokenCount,
-                    tokensPerSecond = tokensPerSec,
-                    error = null
+                val stats = LongArray(GenerationStats.FIELDS)
+                val result = nativeGenerate(handle, prompt, maxTokens, temperature, topP, qos.nativeValue, enqueuedNanos, stats)
+                generateResult(text = result, stats = stats)
+            } catch (e: Exception) {
+                val error = "Generation failed: ${e.message}"
+                Timber.tag(TAG).e(e, error)
+                generateError(error)
+            }
+        }
+    }
+    
+    /**
+     * Generate from standard UTF-8 in a direct buffer into another direct
+     * buffer, without String conversions or copies. [prompt] is read from its
+     * position to its limit and output is written from [output]'s position;
+     * both positions advance. Output stops early when [output] is full.
+     * 
+     * @return GenerateResult with empty text and [GenerateResult.outputBytes] set
+     */
+    suspend fun generate(
+        prompt: ByteBuffer,
+        output: ByteBuffer,
+        maxTokens: Int = DEFAULT_MAX_TOKENS,
+        temperature: Float = DEFAULT_TEMPERATURE,
+        topP: Float = DEFAULT_TOP_P,
+        qos: Qos = Qos.INTERACTIVE
+    ): GenerateResult = withContext(Dispatchers.IO) {
+        if (!prompt.isDirect || !output.isDirect) {
+            return@withContext generateError("Prompt and output must be direct buffers")
+        }
+        val enqueuedNanos = System.nanoTime()
+        withGenerateLock(qos) { handle ->
+            if (handle == 0L) {
+                return@withContext generateError("Model not loaded")
+            }
+            
+            try {
+                val stats = LongArray(GenerationStats.FIELDS)
+                val written = nativeGenerateUtf8(
+                    handle, prompt.slice(), prompt.remaining(), output.slice(),
+                    maxTokens, temperature, topP, qos.nativeValue, enqueuedNanos, stats
                 )
+                if (written >= 0) {
+                    prompt.position(prompt.limit())
+                    output.position(output.position() + written)
+                }
+                generateResult(text = "", stats = stats, outputBytes = maxOf(written, 0))
             } catch (e: Exception) {
                 val error = "Generation failed: ${e.message}"
                 Timber.tag(TAG).e(e, error)
-                GenerateResult(
-                    text = "",
-                    inferenceTimeMs = 0,
-                    tokensGenerated = 0,
-                    tokensPerSecond = 0.0,
-                    error = error
+                generateError(error)
+            }
+        }
+    }
+    
+    /**
+     * Generate from prompt token IDs, e.g. a system prompt tokenized once with
+     * [tokenize] followed by the new turn. Generated IDs are returned in
+     * [GenerateResult.tokens]; [detokenize] turns them into UTF-8.
+     */
+    suspend fun generateTokens(
+        promptTokens: IntArray,
+        maxTokens: Int = DEFAULT_MAX_TOKENS,
+        temperature: Float = DEFAULT_TEMPERATURE,
+        topP: Float = DEFAULT_TOP_P,
+        qos: Qos = Qos.INTERACTIVE
+    ): GenerateResult = withContext(Dispatchers.IO) {
+        val enqueuedNanos = System.nanoTime()
+        withGenerateLock(qos) { handle ->
+            if (handle == 0L) {
+                return@withContext generateError("Model not loaded")
+            }
+            
+            try {
+                val stats = LongArray(GenerationStats.FIELDS)
+                val tokens = nativeGenerateTokens(
+                    handle, promptTokens, maxTokens, temperature, topP, qos.nativeValue, enqueuedNanos, stats
                 )
+                generateResult(text = "", stats = stats, tokens = tokens)
+            } catch (e: Exception) {
+                val error = "Generation failed: ${e.message}"
+                Timber.tag(TAG).e(e, error)
+                generateError(error)
+            }
+        }
+    }
+    
+    /**
+     * Token IDs for the UTF-8 in [text] (position to limit; the position is
+     * not moved), so callers can cache tokenized prompts. [addSpecial] adds
+     * BOS as text prompts get. Null without a model or a direct buffer.
+     */
+    suspend fun tokenize(text: ByteBuffer, addSpecial: Boolean = true): IntArray? = withContext(Dispatchers.IO) {
+        if (!text.isDirect || !libraryLoaded) return@withContext null
+        mutex.withLock {
+            if (modelHandle == 0L) return@withContext null
+            try {
+                nativeTokenize(modelHandle, text.slice(), text.remaining(), addSpecial)
+            } catch (e: UnsatisfiedLinkError) {
+                null
+            }
+        }
+    }
+    
+    /**
+     * Write the UTF-8 text of [tokens] into the direct buffer [output] from its
+     * position, advancing it. Returns bytes written, or minus the size needed
+     * when [output] has too little room (nothing is written then).
+     */
+    suspend fun detokenize(tokens: IntArray, output: ByteBuffer): Int = withContext(Dispatchers.IO) {
+        if (!output.isDirect || !libraryLoaded) return@withContext 0
+        mutex.withLock {
+            if (modelHandle == 0L) return@withContext 0
+            try {
+                val written = nativeDetokenize(modelHandle, tokens, output.slice())
+                if (written > 0) output.position(output.position() + written)
+                written
+            } catch (e: UnsatisfiedLinkError) {
+                0
+            }
+        }
+    }
+    
+    /**
+     * Run a generate call on the handle of the loaded model. Interactive
+     * calls hold [mutex] until they finish. Background calls only read the
+     * handle under it: natively they yield their engine between tokens to
+     * interactive calls and while paused, which holding [mutex] would undo
+     * by keeping interactive calls, unload and hot swap waiting here. A call
+     * cancelled while waiting for [mutex], e.g. queued behind a long
+     * request, is counted in [getPerformanceSnapshot].
+     */
+    private suspend inline fun <T> withGenerateLock(qos: Qos, block: (handle: Long) -> T): T {
+        try {
+            mutex.lock()
+        } catch (e: CancellationException) {
+            if (libraryLoaded) nativeCountCancelled(qos.nativeValue)
+            throw e
+        }
+        if (qos == Qos.BACKGROUND) {
+            val handle = try {
+                modelHandle
+            } finally {
+                mutex.unlock()
             }
+            return block(handle)
         }
+        try {
+            return block(modelHandle)
+        } finally {
+            mutex.unlock()
+        }
+    }
+    
+    /**
+     * Result of the request that just finished, built from the [stats] it
+     * filled in natively. Runs on the thread that made the request, right
+     * after it: the throttle report and profile are that thread's last request.
+     */
+    private fun generateResult(
+        text: String,
+        stats: LongArray,
+        outputBytes: Int = 0,
+        tokens: IntArray? = null
+    ): GenerateResult {
+        val generation = GenerationStats.fromArray(stats)
+        val throttle = ThrottleReport.fromArray(nativeGetThrottleReport())
+        
+        Timber.tag(TAG).d(
+            "Generated ${generation.generatedTokens} tokens in ${generation.totalUs / 1000}ms " +
+                "(first token ${generation.timeToFirstTokenUs / 1000}ms, " +
+                "${String.format("%.1f", generation.tokensPerSecond)} t/s, ${generation.stopReason})"
+        )
+        
+        _state.value = _state.value.copy(
+            lastInferenceTimeMs = generation.totalUs / 1000,
+            lastTokensGenerated = generation.generatedTokens
+        )
+        
+        return GenerateResult(
+            text = text,
+            inferenceTimeMs = generation.totalUs / 1000,
+            tokensGenerated = generation.generatedTokens,
+            tokensPerSecond = generation.tokensPerSecond,
+            error = when (generation.stopReason) {
+                StopReason.NONE -> "Model not loaded"
+                StopReason.ERROR -> "Generation failed"
+                else -> null
+            },
+            contextSize = generation.contextSize,
+            contextResizeMs = generation.contextResizeMs,
+            throttle = throttle.takeIf { it.decisions.isNotEmpty() },
+            outputBytes = outputBytes,
+            tokens = tokens,
+            stats = generation,
+            profile = if (generation.profiledNodes > 0) {
+                nativeGetComputeProfile()?.let { ComputeProfile.parse(it) }
+            } else null
+        )
     }
     
+    private fun generateError(error: String) = GenerateResult(
+        text = "",
+        inferenceTimeMs = 0,
+        tokensGenerated = 0,
+        tokensPerSecond = 0.0,
+        error = error
+    )
+    
     /**
      * Check if a model is currently loaded.
      */
@@ -323,6 +754,16 @@ class LlamaEngine @Inject constructor(
             }
         } else true
     
+    /**
+     * Total time of the last request on the loaded model. Cheap enough to
+     * poll from the UI; [GenerateResult.stats] has the per-phase split.
+     */
+    val lastInferenceTimeMs: Long
+        get() = if (modelHandle != 0L && libraryLoaded) getLastInferenceTimeMs(modelHandle) else 0
+    
+    val lastTokenCount: Int
+        get() = if (modelHandle != 0L && libraryLoaded) getLastTokenCount(modelHandle) else 0
+    
     /**
      * Get current memory usage in bytes.
      */
@@ -339,63 +780,1595 @@ class LlamaEngine @Inject constructor(
     }
     
     /**
-     * Unload the current model.
+     * Get the native memory breakdown (weights, KV cache, compute buffers, process RSS/PSS).
      */
-    suspend fun unload() = withContext(Dispatchers.IO) {
+    suspend fun getMemoryBreakdown(): MemoryBreakdown? = withContext(Dispatchers.IO) {
         mutex.withLock {
-            if (modelHandle != 0L && libraryLoaded) {
+            if (modelHandle == 0L || !libraryLoaded) null else {
                 try {
-                    nativeUnloadModel(modelHandle)
-                    Timber.tag(TAG).i("Model unloaded")
+                    MemoryBreakdown.fromArray(nativeGetMemoryBreakdown(modelHandle))
                 } catch (e: Exception) {
-                    Timber.tag(TAG).e(e, "Error unloading model")
+                    null
                 }
-                modelHandle = 0
             }
-            _state.value = _state.value.copy(
-                isModelLoaded = false,
-                loadedModelPath = null,
-                memoryUsageBytes = 0
-            )
         }
     }
     
     /**
-     * Cleanup backend resources.
+     * Get elastic context size and resize costs for the loaded model.
      */
-    suspend fun cleanup() = withContext(Dispatchers.IO) {
+    suspend fun getContextMetrics(): ContextMetrics? = withContext(Dispatchers.IO) {
         mutex.withLock {
-            if (modelHandle != 0L && libraryLoaded) {
+            if (modelHandle == 0L || !libraryLoaded) null else {
                 try {
-                    nativeUnloadModel(modelHandle)
+                    ContextMetrics.fromArray(nativeGetContextMetrics(modelHandle))
                 } catch (e: Exception) {
-                    Timber.tag(TAG).w(e, "Error unloading model during cleanup")
+                    null
+                }
+            }
+        }
+    }
+    
+    /**
+     * Set the process-wide budget for model weights shared by all engine instances.
+     * Idle models are kept cached within the budget and evicted least-recently-used first.
+     * 0 (default) frees a model as soon as no engine references it.
+     */
+    fun setModelCacheBudget(budgetBytes: Long) {
+        if (!libraryLoaded) return
+        try {
+            nativeSetModelCacheBudget(budgetBytes)
+        } catch (e: UnsatisfiedLinkError) {
+            Timber.tag(TAG).w(e, "Model cache budget not supported by native library")
+        }
+    }
+    
+    /**
+     * Free every cached model that no engine currently references.
+     * 
+     * @return Bytes of model weights released
+     */
+    suspend fun evictIdleModels(): Long = withContext(Dispatchers.IO) {
+        if (!libraryLoaded) return@withContext 0L
+        try {
+            nativeEvictIdleModels()
+        } catch (e: UnsatisfiedLinkError) {
+            Timber.tag(TAG).w(e, "Idle model eviction not supported by native library")
+            0L
+        }
+    }
+    
+    /**
+     * Release memory at [level] without unloading. The next [generate] call
+     * restores whatever was trimmed.
+     * 
+     * @return What was freed and the expected restore cost, or null if no model is loaded
+     */
+    suspend fun trimMemory(level: TrimLevel): TrimResult? = withContext(Dispatchers.IO) {
+        mutex.withLock {
+            if (modelHandle == 0L || !libraryLoaded) return@withLock null
+            try {
+                val result = TrimResult.fromArray(nativeTrimMemory(modelHandle, level.nativeValue))
+                Timber.tag(TAG).i("Trim $level: freed ${result.bytesFreed / 1024 / 1024} MB, " +
+                    "restore ~${result.restoreCostMs} ms")
+                _state.value = _state.value.copy(
+                    memoryUsageBytes = getMemoryUsage(modelHandle)
+                )
+                result
+            } catch (e: UnsatisfiedLinkError) {
+                Timber.tag(TAG).w(e, "Memory trim not supported by native library")
+                null
+            }
+        }
+    }
+    
+    /**
+     * Enable adaptive thread control for generations on the loaded model, or
+     * disable it with null.
+     * 
+     * @return false if no model is loaded or [config] is invalid
+     */
+    suspend fun configureAdaptiveThreads(config: AdaptiveThreads?): Boolean = withContext(Dispatchers.IO) {
+        config?.validate()?.let {
+            Timber.tag(TAG).e("Invalid adaptive thread config: $it")
+            return@withContext false
+        }
+        mutex.withLock {
+            if (modelHandle == 0L || !libraryLoaded) return@withLock false
+            val c = config ?: AdaptiveThreads()
+            try {
+                nativeConfigureAdaptiveThreads(
+                    modelHandle, config != null, c.targetTokensPerSec, c.maxTempC,
+                    c.minThreads, c.windowTokens, c.maxPauseMs
+                )
+            } catch (e: UnsatisfiedLinkError) {
+                Timber.tag(TAG).w(e, "Adaptive threads not supported by native library")
+                false
+            }
+        }
+    }
+    
+    /**
+     * Time every op of [sampleRate] of the generations on the loaded model
+     * (0 disables), reported in [GenerateResult.profile]. Sampled requests run
+     * noticeably slower, so keep the rate small outside benchmarks.
+     * 
+     * @return false if no model is loaded or [sampleRate] is outside 0..1
+     */
+    suspend fun configureProfiler(sampleRate: Float): Boolean = withContext(Dispatchers.IO) {
+        mutex.withLock {
+            if (modelHandle == 0L || !libraryLoaded) return@withLock false
+            try {
+                nativeConfigureProfiler(modelHandle, sampleRate)
+            } catch (e: UnsatisfiedLinkError) {
+                Timber.tag(TAG).w(e, "Compute profiler not supported by native library")
+                false
+            }
+        }
+    }
+    
+    /**
+     * Keep tuned configurations in [storeFile] (null disables the store). From
+     * then on, loading a model tuned on this device uses the stored thread,
+     * batch and KV settings for whatever [loadModel] is not given explicitly.
+     */
+    fun configureAutotune(
+        storeFile: File? = File(context.filesDir, AUTOTUNE_STORE_FILE),
+        deviceKey: String = deviceKey()
+    ) {
+        if (!libraryLoaded) return
+        try {
+            nativeConfigureAutotune(storeFile?.absolutePath, deviceKey)
+        } catch (e: UnsatisfiedLinkError) {
+            Timber.tag(TAG).w(e, "Autotune not supported by native library")
+        }
+    }
+    
+    /**
+     * Measure prompt and generation throughput of candidate configurations on
+     * the loaded model and, with [save], store the winner for the next load.
+     * Takes tens of seconds and blocks other requests on this engine.
+     * 
+     * @return null if no model is loaded or [spec] is invalid
+     */
+    suspend fun autotune(spec: AutotuneSpec = AutotuneSpec(), save: Boolean = true): AutotuneResult? =
+        withContext(Dispatchers.IO) {
+            spec.validate()?.let {
+                Timber.tag(TAG).e("Invalid autotune spec: $it")
+                return@withContext null
+            }
+            if (!libraryLoaded) return@withContext null
+            mutex.withLock {
+                if (modelHandle == 0L) return@withLock null
+                try {
+                    val result = AutotuneResult.fromArray(
+                        nativeAutotune(
+                            modelHandle, spec.prompt, spec.promptTokens, spec.genTokens,
+                            spec.threads.toIntArray(), spec.threadsBatch.toIntArray(),
+                            spec.batchSizes.flatMap { listOf(it.first, it.second) }.toIntArray(),
+                            spec.kvCacheTypes.map { it.ggmlType }.toIntArray(), save
+                        )
+                    )
+                    Timber.tag(TAG).i("Autotune: ${result.trials.size} trials, best ${result.best}, saved=${result.saved}")
+                    result
+                } catch (e: UnsatisfiedLinkError) {
+                    Timber.tag(TAG).w(e, "Autotune not supported by native library")
+                    null
                 }
-                modelHandle = 0
             }
-            if (isInitialized && libraryLoaded) {
+        }
+    
+    /**
+     * Measure memory bandwidth and int8/fp16 throughput on up to [threads]
+     * performance cores (0 = all) in about [budgetMs], for model
+     * recommendations (see ModelRegistry.getRecommendedModel). Waits for the
+     * current request so it does not measure against a running generation.
+     * 
+     * @return null without the native library
+     */
+    suspend fun probeDevice(threads: Int = 0, budgetMs: Int = DEFAULT_PROBE_BUDGET_MS): DeviceCapabilities? =
+        withContext(Dispatchers.IO) {
+            if (!libraryLoaded) return@withContext null
+            mutex.withLock {
                 try {
-                    cleanupBackend()
-                } catch (e: Exception) {
-                    Timber.tag(TAG).w(e, "Error cleaning up backend")
+                    val capabilities = DeviceCapabilities.fromArray(nativeProbeDevice(threads, budgetMs))
+                    Timber.tag(TAG).i("Device probe: $capabilities")
+                    capabilities
+                } catch (e: UnsatisfiedLinkError) {
+                    Timber.tag(TAG).w(e, "Device probe not supported by native library")
+                    null
                 }
-                isInitialized = false
             }
-            _state.value = LlamaEngineState()
-            Timber.tag(TAG).i("LlamaEngine cleaned up")
+        }
+    
+    private fun deviceKey(): String = "${Build.MANUFACTURER} ${Build.MODEL} (${Build.HARDWARE})"
+    
+    /**
+     * CPU topology read from sysfs, or null without the native library.
+     * 
+     * @param sysfsRoot Alternative to /sys/devices/system/cpu, e.g. a fixture tree
+     */
+    fun getCpuTopology(sysfsRoot: String? = null): CpuTopology? {
+        if (!libraryLoaded) return null
+        return try {
+            CpuTopology.fromArray(nativeGetCpuTopology(sysfsRoot))
+        } catch (e: UnsatisfiedLinkError) {
+            null
         }
     }
     
     /**
-     * Result of model loading operation.
+     * Thread count for [policy] on this device, or [DEFAULT_THREADS] if the topology is unknown.
      */
-    data class LoadResult(
-        val success: Boolean,
-        val loadTimeMs: Long,
-        val memoryBytes: Long,
-        val isStub: Boolean,
-        val error: String?
-    )
+    fun recommendedThreads(policy: CpuPolicy = CpuPolicy.PERFORMANCE): Int =
+        getCpuTopology()?.recommendedThreads(policy)?.takeIf { it > 0 } ?: DEFAULT_THREADS
+    
+    /**
+     * Configure the native threadpool shared by all engines. Attached contexts
+     * move to the new pools.
+     * 
+     * @return false if [config] is invalid or the pools could not be created
+     */
+    fun configureThreadPool(config: ThreadPoolConfig): Boolean {
+        config.validate()?.let {
+            Timber.tag(TAG).e("Invalid threadpool config: $it")
+            return false
+        }
+        if (!libraryLoaded) return false
+        return try {
+            nativeConfigureThreadPool(
+                config.threads, config.threadsBatch, config.poll, config.separateBatchPool, config.cpuPolicy.nativeValue
+            )
+        } catch (e: UnsatisfiedLinkError) {
+            Timber.tag(TAG).w(e, "Threadpool configuration not supported by native library")
+            false
+        }
+    }
+    
+    /**
+     * Shared threadpool sizes and decode contention counters, or null without the native library.
+     */
+    fun getThreadPoolStats(): ThreadPoolStats? {
+        if (!libraryLoaded) return null
+        return try {
+            ThreadPoolStats.fromArray(nativeGetThreadPoolStats())
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+    
+    /**
+     * ggml CPU backend variant selected for this device, or null without the native library.
+     */
+    fun getCpuBackend(): CpuBackend? {
+        if (!libraryLoaded) return null
+        return try {
+            CpuBackend.fromArray(nativeGetCpuBackend())
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+    
+    /**
+     * How the native library was built, e.g. "Release+lto+pgo", or null without it.
+     */
+    fun getNativeBuildProfile(): String? {
+        if (!libraryLoaded) return null
+        return try {
+            nativeGetBuildProfile()
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+    
+    /**
+     * Whether this build can load GGUF models of [architecture] (general.architecture,
+     * e.g. "phi3"), or null without the native library. The build compiles in only
+     * LLAMA_MODEL_ARCHS; others fail to load.
+     */
+    fun isArchitectureBuiltIn(architecture: String): Boolean? {
+        if (!libraryLoaded) return null
+        return try {
+            nativeIsArchitectureBuiltIn(architecture)
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+    
+    /**
+     * Keep the weights ggml repacks for its CPU kernels in sidecar files under
+     * [dir] (null disables the cache). Loads after the first map them instead
+     * of repacking into anonymous memory. Sidecars of replaced models or other
+     * CPU backends are removed when a new one is written.
+     */
+    fun configureRepackCache(dir: File? = File(context.noBackupFilesDir, REPACK_CACHE_DIR)) {
+        if (!libraryLoaded) return
+        try {
+            nativeConfigureRepackCache(dir?.absolutePath)
+        } catch (e: UnsatisfiedLinkError) {
+            Timber.tag(TAG).w(e, "Repack cache not supported by this native library")
+        }
+    }
+    
+    /**
+     * Repack cache counters and the outcome of the last load, or null without the native library.
+     */
+    fun getRepackCacheStats(): RepackCacheStats? {
+        if (!libraryLoaded) return null
+        return try {
+            RepackCacheStats.fromArray(nativeGetRepackCacheStats())
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+    
+    /**
+     * Weight type this CPU runs fastest, or null when the downloaded Q4_K_M
+     * layout is already the best choice (or without the native library).
+     */
+    fun recommendedWeightType(): WeightType? {
+        if (!libraryLoaded) return null
+        return try {
+            val type = nativeSelectRequantType()
+            WeightType.values().firstOrNull { it.ggmlType == type }
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+    
+    /**
+     * Convert the model at [inputPath] to [type] and atomically replace
+     * [outputPath], a separate variant file, with the result. [inputPath] is
+     * left as downloaded and verified. The variant is kept only if it loads
+     * and predicts a fixed prompt like the original. Runs on efficiency cores
+     * at background priority without holding the engine. A cancelled or
+     * killed job resumes from its last finished tensor.
+     * 
+     * @return Final state, or null without the native library
+     */
+    suspend fun requantize(
+        inputPath: String,
+        type: WeightType = WeightType.Q4_0,
+        outputPath: String = type.variantPath(inputPath),
+        threads: Int = 0
+    ): RequantizeState? = withContext(Dispatchers.IO) {
+        if (!libraryLoaded) return@withContext null
+        try {
+            val state = RequantizeState.values().getOrElse(
+                nativeRequantize(inputPath, outputPath, type.ggmlType, threads)
+            ) { RequantizeState.FAILED }
+            Timber.tag(TAG).i("Requantize $inputPath -> $outputPath: $state (${getRequantizeProgress()})")
+            state
+        } catch (e: UnsatisfiedLinkError) {
+            Timber.tag(TAG).w(e, "Requantize not supported by this native library")
+            null
+        }
+    }
+    
+    /**
+     * Write the variant of [modelPath] this CPU runs fastest, next to it, when
+     * it prefers another weight type. [modelPath] itself is not modified.
+     * 
+     * @return Path of the checked variant to load, or null to keep using [modelPath]
+     */
+    suspend fun requantizeForDevice(modelPath: String): String? {
+        val type = recommendedWeightType() ?: return null
+        return type.variantPath(modelPath).takeIf { requantize(modelPath, type = type) == RequantizeState.DONE }
+    }
+    
+    /**
+     * Progress of the running (or last) [requantize] job; safe to poll from any thread.
+     */
+    fun getRequantizeProgress(): RequantizeProgress? {
+        if (!libraryLoaded) return null
+        return try {
+            RequantizeProgress.fromArray(nativeGetRequantizeProgress())
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+    
+    /**
+     * Stop the running [requantize] job; the next call with the same paths resumes it.
+     */
+    fun cancelRequantize() {
+        if (!libraryLoaded) return
+        try {
+            nativeCancelRequantize()
+        } catch (e: UnsatisfiedLinkError) {
+            // Nothing to cancel
+        }
+    }
+    
+    /**
+     * Lowercase hex SHA-256 of the file at [path], using the CPU's SHA
+     * instructions and [readers] read-ahead threads (0 picks). Does not need
+     * [initialize]. [onProgress] is called about every
+     * [HASH_PROGRESS_INTERVAL_MS] and once at the end; cancelling the calling
+     * coroutine stops the hash.
+     * 
+     * @return The digest, or null if the file could not be read, the hash was
+     *         cancelled (see [getFileHashProgress]) or the native library is missing
+     */
+    suspend fun sha256File(
+        path: String,
+        readers: Int = 0,
+        onProgress: (FileHashProgress) -> Unit = {}
+    ): String? {
+        if (!libraryLoaded) return null
+        return try {
+            coroutineScope {
+                val hashing = AtomicBoolean(true)
+                val poller = launch {
+                    try {
+                        while (true) {
+                            delay(HASH_PROGRESS_INTERVAL_MS)
+                            getFileHashProgress()?.let(onProgress)
+                        }
+                    } catch (e: CancellationException) {
+                        if (hashing.get()) cancelFileHash()
+                        throw e
+                    }
+                }
+                val hex = withContext(Dispatchers.IO) { nativeSha256File(path, readers) }
+                hashing.set(false)
+                poller.cancel()
+                val progress = getFileHashProgress()
+                progress?.let(onProgress)
+                Timber.tag(TAG).i("SHA-256 $path: $progress")
+                hex
+            }
+        } catch (e: UnsatisfiedLinkError) {
+            Timber.tag(TAG).w(e, "Native SHA-256 not supported by this native library")
+            null
+        }
+    }
+    
+    /**
+     * Progress of the running (or last) [sha256File]; safe to poll from any thread.
+     */
+    fun getFileHashProgress(): FileHashProgress? {
+        if (!libraryLoaded) return null
+        return try {
+            FileHashProgress.fromArray(nativeGetFileHashProgress())
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+    
+    /**
+     * Stop the running [sha256File] after its current chunk; it returns null.
+     */
+    fun cancelFileHash() {
+        if (!libraryLoaded) return
+        try {
+            nativeCancelFileHash()
+        } catch (e: UnsatisfiedLinkError) {
+            // Nothing to cancel
+        }
+    }
+    
+    /**
+     * Hold [Qos.BACKGROUND] generations before their next token, e.g. while
+     * the app is in the foreground. Affects every engine in the process.
+     * A held request gives its engine back meanwhile, so interactive
+     * requests, unload and hot swap do not wait for [resumeBackground]; it
+     * stops with [StopReason.ENGINE_CHANGED] if its model is gone by then.
+     */
+    fun pauseBackground() = setBackgroundPaused(true)
+    
+    fun resumeBackground() = setBackgroundPaused(false)
+    
+    private fun setBackgroundPaused(paused: Boolean) {
+        if (!libraryLoaded) return
+        try {
+            nativeSetBackgroundPaused(paused)
+        } catch (e: UnsatisfiedLinkError) {
+            Timber.tag(TAG).w(e, "Background QoS not supported by native library")
+        }
+    }
+    
+    /**
+     * Native handle table counters: hot swaps, unloads that waited for
+     * in-flight requests, and calls made with stale handles. Null without
+     * the native library.
+     */
+    fun getHandleStats(): HandleStats? {
+        if (!libraryLoaded) return null
+        return try {
+            HandleStats.fromArray(nativeGetHandleStats())
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+    
+    /**
+     * Latency percentiles and counters of every generate call in the process
+     * since the last reset, overall and per [Qos]. [reset] starts a new
+     * window. Null without the native library.
+     */
+    fun getPerformanceSnapshot(reset: Boolean = false): PerformanceSnapshot? {
+        if (!libraryLoaded) return null
+        return try {
+            PerformanceSnapshot.fromArray(nativeGetPerfSnapshot(reset))
+        } catch (e: UnsatisfiedLinkError) {
+            null
+        }
+    }
+    
+    /**
+     * Result of the native self-check run after the last unload or cleanup,
+     * or null without the native library.
+     */
+    fun getTeardownReport(): TeardownReport? {
+        if (!libraryLoaded) return null
+        return try {
+            TeardownReport.fromArray(nativeGetTeardownReport())
+        } catch (e: UnsatisfiedLinkError) {
+            Timber.tag(TAG).w(e, "Teardown report not supported by native library")
+            null
+        }
+    }
+    
+    /**
+     * Unload the current model.
+     */
+    suspend fun unload() = withContext(Dispatchers.IO) {
+        loadMutex.withLock {
+            val handle = mutex.withLock { modelHandle.also { modelHandle = 0 } }
+            if (handle != 0L && libraryLoaded) {
+                try {
+                    // Waits for requests still running on the model
+                    nativeUnloadModel(handle)
+                    Timber.tag(TAG).i("Model unloaded")
+                    getTeardownReport()?.takeUnless { it.isClean }?.let {
+                        Timber.tag(TAG).w("Native memory left after unload: $it")
+                    }
+                } catch (e: Exception) {
+                    Timber.tag(TAG).e(e, "Error unloading model")
+                }
+            }
+            _state.value = _state.value.copy(
+                isModelLoaded = false,
+                loadedModelPath = null,
+                memoryUsageBytes = 0
+            )
+        }
+    }
+    
+    /**
+     * Cleanup backend resources.
+     */
+    suspend fun cleanup() = withContext(Dispatchers.IO) {
+        loadMutex.withLock {
+            mutex.withLock {
+                if (modelHandle != 0L && libraryLoaded) {
+                    try {
+                        nativeUnloadModel(modelHandle)
+                    } catch (e: Exception) {
+                        Timber.tag(TAG).w(e, "Error unloading model during cleanup")
+                    }
+                    modelHandle = 0
+                }
+                if (isInitialized && libraryLoaded) {
+                    try {
+                        cleanupBackend()
+                    } catch (e: Exception) {
+                        Timber.tag(TAG).w(e, "Error cleaning up backend")
+                    }
+                    isInitialized = false
+                }
+                _state.value = LlamaEngineState()
+                Timber.tag(TAG).i("LlamaEngine cleaned up")
+            }
+        }
+    }
+    
+    /**
+     * KV cache element type. Values are ggml_type ids (see context_options.h).
+     */
+    enum class KvCacheType(val ggmlType: Int) {
+        F16(1),
+        Q8_0(8),
+        Q4_0(2)
+    }
+    
+    /**
+     * Flash attention mode. Values match llama_flash_attn_type.
+     */
+    enum class FlashAttention(val nativeValue: Int) {
+        AUTO(-1),
+        DISABLED(0),
+        ENABLED(1)
+    }
+    
+    /**
+     * llama.cpp context parameters beyond context size and thread count.
+     * 
+     * q8_0 KV roughly halves KV memory vs f16 on a 2048-token context; a quantized
+     * V cache needs flash attention. Batch sizes trade prompt throughput for
+     * compute-buffer memory and should be tuned per device.
+     * 
+     * Fields left null (threadsBatch 0) take the configuration [autotune] stored
+     * for this device and model, if any, else the defaults ([DEFAULT_BATCH_SIZE],
+     * f16 KV). Values set explicitly always win over the tuned ones.
+     */
+    data class ContextParams(
+        /** Threads for prompt processing; 0 uses the tuned or generation thread count. */
+        val threadsBatch: Int = 0,
+        val batchSize: Int? = null,
+        val ubatchSize: Int? = null,
+        val maxSequences: Int = 1,
+        val kvCacheTypeK: KvCacheType? = null,
+        val kvCacheTypeV: KvCacheType? = null,
+        val flashAttention: FlashAttention = FlashAttention.AUTO
+    ) {
+        /**
+         * @return null if valid, otherwise a description of the first invalid field
+         */
+        fun validate(contextSize: Int, threads: Int?): String? = when {
+            contextSize < MIN_CONTEXT_SIZE -> "contextSize must be >= $MIN_CONTEXT_SIZE"
+            threads != null && threads < 1 -> "threads must be >= 1"
+            threadsBatch < 0 -> "threadsBatch must be >= 0"
+            batchSize != null && batchSize < 1 -> "batchSize must be >= 1"
+            ubatchSize != null && (ubatchSize < 1 || batchSize != null && ubatchSize > batchSize) ->
+                "ubatchSize must be in 1..batchSize"
+            maxSequences !in 1..MAX_SEQUENCES -> "maxSequences must be in 1..$MAX_SEQUENCES"
+            kvCacheTypeV != null && kvCacheTypeV != KvCacheType.F16 && flashAttention == FlashAttention.DISABLED ->
+                "Quantized V cache requires flash attention"
+            else -> null
+        }
+    }
+    
+    /**
+     * Elastic context sizing: start at the load-time context size, grow to
+     * [maxContextSize] (0 = model's trained length) when a request needs more
+     * tokens, and shrink back after [idleShrinkMs] without requests (0 = never).
+     */
+    data class ElasticContext(
+        val maxContextSize: Int = 0,
+        val idleShrinkMs: Long = DEFAULT_IDLE_SHRINK_MS
+    )
+    
+    /**
+     * Context size and resize cost counters. Mirrors nativeGetContextMetrics.
+     */
+    data class ContextMetrics(
+        val contextSize: Int,
+        val minContextSize: Int,
+        val maxContextSize: Int,
+        val resizeCount: Int,
+        val totalResizeMs: Long,
+        val lastResizeMs: Long,
+        val lastRequestResizeMs: Long
+    ) {
+        companion object {
+            fun fromArray(values: LongArray): ContextMetrics = ContextMetrics(
+                contextSize = values.getOrElse(0) { 0L }.toInt(),
+                minContextSize = values.getOrElse(1) { 0L }.toInt(),
+                maxContextSize = values.getOrElse(2) { 0L }.toInt(),
+                resizeCount = values.getOrElse(3) { 0L }.toInt(),
+                totalResizeMs = values.getOrElse(4) { 0L },
+                lastResizeMs = values.getOrElse(5) { 0L },
+                lastRequestResizeMs = values.getOrElse(6) { 0L }
+            )
+        }
+    }
+    
+    /**
+     * Result of model loading operation.
+     */
+    /**
+     * Graded memory trim, cheapest to undo first. Values match TrimLevel in memory_trim.h.
+     * The engine restores itself lazily on the next request.
+     */
+    enum class TrimLevel(val nativeValue: Int) {
+        /** Drop the cached prompt prefix and shrink an elastic context to its minimum. */
+        DROP_PREFIX_CACHE(1),
+        /** Compress the live KV cache and free the context. */
+        COMPRESS_KV(2),
+        /** Free KV cache and compute buffers; weights stay mapped. */
+        RELEASE_CONTEXT(3),
+        /** Also release the model weights (shared weights stay while other engines use them). */
+        RELEASE_ALL(4);
+        
+        companion object {
+            /**
+             * Map a ComponentCallbacks2.onTrimMemory level to a trim level, or null for none.
+             */
+            fun fromTrimMemory(level: Int): TrimLevel? = when {
+                level >= TRIM_MEMORY_MODERATE -> RELEASE_ALL
+                level >= TRIM_MEMORY_BACKGROUND -> RELEASE_CONTEXT
+                level >= TRIM_MEMORY_RUNNING_LOW -> COMPRESS_KV
+                level >= TRIM_MEMORY_RUNNING_MODERATE -> DROP_PREFIX_CACHE
+                else -> null
+            }
+            
+            // ComponentCallbacks2 constants, inlined so the mapping is testable off-device
+            private const val TRIM_MEMORY_RUNNING_MODERATE = 5
+            private const val TRIM_MEMORY_RUNNING_LOW = 10
+            private const val TRIM_MEMORY_BACKGROUND = 40
+            private const val TRIM_MEMORY_MODERATE = 60
+        }
+    }
+    
+    /**
+     * Outcome of [trimMemory]. Mirrors TrimResult::Index in memory_trim.h.
+     */
+    data class TrimResult(
+        val level: Int,
+        /** Bytes released according to engine accounting. */
+        val bytesFreed: Long,
+        /** Measured drop in process RSS; may lag bytesFreed until the allocator returns pages. */
+        val rssFreedBytes: Long,
+        /** Expected extra latency on the next request to undo the trim. */
+        val restoreCostMs: Long
+    ) {
+        companion object {
+            fun fromArray(values: LongArray): TrimResult = TrimResult(
+                level = values.getOrElse(0) { 0L }.toInt(),
+                bytesFreed = values.getOrElse(1) { 0L },
+                rssFreedBytes = values.getOrElse(2) { 0L },
+                restoreCostMs = values.getOrElse(3) { 0L }
+            )
+        }
+    }
+    
+    /**
+     * Which cores inference threads may run on. Values match CpuPolicy in cpu_topology.h.
+     */
+    enum class CpuPolicy(val nativeValue: Int) {
+        /** No pinning. */
+        ALL(0),
+        /** Every cluster except the slowest; on single-cluster devices the same as [ALL]. */
+        PERFORMANCE(1),
+        /** Slowest cluster only, for background work. */
+        EFFICIENCY(2)
+    }
+    
+    /**
+     * Scheduling class of a generation. Values mirror RequestQos in thread_pool.h.
+     */
+    enum class Qos(val nativeValue: Int) {
+        INTERACTIVE(0),
+        /**
+         * Efficiency cores with fewer threads at background priority; waits
+         * between tokens while an interactive generation runs or background
+         * work is paused.
+         */
+        BACKGROUND(1)
+    }
+    
+    /**
+     * Thermal- and throughput-aware thread control for long generations.
+     * Each window of [windowTokens] tokens the engine may drop a generate
+     * thread, or add a per-token pause once at [minThreads], when decode
+     * latency degrades (thermal throttling), when the hottest thermal zone
+     * reaches [maxTempC], or when it runs faster than [targetTokensPerSec]
+     * needs. It steps back up with headroom. 0 disables a goal.
+     */
+    data class AdaptiveThreads(
+        val targetTokensPerSec: Float = 0f,
+        val maxTempC: Float = 0f,
+        val minThreads: Int = 1,
+        val windowTokens: Int = DEFAULT_THROTTLE_WINDOW,
+        val maxPauseMs: Long = DEFAULT_MAX_THROTTLE_PAUSE_MS
+    ) {
+        fun validate(): String? = when {
+            targetTokensPerSec < 0f -> "targetTokensPerSec must be >= 0"
+            maxTempC < 0f -> "maxTempC must be >= 0"
+            minThreads < 1 -> "minThreads must be >= 1"
+            windowTokens < 1 -> "windowTokens must be >= 1"
+            maxPauseMs < 0 -> "maxPauseMs must be >= 0"
+            else -> null
+        }
+    }
+    
+    /**
+     * One thread control step. Action and reason values match thread_control.h.
+     */
+    data class ThrottleDecision(
+        /** Generated-token index the step applies from. */
+        val token: Int,
+        val action: Action,
+        val reason: Reason,
+        val threads: Int,
+        val pauseMs: Long,
+        val windowUsPerToken: Long,
+        /** Hottest thermal zone in milli-degrees C; -1 when unreadable. */
+        val tempMilliC: Int
+    ) {
+        enum class Action { NONE, THREADS_DOWN, THREADS_UP, PAUSE_UP, PAUSE_DOWN }
+        enum class Reason { NONE, THERMAL, SLOWDOWN, ABOVE_TARGET, BELOW_TARGET, RECOVERED }
+    }
+    
+    /**
+     * Thread control outcome of one generation. Mirrors ThrottleReport::to_array.
+     */
+    data class ThrottleReport(
+        val finalThreads: Int,
+        val totalPauseMs: Long,
+        val lastTempMilliC: Int,
+        val decisions: List<ThrottleDecision>
+    ) {
+        companion object {
+            private const val HEADER_SIZE = 4
+            private const val DECISION_FIELDS = 7
+            
+            fun fromArray(values: LongArray): ThrottleReport {
+                val count = values.getOrElse(0) { 0L }.toInt()
+                val decisions = (0 until count).mapNotNull { i ->
+                    val base = HEADER_SIZE + i * DECISION_FIELDS
+                    if (base + DECISION_FIELDS > values.size) return@mapNotNull null
+                    ThrottleDecision(
+                        token = values[base].toInt(),
+                        action = ThrottleDecision.Action.values().getOrElse(values[base + 1].toInt()) {
+                            ThrottleDecision.Action.NONE
+                        },
+                        reason = ThrottleDecision.Reason.values().getOrElse(values[base + 2].toInt()) {
+                            ThrottleDecision.Reason.NONE
+                        },
+                        threads = values[base + 3].toInt(),
+                        pauseMs = values[base + 4],
+                        windowUsPerToken = values[base + 5],
+                        tempMilliC = values[base + 6].toInt()
+                    )
+                }
+                return ThrottleReport(
+                    finalThreads = values.getOrElse(1) { 0L }.toInt(),
+                    totalPauseMs = values.getOrElse(2) { 0L },
+                    lastTempMilliC = values.getOrElse(3) { -1L }.toInt(),
+                    decisions = decisions
+                )
+            }
+        }
+    }
+    
+    /**
+     * Candidates for [autotune]. Empty lists are derived natively from the CPU
+     * topology and the loaded context. Phases run in order, each starting from
+     * the winners of the previous ones: threads (by generation speed), prompt
+     * threads and batch sizes (by prompt speed), then KV type (by generation
+     * speed, at the loaded context size with the cache filled). Results within
+     * 3% go to the cheaper candidate, or for KV types to the more precise one.
+     */
+    data class AutotuneSpec(
+        /** Benchmark text, repeated to [promptTokens]; null uses a classification-style prompt. */
+        val prompt: String? = null,
+        val promptTokens: Int = DEFAULT_AUTOTUNE_PROMPT_TOKENS,
+        val genTokens: Int = DEFAULT_AUTOTUNE_GEN_TOKENS,
+        val threads: List<Int> = emptyList(),
+        val threadsBatch: List<Int> = emptyList(),
+        /** (batchSize, ubatchSize) pairs. */
+        val batchSizes: List<Pair<Int, Int>> = emptyList(),
+        /** Applied to both K and V. */
+        val kvCacheTypes: List<KvCacheType> = emptyList()
+    ) {
+        fun validate(): String? = when {
+            promptTokens < 1 -> "promptTokens must be >= 1"
+            genTokens < 1 -> "genTokens must be >= 1"
+            threads.any { it < 1 } || threadsBatch.any { it < 1 } -> "thread counts must be >= 1"
+            batchSizes.any { (batch, ubatch) -> ubatch < 1 || ubatch > batch } -> "ubatchSize must be in [1, batchSize]"
+            else -> null
+        }
+    }
+    
+    /**
+     * A context configuration and its measured throughput. Mirrors TunedConfig in autotune.h.
+     */
+    data class TunedConfig(
+        val threads: Int,
+        val threadsBatch: Int,
+        val batchSize: Int,
+        val ubatchSize: Int,
+        val kvCacheTypeK: KvCacheType?,
+        val kvCacheTypeV: KvCacheType?,
+        val promptTokensPerSec: Double,
+        val generationTokensPerSec: Double
+    ) {
+        companion object {
+            const val FIELDS = 8
+            
+            fun fromArray(values: LongArray, offset: Int = 0): TunedConfig {
+                fun at(i: Int) = values.getOrElse(offset + i) { 0L }
+                fun kvType(i: Int) = KvCacheType.values().firstOrNull { it.ggmlType.toLong() == at(i) }
+                return TunedConfig(
+                    threads = at(0).toInt(),
+                    threadsBatch = at(1).toInt(),
+                    batchSize = at(2).toInt(),
+                    ubatchSize = at(3).toInt(),
+                    kvCacheTypeK = kvType(4),
+                    kvCacheTypeV = kvType(5),
+                    promptTokensPerSec = at(6) / 100.0,
+                    generationTokensPerSec = at(7) / 100.0
+                )
+            }
+        }
+    }
+    
+    data class AutotuneTrial(val phase: Phase, val config: TunedConfig) {
+        /** Ordinals match AutotunePhase in autotune.h. */
+        enum class Phase { NONE, THREADS, THREADS_BATCH, BATCH, KV_CACHE }
+    }
+    
+    /**
+     * Outcome of [autotune]. Mirrors AutotuneResult::to_array.
+     */
+    data class AutotuneResult(
+        val best: TunedConfig,
+        val trials: List<AutotuneTrial>,
+        /** Whether [best] was written to the store. */
+        val saved: Boolean
+    ) {
+        companion object {
+            private const val HEADER_SIZE = 2
+            
+            fun fromArray(values: LongArray): AutotuneResult {
+                val count = values.getOrElse(0) { 0L }.toInt()
+                val trialsStart = HEADER_SIZE + TunedConfig.FIELDS
+                val trials = (0 until count).mapNotNull { i ->
+                    val base = trialsStart + i * (TunedConfig.FIELDS + 1)
+                    if (base + TunedConfig.FIELDS + 1 > values.size) return@mapNotNull null
+                    AutotuneTrial(
+                        phase = AutotuneTrial.Phase.values().getOrElse(values[base].toInt()) {
+                            AutotuneTrial.Phase.NONE
+                        },
+                        config = TunedConfig.fromArray(values, base + 1)
+                    )
+                }
+                return AutotuneResult(
+                    best = TunedConfig.fromArray(values, HEADER_SIZE),
+                    trials = trials,
+                    saved = values.getOrElse(1) { 0L } != 0L
+                )
+            }
+        }
+    }
+    
+    /**
+     * ggml CPU backend build in use. Ordinals match CpuVariant in cpu_backend.h.
+     */
+    enum class CpuVariant {
+        /** Not loaded yet, or no variant could be loaded. */
+        NONE,
+        /** Linked into the library (builds without loadable variants). */
+        STATIC,
+        ARMV8,
+        DOTPROD,
+        I8MM,
+        SVE,
+        /** x86_64 emulators and Linux hosts. */
+        X86_64,
+        AVX2,
+        AVX512
+    }
+    
+    /**
+     * The CPU backend chosen at startup. Mirrors CpuBackendInfo::to_array in cpu_backend.h.
+     */
+    data class CpuBackend(
+        val variant: CpuVariant,
+        /** CpuFeature bits of this CPU (see device_probe.h). */
+        val cpuFeatures: Int,
+        /** CpuFeature bits the variant was compiled for. */
+        val variantFeatures: Int,
+        /** Better variants that failed to load. */
+        val fallbacks: Int,
+        val loadTimeMs: Long
+    ) {
+        companion object {
+            fun fromArray(values: LongArray): CpuBackend = CpuBackend(
+                variant = CpuVariant.values().getOrElse(values.getOrElse(0) { 0L }.toInt()) { CpuVariant.NONE },
+                cpuFeatures = values.getOrElse(1) { 0L }.toInt(),
+                variantFeatures = values.getOrElse(2) { 0L }.toInt(),
+                fallbacks = values.getOrElse(3) { 0L }.toInt(),
+                loadTimeMs = values.getOrElse(4) { 0L }
+            )
+        }
+    }
+    
+    /**
+     * Outcome of a load for the repack cache. Ordinals match RepackCacheResult in repack_cache.h.
+     */
+    enum class RepackCacheResult {
+        /** Cache disabled, or no weight of the model is repacked. */
+        NONE,
+        /** Repacked weights mapped from the sidecar. */
+        HIT,
+        /** Repacked at load into a new sidecar. */
+        BUILT,
+        /** Sidecar from another ggml layout; repacked in memory and rebuilt next load. */
+        STALE,
+        /** Sidecar could not be written; repacked in memory. */
+        UNCACHED
+    }
+    
+    /**
+     * Mirrors RepackCacheStats::to_array in repack_cache.h.
+     */
+    data class RepackCacheStats(
+        val hits: Long,
+        val builds: Long,
+        val stale: Long,
+        val uncached: Long,
+        val lastResult: RepackCacheResult,
+        val lastTensors: Int,
+        val lastBytes: Long,
+        /** Repacking time of the last load; on a hit only the first tensor is repacked. */
+        val lastMs: Long
+    ) {
+        companion object {
+            fun fromArray(values: LongArray): RepackCacheStats = RepackCacheStats(
+                hits = values.getOrElse(0) { 0L },
+                builds = values.getOrElse(1) { 0L },
+                stale = values.getOrElse(2) { 0L },
+                uncached = values.getOrElse(3) { 0L },
+                lastResult = RepackCacheResult.values().getOrElse(values.getOrElse(4) { 0L }.toInt()) {
+                    RepackCacheResult.NONE
+                },
+                lastTensors = values.getOrElse(5) { 0L }.toInt(),
+                lastBytes = values.getOrElse(6) { 0L },
+                lastMs = values.getOrElse(7) { 0L }
+            )
+        }
+    }
+    
+    /**
+     * Weight types [requantize] produces. Values are ggml_type ids.
+     */
+    enum class WeightType(val ggmlType: Int) {
+        Q4_0(2);
+        
+        /** Where [requantize] writes this variant of [modelPath]: model.gguf -> model.Q4_0.gguf */
+        fun variantPath(modelPath: String): String = "${modelPath.removeSuffix(".gguf")}.$name.gguf"
+    }
+    
+    /**
+     * State of a [requantize] job. Ordinals match RequantizeState in requantize.h.
+     */
+    enum class RequantizeState {
+        IDLE,
+        RUNNING,
+        VERIFYING,
+        DONE,
+        FAILED,
+        /** Partial output kept; the same call resumes it. */
+        CANCELLED
+    }
+    
+    /**
+     * Mirrors RequantizeProgress::to_array in requantize.h.
+     */
+    data class RequantizeProgress(
+        val state: RequantizeState,
+        val tensorsDone: Int,
+        val tensorsTotal: Int,
+        val bytesDone: Long,
+        val bytesTotal: Long,
+        /** Tensors a previous, interrupted run had finished. */
+        val resumedTensors: Int,
+        /** Tensors whose type changes; the rest are copied. */
+        val convertedTensors: Int,
+        val targetType: WeightType?,
+        val elapsedMs: Long
+    ) {
+        val fraction: Float
+            get() = if (bytesTotal > 0) bytesDone.toFloat() / bytesTotal else 0f
+        
+        companion object {
+            fun fromArray(values: LongArray): RequantizeProgress {
+                val target = values.getOrElse(7) { -1L }.toInt()
+                return RequantizeProgress(
+                    state = RequantizeState.values().getOrElse(values.getOrElse(0) { 0L }.toInt()) {
+                        RequantizeState.IDLE
+                    },
+                    tensorsDone = values.getOrElse(1) { 0L }.toInt(),
+                    tensorsTotal = values.getOrElse(2) { 0L }.toInt(),
+                    bytesDone = values.getOrElse(3) { 0L },
+                    bytesTotal = values.getOrElse(4) { 0L },
+                    resumedTensors = values.getOrElse(5) { 0L }.toInt(),
+                    convertedTensors = values.getOrElse(6) { 0L }.toInt(),
+                    targetType = WeightType.values().firstOrNull { it.ggmlType == target },
+                    elapsedMs = values.getOrElse(8) { 0L }
+                )
+            }
+        }
+    }
+    
+    /**
+     * State of a [sha256File] hash. Ordinals match HashState in sha256.h.
+     */
+    enum class HashState {
+        IDLE,
+        RUNNING,
+        DONE,
+        FAILED,
+        CANCELLED
+    }
+    
+    /**
+     * SHA-256 implementation a hash ran on. Ordinals match Sha256Kernel in sha256.h.
+     */
+    enum class Sha256Kernel {
+        PORTABLE,
+        /** ARMv8 SHA2 extension */
+        ARMV8,
+        /** x86 SHA-NI */
+        SHANI
+    }
+    
+    /**
+     * Mirrors FileHashProgress::to_array in sha256.h.
+     */
+    data class FileHashProgress(
+        val state: HashState,
+        val bytesDone: Long,
+        val bytesTotal: Long,
+        val kernel: Sha256Kernel,
+        /** Read-ahead threads. */
+        val readers: Int,
+        val elapsedMs: Long
+    ) {
+        val fraction: Float
+            get() = if (bytesTotal > 0) bytesDone.toFloat() / bytesTotal else 0f
+        
+        /** Hashing throughput in MB/s, 0 before the first chunk. */
+        val megabytesPerSecond: Float
+            get() = if (elapsedMs > 0) bytesDone / 1_000f / elapsedMs else 0f
+        
+        companion object {
+            fun fromArray(values: LongArray): FileHashProgress = FileHashProgress(
+                state = HashState.values().getOrElse(values.getOrElse(0) { 0L }.toInt()) { HashState.IDLE },
+                bytesDone = values.getOrElse(1) { 0L },
+                bytesTotal = values.getOrElse(2) { 0L },
+                kernel = Sha256Kernel.values().getOrElse(values.getOrElse(3) { 0L }.toInt()) {
+                    Sha256Kernel.PORTABLE
+                },
+                readers = values.getOrElse(4) { 0L }.toInt(),
+                elapsedMs = values.getOrElse(5) { 0L }
+            )
+        }
+    }
+    
+    /**
+     * CPU cores grouped into clusters of equal capacity, fastest cluster first.
+     * Mirrors CpuTopology::to_array in cpu_topology.h.
+     */
+    data class CpuTopology(val cores: List<Core>) {
+        data class Core(val id: Int, val cluster: Int, val capacity: Long, val maxFreqKhz: Long)
+        
+        val clusterCount: Int
+            get() = cores.maxOfOrNull { it.cluster + 1 } ?: 0
+        
+        /** Core ids [policy] allows; empty means unrestricted. */
+        fun cpusFor(policy: CpuPolicy): List<Int> {
+            if (clusterCount < 2) return emptyList()
+            return when (policy) {
+                CpuPolicy.ALL -> emptyList()
+                CpuPolicy.PERFORMANCE -> cores.filter { it.cluster < clusterCount - 1 }.map { it.id }
+                CpuPolicy.EFFICIENCY -> cores.filter { it.cluster == clusterCount - 1 }.map { it.id }
+            }
+        }
+        
+        /** One thread per allowed core. */
+        fun recommendedThreads(policy: CpuPolicy): Int =
+            cpusFor(policy).size.takeIf { it > 0 } ?: cores.size
+        
+        companion object {
+            private const val HEADER_SIZE = 2
+            private const val CORE_FIELDS = 4
+            
+            fun fromArray(values: LongArray): CpuTopology {
+                val count = values.getOrElse(0) { 0L }.toInt()
+                val cores = (0 until count).mapNotNull { i ->
+                    val base = HEADER_SIZE + i * CORE_FIELDS
+                    if (base + CORE_FIELDS > values.size) return@mapNotNull null
+                    Core(
+                        id = values[base].toInt(),
+                        cluster = values[base + 1].toInt(),
+                        capacity = values[base + 2],
+                        maxFreqKhz = values[base + 3]
+                    )
+                }
+                return CpuTopology(cores)
+            }
+        }
+    }
+    
+    /**
+     * Threadpool shared by every loaded context. Thread counts of 0 size the
+     * pools to the largest context and [cpuPolicy] pins them. [poll] (0..100) is how long idle workers
+     * spin before sleeping between decodes; pools are parked between requests.
+     */
+    data class ThreadPoolConfig(
+        val threads: Int = 0,
+        /** Prompt-phase pool size; 0 = same as [threads]. */
+        val threadsBatch: Int = 0,
+        val poll: Int = DEFAULT_THREADPOOL_POLL,
+        /** Use a separate pool for prompt processing when its size differs. */
+        val separateBatchPool: Boolean = true,
+        val cpuPolicy: CpuPolicy = CpuPolicy.PERFORMANCE
+    ) {
+        fun validate(): String? = when {
+            threads < 0 -> "threads must be >= 0"
+            threadsBatch < 0 -> "threadsBatch must be >= 0"
+            poll !in 0..100 -> "poll must be in 0..100"
+            else -> null
+        }
+    }
+    
+    /**
+     * Shared threadpool counters. Mirrors ThreadPoolStats::Index in thread_pool.h.
+     */
+    data class ThreadPoolStats(
+        val threads: Int,
+        /** 0 when prompts share the generate pool. */
+        val threadsBatch: Int,
+        val poll: Int,
+        val attachedContexts: Int,
+        val decodes: Long,
+        /** Decodes that waited for another context to finish its step. */
+        val contendedDecodes: Long,
+        val waitMs: Long,
+        val cpuPolicy: Int,
+        /** Cores the pools are pinned to; 0 = unpinned. */
+        val pinnedCpus: Int,
+        /** Background pool size; 0 until the first background generation. */
+        val backgroundThreads: Int = 0,
+        val backgroundDecodes: Long = 0,
+        /** Time background decodes waited for interactive work or a pause. */
+        val backgroundYieldMs: Long = 0,
+        val backgroundPaused: Boolean = false
+    ) {
+        companion object {
+            fun fromArray(values: LongArray): ThreadPoolStats = ThreadPoolStats(
+                threads = values.getOrElse(0) { 0L }.toInt(),
+                threadsBatch = values.getOrElse(1) { 0L }.toInt(),
+                poll = values.getOrElse(2) { 0L }.toInt(),
+                attachedContexts = values.getOrElse(3) { 0L }.toInt(),
+                decodes = values.getOrElse(4) { 0L },
+                contendedDecodes = values.getOrElse(5) { 0L },
+                waitMs = values.getOrElse(6) { 0L },
+                cpuPolicy = values.getOrElse(7) { 0L }.toInt(),
+                pinnedCpus = values.getOrElse(8) { 0L }.toInt(),
+                backgroundThreads = values.getOrElse(9) { 0L }.toInt(),
+                backgroundDecodes = values.getOrElse(10) { 0L },
+                backgroundYieldMs = values.getOrElse(11) { 0L },
+                backgroundPaused = values.getOrElse(12) { 0L } != 0L
+            )
+        }
+    }
+    
+    /**
+     * Post-unload self-check. Mirrors TeardownReport::Index in teardown.h.
+     * 
+     * Weights still held by the model registry (shared with another engine or
+     * cached within the model cache budget) are expected and reported in
+     * [registryBytes]; [modelMappedBytes] and [extraThreads] are leftovers.
+     */
+    data class TeardownReport(
+        /** Unloaded model file still mapped although nothing references it. */
+        val modelMappedBytes: Long,
+        val registryBytes: Long,
+        val liveEngines: Int,
+        val anonFreedBytes: Long,
+        /** RSS returned to the kernel by trimming the native heap. */
+        val heapTrimmedBytes: Long,
+        /** Anonymous memory above the pre-load baseline; includes Java heap growth. */
+        val residualAnonBytes: Long,
+        /** Threads above the pre-load baseline. */
+        val extraThreads: Int
+    ) {
+        /** True when nothing native outlives the unload except what the registry keeps on purpose. */
+        val isClean: Boolean
+            get() = modelMappedBytes == 0L && (liveEngines > 0 || extraThreads <= 0)
+        
+        companion object {
+            fun fromArray(values: LongArray): TeardownReport = TeardownReport(
+                modelMappedBytes = values.getOrElse(0) { 0L },
+                registryBytes = values.getOrElse(1) { 0L },
+                liveEngines = values.getOrElse(2) { 0L }.toInt(),
+                anonFreedBytes = values.getOrElse(3) { 0L },
+                heapTrimmedBytes = values.getOrElse(4) { 0L },
+                residualAnonBytes = values.getOrElse(5) { 0L },
+                extraThreads = values.getOrElse(6) { 0L }.toInt()
+            )
+        }
+    }
+    
+    data class LoadResult(
+        val success: Boolean,
+        val loadTimeMs: Long,
+        val memoryBytes: Long,
+        val isStub: Boolean,
+        val error: String?,
+        val contextSize: Int = 0,
+        val memoryBreakdown: MemoryBreakdown? = null,
+        /** The model replaced a loaded one without unloading it first. */
+        val swapped: Boolean = false,
+        val warmUpMs: Long = 0
+    )
+    
+    /**
+     * Percentiles of one native latency histogram, in its metric's unit.
+     * Mirrors LatencySummary::Index in perf_metrics.h. Percentiles are the
+     * top of a histogram bucket, within 6.25% of the exact value.
+     */
+    data class LatencySummary(
+        val samples: Long,
+        val min: Long,
+        val max: Long,
+        val mean: Long,
+        val p50: Long,
+        val p90: Long,
+        val p95: Long,
+        val p99: Long
+    ) {
+        companion object {
+            const val FIELDS = 8
+            
+            fun fromArray(values: LongArray, offset: Int = 0): LatencySummary = LatencySummary(
+                samples = values.getOrElse(offset) { 0L },
+                min = values.getOrElse(offset + 1) { 0L },
+                max = values.getOrElse(offset + 2) { 0L },
+                mean = values.getOrElse(offset + 3) { 0L },
+                p50 = values.getOrElse(offset + 4) { 0L },
+                p90 = values.getOrElse(offset + 5) { 0L },
+                p95 = values.getOrElse(offset + 6) { 0L },
+                p99 = values.getOrElse(offset + 7) { 0L }
+            )
+        }
+    }
+    
+    /**
+     * Generate latency distributions and counters of one request class.
+     * Mirrors a PerfMetrics row in perf_metrics.h; "submit" is when generate
+     * was called, before waiting for the engine.
+     */
+    data class RequestMetrics(
+        /** Submit to the first generated token, µs. */
+        val timeToFirstTokenUs: LatencySummary,
+        /** Uncached prompt tokens per second of prompt evaluation. */
+        val promptTokensPerSecond: LatencySummary,
+        /** Sample + decode time of each generated token, µs. */
+        val tokenUs: LatencySummary,
+        /** Submit to the engine starting the request, µs. */
+        val queueWaitUs: LatencySummary,
+        /** Submit to the output being ready, µs. */
+        val endToEndUs: LatencySummary,
+        val requests: Long,
+        /** Requests that reused part of their prompt from the KV cache. */
+        val cacheHits: Long,
+        /** Calls cancelled before the engine ran them. */
+        val cancelled: Long,
+        val failed: Long
+    ) {
+        companion object {
+            private const val HISTOGRAMS = 5
+            const val FIELDS = HISTOGRAMS * LatencySummary.FIELDS + 4
+            
+            fun fromArray(values: LongArray, offset: Int = 0): RequestMetrics {
+                val counters = offset + HISTOGRAMS * LatencySummary.FIELDS
+                return RequestMetrics(
+                    timeToFirstTokenUs = LatencySummary.fromArray(values, offset),
+                    promptTokensPerSecond = LatencySummary.fromArray(values, offset + LatencySummary.FIELDS),
+                    tokenUs = LatencySummary.fromArray(values, offset + 2 * LatencySummary.FIELDS),
+                    queueWaitUs = LatencySummary.fromArray(values, offset + 3 * LatencySummary.FIELDS),
+                    endToEndUs = LatencySummary.fromArray(values, offset + 4 * LatencySummary.FIELDS),
+                    requests = values.getOrElse(counters) { 0L },
+                    cacheHits = values.getOrElse(counters + 1) { 0L },
+                    cancelled = values.getOrElse(counters + 2) { 0L },
+                    failed = values.getOrElse(counters + 3) { 0L }
+                )
+            }
+        }
+    }
+    
+    /**
+     * Process-wide generate metrics since the last reset, from
+     * [getPerformanceSnapshot]. Rows match PerfMetrics::Row in perf_metrics.h.
+     */
+    data class PerformanceSnapshot(
+        val all: RequestMetrics,
+        val interactive: RequestMetrics,
+        val background: RequestMetrics
+    ) {
+        fun forQos(qos: Qos): RequestMetrics = if (qos == Qos.BACKGROUND) background else interactive
+        
+        companion object {
+            fun fromArray(values: LongArray): PerformanceSnapshot = PerformanceSnapshot(
+                all = RequestMetrics.fromArray(values, 0),
+                interactive = RequestMetrics.fromArray(values, RequestMetrics.FIELDS),
+                background = RequestMetrics.fromArray(values, 2 * RequestMetrics.FIELDS)
+            )
+        }
+    }
+    
+    /**
+     * Mirrors HandleStats::to_array in engine_handles.h.
+     */
+    data class HandleStats(
+        /** Native engines loaded, including a replacement that is warming up. */
+        val live: Int,
+        val swaps: Long,
+        /** Calls made with a handle that had already been unloaded. */
+        val staleLookups: Long,
+        /** Unloads that waited for in-flight requests. */
+        val drained: Long,
+        val lastDrainMs: Long
+    ) {
+        companion object {
+            fun fromArray(values: LongArray): HandleStats = HandleStats(
+                live = values.getOrElse(0) { 0L }.toInt(),
+                swaps = values.getOrElse(1) { 0L },
+                staleLookups = values.getOrElse(2) { 0L },
+                drained = values.getOrElse(3) { 0L },
+                lastDrainMs = values.getOrElse(4) { 0L }
+            )
+        }
+    }
+    
+    /**
+     * Native memory counters. Mirrors MemoryBreakdown::Index in memory_stats.h.
+     */
+    data class MemoryBreakdown(
+        val weightsMappedBytes: Long,
+        val weightsResidentBytes: Long,
+        val kvCacheBytes: Long,
+        val computeBufferBytes: Long,
+        val processRssBytes: Long,
+        val processPssBytes: Long,
+        val processAnonymousBytes: Long
+    ) {
+        /** Memory attributable to the engine: resident weights + KV cache + compute buffers. */
+        val engineBytes: Long
+            get() = weightsResidentBytes + kvCacheBytes + computeBufferBytes
+        
+        companion object {
+            fun fromArray(values: LongArray): MemoryBreakdown = MemoryBreakdown(
+                weightsMappedBytes = values.getOrElse(0) { 0L },
+                weightsResidentBytes = values.getOrElse(1) { 0L },
+                kvCacheBytes = values.getOrElse(2) { 0L },
+                computeBufferBytes = values.getOrElse(3) { 0L },
+                processRssBytes = values.getOrElse(4) { 0L },
+                processPssBytes = values.getOrElse(5) { 0L },
+                processAnonymousBytes = values.getOrElse(6) { 0L }
+            )
+        }
+    }
+    
+    /**
+     * Why generation stopped. Ordinals match StopReason in generate_stats.h.
+     */
+    enum class StopReason {
+        /** No request ran (the model was unloaded) */
+        NONE,
+        END_OF_GENERATION,
+        MAX_TOKENS,
+        /** The context could not grow to fit maxTokens */
+        CONTEXT_FULL,
+        /** The output buffer is full */
+        OUTPUT_FULL,
+        /** Decode failed mid-generation; the output so far is returned */
+        DECODE_ERROR,
+        /** Failed before the first token */
+        ERROR,
+        /** The model was unloaded or replaced while this background request yielded; output so far is kept */
+        ENGINE_CHANGED
+    }
+    
+    /**
+     * Phases and counts of one request, returned with its output. Mirrors
+     * GenerateStats::Index in generate_stats.h.
+     */
+    data class GenerationStats(
+        val stopReason: StopReason,
+        val promptTokens: Int,
+        /** Prompt tokens reused from the previous request's KV cache. */
+        val cachedPromptTokens: Int,
+        val generatedTokens: Int,
+        val tokenizeUs: Long,
+        val promptEvalUs: Long,
+        /** Request start to the first generated token. */
+        val timeToFirstTokenUs: Long,
+        /** End of prompt evaluation to the last decode. */
+        val generationUs: Long,
+        val totalUs: Long,
+        /** Sample + decode time per generated token. */
+        val tokenMinUs: Long,
+        val tokenP50Us: Long,
+        val tokenP90Us: Long,
+        val tokenMaxUs: Long,
+        val contextSize: Int,
+        val contextResizeMs: Long,
+        /** Ops timed by the compute profiler; 0 when the request was not sampled. */
+        val profiledNodes: Long = 0
+    ) {
+        /** Generation speed, excluding tokenization and prompt evaluation. */
+        val tokensPerSecond: Double
+            get() = if (generationUs > 0) generatedTokens * 1_000_000.0 / generationUs else 0.0
+        
+        /** Prompt evaluation speed over the tokens not reused from the cache. */
+        val promptTokensPerSecond: Double
+            get() = if (promptEvalUs > 0) (promptTokens - cachedPromptTokens) * 1_000_000.0 / promptEvalUs else 0.0
+        
+        companion object {
+            const val FIELDS = 16
+            
+            fun fromArray(values: LongArray): GenerationStats = GenerationStats(
+                stopReason = StopReason.values().getOrElse(values.getOrElse(0) { 0L }.toInt()) { StopReason.NONE },
+                promptTokens = values.getOrElse(1) { 0L }.toInt(),
+                cachedPromptTokens = values.getOrElse(2) { 0L }.toInt(),
+                generatedTokens = values.getOrElse(3) { 0L }.toInt(),
+                tokenizeUs = values.getOrElse(4) { 0L },
+                promptEvalUs = values.getOrElse(5) { 0L },
+                timeToFirstTokenUs = values.getOrElse(6) { 0L },
+                generationUs = values.getOrElse(7) { 0L },
+                totalUs = values.getOrElse(8) { 0L },
+                tokenMinUs = values.getOrElse(9) { 0L },
+                tokenP50Us = values.getOrElse(10) { 0L },
+                tokenP90Us = values.getOrElse(11) { 0L },
+                tokenMaxUs = values.getOrElse(12) { 0L },
+                contextSize = values.getOrElse(13) { 0L }.toInt(),
+                contextResizeMs = values.getOrElse(14) { 0L },
+                profiledNodes = values.getOrElse(15) { 0L }
+            )
+        }
+    }
+    
+    /** Time spent in one op, weight type, output shape and layer of a profiled request. */
+    data class OpTiming(
+        /** ggml op (MUL_MAT, ROPE, SOFT_MAX...), unary op name, or SAMPLE for token sampling. */
+        val op: String,
+        /** Type of the op's first source, e.g. the weight type of a MUL_MAT. */
+        val type: String,
+        /** Output shape; the second dimension is the batch (1 for generated tokens). */
+        val shape: String,
+        /** Transformer layer, or -1 outside the layers. */
+        val layer: Int,
+        val count: Long,
+        val totalUs: Long,
+        val maxUs: Long
+    )
+    
+    /**
+     * Per-op profile of one generation, slowest entries first. Parsed from
+     * ComputeProfiler::report in compute_profiler.h.
+     */
+    data class ComputeProfile(val entries: List<OpTiming>) {
+        val totalUs: Long
+            get() = entries.sumOf { it.totalUs }
+        
+        /** Total time per op, slowest first. */
+        fun byOp(): List<Pair<String, Long>> = entries
+            .groupBy { if (it.type.isEmpty()) it.op else "${it.op} ${it.type}" }
+            .map { (op, timings) -> op to timings.sumOf { it.totalUs } }
+            .sortedByDescending { it.second }
+        
+        /** Total time per layer, in layer order; -1 holds ops outside the layers. */
+        fun byLayer(): List<Pair<Int, Long>> = entries
+            .groupBy { it.layer }
+            .map { (layer, timings) -> layer to timings.sumOf { it.totalUs } }
+            .sortedBy { it.first }
+        
+        companion object {
+            fun parse(report: String): ComputeProfile = ComputeProfile(
+                report.lineSequence().mapNotNull { line ->
+                    val fields = line.split('\t')
+                    if (fields.size < 7) return@mapNotNull null
+                    OpTiming(
+                        op = fields[0],
+                        type = fields[1],
+                        shape = fields[2],
+                        layer = fields[3].toIntOrNull() ?: -1,
+                        count = fields[4].toLongOrNull() ?: 0L,
+                        totalUs = fields[5].toLongOrNull() ?: 0L,
+                        maxUs = fields[6].toLongOrNull() ?: 0L
+                    )
+                }.toList()
+            )
+        }
+    }
     
     /**
      * Result of text generation operation.
@@ -404,8 +2377,22 @@ class LlamaEngine @Inject constructor(
         val text: String,
         val inferenceTimeMs: Long,
         val tokensGenerated: Int,
+        /** Generation speed; see [GenerationStats.tokensPerSecond]. */
         val tokensPerSecond: Double,
-        val error: String?
+        val error: String?,
+        val contextSize: Int = 0,
+        /** Time this request spent growing the context before decoding. */
+        val contextResizeMs: Long = 0,
+        /** Adaptive thread control steps taken during this request, if any. */
+        val throttle: ThrottleReport? = null,
+        /** UTF-8 bytes written to the output buffer (buffer generate only). */
+        val outputBytes: Int = 0,
+        /** Generated token IDs (token generate only). */
+        val tokens: IntArray? = null,
+        /** Per-phase timings and stop reason; null when no request ran. */
+        val stats: GenerationStats? = null,
+        /** Per-op timing when this request was sampled by [configureProfiler]. */
+        val profile: ComputeProfile? = null
     )
 }
 
@@ -420,6 +2407,7 @@ data class LlamaEngineState(
     val loadedModelPath: String? = null,
     val loadTimeMs: Long = 0,
     val memoryUsageBytes: Long = 0,
+    val memoryBreakdown: LlamaEngine.MemoryBreakdown? = null,
     val lastInferenceTimeMs: Long = 0,
     val lastTokensGenerated: Int = 0,
     val error: String? = null
@@ -0,0 +1,39 @@
+package com.prio.core.aiprovider.llm
+
+import com.prio.core.ai.registry.FileHasher
+import com.prio.core.ai.registry.StreamingFileHasher
+import timber.log.Timber
+import java.io.File
+import javax.inject.Inject
+import javax.inject.Singleton
+
+/**
+ * [FileHasher] on the native SHA-256 ([LlamaEngine.sha256File]): ARMv8 SHA2
+ * or x86 SHA-NI instructions with read-ahead threads, at roughly storage
+ * speed. Falls back to [StreamingFileHasher] without the native library or
+ * when the native hash fails.
+ */
+@Singleton
+class NativeFileHasher @Inject constructor(
+    private val llamaEngine: LlamaEngine,
+    private val streamingFileHasher: StreamingFileHasher
+) : FileHasher {
+    
+    companion object {
+        private const val TAG = "NativeFileHasher"
+    }
+    
+    override suspend fun sha256(file: File, onProgress: (Float) -> Unit): String? {
+        llamaEngine.sha256File(file.absolutePath) { onProgress(it.fraction) }?.let { return it }
+        
+        val progress = llamaEngine.getFileHashProgress()
+        if (progress?.state == LlamaEngine.HashState.CANCELLED) return null
+        Timber.tag(TAG).w("Native SHA-256 unavailable (${progress?.state}), streaming ${file.name}")
+        return streamingFileHasher.sha256(file, onProgress)
+    }
+    
+    override fun cancel() {
+        llamaEngine.cancelFileHash()
+        streamingFileHasher.cancel()
+    }
+}
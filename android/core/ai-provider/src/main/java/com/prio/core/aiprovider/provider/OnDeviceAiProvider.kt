@@ -1,6 +1,7 @@
 package com.prio.core.aiprovider.provider
 
 import com.prio.core.ai.model.AiContext
+import com.prio.core.ai.model.AiQos
 import com.prio.core.ai.model.AiRequest
 import com.prio.core.ai.model.AiRequestType
 import com.prio.core.ai.model.AiResponse
@@ -127,7 +128,15 @@ class OnDeviceAiProvider @Inject constructor(
             return@withContext false
         }
         
-        currentModelDefinition = PredefinedModels.ALL.find { it.id == modelId }
+        val definition = PredefinedModels.ALL.find { it.id == modelId }
+        if (definition != null && definition.architecture.isNotEmpty() &&
+            llamaEngine.isArchitectureBuiltIn(definition.architecture) == false
+        ) {
+            Timber.tag(TAG).e("Model $modelId (${definition.architecture}) is not built into the native library")
+            return@withContext false
+        }
+        
+        currentModelDefinition = definition
         val result = llamaEngine.loadModel(modelPath)
         _isAvailable.value = result.success && !result.isStub
         
@@ -191,7 +200,8 @@ class OnDeviceAiProvider @Inject constructor(
             prompt = prompt,
             maxTokens = request.options.maxTokens,
             temperature = request.options.temperature,
-            topP = request.options.topP
+            topP = request.options.topP,
+            qos = request.options.qos.toEngineQos()
         )
         
         if (result.error != null) {
@@ -304,7 +314,8 @@ Output JSON: {"title": "...", "due_date": "YYYY-MM-DD or null", "due_time": "HH:
         val result = llamaEngine.generate(
             prompt = prompt,
             maxTokens = request.options.maxTokens,
-            temperature = request.options.temperature
+            temperature = request.options.temperature,
+            qos = request.options.qos.toEngineQos()
         )
         
         if (result.error != null) {
@@ -346,7 +357,8 @@ Be concise and actionable. Focus on priorities."""
         val result = llamaEngine.generate(
             prompt = prompt,
             maxTokens = request.options.maxTokens,
-            temperature = 0.7f // Slightly higher for creative briefings
+            temperature = 0.7f, // Slightly higher for creative briefings
+            qos = request.options.qos.toEngineQos()
         )
         
         if (result.error != null) {
@@ -393,7 +405,8 @@ Only output the JSON object, nothing else."""
         val result = llamaEngine.generate(
             prompt = prompt,
             maxTokens = request.options.maxTokens,
-            temperature = request.options.temperature
+            temperature = request.options.temperature,
+            qos = request.options.qos.toEngineQos()
         )
 
         if (result.error != null) {
@@ -469,7 +482,8 @@ Only output the JSON object, nothing else."""
         val result = llamaEngine.generate(
             prompt = prompt,
             maxTokens = request.options.maxTokens,
-            temperature = request.options.temperature
+            temperature = request.options.temperature,
+            qos = request.options.qos.toEngineQos()
         )
         
         return AiResponse(
@@ -529,10 +543,22 @@ Only output the JSON object, nothing else."""
     
     override suspend fun estimateCost(request: AiRequest): Float? = null // On-device is free
     
+    /**
+     * llama.cpp generate latency percentiles and counters since the last
+     * reset, or null without the native library. [reset] starts a new window.
+     */
+    fun getPerformanceSnapshot(reset: Boolean = false): LlamaEngine.PerformanceSnapshot? =
+        llamaEngine.getPerformanceSnapshot(reset)
+    
     override suspend fun release() {
         llamaEngine.unload()
         _isAvailable.value = false
         currentModelDefinition = null
         Timber.tag(TAG).i("OnDeviceAiProvider released")
     }
+    
+    private fun AiQos.toEngineQos(): LlamaEngine.Qos = when (this) {
+        AiQos.INTERACTIVE -> LlamaEngine.Qos.INTERACTIVE
+        AiQos.BACKGROUND -> LlamaEngine.Qos.BACKGROUND
+    }
 }
@@ -9,6 +9,7 @@ import com.prio.core.ai.model.AiStreamChunk
 import com.prio.core.ai.provider.AiCapability
 import com.prio.core.ai.provider.AiProvider
 import com.prio.core.ai.provider.ModelInfo
+import com.prio.core.aiprovider.llm.LlamaEngine
 import com.prio.core.aiprovider.nano.GeminiNanoProvider
 import com.prio.core.aiprovider.provider.OnDeviceAiProvider
 import com.prio.core.aiprovider.provider.RuleBasedFallbackProvider
@@ -122,7 +123,12 @@ class AiProviderRouter @Inject constructor(
         val llmFailed: Long = 0,
         val overrides: Long = 0,
         val averageRuleBasedLatencyMs: Long = 0,
-        val averageLlmLatencyMs: Long = 0
+        val averageLlmLatencyMs: Long = 0,
+        /**
+         * On-device LLM latency percentiles (TTFT, ms/token, end to end) and
+         * counters since the last [resetStats]; null until an LLM request ran.
+         */
+        val llmMetrics: LlamaEngine.RequestMetrics? = null
     )
     
     private val _stats = MutableStateFlow(RoutingStats())
@@ -601,7 +607,12 @@ class AiProviderRouter @Inject constructor(
             totalRequests = _stats.value.totalRequests + 1,
             ruleBasedOnly = _stats.value.ruleBasedOnly + if (ruleBasedOnly) 1 else 0,
             llmEscalated = _stats.value.llmEscalated + if (llmEscalated) 1 else 0,
-            llmFailed = _stats.value.llmFailed + if (llmFailed) 1 else 0
+            llmFailed = _stats.value.llmFailed + if (llmFailed) 1 else 0,
+            llmMetrics = if (llmEscalated || llmFailed) {
+                onDeviceProvider.getPerformanceSnapshot()?.all ?: _stats.value.llmMetrics
+            } else {
+                _stats.value.llmMetrics
+            }
         )
     }
     
@@ -656,6 +667,7 @@ class AiProviderRouter @Inject constructor(
     fun resetStats() {
         _stats.value = RoutingStats()
         overrideHistory.clear()
+        onDeviceProvider.getPerformanceSnapshot(reset = true)
     }
     
     // ========================================================================
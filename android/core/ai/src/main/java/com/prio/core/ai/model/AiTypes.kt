@@ -46,6 +46,20 @@ enum class AiRequestType {
     GENERAL_CHAT
 }
 
+/**
+ * Scheduling class of a request. Background requests (worker-initiated
+ * briefing prefetch, recurring-task and nudge work) run on-device with fewer
+ * threads at low priority and yield to interactive requests.
+ */
+@Serializable
+enum class AiQos {
+    @SerialName("interactive")
+    INTERACTIVE,
+    
+    @SerialName("background")
+    BACKGROUND
+}
+
 /**
  * Unified AI request format used across all providers.
  * Designed to be serializable for both local and network use.
@@ -144,7 +158,11 @@ data class AiRequestOptions(
     
     /** Minimum confidence threshold for classification */
     @SerialName("min_confidence")
-    val minConfidence: Float = 0.7f
+    val minConfidence: Float = 0.7f,
+    
+    /** Scheduling class; BACKGROUND for work no user is waiting on */
+    @SerialName("qos")
+    val qos: AiQos = AiQos.INTERACTIVE
 )
 
 /**
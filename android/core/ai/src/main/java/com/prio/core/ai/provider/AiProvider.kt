@@ -172,7 +172,14 @@ data class ModelDefinition(
     val recommendedForTasks: Set<AiTaskType> = emptySet(),
     val description: String = "",
     val minRamGb: Int = 4,
-    val promptTemplate: PromptTemplate = PromptTemplate.CHATML
+    val promptTemplate: PromptTemplate = PromptTemplate.CHATML,
+    /** Number of weights; 0 if unknown. Drives prompt throughput predictions. */
+    val parameterCount: Long = 0,
+    /**
+     * GGUF general.architecture, e.g. "phi3"; empty for non-GGUF models. The
+     * native library compiles in only the architectures the catalog uses.
+     */
+    val architecture: String = ""
 )
 
 /**
@@ -233,7 +240,9 @@ object PredefinedModels {
         recommendedForTasks = setOf(AiTaskType.CLASSIFY_EISENHOWER, AiTaskType.PARSE_TASK),
         description = "Fast on-device AI (2.3 GB). 2-3s inference on modern devices.",
         minRamGb = 4,
-        promptTemplate = PromptTemplate.PHI3
+        promptTemplate = PromptTemplate.PHI3,
+        parameterCount = 3_820_000_000L,
+        architecture = "phi3"
     )
     
     val MISTRAL_7B = ModelDefinition(
@@ -248,7 +257,9 @@ object PredefinedModels {
         recommendedForTasks = setOf(AiTaskType.CLASSIFY_EISENHOWER, AiTaskType.GENERATE_BRIEFING),
         description = "Higher accuracy (4.1 GB). 80% Eisenhower accuracy but 45-60s inference.",
         minRamGb = 6,
-        promptTemplate = PromptTemplate.MISTRAL
+        promptTemplate = PromptTemplate.MISTRAL,
+        parameterCount = 7_240_000_000L,
+        architecture = "llama"
     )
     
     val GEMMA_2B = ModelDefinition(
@@ -263,7 +274,9 @@ object PredefinedModels {
         recommendedForTasks = setOf(AiTaskType.CLASSIFY_EISENHOWER),
         description = "Smaller model (1.7 GB). Good for devices with less RAM.",
         minRamGb = 3,
-        promptTemplate = PromptTemplate.GEMMA
+        promptTemplate = PromptTemplate.GEMMA,
+        parameterCount = 2_610_000_000L,
+        architecture = "gemma2"
     )
     
     val RULE_BASED = ModelDefinition(
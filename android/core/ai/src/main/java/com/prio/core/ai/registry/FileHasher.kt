@@ -0,0 +1,65 @@
+package com.prio.core.ai.registry
+
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
+import java.io.File
+import java.security.MessageDigest
+import javax.inject.Inject
+import javax.inject.Singleton
+
+/**
+ * SHA-256 of downloaded model files, for [ModelDownloadManager] verification.
+ * 
+ * core:ai-provider binds a native implementation that uses the CPU's SHA
+ * instructions; [StreamingFileHasher] is the portable fallback.
+ */
+interface FileHasher {
+    /**
+     * Lowercase hex SHA-256 of [file].
+     * 
+     * @param onProgress Fraction hashed (0.0 to 1.0)
+     * @return The digest, or null if [cancel] stopped it
+     * @throws java.io.IOException if the file cannot be read
+     */
+    suspend fun sha256(file: File, onProgress: (Float) -> Unit = {}): String?
+    
+    /**
+     * Stop the running [sha256].
+     */
+    fun cancel()
+}
+
+/**
+ * [FileHasher] on a buffered stream and the JVM's MessageDigest.
+ */
+@Singleton
+class StreamingFileHasher @Inject constructor() : FileHasher {
+    companion object {
+        private const val BUFFER_SIZE = 1 shl 20
+    }
+    
+    @Volatile
+    private var isCancelled = false
+    
+    override suspend fun sha256(file: File, onProgress: (Float) -> Unit): String? = withContext(Dispatchers.IO) {
+        isCancelled = false
+        val digest = MessageDigest.getInstance("SHA-256")
+        val totalBytes = file.length()
+        var hashedBytes = 0L
+        file.inputStream().use { input ->
+            val buffer = ByteArray(BUFFER_SIZE)
+            var bytesRead: Int
+            while (input.read(buffer).also { bytesRead = it } != -1) {
+                if (isCancelled) return@withContext null
+                digest.update(buffer, 0, bytesRead)
+                hashedBytes += bytesRead
+                if (totalBytes > 0) onProgress(hashedBytes.toFloat() / totalBytes)
+            }
+        }
+        digest.digest().joinToString("") { "%02x".format(it) }
+    }
+    
+    override fun cancel() {
+        isCancelled = true
+    }
+}
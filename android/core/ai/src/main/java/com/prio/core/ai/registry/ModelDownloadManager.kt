@@ -18,7 +18,6 @@ import java.io.IOException
 import java.io.RandomAccessFile
 import java.net.HttpURLConnection
 import java.net.URL
-import java.security.MessageDigest
 import javax.inject.Inject
 import javax.inject.Singleton
 
@@ -27,7 +26,8 @@ import javax.inject.Singleton
  * 
  * Based on ACTION_PLAN.md Milestone 2.2.4:
  * - Downloads model with progress tracking
- * - SHA-256 verification after download
+ * - SHA-256 verification after download ([FileHasher]; native and
+ *   hardware-accelerated when core:ai-provider is present)
  * - Resume on failure (range requests)
  * - Atomic file operations (temp file → final file)
  * 
@@ -39,7 +39,8 @@ import javax.inject.Singleton
 @Singleton
 class ModelDownloadManager @Inject constructor(
     @ApplicationContext private val context: Context,
-    private val modelRegistry: ModelRegistry
+    private val modelRegistry: ModelRegistry,
+    private val fileHasher: FileHasher
 ) {
     companion object {
         private const val BUFFER_SIZE = 8192
@@ -57,7 +58,7 @@ class ModelDownloadManager @Inject constructor(
             val downloadedBytes: Long,
             val totalBytes: Long
         ) : DownloadState()
-        data class Verifying(val modelId: String) : DownloadState()
+        data class Verifying(val modelId: String, val progress: Float = 0f) : DownloadState()
         data class Completed(val modelId: String) : DownloadState()
         data class Failed(val modelId: String, val error: String) : DownloadState()
         data class Cancelled(val modelId: String) : DownloadState()
@@ -169,7 +170,9 @@ class ModelDownloadManager @Inject constructor(
             Timber.d("Verifying SHA-256 for: $modelId")
             
             if (definition.sha256.isNotEmpty()) {
-                val actualHash = calculateSha256(tempFile)
+                val actualHash = fileHasher.sha256(tempFile) { progress ->
+                    _downloadState.value = DownloadState.Verifying(modelId, progress)
+                } ?: throw CancellationException("Verification cancelled")
                 if (!actualHash.equals(definition.sha256, ignoreCase = true)) {
                     tempFile.delete()
                     throw IOException("SHA-256 verification failed. Expected: ${definition.sha256}, Got: $actualHash")
@@ -215,6 +218,7 @@ class ModelDownloadManager @Inject constructor(
     fun cancelDownload() {
         Timber.d("Cancelling download for: $currentDownloadId")
         isCancelled = true
+        fileHasher.cancel()
     }
     
     /**
@@ -334,24 +338,6 @@ class ModelDownloadManager @Inject constructor(
         }
     }
     
-    /**
-     * Calculate SHA-256 hash of a file.
-     */
-    private fun calculateSha256(file: File): String {
-        Timber.d("Calculating SHA-256 for: ${file.name}")
-        
-        val digest = MessageDigest.getInstance("SHA-256")
-        file.inputStream().use { input ->
-            val buffer = ByteArray(BUFFER_SIZE)
-            var bytesRead: Int
-            while (input.read(buffer).also { bytesRead = it } != -1) {
-                digest.update(buffer, 0, bytesRead)
-            }
-        }
-        
-        return digest.digest().joinToString("") { "%02x".format(it) }
-    }
-    
     /**
      * Format bytes to human-readable string.
      */
@@ -250,6 +250,41 @@ class ModelRegistry @Inject constructor(
         return PredefinedModels.RULE_BASED
     }
     
+    /**
+     * Predicted prompt and generation throughput of each catalog model on a
+     * probed device, fastest generation first.
+     */
+    fun predictThroughput(capabilities: DeviceCapabilities): List<ThroughputPrediction> =
+        ThroughputPredictor.predictAll(modelCatalog, capabilities)
+    
+    /**
+     * Get models predicted to meet [slo] on a probed device. Unlike
+     * [getModelsForDeviceTier] this accounts for memory bandwidth and compute,
+     * not just RAM.
+     */
+    fun getServableModels(
+        capabilities: DeviceCapabilities,
+        slo: LatencySlo = LatencySlo()
+    ): List<ModelDefinition> = ThroughputPredictor.servableModels(modelCatalog, capabilities, slo)
+    
+    /**
+     * Get the recommended model for a probed device.
+     * 
+     * @param capabilities Result of the native device probe
+     * @param slo Latency the model must meet
+     * @return Best downloaded model predicted to meet [slo], or rule-based
+     */
+    fun getRecommendedModel(capabilities: DeviceCapabilities, slo: LatencySlo = LatencySlo()): ModelDefinition {
+        val suitable = getServableModels(capabilities, slo).filter { isModelDownloaded(it.id) }
+        
+        // Same preference as the RAM-tier recommendation
+        suitable.find { it.id == PredefinedModels.PHI3_MINI_4K.id }?.let { return it }
+        suitable.firstOrNull()?.let { return it }
+        
+        Timber.d("No downloaded model meets $slo on this device")
+        return PredefinedModels.RULE_BASED
+    }
+    
     /**
      * Get storage space used by downloaded models.
      */
@@ -0,0 +1,148 @@
+package com.prio.core.ai.registry
+
+import com.prio.core.ai.provider.ModelDefinition
+
+/**
+ * Measured capabilities of this device, from the native probe
+ * (DeviceProbe::to_array in device_probe.h).
+ */
+data class DeviceCapabilities(
+    /** Sustained multi-threaded read bandwidth. */
+    val memoryBandwidthMbps: Long,
+    /** int8 multiply-accumulate throughput, in million ops/s across [threads]. */
+    val int8Mops: Long,
+    /** fp16 FMA throughput in million flops/s; fp32 when [hasFp16] is false. */
+    val fp16Mflops: Long,
+    /** [Feature] bits. */
+    val features: Int,
+    val threads: Int,
+    val totalMemoryBytes: Long,
+    val availableMemoryBytes: Long,
+    val probeMs: Long,
+    /** Core count per cluster, fastest first. */
+    val clusterCores: List<Int>
+) {
+    /** Bits mirror CpuFeature in device_probe.h. */
+    enum class Feature(val bit: Int) {
+        DOTPROD(1 shl 0),
+        I8MM(1 shl 1),
+        FP16(1 shl 2),
+        SVE(1 shl 3),
+        AVX2(1 shl 4),
+        AVX512(1 shl 5),
+        SHA2(1 shl 6)
+    }
+    
+    fun has(feature: Feature): Boolean = (features and feature.bit) != 0
+    
+    val hasFp16: Boolean
+        get() = has(Feature.FP16)
+    
+    companion object {
+        private const val HEADER_SIZE = 9
+        
+        fun fromArray(values: LongArray): DeviceCapabilities {
+            val clusters = values.getOrElse(8) { 0L }.toInt()
+            return DeviceCapabilities(
+                memoryBandwidthMbps = values.getOrElse(0) { 0L },
+                int8Mops = values.getOrElse(1) { 0L },
+                fp16Mflops = values.getOrElse(2) { 0L },
+                features = values.getOrElse(3) { 0L }.toInt(),
+                threads = values.getOrElse(4) { 0L }.toInt(),
+                totalMemoryBytes = values.getOrElse(5) { 0L },
+                availableMemoryBytes = values.getOrElse(6) { 0L },
+                probeMs = values.getOrElse(7) { 0L },
+                clusterCores = (0 until clusters).mapNotNull { values.getOrNull(HEADER_SIZE + it)?.toInt() }
+            )
+        }
+    }
+}
+
+/**
+ * Latency a model must meet to be recommended. The defaults fit an
+ * interactive classification: a few hundred prompt tokens answered within
+ * seconds, with streamed output faster than it is read.
+ */
+data class LatencySlo(
+    /** Prompt length the time-to-first-token target applies to. */
+    val promptTokens: Int = 256,
+    val maxTimeToFirstTokenMs: Long = 5_000L,
+    val minGenerationTokensPerSec: Double = 4.0
+)
+
+/**
+ * Predicted throughput of [model] on a probed device.
+ */
+data class ThroughputPrediction(
+    val model: ModelDefinition,
+    val promptTokensPerSec: Double,
+    val generationTokensPerSec: Double,
+    /** Whether the weights plus runtime overhead fit in available memory. */
+    val fitsInMemory: Boolean
+) {
+    fun timeToFirstTokenMs(promptTokens: Int): Long =
+        if (promptTokensPerSec > 0) (promptTokens * 1000.0 / promptTokensPerSec).toLong() else Long.MAX_VALUE
+    
+    fun meets(slo: LatencySlo): Boolean =
+        fitsInMemory &&
+            timeToFirstTokenMs(slo.promptTokens) <= slo.maxTimeToFirstTokenMs &&
+            generationTokensPerSec >= slo.minGenerationTokensPerSec
+}
+
+/**
+ * First-order throughput model for quantized GGUF models on CPU.
+ *
+ * Generation reads every weight once per token, so it is bound by memory
+ * bandwidth: tokens/s ~ bandwidth / model size. Prompt processing runs the
+ * weights as int8 dot products over the whole batch, so it is bound by
+ * compute: tokens/s ~ int8 ops/s / (2 * parameters). The efficiency factors
+ * cover what the probe kernels do not (dequantization, attention, scheduling);
+ * they are deliberately conservative, and the autotuner measures the real
+ * figures once a model is loaded.
+ */
+object ThroughputPredictor {
+    /** Share of probed bandwidth generation achieves. */
+    const val BANDWIDTH_EFFICIENCY = 0.75
+    
+    /** Share of probed int8 throughput prompt processing achieves. */
+    const val COMPUTE_EFFICIENCY = 0.4
+    
+    /** KV cache, compute buffers and runtime on top of the weights. */
+    const val MEMORY_OVERHEAD = 1.2
+    
+    /** Bits per weight assumed when a model has no [ModelDefinition.parameterCount] (Q4_K_M). */
+    private const val DEFAULT_BITS_PER_WEIGHT = 4.8
+    
+    fun predict(model: ModelDefinition, device: DeviceCapabilities): ThroughputPrediction {
+        val parameters = model.parameterCount.takeIf { it > 0 }
+            ?: (model.sizeBytes * 8 / DEFAULT_BITS_PER_WEIGHT).toLong()
+        if (model.sizeBytes <= 0 || parameters <= 0) {
+            return ThroughputPrediction(model, 0.0, 0.0, fitsInMemory = false)
+        }
+        
+        val opsPerToken = 2.0 * parameters
+        val computeTokensPerSec = device.int8Mops * 1e6 * COMPUTE_EFFICIENCY / opsPerToken
+        val bandwidthTokensPerSec = device.memoryBandwidthMbps * 1e6 * BANDWIDTH_EFFICIENCY / model.sizeBytes
+        
+        val available = device.availableMemoryBytes.takeIf { it > 0 } ?: device.totalMemoryBytes
+        return ThroughputPrediction(
+            model = model,
+            promptTokensPerSec = computeTokensPerSec,
+            generationTokensPerSec = minOf(bandwidthTokensPerSec, computeTokensPerSec),
+            fitsInMemory = model.sizeBytes * MEMORY_OVERHEAD <= available
+        )
+    }
+    
+    /** Predictions for the downloadable models in [catalog], fastest generation first. */
+    fun predictAll(catalog: List<ModelDefinition>, device: DeviceCapabilities): List<ThroughputPrediction> =
+        catalog.filter { it.fileName.isNotEmpty() }
+            .map { predict(it, device) }
+            .sortedByDescending { it.generationTokensPerSec }
+    
+    /** Models in [catalog] predicted to meet [slo] on [device]. */
+    fun servableModels(
+        catalog: List<ModelDefinition>,
+        device: DeviceCapabilities,
+        slo: LatencySlo
+    ): List<ModelDefinition> = predictAll(catalog, device).filter { it.meets(slo) }.map { it.model }
+}
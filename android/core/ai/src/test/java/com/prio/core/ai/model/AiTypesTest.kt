@@ -278,6 +278,15 @@ class AiTypesTest {
             assertTrue(jsonString.contains("\"stop_sequences\""))
         }
         
+        @Test
+        fun `AiRequestOptions qos defaults to interactive and round-trips`() {
+            assertEquals(AiQos.INTERACTIVE, AiRequestOptions().qos)
+            
+            val jsonString = json.encodeToString(AiRequestOptions(qos = AiQos.BACKGROUND))
+            assertTrue(jsonString.contains("\"qos\": \"background\""))
+            assertEquals(AiQos.BACKGROUND, json.decodeFromString<AiRequestOptions>(jsonString).qos)
+        }
+        
         @Test
         fun `AiResponseMetadata serializes correctly`() {
             val metadata = AiResponseMetadata(
@@ -88,6 +88,17 @@ class ModelRegistryTest {
         fun `Default model is Phi-3 Mini`() {
             assertEquals(PredefinedModels.PHI3_MINI_4K, PredefinedModels.DEFAULT)
         }
+        
+        @Test
+        fun `Every GGUF model uses a built-in architecture`() {
+            // Must stay in sync with LLAMA_MODEL_ARCHS in the native CMakeLists.txt
+            val builtIn = setOf("llama", "phi3", "gemma", "gemma2", "gemma3")
+            
+            for (model in PredefinedModels.ALL.filter { it.fileName.isNotEmpty() }) {
+                assertTrue(model.architecture in builtIn, "${model.id} uses ${model.architecture}")
+            }
+            assertEquals("", PredefinedModels.RULE_BASED.architecture)
+        }
     }
     
     @Nested
@@ -0,0 +1,46 @@
+package com.prio.core.ai.registry
+
+import kotlinx.coroutines.test.runTest
+import org.junit.jupiter.api.Assertions.*
+import org.junit.jupiter.api.Test
+import org.junit.jupiter.api.io.TempDir
+import java.io.File
+
+/**
+ * Unit tests for the portable SHA-256 used to verify model downloads.
+ */
+class StreamingFileHasherTest {
+    
+    @TempDir
+    lateinit var dir: File
+    
+    private val hasher = StreamingFileHasher()
+    
+    @Test
+    fun `matches known digests`() = runTest {
+        val empty = File(dir, "empty.bin").apply { writeBytes(ByteArray(0)) }
+        val abc = File(dir, "abc.bin").apply { writeText("abc") }
+        
+        assertEquals("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", hasher.sha256(empty))
+        assertEquals("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", hasher.sha256(abc))
+    }
+    
+    @Test
+    fun `reports progress up to completion`() = runTest {
+        val file = File(dir, "model.bin").apply { writeBytes(ByteArray(3 * (1 shl 20) + 17)) }
+        val progress = mutableListOf<Float>()
+        
+        assertNotNull(hasher.sha256(file) { progress.add(it) })
+        assertEquals(4, progress.size)
+        assertEquals(1f, progress.last(), 0f)
+        assertEquals(progress.sorted(), progress)
+    }
+    
+    @Test
+    fun `cancel stops the hash`() = runTest {
+        val file = File(dir, "model.bin").apply { writeBytes(ByteArray(3 * (1 shl 20))) }
+        
+        assertNull(hasher.sha256(file) { hasher.cancel() })
+        assertNotNull(hasher.sha256(file))
+    }
+}
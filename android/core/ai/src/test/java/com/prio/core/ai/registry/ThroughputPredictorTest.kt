@@ -0,0 +1,129 @@
+package com.prio.core.ai.registry
+
+import com.prio.core.ai.provider.PredefinedModels
+import org.junit.jupiter.api.Assertions.*
+import org.junit.jupiter.api.Nested
+import org.junit.jupiter.api.Test
+
+/**
+ * Unit tests for DeviceCapabilities parsing and ThroughputPredictor.
+ */
+class ThroughputPredictorTest {
+    
+    /** Flagship-class: 40 GB/s, 4 dotprod cores, 12 GB RAM. */
+    private val flagship = DeviceCapabilities(
+        memoryBandwidthMbps = 40_000,
+        int8Mops = 1_200_000,
+        fp16Mflops = 200_000,
+        features = DeviceCapabilities.Feature.DOTPROD.bit or DeviceCapabilities.Feature.FP16.bit,
+        threads = 4,
+        totalMemoryBytes = 12_000_000_000L,
+        availableMemoryBytes = 7_000_000_000L,
+        probeMs = 500,
+        clusterCores = listOf(1, 3, 4)
+    )
+    
+    /** Budget: 8 GB/s, no dotprod, 4 GB RAM. */
+    private val budget = DeviceCapabilities(
+        memoryBandwidthMbps = 8_000,
+        int8Mops = 60_000,
+        fp16Mflops = 20_000,
+        features = 0,
+        threads = 4,
+        totalMemoryBytes = 4_000_000_000L,
+        availableMemoryBytes = 2_000_000_000L,
+        probeMs = 700,
+        clusterCores = listOf(4, 4)
+    )
+    
+    @Nested
+    inner class DeviceCapabilitiesTests {
+        
+        @Test
+        fun `fromArray reads header and clusters`() {
+            val caps = DeviceCapabilities.fromArray(
+                longArrayOf(40_000, 1_200_000, 200_000, 5, 4, 12_000_000_000L, 7_000_000_000L, 500, 3, 1, 3, 4)
+            )
+            
+            assertEquals(flagship, caps)
+            assertTrue(caps.has(DeviceCapabilities.Feature.DOTPROD))
+            assertFalse(caps.has(DeviceCapabilities.Feature.I8MM))
+            assertTrue(caps.hasFp16)
+        }
+        
+        @Test
+        fun `fromArray tolerates truncated arrays`() {
+            val caps = DeviceCapabilities.fromArray(longArrayOf(1_000, 2_000, 0, 0, 0, 0, 0, 0, 2, 4))
+            
+            assertEquals(1_000, caps.memoryBandwidthMbps)
+            assertEquals(listOf(4), caps.clusterCores)
+            assertEquals(emptyList<Int>(), DeviceCapabilities.fromArray(LongArray(0)).clusterCores)
+        }
+    }
+    
+    @Nested
+    inner class PredictionTests {
+        
+        @Test
+        fun `Generation scales with bandwidth over model size`() {
+            val phi3 = ThroughputPredictor.predict(PredefinedModels.PHI3_MINI_4K, flagship)
+            val mistral = ThroughputPredictor.predict(PredefinedModels.MISTRAL_7B, flagship)
+            
+            assertEquals(40e9 * ThroughputPredictor.BANDWIDTH_EFFICIENCY / 2.3e9, phi3.generationTokensPerSec, 0.01)
+            assertTrue(mistral.generationTokensPerSec < phi3.generationTokensPerSec)
+        }
+        
+        @Test
+        fun `Prompt throughput scales with int8 compute over parameters`() {
+            val phi3 = ThroughputPredictor.predict(PredefinedModels.PHI3_MINI_4K, flagship)
+            val expected = 1200e9 * ThroughputPredictor.COMPUTE_EFFICIENCY / (2 * 3.82e9)
+            
+            assertEquals(expected, phi3.promptTokensPerSec, 0.01)
+            assertEquals((256 * 1000 / expected).toLong(), phi3.timeToFirstTokenMs(256))
+        }
+        
+        @Test
+        fun `Model larger than available memory does not fit`() {
+            assertFalse(ThroughputPredictor.predict(PredefinedModels.MISTRAL_7B, budget).fitsInMemory)
+            assertTrue(ThroughputPredictor.predict(PredefinedModels.MISTRAL_7B, flagship).fitsInMemory)
+        }
+        
+        @Test
+        fun `Rule-based model is not predicted`() {
+            val predictions = ThroughputPredictor.predictAll(PredefinedModels.ALL, flagship)
+            
+            assertEquals(3, predictions.size)
+            assertTrue(predictions.none { it.model.id == PredefinedModels.RULE_BASED.id })
+            assertEquals(PredefinedModels.GEMMA_2B.id, predictions.first().model.id)
+        }
+    }
+    
+    @Nested
+    inner class SloTests {
+        
+        @Test
+        fun `Flagship serves small models but Mistral misses time to first token`() {
+            val servable = ThroughputPredictor.servableModels(PredefinedModels.ALL, flagship, LatencySlo())
+            
+            assertEquals(
+                listOf(PredefinedModels.GEMMA_2B.id, PredefinedModels.PHI3_MINI_4K.id),
+                servable.map { it.id }
+            )
+        }
+        
+        @Test
+        fun `Budget device serves no model within default SLO`() {
+            val servable = ThroughputPredictor.servableModels(PredefinedModels.ALL, budget, LatencySlo())
+            
+            assertTrue(servable.isEmpty())
+        }
+        
+        @Test
+        fun `Tighter SLO excludes slower models`() {
+            val slo = LatencySlo(minGenerationTokensPerSec = 15.0)
+            val servable = ThroughputPredictor.servableModels(PredefinedModels.ALL, flagship, slo)
+            
+            assertEquals(listOf(PredefinedModels.GEMMA_2B.id), servable.map { it.id })
+        }
+    }
+}
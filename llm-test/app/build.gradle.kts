@@ -27,7 +27,10 @@ android {
             cmake {
                 arguments += listOf(
                     "-DANDROID_STL=c++_shared",
-                    "-DCMAKE_BUILD_TYPE=Release"
+                    "-DCMAKE_BUILD_TYPE=Release",
+                    // -Pllama.pgo=generate builds the instrumented library pgo_train.sh
+                    // trains; -Pllama.pgo=use compiles with src/main/cpp/pgo/<abi>.profdata
+                    "-DLLAMA_PGO=${(project.findProperty("llama.pgo") as String?)?.uppercase() ?: "OFF"}"
                 )
                 // Note: Do NOT use -ffast-math here - llama.cpp requires finite math
                 cppFlags += listOf(
@@ -0,0 +1,85 @@
+package app.prio.llmtest
+
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import androidx.test.platform.app.InstrumentationRegistry
+import app.prio.llmtest.benchmark.ExtendedTestDataset
+import app.prio.llmtest.engine.EisenhowerClassifier
+import app.prio.llmtest.engine.LlamaEngine
+import kotlinx.coroutines.runBlocking
+import org.junit.Assert.*
+import org.junit.Assume.assumeTrue
+import org.junit.Test
+import org.junit.runner.RunWith
+import java.io.File
+
+/**
+ * PGO training workload for the native library.
+ *
+ * Runs what production runs - Eisenhower classification of the 50-task
+ * dataset and a few daily briefings - on an instrumented build, then writes
+ * the profiles for pgo_train.sh to merge. Skipped on regular builds.
+ *
+ * Usage: ./pgo_train.sh (builds with -Pllama.pgo=generate and runs this test)
+ */
+@RunWith(AndroidJUnit4::class)
+class PgoTrainingTest {
+
+    companion object {
+        private const val TAG = "PgoTraining"
+
+        /** Profiles are written here; pgo_train.sh pulls them with run-as. */
+        const val PROFILE_DIR = "pgo"
+
+        private val BRIEFING_TASKS = listOf(
+            "Submit quarterly tax filing (due today)",
+            "Prepare slides for Thursday board meeting",
+            "Reply to recruiter email",
+            "Book dentist appointment",
+            "Review pull request from Alex",
+            "Plan weekend hiking trip",
+            "Renew car insurance (expires in 3 days)"
+        )
+
+        private val BRIEFING_PROMPTS = listOf(
+            "Write a short morning briefing for these tasks. Start with what must happen today, " +
+                "then what can wait:\n" + BRIEFING_TASKS.joinToString("\n") { "- $it" },
+            "Summarize the day ahead in three sentences. Tasks:\n" +
+                BRIEFING_TASKS.take(4).joinToString("\n") { "- $it" },
+            "Write an evening review: which of these tasks should move to tomorrow, and why?\n" +
+                BRIEFING_TASKS.drop(2).joinToString("\n") { "- $it" }
+        )
+
+        private const val BRIEFING_MAX_TOKENS = 160
+    }
+
+    @Test
+    fun trainProfile() = runBlocking {
+        val context = InstrumentationRegistry.getInstrumentation().targetContext
+        val engine = LlamaEngine(context)
+        try {
+            engine.initialize()
+            val profile = engine.getNativeBuildProfile()
+            assumeTrue("Not an instrumented build ($profile)", profile.contains("pgo-instrumented"))
+
+            val modelFile = File(context.filesDir, "model.gguf")
+            assumeTrue("Model not found at ${modelFile.absolutePath}", modelFile.exists())
+            val load = engine.loadModel(modelFile.absolutePath, contextSize = 2048)
+            assertTrue("Model load failed: ${load.error}", load.success)
+
+            val classifier = EisenhowerClassifier(engine)
+            for (case in ExtendedTestDataset.TEST_CASES_50) {
+                classifier.classify(case.task)
+            }
+            for (prompt in BRIEFING_PROMPTS) {
+                val result = engine.generate("<|user|>\n$prompt<|end|>\n<|assistant|>\n", maxTokens = BRIEFING_MAX_TOKENS)
+                assertNull("Briefing failed: ${result.error}", result.error)
+            }
+
+            val written = engine.writePgoProfiles(File(context.filesDir, PROFILE_DIR))
+            android.util.Log.i(TAG, "Wrote $written profiles ($profile)")
+            assertTrue("No profiles written", written > 0)
+        } finally {
+            engine.cleanup()
+        }
+    }
+}
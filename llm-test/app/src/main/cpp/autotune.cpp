@@ -0,0 +1,463 @@
+/**
+ * Jeeves LLM Test Project - Per-device inference autotuner
+ */
+
+#include "autotune.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+#include "cpu_topology.h"
+#include "llama_log.h"
+
+namespace {
+
+struct AutotuneStore {
+    std::mutex mutex;
+    std::string path;
+    std::string device;
+};
+
+AutotuneStore& store() {
+    static AutotuneStore s;
+    return s;
+}
+
+// Keys are one line of a tab-separated file
+std::string sanitize(std::string value) {
+    for (char& c : value) {
+        if (c == '\t' || c == '\n' || c == '\r') c = ' ';
+    }
+    return value;
+}
+
+std::vector<std::string> read_lines(const std::string& path) {
+    std::vector<std::string> lines;
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) return lines;
+    char buf[1024];
+    while (fgets(buf, sizeof(buf), f)) {
+        size_t len = strlen(buf);
+        while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == '\r')) buf[--len] = '\0';
+        if (len > 0) lines.emplace_back(buf);
+    }
+    fclose(f);
+    return lines;
+}
+
+bool parse_line(const std::string& line, std::string& key, TunedConfig& config) {
+    size_t tab = line.find('\t');
+    if (tab == std::string::npos) return false;
+    key = line.substr(0, tab);
+    return sscanf(line.c_str() + tab + 1, "%d %d %d %d %d %d %lf %lf",
+                  &config.n_threads, &config.n_threads_batch, &config.n_batch, &config.n_ubatch,
+                  &config.type_k, &config.type_v, &config.prompt_tps, &config.gen_tps) == 8;
+}
+
+} // namespace
+
+// ============================================================================
+// Configurations
+// ============================================================================
+
+void TunedConfig::apply(ContextOptions& options) const {
+    if (options.n_threads == 0 && n_threads > 0) options.n_threads = n_threads;
+    if (options.n_threads_batch == 0 && n_threads_batch > 0) options.n_threads_batch = n_threads_batch;
+    // Batch sizes and KV types are tuned as pairs, so only replace both
+    if (options.n_batch == 0 && options.n_ubatch == 0 && n_batch > 0 && n_ubatch > 0 && n_ubatch <= n_batch) {
+        options.n_batch = n_batch;
+        options.n_ubatch = n_ubatch;
+    }
+    // A quantized V cache needs the flash attention the caller may have disabled
+    if (options.type_k == 0 && options.type_v == 0
+        && (type_v == KV_CACHE_F16 || options.flash_attn != FLASH_ATTN_DISABLED)) {
+        options.type_k = type_k;
+        options.type_v = type_v;
+    }
+}
+
+void TunedConfig::append_to(std::vector<long long>& out) const {
+    out.push_back(n_threads);
+    out.push_back(n_threads_batch);
+    out.push_back(n_batch);
+    out.push_back(n_ubatch);
+    out.push_back(type_k);
+    out.push_back(type_v);
+    out.push_back(static_cast<long long>(prompt_tps * 100.0));
+    out.push_back(static_cast<long long>(gen_tps * 100.0));
+}
+
+bool AutotuneSpec::valid() const {
+    if (prompt_tokens < 1 || gen_tokens < 1) return false;
+    for (int t : threads) if (t < 1) return false;
+    for (int t : threads_batch) if (t < 1) return false;
+    for (const auto& b : batch_sizes) if (b.first < 1 || b.second < 1 || b.second > b.first) return false;
+    for (int t : kv_types) if (t != KV_CACHE_F16 && t != KV_CACHE_Q8_0 && t != KV_CACHE_Q4_0) return false;
+    return true;
+}
+
+std::vector<long long> AutotuneResult::to_array() const {
+    std::vector<long long> out;
+    out.reserve(2 + TunedConfig::FIELDS * (1 + trials.size()) + trials.size());
+    out.push_back(static_cast<long long>(trials.size()));
+    out.push_back(saved ? 1 : 0);
+    best.append_to(out);
+    for (const auto& trial : trials) {
+        out.push_back(trial.first);
+        trial.second.append_to(out);
+    }
+    return out;
+}
+
+// ============================================================================
+// Store
+// ============================================================================
+
+void configure_autotune_store(const std::string& path, const std::string& device) {
+    AutotuneStore& s = store();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.path = path;
+    s.device = sanitize(device);
+    LOGI("Autotune store: %s", path.empty() ? "disabled" : path.c_str());
+}
+
+bool autotune_store_configured() {
+    AutotuneStore& s = store();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return !s.path.empty();
+}
+
+std::string autotune_key(const std::string& model_desc, long long model_bytes) {
+    AutotuneStore& s = store();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return sanitize(s.device + "|" + model_desc + "|" + std::to_string(model_bytes));
+}
+
+bool load_tuned_config(const std::string& key, TunedConfig& out) {
+    AutotuneStore& s = store();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.path.empty()) return false;
+    for (const std::string& line : read_lines(s.path)) {
+        std::string line_key;
+        TunedConfig config;
+        if (parse_line(line, line_key, config) && line_key == key) {
+            out = config;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool save_tuned_config(const std::string& key, const TunedConfig& config) {
+    AutotuneStore& s = store();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.path.empty()) return false;
+
+    std::vector<std::string> lines;
+    for (const std::string& line : read_lines(s.path)) {
+        std::string line_key;
+        TunedConfig existing;
+        if (parse_line(line, line_key, existing) && line_key != key) lines.push_back(line);
+    }
+    char values[160];
+    snprintf(values, sizeof(values), "\t%d %d %d %d %d %d %.2f %.2f",
+             config.n_threads, config.n_threads_batch, config.n_batch, config.n_ubatch,
+             config.type_k, config.type_v, config.prompt_tps, config.gen_tps);
+    lines.push_back(sanitize(key) + values);
+
+    // A crash mid-write must not lose the other devices' and models' entries
+    const std::string tmp = s.path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "w");
+    if (!f) {
+        LOGE("Autotune store: cannot write %s", tmp.c_str());
+        return false;
+    }
+    bool ok = true;
+    for (const std::string& line : lines) ok = ok && fprintf(f, "%s\n", line.c_str()) > 0;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), s.path.c_str()) != 0) {
+        LOGE("Autotune store: failed to update %s", s.path.c_str());
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+#if LLAMA_AVAILABLE
+
+#include "cpu_backend.h"
+#include "thread_pool.h"
+
+namespace {
+
+ggml_threadpool* trial_pool(int n_threads, const std::vector<int>& cpus) {
+    ggml_threadpool_params params = ggml_threadpool_params_default(n_threads);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < GGML_MAX_N_THREADS) params.cpumask[cpu] = true;
+    }
+    params.strict_cpu = false;
+    return cpu_threadpool_new(&params);
+}
+
+void fill_batch(llama_batch& batch, const std::vector<llama_token>& tokens, int start, int n, bool logits_last) {
+    for (int i = 0; i < n; i++) {
+        batch.token[i] = tokens[start + i];
+        batch.pos[i] = start + i;
+        batch.n_seq_id[i] = 1;
+        batch.seq_id[i][0] = 0;
+        batch.logits[i] = logits_last && i == n - 1;
+    }
+    batch.n_tokens = n;
+}
+
+/** Context size that holds [n_prompt] tokens plus generation. */
+int trial_context(int n_prompt, int gen_tokens) {
+    return std::max(64, n_prompt + gen_tokens + 16);
+}
+
+/**
+ * Prompt and generation tokens/s of [options] on a fresh context of
+ * options.n_ctx. Generation feeds a fixed token instead of sampling, which
+ * leaves decode cost unchanged. Decodes take turns with every other context
+ * on the shared compute lock, and only their own compute time counts.
+ */
+bool measure(llama_model* model, ContextOptions options, const std::vector<llama_token>& prompt,
+             int gen_tokens, const std::vector<int>& cpus, TunedConfig& out) {
+    const int n_prompt = static_cast<int>(prompt.size());
+    options.n_ctx = std::max(options.n_ctx, trial_context(n_prompt, gen_tokens));
+    options.n_seq_max = 1;
+    llama_context_params params = llama_context_default_params();
+    options.apply(params);
+
+    llama_context* ctx = llama_init_from_model(model, params);
+    if (!ctx) return false;
+
+    ggml_threadpool* pool = trial_pool(params.n_threads, cpus);
+    ggml_threadpool* batch_pool = params.n_threads_batch != params.n_threads
+        ? trial_pool(params.n_threads_batch, cpus) : nullptr;
+    if (pool) llama_attach_threadpool(ctx, pool, batch_pool ? batch_pool : pool);
+
+    SharedThreadPools& pools = SharedThreadPools::instance();
+    bool ok = true;
+    double compute_s = 0.0;
+    llama_batch batch = llama_batch_init(static_cast<int32_t>(params.n_batch), 0, 1);
+    llama_memory_t mem = llama_get_memory(ctx);
+
+    // Warm-up: the first graph allocates buffers and faults in weights
+    fill_batch(batch, prompt, 0, std::min(8, n_prompt), true);
+    ok = pools.decode_exclusive(ctx, batch, compute_s) == 0;
+    llama_memory_clear(mem, true);
+
+    double prompt_s = 0.0;
+    const int n_batch = static_cast<int>(params.n_batch);
+    for (int chunk = 0; ok && chunk < n_prompt; chunk += n_batch) {
+        int n = std::min(n_batch, n_prompt - chunk);
+        fill_batch(batch, prompt, chunk, n, chunk + n == n_prompt);
+        ok = pools.decode_exclusive(ctx, batch, compute_s) == 0;
+        prompt_s += compute_s;
+    }
+
+    double gen_s = 0.0;
+    for (int i = 0; ok && i < gen_tokens; i++) {
+        batch.token[0] = prompt.back();
+        batch.pos[0] = n_prompt + i;
+        batch.n_seq_id[0] = 1;
+        batch.seq_id[0][0] = 0;
+        batch.logits[0] = true;
+        batch.n_tokens = 1;
+        ok = pools.decode_exclusive(ctx, batch, compute_s) == 0;
+        gen_s += compute_s;
+    }
+
+    llama_batch_free(batch);
+    llama_free(ctx);
+    if (batch_pool) cpu_threadpool_free(batch_pool);
+    if (pool) cpu_threadpool_free(pool);
+    if (!ok) return false;
+
+    out.n_threads = static_cast<int>(params.n_threads);
+    out.n_threads_batch = static_cast<int>(params.n_threads_batch);
+    out.n_batch = static_cast<int>(params.n_batch);
+    out.n_ubatch = static_cast<int>(params.n_ubatch);
+    out.type_k = options.type_k;
+    out.type_v = options.type_v;
+    out.prompt_tps = prompt_s > 0.0 ? n_prompt / prompt_s : 0.0;
+    out.gen_tps = gen_s > 0.0 ? gen_tokens / gen_s : 0.0;
+    return true;
+}
+
+/**
+ * Index of the first measurement within the tie tolerance of the best (see
+ * complete_spec for the order), or -1 if none succeeded.
+ */
+int pick(const std::vector<TunedConfig>& measured, bool by_prompt) {
+    double best = 0.0;
+    for (const TunedConfig& m : measured) best = std::max(best, by_prompt ? m.prompt_tps : m.gen_tps);
+    if (best <= 0.0) return -1;
+    for (size_t i = 0; i < measured.size(); i++) {
+        double tps = by_prompt ? measured[i].prompt_tps : measured[i].gen_tps;
+        if (tps >= best * (1.0 - AUTOTUNE_TIE_TOLERANCE)) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+template <typename T>
+void sort_unique(std::vector<T>& values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+}
+
+// Fill empty candidate lists and order them so ties go to the first entry:
+// cheapest first, except KV types, most precise first
+void complete_spec(AutotuneSpec& spec, const ContextOptions& base) {
+    const CpuTopology& topology = system_cpu_topology();
+    const int n_cores = std::max(1, static_cast<int>(topology.cores.size()));
+    if (spec.threads.empty()) {
+        for (int t = std::min(2, n_cores); t <= n_cores; t++) spec.threads.push_back(t);
+        spec.threads.push_back(base.n_threads);
+    }
+    if (spec.threads_batch.empty()) {
+        spec.threads_batch = {topology.recommended_threads(CPU_POLICY_PERFORMANCE), n_cores,
+                              base.n_threads_batch > 0 ? base.n_threads_batch : base.n_threads};
+    }
+    if (spec.batch_sizes.empty()) {
+        spec.batch_sizes = {{128, 128}, {256, 128}, {256, 256}, {512, 256}, {512, 512},
+                            {base.n_batch, base.n_ubatch}};
+    }
+    if (spec.kv_types.empty()) {
+        spec.kv_types = {KV_CACHE_F16};
+        if (base.flash_attn != FLASH_ATTN_DISABLED) spec.kv_types.push_back(KV_CACHE_Q8_0);
+    }
+    sort_unique(spec.threads);
+    sort_unique(spec.threads_batch);
+    std::sort(spec.batch_sizes.begin(), spec.batch_sizes.end(),
+              [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+                  return a.second != b.second ? a.second < b.second : a.first < b.first;
+              });
+    spec.batch_sizes.erase(std::unique(spec.batch_sizes.begin(), spec.batch_sizes.end()), spec.batch_sizes.end());
+    // f16, q8_0, q4_0: a lossy cache has to be measurably faster to win
+    auto kv_loss = [](int t) { return t == KV_CACHE_Q4_0 ? 2 : t == KV_CACHE_Q8_0 ? 1 : 0; };
+    std::sort(spec.kv_types.begin(), spec.kv_types.end(),
+              [&](int a, int b) { return kv_loss(a) < kv_loss(b); });
+    spec.kv_types.erase(std::unique(spec.kv_types.begin(), spec.kv_types.end()), spec.kv_types.end());
+}
+
+std::vector<llama_token> benchmark_prompt(const llama_model* model, const std::string& text, int n_tokens) {
+    const llama_vocab* vocab = llama_model_get_vocab(model);
+    const std::string source = text.empty()
+        ? "Classify the task into an Eisenhower quadrant and explain briefly: "
+          "prepare the quarterly report for tomorrow's board meeting. "
+        : text;
+    std::vector<llama_token> chunk(source.size() + 16);
+    int n = llama_tokenize(vocab, source.c_str(), static_cast<int32_t>(source.size()),
+                           chunk.data(), static_cast<int32_t>(chunk.size()), false, false);
+    if (n <= 0) return {};
+    chunk.resize(n);
+
+    std::vector<llama_token> tokens;
+    tokens.reserve(n_tokens);
+    while (static_cast<int>(tokens.size()) < n_tokens) {
+        tokens.insert(tokens.end(), chunk.begin(), chunk.end());
+    }
+    tokens.resize(n_tokens);
+    return tokens;
+}
+
+} // namespace
+
+std::string autotune_key(const llama_model* model) {
+    char desc[128] = {0};
+    llama_model_desc(model, desc, sizeof(desc));
+    return autotune_key(desc, static_cast<long long>(llama_model_size(model)));
+}
+
+AutotuneResult run_autotune(llama_model* model, const ContextOptions& base, const AutotuneSpec& input) {
+    AutotuneResult result;
+    AutotuneSpec spec = input;
+    complete_spec(spec, base);
+
+    const std::vector<llama_token> prompt = benchmark_prompt(model, spec.prompt, spec.prompt_tokens);
+    // KV types are measured at the target context, filled so generation
+    // attends over all of it: their cost grows with the cached tokens
+    const int kv_depth = std::max(spec.prompt_tokens, base.n_ctx - spec.gen_tokens - 16);
+    const std::vector<llama_token> kv_prompt = benchmark_prompt(model, spec.prompt, kv_depth);
+    if (prompt.empty() || kv_prompt.empty()) {
+        LOGE("Autotune: cannot tokenize the benchmark prompt");
+        return result;
+    }
+
+    // Pinned and parked like a regular request
+    ThreadPoolRequest request;
+    const std::vector<int> cpus = SharedThreadPools::instance().pinned_cpus();
+
+    ContextOptions current = base;
+    current.n_ctx = trial_context(spec.prompt_tokens, spec.gen_tokens);
+    auto run_phase = [&](int phase, const std::vector<ContextOptions>& candidates,
+                         const std::vector<llama_token>& tokens, bool by_prompt) {
+        std::vector<TunedConfig> measured;
+        std::vector<ContextOptions> measured_options;
+        for (const ContextOptions& candidate : candidates) {
+            std::string error;
+            if (!candidate.validate(error)) continue;
+            TunedConfig m;
+            if (!measure(model, candidate, tokens, spec.gen_tokens, cpus, m)) {
+                LOGW("Autotune phase %d: trial failed", phase);
+                continue;
+            }
+            LOGD("Autotune phase %d: threads %d/%d batch %d/%d kv %d -> prompt %.1f t/s, gen %.1f t/s",
+                 phase, m.n_threads, m.n_threads_batch, m.n_batch, m.n_ubatch, m.type_k, m.prompt_tps, m.gen_tps);
+            result.trials.emplace_back(phase, m);
+            measured.push_back(m);
+            measured_options.push_back(candidate);
+        }
+        int winner = pick(measured, by_prompt);
+        if (winner >= 0) {
+            current = measured_options[winner];
+            result.best = measured[winner];
+        }
+    };
+
+    std::vector<ContextOptions> candidates;
+    for (int t : spec.threads) {
+        ContextOptions c = current;
+        c.n_threads = t;
+        candidates.push_back(c);
+    }
+    run_phase(AUTOTUNE_THREADS, candidates, prompt, false);
+
+    candidates.clear();
+    for (int t : spec.threads_batch) {
+        ContextOptions c = current;
+        c.n_threads_batch = t;
+        candidates.push_back(c);
+    }
+    run_phase(AUTOTUNE_THREADS_BATCH, candidates, prompt, true);
+
+    candidates.clear();
+    for (const auto& b : spec.batch_sizes) {
+        ContextOptions c = current;
+        c.n_batch = b.first;
+        c.n_ubatch = b.second;
+        candidates.push_back(c);
+    }
+    run_phase(AUTOTUNE_BATCH, candidates, prompt, true);
+
+    candidates.clear();
+    for (int t : spec.kv_types) {
+        ContextOptions c = current;
+        c.n_ctx = base.n_ctx;
+        c.type_k = t;
+        c.type_v = t;
+        candidates.push_back(c);
+    }
+    run_phase(AUTOTUNE_KV, candidates, kv_prompt, false);
+
+    LOGI("Autotune: %zu trials, best threads %d/%d batch %d/%d kv %d/%d (prompt %.1f t/s, gen %.1f t/s)",
+         result.trials.size(), result.best.n_threads, result.best.n_threads_batch, result.best.n_batch,
+         result.best.n_ubatch, result.best.type_k, result.best.type_v, result.best.prompt_tps, result.best.gen_tps);
+    return result;
+}
+
+#endif // LLAMA_AVAILABLE
@@ -0,0 +1,136 @@
+/**
+ * Jeeves LLM Test Project - Per-device inference autotuner
+ *
+ * The best thread and batch configuration depends on the SoC, the model and
+ * its quantization: the Phi-3 benchmark settled on 4 threads by hand on one
+ * Pixel. The autotuner measures prompt and generation throughput on the
+ * loaded model for candidate configurations and keeps the winner in a small
+ * store keyed by device, model and quantization. Once the store is
+ * configured, nativeLoadModel takes the stored configuration for whatever
+ * the caller did not set explicitly.
+ *
+ * A full cartesian sweep would take minutes, so parameters are tuned one at
+ * a time, each phase starting from the winners of the previous ones:
+ *
+ *   AUTOTUNE_THREADS        n_threads by generation tokens/s
+ *   AUTOTUNE_THREADS_BATCH  n_threads_batch by prompt tokens/s
+ *   AUTOTUNE_BATCH          n_batch / n_ubatch by prompt tokens/s
+ *   AUTOTUNE_KV             KV cache type by generation tokens/s
+ *
+ * Candidates within AUTOTUNE_TIE_TOLERANCE of the best lose to the cheaper
+ * one (fewer threads, smaller ubatch), which saves power and memory. KV types
+ * trade accuracy rather than power, so there a tie keeps the more precise
+ * cache. They are measured at the engine's context size with the cache
+ * filled, where their cost shows; that trial context comes on top of the
+ * engine's own for its duration.
+ *
+ * Trials decode on pools of their own sizes but take turns with the shared
+ * pools (SharedThreadPools::decode_exclusive), so they neither slow down
+ * nor are timed against concurrent requests.
+ */
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "context_options.h"
+
+constexpr double AUTOTUNE_TIE_TOLERANCE = 0.03;
+
+/** Values mirror LlamaEngine.AutotuneTrial.Phase on the Kotlin side. */
+enum AutotunePhase : int {
+    AUTOTUNE_THREADS = 1,
+    AUTOTUNE_THREADS_BATCH = 2,
+    AUTOTUNE_BATCH = 3,
+    AUTOTUNE_KV = 4,
+};
+
+/**
+ * A tuned configuration and what it measured. Flattened for JNI as
+ * [n_threads, n_threads_batch, n_batch, n_ubatch, type_k, type_v,
+ * prompt tokens/s x100, generation tokens/s x100].
+ */
+struct TunedConfig {
+    static constexpr int FIELDS = 8;
+
+    int n_threads = 0;
+    int n_threads_batch = 0;
+    int n_batch = 0;
+    int n_ubatch = 0;
+    int type_k = KV_CACHE_F16;
+    int type_v = KV_CACHE_F16;
+    double prompt_tps = 0.0;
+    double gen_tps = 0.0;
+
+    /**
+     * Fill the fields [options] leaves unset (0) with the tuned values,
+     * unless it cannot run with them. Explicit settings always win.
+     */
+    void apply(ContextOptions& options) const;
+
+    void append_to(std::vector<long long>& out) const;
+};
+
+/** Empty candidate lists are filled from the CPU topology and [base]. */
+struct AutotuneSpec {
+    std::string prompt;                 // Tokenized and repeated to prompt_tokens
+    int prompt_tokens = 256;
+    int gen_tokens = 16;
+    std::vector<int> threads;
+    std::vector<int> threads_batch;
+    std::vector<std::pair<int, int>> batch_sizes;   // (n_batch, n_ubatch)
+    std::vector<int> kv_types;          // Applied to both K and V
+
+    bool valid() const;
+};
+
+/**
+ * Every measured configuration plus the winner, flattened for JNI as
+ * [n_trials, saved, then best (TunedConfig::FIELDS), then per trial: phase
+ * followed by TunedConfig::FIELDS].
+ */
+struct AutotuneResult {
+    TunedConfig best;
+    std::vector<std::pair<int, TunedConfig>> trials;   // (phase, measured)
+    bool saved = false;
+
+    std::vector<long long> to_array() const;
+};
+
+// ============================================================================
+// Store
+// ============================================================================
+
+/**
+ * Keep tuned configurations in [path] for [device] (e.g. manufacturer and
+ * model). An empty path disables the store and the load-time lookup.
+ */
+void configure_autotune_store(const std::string& path, const std::string& device);
+
+bool autotune_store_configured();
+
+/** Store key for a model on this device, from llama_model_desc and its size. */
+std::string autotune_key(const std::string& model_desc, long long model_bytes);
+
+bool load_tuned_config(const std::string& key, TunedConfig& out);
+
+/** Insert or replace [key], rewriting the store through a temp file. */
+bool save_tuned_config(const std::string& key, const TunedConfig& config);
+
+#if LLAMA_AVAILABLE
+
+#include "llama.h"
+
+/** autotune_key for a loaded model. */
+std::string autotune_key(const llama_model* model);
+
+/**
+ * Sweep [spec] on [model], starting from [base] (base.n_ctx is the target
+ * context for the KV phase). Each trial runs on its own short-lived context
+ * and threadpool, pinned like the shared pools.
+ */
+AutotuneResult run_autotune(llama_model* model, const ContextOptions& base, const AutotuneSpec& spec);
+
+#endif // LLAMA_AVAILABLE
@@ -0,0 +1,129 @@
+/**
+ * Jeeves LLM Test Project - Per-op compute profiler
+ */
+
+#include "compute_profiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <sstream>
+
+#if LLAMA_AVAILABLE
+#include "ggml.h"
+
+namespace {
+
+/**
+ * Layer of a llama.cpp node name: "ffn_up-12" and "Qcur-3 (reshaped)" give
+ * 12 and 3, names without a "-<digits>" suffix give -1.
+ */
+int layer_of(const char* name) {
+    const char* dash = strrchr(name, '-');
+    if (!dash || dash[1] < '0' || dash[1] > '9') return -1;
+    char* end = nullptr;
+    long layer = strtol(dash + 1, &end, 10);
+    return (*end == '\0' || *end == ' ') ? static_cast<int>(layer) : -1;
+}
+
+} // namespace
+#endif
+
+bool ComputeProfiler::Key::operator==(const Key& other) const {
+    return op == other.op && type == other.type && layer == other.layer &&
+           memcmp(ne, other.ne, sizeof(ne)) == 0;
+}
+
+size_t ComputeProfiler::KeyHash::operator()(const Key& key) const {
+    // op and type point at static strings, so their addresses identify them
+    size_t h = std::hash<const void*>()(key.op);
+    h = h * 31 + std::hash<const void*>()(key.type);
+    for (int64_t n : key.ne) h = h * 31 + std::hash<int64_t>()(n);
+    return h * 31 + static_cast<size_t>(key.layer);
+}
+
+void ComputeProfiler::configure(float sample_rate) {
+    sample_rate_ = std::min(std::max(sample_rate, 0.0f), 1.0f);
+}
+
+bool ComputeProfiler::begin_request() {
+    active_ = sample_rate_ > 0.0f &&
+        std::uniform_real_distribution<float>(0.0f, 1.0f)(rng_) < sample_rate_;
+    if (active_) {
+        report_id_++;
+        index_.clear();
+        entries_.clear();
+        nodes_ = 0;
+    }
+    return active_;
+}
+
+void ComputeProfiler::record(const char* op, const char* type, const int64_t ne[4], int layer, long long us) {
+    Key key {op, type, {0, 0, 0, 0}, layer};
+    if (ne) std::copy(ne, ne + 4, key.ne);
+
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        it = index_.emplace(key, entries_.size()).first;
+        Entry entry;
+        entry.op = op;
+        entry.type = type;
+        std::copy(key.ne, key.ne + 4, entry.ne);
+        entry.layer = layer;
+        entries_.push_back(entry);
+    }
+    Entry& entry = entries_[it->second];
+    entry.count++;
+    entry.total_us += us;
+    entry.max_us = std::max(entry.max_us, us);
+    nodes_++;
+}
+
+std::string ComputeProfiler::report() const {
+    std::vector<const Entry*> sorted;
+    sorted.reserve(entries_.size());
+    for (const Entry& entry : entries_) sorted.push_back(&entry);
+    std::sort(sorted.begin(), sorted.end(), [](const Entry* a, const Entry* b) {
+        return a->total_us > b->total_us;
+    });
+
+    std::ostringstream out;
+    for (const Entry* entry : sorted) {
+        // Shape without trailing unit dimensions past the batch: 4096x1, 128x7x32
+        int dims = entry->ne[0] > 0 ? 4 : 0;
+        while (dims > 2 && entry->ne[dims - 1] == 1) dims--;
+        out << entry->op << '\t' << entry->type << '\t';
+        for (int i = 0; i < dims; i++) out << (i > 0 ? "x" : "") << entry->ne[i];
+        out << '\t' << entry->layer << '\t' << entry->count << '\t' << entry->total_us
+            << '\t' << entry->max_us << '\n';
+    }
+    return out.str();
+}
+
+bool ComputeProfiler::eval_callback(ggml_tensor* t, bool ask, void* user_data) {
+#if LLAMA_AVAILABLE
+    ComputeProfiler* profiler = static_cast<ComputeProfiler*>(user_data);
+    if (ask) {
+        if (!profiler->active_) return false;
+        switch (t->op) {
+            case GGML_OP_NONE:
+            case GGML_OP_VIEW:
+            case GGML_OP_RESHAPE:
+            case GGML_OP_PERMUTE:
+            case GGML_OP_TRANSPOSE:
+                return false;
+            default:
+                profiler->node_start_ = std::chrono::steady_clock::now();
+                return true;
+        }
+    }
+
+    // Computed and synchronised: the node alone took since its ask
+    long long us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - profiler->node_start_).count();
+    const char* type = t->src[0] ? ggml_type_name(t->src[0]->type) : "";
+    profiler->record(ggml_op_desc(t), type, t->ne, layer_of(t->name), us);
+#endif
+    return true;
+}
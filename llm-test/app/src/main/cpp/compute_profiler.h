@@ -0,0 +1,150 @@
+/**
+ * Jeeves LLM Test Project - Per-op compute profiler
+ *
+ * GenerateStats says a request got slower, not where. After a llama.cpp
+ * update or a model change, tokens/s alone cannot tell a slower matmul
+ * kernel from attention growing with the context or from the sampler. The
+ * profiler times every ggml node of a request's decodes through the
+ * scheduler's eval callback (llama_context_params.cb_eval) and aggregates
+ * by op, weight type, output shape and layer:
+ *   - MUL_MAT rows split by weight type (q4_0, q4_K, f16...). The CPU
+ *     backend dequantizes inside the matmul, so dequantization cost shows
+ *     up there and in GET_ROWS on quantized embeddings.
+ *   - The layer comes from llama.cpp's "<name>-<layer>" node names; nodes
+ *     outside the layers (embeddings, output head) have layer -1.
+ *   - The shape's second dimension is the batch, so prompt evaluation and
+ *     per-token decode land in separate rows.
+ *   - Token sampling is not a graph node; it is recorded as op SAMPLE.
+ *
+ * Timing a node means computing it on its own and synchronising, which
+ * slows a profiled request noticeably. Requests are therefore sampled at
+ * a configurable rate. The callback is installed on every context but
+ * declines every node of an unsampled request, so the scheduler computes
+ * the graph in one piece as without a callback; the cost is one cheap
+ * call per node. Views, reshapes and permutes are never timed: they
+ * compute nothing and are folded into the next node.
+ *
+ * The profiler belongs to one engine and is only used under its mutex
+ * (the callback runs on the decoding thread), so it needs no locking.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ggml_tensor;
+
+class ComputeProfiler {
+public:
+    /** Aggregated time of one (op, type, shape, layer) combination. */
+    struct Entry {
+        const char* op = "";        // ggml_op_desc, or SAMPLE; static strings
+        const char* type = "";      // Weight (src0) type name
+        int64_t ne[4] = {0, 0, 0, 0};   // Output shape
+        int layer = -1;
+        long long count = 0;
+        long long total_us = 0;
+        long long max_us = 0;
+    };
+
+    /** Profile this fraction of requests (0 = off, 1 = every request). */
+    void configure(float sample_rate);
+    float sample_rate() const { return sample_rate_; }
+
+    /**
+     * Decide whether the request starting now is profiled. A profiled
+     * request replaces the previous report.
+     */
+    bool begin_request();
+    void end_request() { active_ = false; }
+    bool active() const { return active_; }
+
+    /** Counts profiled requests; identifies the report a request is timing. */
+    long long report_id() const { return report_id_; }
+
+    /**
+     * Continue timing a request that stopped while another one used the
+     * engine, unless a later profiled request replaced report [id].
+     */
+    void resume_request(long long id) { active_ = id == report_id_; }
+
+    /** Add one timed operation to the current report. */
+    void record(const char* op, const char* type, const int64_t ne[4], int layer, long long us);
+
+    /** Nodes timed in the last profiled request; 0 if none was profiled. */
+    long long nodes() const { return nodes_; }
+
+    /**
+     * The last profiled request, one tab-separated line per entry, slowest
+     * first: op, type, shape (e.g. "4096x1"), layer, count, total_us, max_us.
+     */
+    std::string report() const;
+
+    /** ggml_backend_sched_eval_callback; [user_data] is the profiler. */
+    static bool eval_callback(ggml_tensor* t, bool ask, void* user_data);
+
+private:
+    struct Key {
+        const char* op;
+        const char* type;
+        int64_t ne[4];
+        int layer;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    float sample_rate_ = 0.0f;
+    bool active_ = false;
+    long long report_id_ = 0;
+    std::minstd_rand rng_{std::random_device{}()};
+    std::chrono::steady_clock::time_point node_start_;
+
+    std::unordered_map<Key, size_t, KeyHash> index_;
+    std::vector<Entry> entries_;
+    long long nodes_ = 0;
+};
+
+/**
+ * RAII begin_request / end_request for one generate call, so an early
+ * return does not leave the profiler timing later warm-up or trim decodes.
+ */
+class ProfiledRequest {
+public:
+    explicit ProfiledRequest(ComputeProfiler& profiler) : profiler_(&profiler) {
+        if (profiler_->begin_request()) report_ = profiler_->report_id();
+    }
+    ~ProfiledRequest() {
+        if (profiler_) profiler_->end_request();
+    }
+
+    ProfiledRequest(const ProfiledRequest&) = delete;
+    ProfiledRequest& operator=(const ProfiledRequest&) = delete;
+
+    bool active() const { return profiler_ && profiler_->active(); }
+
+    /**
+     * Stop timing while the request has yielded its engine to others; the
+     * engine, and with it the profiler, may be gone before resume().
+     */
+    void suspend() {
+        profiler_->end_request();
+        profiler_ = nullptr;
+    }
+    void resume(ComputeProfiler& profiler) {
+        profiler_ = &profiler;
+        if (report_ != 0) profiler_->resume_request(report_);
+    }
+
+private:
+    ComputeProfiler* profiler_;
+    long long report_ = 0;              // Report this request times; 0 = not sampled
+};
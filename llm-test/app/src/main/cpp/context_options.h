@@ -0,0 +1,107 @@
+/**
+ * Jeeves LLM Test Project - Context parameters accepted over JNI
+ *
+ * Everything nativeLoadModel lets Kotlin tune on top of
+ * llama_context_default_params(), validated before it reaches llama.cpp.
+ * Kotlin mirrors the enum values in LlamaEngine.KvCacheType / FlashAttention.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#if LLAMA_AVAILABLE
+#include "llama.h"
+#endif
+
+/** KV cache element types accepted from Kotlin (values are ggml_type ids). */
+enum KvCacheType : int {
+    KV_CACHE_F16 = 1,
+    KV_CACHE_Q4_0 = 2,
+    KV_CACHE_Q8_0 = 8,
+};
+
+/** Same values as llama_flash_attn_type. */
+enum FlashAttention : int {
+    FLASH_ATTN_AUTO = -1,
+    FLASH_ATTN_DISABLED = 0,
+    FLASH_ATTN_ENABLED = 1,
+};
+
+constexpr int MAX_CONTEXT_SEQUENCES = 64;
+
+struct ContextOptions {
+    int n_ctx = 2048;
+    int n_threads = 4;
+    int n_threads_batch = 0;    // 0 = same as n_threads
+    int n_batch = 512;
+    int n_ubatch = 512;
+    int n_seq_max = 1;
+    int type_k = KV_CACHE_F16;
+    int type_v = KV_CACHE_F16;
+    int flash_attn = FLASH_ATTN_AUTO;
+
+    /** Returns false and sets [error] if any option is out of range. */
+    bool validate(std::string& error) const {
+        auto valid_kv = [](int t) {
+            return t == KV_CACHE_F16 || t == KV_CACHE_Q8_0 || t == KV_CACHE_Q4_0;
+        };
+        if (n_ctx < 64) error = "n_ctx must be >= 64";
+        else if (n_threads < 1) error = "n_threads must be >= 1";
+        else if (n_threads_batch < 0) error = "n_threads_batch must be >= 0";
+        else if (n_batch < 1) error = "n_batch must be >= 1";
+        else if (n_ubatch < 1 || n_ubatch > n_batch) error = "n_ubatch must be in [1, n_batch]";
+        else if (n_seq_max < 1 || n_seq_max > MAX_CONTEXT_SEQUENCES) error = "n_seq_max must be in [1, 64]";
+        else if (!valid_kv(type_k)) error = "type_k must be f16, q8_0 or q4_0";
+        else if (!valid_kv(type_v)) error = "type_v must be f16, q8_0 or q4_0";
+        else if (flash_attn < FLASH_ATTN_AUTO || flash_attn > FLASH_ATTN_ENABLED) error = "invalid flash_attn mode";
+        // llama.cpp can only quantize the V cache through the flash attention kernel
+        else if (type_v != KV_CACHE_F16 && flash_attn == FLASH_ATTN_DISABLED) error = "quantized V cache requires flash attention";
+        else return true;
+        return false;
+    }
+
+    /**
+     * Fill the fields nativeLoadModel leaves unset (0) for a tuned
+     * configuration: threads, batch sizes and KV types.
+     */
+    void fill_unset(int default_threads) {
+        const ContextOptions defaults;
+        if (n_threads == 0) n_threads = default_threads > 0 ? default_threads : defaults.n_threads;
+        if (n_batch == 0) n_batch = std::max(defaults.n_batch, n_ubatch);
+        if (n_ubatch == 0) n_ubatch = std::min(defaults.n_ubatch, n_batch);
+        if (type_k == 0) type_k = defaults.type_k;
+        if (type_v == 0) type_v = defaults.type_v;
+    }
+
+#if LLAMA_AVAILABLE
+    void apply(llama_context_params& params) const {
+        params.n_ctx = static_cast<uint32_t>(n_ctx);
+        params.n_threads = n_threads;
+        params.n_threads_batch = n_threads_batch > 0 ? n_threads_batch : n_threads;
+        params.n_batch = static_cast<uint32_t>(n_batch);
+        params.n_ubatch = static_cast<uint32_t>(n_ubatch);
+        params.n_seq_max = static_cast<uint32_t>(n_seq_max);
+        params.type_k = static_cast<ggml_type>(type_k);
+        params.type_v = static_cast<ggml_type>(type_v);
+        params.flash_attn_type = static_cast<llama_flash_attn_type>(flash_attn);
+    }
+
+    /** Options that reproduce [params] (n_ctx and n_seq_max included). */
+    static ContextOptions from(const llama_context_params& params) {
+        ContextOptions options;
+        options.n_ctx = static_cast<int>(params.n_ctx);
+        options.n_threads = params.n_threads;
+        options.n_threads_batch = params.n_threads_batch;
+        options.n_batch = static_cast<int>(params.n_batch);
+        options.n_ubatch = static_cast<int>(params.n_ubatch);
+        options.n_seq_max = static_cast<int>(params.n_seq_max);
+        options.type_k = params.type_k;
+        options.type_v = params.type_v;
+        options.flash_attn = params.flash_attn_type;
+        return options;
+    }
+#endif
+};
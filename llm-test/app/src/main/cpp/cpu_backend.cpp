@@ -0,0 +1,233 @@
+/**
+ * Jeeves LLM Test Project - Runtime-selected ggml CPU backend
+ */
+
+#include "cpu_backend.h"
+
+#include <chrono>
+#include <iterator>
+#include <mutex>
+
+#include "device_probe.h"
+#include "llama_log.h"
+
+#if LLAMA_AVAILABLE && defined(GGML_BACKEND_DL)
+#include <dlfcn.h>
+
+#include "ggml-backend.h"
+#endif
+
+namespace {
+
+struct VariantSpec {
+    int variant;
+    const char* name;
+    int features;           // Required CpuFeature bits
+};
+
+// Best first, baseline last; names match the module suffixes built by CMakeLists.txt
+#if defined(__x86_64__)
+constexpr VariantSpec VARIANTS[] = {
+    {CPU_VARIANT_AVX512, "avx512", CPU_FEATURE_AVX2 | CPU_FEATURE_AVX512},
+    {CPU_VARIANT_AVX2, "avx2", CPU_FEATURE_AVX2},
+    {CPU_VARIANT_X86_64, "x86_64", 0},
+};
+#else
+constexpr VariantSpec VARIANTS[] = {
+    {CPU_VARIANT_SVE, "sve", CPU_FEATURE_DOTPROD | CPU_FEATURE_FP16 | CPU_FEATURE_I8MM | CPU_FEATURE_SVE},
+    {CPU_VARIANT_I8MM, "i8mm", CPU_FEATURE_DOTPROD | CPU_FEATURE_FP16 | CPU_FEATURE_I8MM},
+    {CPU_VARIANT_DOTPROD, "dotprod", CPU_FEATURE_DOTPROD | CPU_FEATURE_FP16},
+    {CPU_VARIANT_ARMV8, "armv8", 0},
+};
+#endif
+
+// Features the statically linked backend was compiled with
+int compiled_cpu_features() {
+    int features = 0;
+#if defined(__ARM_FEATURE_DOTPROD)
+    features |= CPU_FEATURE_DOTPROD;
+#endif
+#if defined(__ARM_FEATURE_MATMUL_INT8)
+    features |= CPU_FEATURE_I8MM;
+#endif
+#if defined(__ARM_FEATURE_FP16_VECTOR_ARITHMETIC)
+    features |= CPU_FEATURE_FP16;
+#endif
+#if defined(__ARM_FEATURE_SVE)
+    features |= CPU_FEATURE_SVE;
+#endif
+#if defined(__AVX2__)
+    features |= CPU_FEATURE_AVX2;
+#endif
+#if defined(__AVX512F__)
+    features |= CPU_FEATURE_AVX512;
+#endif
+    return features;
+}
+
+struct CpuBackendState {
+    std::mutex mutex;
+    bool loaded = false;
+    CpuBackendInfo info;
+#if LLAMA_AVAILABLE && defined(GGML_BACKEND_DL)
+    // Resolved from the module load_cpu_backend selects
+    decltype(&ggml_threadpool_new) threadpool_new = nullptr;
+    decltype(&ggml_threadpool_free) threadpool_free = nullptr;
+    decltype(&ggml_threadpool_get_n_threads) threadpool_get_n_threads = nullptr;
+    decltype(&ggml_threadpool_pause) threadpool_pause = nullptr;
+#elif LLAMA_AVAILABLE
+    decltype(&ggml_threadpool_new) threadpool_new = ggml_threadpool_new;
+    decltype(&ggml_threadpool_free) threadpool_free = ggml_threadpool_free;
+    decltype(&ggml_threadpool_get_n_threads) threadpool_get_n_threads = ggml_threadpool_get_n_threads;
+    decltype(&ggml_threadpool_pause) threadpool_pause = ggml_threadpool_pause;
+#endif
+};
+
+CpuBackendState& state() {
+    static CpuBackendState s;
+    return s;
+}
+
+#if LLAMA_AVAILABLE && defined(GGML_BACKEND_DL)
+
+// Register the module at [path] and resolve the threadpool entry points from it
+bool load_variant(CpuBackendState& s, const std::string& path) {
+    ggml_backend_reg_t reg = ggml_backend_load(path.c_str());
+    if (!reg) return false;
+
+    // ggml already holds the module; this only takes a second reference for dlsym
+    void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle) {
+        s.threadpool_new = reinterpret_cast<decltype(s.threadpool_new)>(dlsym(handle, "ggml_threadpool_new"));
+        s.threadpool_free = reinterpret_cast<decltype(s.threadpool_free)>(dlsym(handle, "ggml_threadpool_free"));
+        s.threadpool_get_n_threads = reinterpret_cast<decltype(s.threadpool_get_n_threads)>(
+            dlsym(handle, "ggml_threadpool_get_n_threads"));
+        s.threadpool_pause = reinterpret_cast<decltype(s.threadpool_pause)>(dlsym(handle, "ggml_threadpool_pause"));
+    }
+    if (!handle || !s.threadpool_new || !s.threadpool_free || !s.threadpool_get_n_threads || !s.threadpool_pause) {
+        LOGW("CPU backend %s lacks threadpool symbols", path.c_str());
+        if (handle) dlclose(handle);
+        ggml_backend_unload(reg);
+        s.threadpool_new = nullptr;
+        s.threadpool_free = nullptr;
+        s.threadpool_get_n_threads = nullptr;
+        s.threadpool_pause = nullptr;
+        return false;
+    }
+    return true;
+}
+
+#endif
+
+} // namespace
+
+const char* cpu_variant_name(int variant) {
+    switch (variant) {
+        case CPU_VARIANT_STATIC: return "static";
+        case CPU_VARIANT_ARMV8: return "armv8";
+        case CPU_VARIANT_DOTPROD: return "dotprod";
+        case CPU_VARIANT_I8MM: return "i8mm";
+        case CPU_VARIANT_SVE: return "sve";
+        case CPU_VARIANT_X86_64: return "x86_64";
+        case CPU_VARIANT_AVX2: return "avx2";
+        case CPU_VARIANT_AVX512: return "avx512";
+        default: return "none";
+    }
+}
+
+int cpu_variant_features(int variant) {
+    if (variant == CPU_VARIANT_STATIC) return compiled_cpu_features();
+    for (const VariantSpec& spec : VARIANTS) {
+        if (spec.variant == variant) return spec.features;
+    }
+    return 0;
+}
+
+int select_cpu_variant(int features) {
+    for (const VariantSpec& spec : VARIANTS) {
+        if ((features & spec.features) == spec.features) return spec.variant;
+    }
+    return std::end(VARIANTS)[-1].variant;
+}
+
+void CpuBackendInfo::to_array(long long out[COUNT]) const {
+    out[VARIANT] = variant;
+    out[CPU_FEATURES] = cpu_features;
+    out[VARIANT_FEATURES] = variant_features;
+    out[FALLBACKS] = fallbacks;
+    out[LOAD_MS] = load_ms;
+}
+
+const CpuBackendInfo& load_cpu_backend(const std::string& lib_dir) {
+    CpuBackendState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.loaded) return s.info;
+    s.loaded = true;
+
+    auto start = std::chrono::steady_clock::now();
+    s.info.cpu_features = detect_cpu_features();
+
+#if LLAMA_AVAILABLE && defined(GGML_BACKEND_DL)
+    const int best = select_cpu_variant(s.info.cpu_features);
+    bool started = false;
+    for (const VariantSpec& spec : VARIANTS) {
+        if (spec.variant == best) started = true;
+        if (!started) continue;
+
+        std::string path = std::string("libggml-cpu-") + spec.name + ".so";
+        if (!lib_dir.empty()) path = lib_dir + "/" + path;
+        if (load_variant(s, path)) {
+            s.info.variant = spec.variant;
+            s.info.variant_features = spec.features;
+            break;
+        }
+        LOGW("CPU backend %s failed to load, trying the next level", spec.name);
+        s.info.fallbacks++;
+    }
+    if (s.info.variant == CPU_VARIANT_NONE) LOGE("No CPU backend could be loaded");
+#else
+    s.info.variant = CPU_VARIANT_STATIC;
+    s.info.variant_features = compiled_cpu_features();
+#endif
+
+    s.info.load_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    LOGI("CPU backend: %s (cpu features 0x%x, variant features 0x%x, %d fallbacks, %lld ms)",
+         cpu_variant_name(s.info.variant), s.info.cpu_features, s.info.variant_features,
+         s.info.fallbacks, s.info.load_ms);
+    return s.info;
+}
+
+CpuBackendInfo cpu_backend_info() {
+    CpuBackendState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.info;
+}
+
+#if LLAMA_AVAILABLE
+
+// With GGML_BACKEND_DL the entry points are written once, under the mutex,
+// before any pool exists, so reads here need no lock
+
+ggml_threadpool* cpu_threadpool_new(ggml_threadpool_params* params) {
+    auto fn = state().threadpool_new;
+    if (!fn) {
+        LOGE("Threadpool requested before the CPU backend was loaded");
+        return nullptr;
+    }
+    return fn(params);
+}
+
+void cpu_threadpool_free(ggml_threadpool* pool) {
+    if (pool && state().threadpool_free) state().threadpool_free(pool);
+}
+
+int cpu_threadpool_get_n_threads(const ggml_threadpool* pool) {
+    return pool && state().threadpool_get_n_threads ? state().threadpool_get_n_threads(pool) : 0;
+}
+
+void cpu_threadpool_pause(ggml_threadpool* pool) {
+    if (pool && state().threadpool_pause) state().threadpool_pause(pool);
+}
+
+#endif // LLAMA_AVAILABLE
@@ -0,0 +1,85 @@
+/**
+ * Jeeves LLM Test Project - Runtime-selected ggml CPU backend
+ *
+ * A single ggml CPU build must target the oldest supported core, which
+ * leaves the dotprod, i8mm and SVE kernels unused on newer phones (and AVX2 /
+ * AVX-512 on x86_64 emulators and hosts). With GGML_BACKEND_DL the build
+ * packages one CPU backend module per feature level
+ * (libggml-cpu-<variant>.so). load_cpu_backend picks the best one the
+ * CPU supports and registers it with ggml, falling back to older levels if a
+ * module is missing. Builds without GGML_BACKEND_DL link the CPU backend in
+ * and report CPU_VARIANT_STATIC.
+ *
+ * The ggml_threadpool functions live in the CPU backend, so with loadable
+ * variants they are resolved from the selected module. Callers use the
+ * cpu_threadpool_* wrappers, which work in both builds.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/** Values mirror LlamaEngine.CpuVariant on the Kotlin side. */
+enum CpuVariant : int {
+    CPU_VARIANT_NONE = 0,       // Not loaded yet, or no module could be loaded
+    CPU_VARIANT_STATIC,         // Linked in (no GGML_BACKEND_DL)
+    CPU_VARIANT_ARMV8,          // Baseline ARMv8.0 NEON
+    CPU_VARIANT_DOTPROD,        // ARMv8.2 + dotprod + fp16
+    CPU_VARIANT_I8MM,           // ARMv8.6 + i8mm
+    CPU_VARIANT_SVE,            // ARMv8.6 + i8mm + SVE
+    CPU_VARIANT_X86_64,         // x86-64-v2 (SSE4.2)
+    CPU_VARIANT_AVX2,           // Haswell: AVX2 + FMA + F16C
+    CPU_VARIANT_AVX512,         // Skylake-X: AVX-512
+};
+
+const char* cpu_variant_name(int variant);
+
+/** CpuFeature bits [variant] was compiled for. */
+int cpu_variant_features(int variant);
+
+/** Best loadable variant whose required CpuFeature bits are all in [features]. */
+int select_cpu_variant(int features);
+
+/**
+ * Which CPU backend is in use. Flattened for JNI as the Index fields.
+ */
+struct CpuBackendInfo {
+    enum Index {
+        VARIANT = 0,
+        CPU_FEATURES,               // CpuFeature bits of this CPU
+        VARIANT_FEATURES,           // CpuFeature bits the variant was compiled for
+        FALLBACKS,                  // Better variants that failed to load
+        LOAD_MS,
+        COUNT
+    };
+
+    int variant = CPU_VARIANT_NONE;
+    int cpu_features = 0;
+    int variant_features = 0;
+    int fallbacks = 0;
+    long long load_ms = 0;
+
+    void to_array(long long out[COUNT]) const;
+};
+
+/**
+ * Load and register the best CPU backend, once per process. Modules are
+ * looked up in [lib_dir], or by soname in the app's library path when empty.
+ */
+const CpuBackendInfo& load_cpu_backend(const std::string& lib_dir = "");
+
+/** The backend chosen by load_cpu_backend; CPU_VARIANT_NONE before it ran. */
+CpuBackendInfo cpu_backend_info();
+
+#if LLAMA_AVAILABLE
+
+#include "ggml-cpu.h"
+
+// With GGML_BACKEND_DL these return null / do nothing until load_cpu_backend
+ggml_threadpool* cpu_threadpool_new(ggml_threadpool_params* params);
+void cpu_threadpool_free(ggml_threadpool* pool);
+int cpu_threadpool_get_n_threads(const ggml_threadpool* pool);
+void cpu_threadpool_pause(ggml_threadpool* pool);
+
+#endif // LLAMA_AVAILABLE
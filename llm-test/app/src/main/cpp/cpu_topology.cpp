@@ -0,0 +1,173 @@
+/**
+ * Jeeves LLM Test Project - CPU topology and inference thread affinity
+ */
+
+#include "cpu_topology.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+
+#include "llama_log.h"
+
+namespace {
+
+long read_long(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) return 0;
+    long value = 0;
+    if (fscanf(f, "%ld", &value) != 1) value = 0;
+    fclose(f);
+    return value;
+}
+
+// cpuN/online is absent for cores that cannot be hotplugged (usually cpu0)
+bool is_online(const std::string& cpu_dir) {
+    FILE* f = fopen((cpu_dir + "/online").c_str(), "r");
+    if (!f) return true;
+    int online = 1;
+    if (fscanf(f, "%d", &online) != 1) online = 1;
+    fclose(f);
+    return online != 0;
+}
+
+long performance_score(const CpuCore& core) {
+    return core.capacity > 0 ? core.capacity : core.max_freq_khz;
+}
+
+} // namespace
+
+std::vector<int> CpuTopology::cpus_for_policy(int policy) const {
+    // One cluster (or unknown topology): pinning cannot help
+    if (clusters.size() < 2) return {};
+
+    std::vector<int> cpus;
+    switch (policy) {
+    case CPU_POLICY_PERFORMANCE:
+        for (size_t i = 0; i + 1 < clusters.size(); i++) {
+            cpus.insert(cpus.end(), clusters[i].begin(), clusters[i].end());
+        }
+        break;
+    case CPU_POLICY_EFFICIENCY:
+        cpus = clusters.back();
+        break;
+    default:
+        break;
+    }
+    std::sort(cpus.begin(), cpus.end());
+    return cpus;
+}
+
+int CpuTopology::recommended_threads(int policy) const {
+    std::vector<int> cpus = cpus_for_policy(policy);
+    if (!cpus.empty()) return static_cast<int>(cpus.size());
+    return static_cast<int>(cores.size());
+}
+
+std::vector<long long> CpuTopology::to_array() const {
+    std::vector<long long> out;
+    out.reserve(2 + cores.size() * 4);
+    out.push_back(static_cast<long long>(cores.size()));
+    out.push_back(static_cast<long long>(clusters.size()));
+    for (const CpuCore& core : cores) {
+        out.push_back(core.id);
+        out.push_back(core.cluster);
+        out.push_back(core.capacity);
+        out.push_back(core.max_freq_khz);
+    }
+    return out;
+}
+
+CpuTopology detect_cpu_topology(const std::string& sysfs_root) {
+    CpuTopology topology;
+
+    DIR* dir = opendir(sysfs_root.c_str());
+    if (!dir) {
+        LOGW("CPU topology: cannot open %s", sysfs_root.c_str());
+        return topology;
+    }
+    while (dirent* entry = readdir(dir)) {
+        const char* name = entry->d_name;
+        if (strncmp(name, "cpu", 3) != 0 || name[3] < '0' || name[3] > '9') continue;
+        char* end = nullptr;
+        long id = strtol(name + 3, &end, 10);
+        if (*end != '\0') continue;
+
+        std::string cpu_dir = sysfs_root + "/" + name;
+        if (!is_online(cpu_dir)) continue;
+
+        CpuCore core;
+        core.id = static_cast<int>(id);
+        core.capacity = read_long(cpu_dir + "/cpu_capacity");
+        core.max_freq_khz = read_long(cpu_dir + "/cpufreq/cpuinfo_max_freq");
+        topology.cores.push_back(core);
+    }
+    closedir(dir);
+
+    std::sort(topology.cores.begin(), topology.cores.end(),
+              [](const CpuCore& a, const CpuCore& b) { return a.id < b.id; });
+
+    // Equal scores form a cluster; highest score first
+    std::map<long, std::vector<int>, std::greater<long>> by_score;
+    for (const CpuCore& core : topology.cores) by_score[performance_score(core)].push_back(core.id);
+    for (auto& group : by_score) topology.clusters.push_back(std::move(group.second));
+
+    for (CpuCore& core : topology.cores) {
+        for (size_t c = 0; c < topology.clusters.size(); c++) {
+            const auto& ids = topology.clusters[c];
+            if (std::find(ids.begin(), ids.end(), core.id) != ids.end()) core.cluster = static_cast<int>(c);
+        }
+    }
+
+    LOGI("CPU topology: %zu cores in %zu clusters", topology.cores.size(), topology.clusters.size());
+    return topology;
+}
+
+const CpuTopology& system_cpu_topology() {
+    static const CpuTopology topology = detect_cpu_topology();
+    return topology;
+}
+
+bool valid_cpu_policy(int policy) {
+    return policy == CPU_POLICY_ALL || policy == CPU_POLICY_PERFORMANCE || policy == CPU_POLICY_EFFICIENCY;
+}
+
+ScopedCpuAffinity::ScopedCpuAffinity(const std::vector<int>& cpus) {
+    if (cpus.empty()) return;
+    if (sched_getaffinity(0, sizeof(previous_), &previous_) != 0) return;
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int cpu : cpus) CPU_SET(cpu, &mask);
+    pinned_ = sched_setaffinity(0, sizeof(mask), &mask) == 0;
+    if (!pinned_) LOGW("sched_setaffinity failed - running unpinned");
+}
+
+ScopedCpuAffinity::~ScopedCpuAffinity() {
+    if (pinned_) sched_setaffinity(0, sizeof(previous_), &previous_);
+}
+
+ScopedThreadPriority::ScopedThreadPriority(int nice) {
+    if (nice == 0) return;
+    if (pthread_getschedparam(pthread_self(), &previous_policy_, &previous_param_) != 0) return;
+    // On Linux PRIO_PROCESS with who = 0 applies to the calling thread only
+    errno = 0;
+    previous_nice_ = getpriority(PRIO_PROCESS, 0);
+    if (errno != 0) return;
+    changed_ = setpriority(PRIO_PROCESS, 0, nice) == 0;
+    if (!changed_) LOGW("setpriority(%d) failed - running at normal priority", nice);
+}
+
+ScopedThreadPriority::~ScopedThreadPriority() {
+    if (!changed_) return;
+    pthread_setschedparam(pthread_self(), previous_policy_, &previous_param_);
+    setpriority(PRIO_PROCESS, 0, previous_nice_);
+}
@@ -0,0 +1,98 @@
+/**
+ * Jeeves LLM Test Project - CPU topology and inference thread affinity
+ *
+ * Phones are big.LITTLE: on a Tensor G4 one X4, three A720 and four A520
+ * cores share the scheduler, and a matmul split across them finishes when
+ * its slowest thread does. Topology is read from sysfs (cpu_capacity, or
+ * cpufreq/cpuinfo_max_freq when the kernel does not expose capacity) and
+ * cores with the same score are grouped into clusters, fastest first.
+ *
+ * The sysfs root is a parameter so detection can run against fixture trees.
+ */
+
+#pragma once
+
+#include <sched.h>
+
+#include <string>
+#include <vector>
+
+constexpr const char* DEFAULT_CPU_SYSFS_ROOT = "/sys/devices/system/cpu";
+
+/** Values mirror LlamaEngine.CpuPolicy on the Kotlin side. */
+enum CpuPolicy : int {
+    CPU_POLICY_ALL = 0,           // No pinning
+    CPU_POLICY_PERFORMANCE = 1,   // Every cluster except the slowest
+    CPU_POLICY_EFFICIENCY = 2,    // Slowest cluster only, for background work
+};
+
+struct CpuCore {
+    int id = 0;
+    int cluster = 0;            // Index into CpuTopology::clusters, 0 = fastest
+    long capacity = 0;          // cpu_capacity, 0 if not exposed
+    long max_freq_khz = 0;      // cpuinfo_max_freq, 0 if not exposed
+};
+
+struct CpuTopology {
+    std::vector<CpuCore> cores;                  // Online cores, by id
+    std::vector<std::vector<int>> clusters;      // Core ids, fastest cluster first
+
+    /** Cores [policy] allows; empty means no restriction. */
+    std::vector<int> cpus_for_policy(int policy) const;
+
+    /** Thread count that fills [policy]'s cores without sharing one. */
+    int recommended_threads(int policy) const;
+
+    /**
+     * Flattened for JNI: [n_cores, n_clusters, then per core: id, cluster,
+     * capacity, max_freq_khz].
+     */
+    std::vector<long long> to_array() const;
+};
+
+/** Detect topology under [sysfs_root]. Returns no cores if nothing is readable. */
+CpuTopology detect_cpu_topology(const std::string& sysfs_root = DEFAULT_CPU_SYSFS_ROOT);
+
+/** Topology of this device, detected once. */
+const CpuTopology& system_cpu_topology();
+
+bool valid_cpu_policy(int policy);
+
+/**
+ * Pins the calling thread to [cpus] with sched_setaffinity and restores its
+ * previous mask on destruction, so a JVM thread borrowed for inference does
+ * not stay pinned. An empty set leaves the thread alone.
+ */
+class ScopedCpuAffinity {
+public:
+    explicit ScopedCpuAffinity(const std::vector<int>& cpus);
+    ~ScopedCpuAffinity();
+
+    ScopedCpuAffinity(const ScopedCpuAffinity&) = delete;
+    ScopedCpuAffinity& operator=(const ScopedCpuAffinity&) = delete;
+
+private:
+    cpu_set_t previous_;
+    bool pinned_ = false;
+};
+
+/**
+ * Lowers the calling thread to [nice] and restores its nice value and
+ * scheduling policy on destruction. ggml applies a low-priority pool's
+ * policy to the thread that runs its graphs, so the policy is restored too.
+ * A nice of 0 leaves the thread alone.
+ */
+class ScopedThreadPriority {
+public:
+    explicit ScopedThreadPriority(int nice);
+    ~ScopedThreadPriority();
+
+    ScopedThreadPriority(const ScopedThreadPriority&) = delete;
+    ScopedThreadPriority& operator=(const ScopedThreadPriority&) = delete;
+
+private:
+    int previous_nice_ = 0;
+    int previous_policy_ = 0;
+    sched_param previous_param_ {};
+    bool changed_ = false;
+};
@@ -0,0 +1,287 @@
+/**
+ * Jeeves LLM Test Project - Device capability probe
+ */
+
+#include "device_probe.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#elif defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+#include "cpu_topology.h"
+#include "llama_log.h"
+#include "memory_stats.h"
+
+#if defined(__aarch64__)
+// Older NDK headers lack the newer hwcap bits
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2 (1 << 6)
+#endif
+#ifndef HWCAP_FPHP
+#define HWCAP_FPHP (1 << 9)
+#endif
+#ifndef HWCAP_ASIMDHP
+#define HWCAP_ASIMDHP (1 << 10)
+#endif
+#ifndef HWCAP_ASIMDDP
+#define HWCAP_ASIMDDP (1 << 20)
+#endif
+#ifndef HWCAP_SVE
+#define HWCAP_SVE (1 << 22)
+#endif
+#ifndef HWCAP2_I8MM
+#define HWCAP2_I8MM (1 << 13)
+#endif
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t BANDWIDTH_BUFFER_BYTES = 64u << 20;   // Well past the last-level cache
+constexpr size_t SMALL_BUFFER_BYTES = 16u << 20;       // When memory is short
+constexpr int DOT_LENGTH = 4096;                       // Operands stay in L1
+constexpr int FMA_LANES = 64;
+
+/**
+ * Run [work](index, stop) on [threads] threads for [seconds]; each returns
+ * the units it completed. Returns total units per second.
+ */
+template <typename Work>
+double run_parallel(int threads, double seconds, Work work) {
+    std::atomic<bool> stop{false};
+    std::vector<double> units(threads, 0.0);
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back([&, i] { units[i] = work(i, stop); });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread& t : workers) t.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    double total = 0.0;
+    for (double u : units) total += u;
+    return elapsed > 0.0 ? total / elapsed : 0.0;
+}
+
+// ============================================================================
+// Kernels
+// ============================================================================
+
+uint64_t sum_words(const uint64_t* words, size_t n) {
+    // Independent accumulators keep loads, not adds, on the critical path
+    uint64_t a = 0, b = 0, c = 0, d = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        a += words[i];
+        b += words[i + 1];
+        c += words[i + 2];
+        d += words[i + 3];
+    }
+    for (; i < n; i++) a += words[i];
+    return a + b + c + d;
+}
+
+int32_t dot_i8_generic(const int8_t* a, const int8_t* b, int n) {
+    int32_t acc = 0;
+    for (int i = 0; i < n; i++) acc += static_cast<int32_t>(a[i]) * b[i];
+    return acc;
+}
+
+void fma_f32(float* acc, int iterations) {
+    for (int it = 0; it < iterations; it++) {
+        for (int j = 0; j < FMA_LANES; j++) acc[j] = acc[j] * 0.999f + 0.001f;
+    }
+}
+
+#if defined(__aarch64__)
+
+__attribute__((target("arch=armv8.2-a+dotprod")))
+int32_t dot_i8_dotprod(const int8_t* a, const int8_t* b, int n) {
+    int32x4_t acc0 = vdupq_n_s32(0);
+    int32x4_t acc1 = vdupq_n_s32(0);
+    for (int i = 0; i + 32 <= n; i += 32) {
+        acc0 = vdotq_s32(acc0, vld1q_s8(a + i), vld1q_s8(b + i));
+        acc1 = vdotq_s32(acc1, vld1q_s8(a + i + 16), vld1q_s8(b + i + 16));
+    }
+    return vaddvq_s32(vaddq_s32(acc0, acc1));
+}
+
+__attribute__((target("arch=armv8.2-a+fp16")))
+float fma_f16(int iterations) {
+    const float16x8_t m = vdupq_n_f16(0.999f);
+    const float16x8_t c = vdupq_n_f16(0.001f);
+    float16x8_t acc[FMA_LANES / 8];
+    for (auto& a : acc) a = vdupq_n_f16(1.0f);
+    for (int it = 0; it < iterations; it++) {
+        for (auto& a : acc) a = vfmaq_f16(c, a, m);
+    }
+    float16x8_t sum = acc[0];
+    for (int j = 1; j < FMA_LANES / 8; j++) sum = vaddq_f16(sum, acc[j]);
+    return static_cast<float>(vgetq_lane_f16(sum, 0));
+}
+
+#endif // __aarch64__
+
+// ============================================================================
+// Measurements
+// ============================================================================
+
+long long measure_bandwidth_mbps(int threads, double seconds, size_t available_bytes) {
+    size_t bytes = available_bytes > 0 && available_bytes < 4 * BANDWIDTH_BUFFER_BYTES
+        ? SMALL_BUFFER_BYTES : BANDWIDTH_BUFFER_BYTES;
+    const size_t n_words = bytes / sizeof(uint64_t);
+    std::unique_ptr<uint64_t[]> buffer(new (std::nothrow) uint64_t[n_words]);
+    if (!buffer) return 0;
+    for (size_t i = 0; i < n_words; i++) buffer[i] = i;
+
+    const size_t slice = n_words / threads;
+    std::atomic<uint64_t> sink{0};
+    double words_per_s = run_parallel(threads, seconds, [&](int index, const std::atomic<bool>& stop) {
+        const uint64_t* words = buffer.get() + index * slice;
+        uint64_t local = 0;
+        double done = 0.0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            local += sum_words(words, slice);
+            done += static_cast<double>(slice);
+        }
+        sink.fetch_add(local, std::memory_order_relaxed);
+        return done;
+    });
+    return static_cast<long long>(words_per_s * sizeof(uint64_t) / 1e6);
+}
+
+long long measure_int8_mops(int threads, double seconds, int features) {
+    std::atomic<int64_t> sink{0};
+    double ops_per_s = run_parallel(threads, seconds, [&](int index, const std::atomic<bool>& stop) {
+        alignas(64) int8_t a[DOT_LENGTH];
+        alignas(64) int8_t b[DOT_LENGTH];
+        for (int i = 0; i < DOT_LENGTH; i++) {
+            a[i] = static_cast<int8_t>((i * 7 + index) & 0x7f);
+            b[i] = static_cast<int8_t>((i * 13) & 0x7f) - 64;
+        }
+        int64_t local = 0;
+        double done = 0.0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            for (int r = 0; r < 64; r++) {
+#if defined(__aarch64__)
+                local += (features & CPU_FEATURE_DOTPROD) ? dot_i8_dotprod(a, b, DOT_LENGTH)
+                                                          : dot_i8_generic(a, b, DOT_LENGTH);
+#else
+                local += dot_i8_generic(a, b, DOT_LENGTH);
+#endif
+                a[r] ^= 1;   // Keeps the compiler from hoisting the dot product
+            }
+            done += 64.0 * 2 * DOT_LENGTH;
+        }
+        sink.fetch_add(local, std::memory_order_relaxed);
+        return done;
+    });
+    return static_cast<long long>(ops_per_s / 1e6);
+}
+
+long long measure_fp16_mflops(int threads, double seconds, int features) {
+    constexpr int ITERATIONS = 256;
+    std::atomic<int64_t> sink{0};
+    double flops_per_s = run_parallel(threads, seconds, [&](int index, const std::atomic<bool>& stop) {
+        float acc[FMA_LANES];
+        for (int j = 0; j < FMA_LANES; j++) acc[j] = 1.0f + index + j;
+        float result = 0.0f;
+        double done = 0.0;
+        while (!stop.load(std::memory_order_relaxed)) {
+#if defined(__aarch64__)
+            if (features & CPU_FEATURE_FP16) {
+                result += fma_f16(ITERATIONS);
+            } else {
+                fma_f32(acc, ITERATIONS);
+            }
+#else
+            fma_f32(acc, ITERATIONS);
+#endif
+            done += 2.0 * FMA_LANES * ITERATIONS;
+        }
+        sink.fetch_add(static_cast<int64_t>(result + acc[0]), std::memory_order_relaxed);
+        return done;
+    });
+    return static_cast<long long>(flops_per_s / 1e6);
+}
+
+} // namespace
+
+int detect_cpu_features() {
+    int features = 0;
+#if defined(__aarch64__)
+    unsigned long hwcap = getauxval(AT_HWCAP);
+    unsigned long hwcap2 = getauxval(AT_HWCAP2);
+    if (hwcap & HWCAP_ASIMDDP) features |= CPU_FEATURE_DOTPROD;
+    if (hwcap2 & HWCAP2_I8MM) features |= CPU_FEATURE_I8MM;
+    if ((hwcap & HWCAP_FPHP) && (hwcap & HWCAP_ASIMDHP)) features |= CPU_FEATURE_FP16;
+    if (hwcap & HWCAP_SVE) features |= CPU_FEATURE_SVE;
+    if (hwcap & HWCAP_SHA2) features |= CPU_FEATURE_SHA2;
+#elif defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) features |= CPU_FEATURE_AVX2;
+    if (__builtin_cpu_supports("avx512f")) features |= CPU_FEATURE_AVX512;
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1u << 29))) features |= CPU_FEATURE_SHA2;
+#endif
+    return features;
+}
+
+std::vector<long long> DeviceProbe::to_array() const {
+    std::vector<long long> out(COUNT, 0);
+    out[MEM_BANDWIDTH_MBPS] = mem_bandwidth_mbps;
+    out[INT8_MOPS] = int8_mops;
+    out[FP16_MFLOPS] = fp16_mflops;
+    out[FEATURES] = features;
+    out[THREADS] = threads;
+    out[TOTAL_MEM_BYTES] = total_mem_bytes;
+    out[AVAILABLE_MEM_BYTES] = available_mem_bytes;
+    out[PROBE_MS] = probe_ms;
+    out[N_CLUSTERS] = static_cast<long long>(cluster_cores.size());
+    for (int cores : cluster_cores) out.push_back(cores);
+    return out;
+}
+
+DeviceProbe probe_device(int threads, int budget_ms) {
+    auto start = Clock::now();
+    DeviceProbe probe;
+
+    const CpuTopology& topology = system_cpu_topology();
+    for (const auto& cluster : topology.clusters) probe.cluster_cores.push_back(static_cast<int>(cluster.size()));
+    probe.features = detect_cpu_features();
+
+    const int hardware = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    if (threads <= 0) threads = topology.cores.empty() ? hardware : topology.recommended_threads(CPU_POLICY_PERFORMANCE);
+    probe.threads = std::min(threads, hardware);
+
+    size_t total = 0, available = 0;
+    read_system_memory(total, available);
+    probe.total_mem_bytes = static_cast<long long>(total);
+    probe.available_mem_bytes = static_cast<long long>(available);
+
+    // Measure on the cores inference runs on; spawned threads inherit the mask
+    ScopedCpuAffinity affinity(topology.cpus_for_policy(CPU_POLICY_PERFORMANCE));
+    const double kernel_s = std::max(10, budget_ms / 4) / 1000.0;
+    probe.mem_bandwidth_mbps = measure_bandwidth_mbps(probe.threads, kernel_s, available);
+    probe.int8_mops = measure_int8_mops(probe.threads, kernel_s, probe.features);
+    probe.fp16_mflops = measure_fp16_mflops(probe.threads, kernel_s, probe.features);
+
+    probe.probe_ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+    LOGI("Device probe: %lld MB/s, %lld int8 MOPS, %lld %s MFLOPS, features 0x%x, %d threads, %lld ms",
+         probe.mem_bandwidth_mbps, probe.int8_mops, probe.fp16_mflops,
+         (probe.features & CPU_FEATURE_FP16) ? "fp16" : "fp32", probe.features, probe.threads, probe.probe_ms);
+    return probe;
+}
@@ -0,0 +1,66 @@
+/**
+ * Jeeves LLM Test Project - Device capability probe
+ *
+ * RAM tiers say whether a model fits, not whether the device can serve it
+ * fast enough. Token generation streams every weight once per token, so it is
+ * bound by memory bandwidth; prompt processing is bound by int8 (quantized
+ * weights) dot-product throughput. The probe measures both on the cores the
+ * inference pools use, plus fp16 FMA throughput where the CPU has native
+ * half precision, in well under a second. Kotlin turns the numbers into
+ * per-model tokens/s predictions.
+ */
+
+#pragma once
+
+#include <vector>
+
+/** Bits mirror LlamaEngine / DeviceCapabilities feature flags on the Kotlin side. */
+enum CpuFeature : int {
+    CPU_FEATURE_DOTPROD = 1 << 0,   // ARMv8.2 SDOT/UDOT
+    CPU_FEATURE_I8MM = 1 << 1,      // ARMv8.6 SMMLA
+    CPU_FEATURE_FP16 = 1 << 2,      // Native half-precision arithmetic
+    CPU_FEATURE_SVE = 1 << 3,
+    CPU_FEATURE_AVX2 = 1 << 4,
+    CPU_FEATURE_AVX512 = 1 << 5,
+    CPU_FEATURE_SHA2 = 1 << 6,      // ARMv8 SHA2 / x86 SHA-NI
+};
+
+/** CpuFeature bits present on this CPU (getauxval on ARM, cpuid on x86). */
+int detect_cpu_features();
+
+/**
+ * Probe results, flattened for JNI as the Index fields followed by one core
+ * count per cluster, fastest cluster first.
+ */
+struct DeviceProbe {
+    enum Index {
+        MEM_BANDWIDTH_MBPS = 0,     // Sustained multi-threaded read bandwidth
+        INT8_MOPS,                  // int8 multiply-accumulate ops/s / 1e6, all probe threads
+        FP16_MFLOPS,                // fp16 FMA flops/s / 1e6; fp32 when FP16 is absent
+        FEATURES,                   // CpuFeature bits
+        THREADS,                    // Threads the throughput figures were measured with
+        TOTAL_MEM_BYTES,
+        AVAILABLE_MEM_BYTES,
+        PROBE_MS,
+        N_CLUSTERS,
+        COUNT
+    };
+
+    long long mem_bandwidth_mbps = 0;
+    long long int8_mops = 0;
+    long long fp16_mflops = 0;
+    int features = 0;
+    int threads = 0;
+    long long total_mem_bytes = 0;
+    long long available_mem_bytes = 0;
+    long long probe_ms = 0;
+    std::vector<int> cluster_cores;
+
+    std::vector<long long> to_array() const;
+};
+
+/**
+ * Run the probe on up to [threads] threads (0 = one per performance core),
+ * spending about [budget_ms] in total across the three kernels.
+ */
+DeviceProbe probe_device(int threads = 0, int budget_ms = 600);
@@ -0,0 +1,132 @@
+/**
+ * Jeeves LLM Test Project - Elastic context sizing
+ */
+
+#include "elastic_context.h"
+
+#if LLAMA_AVAILABLE
+
+#include <algorithm>
+
+#include "llama_log.h"
+
+namespace {
+
+constexpr auto SHRINK_POLL_INTERVAL = std::chrono::seconds(1);
+
+uint32_t align_up(uint32_t n, uint32_t align) {
+    return (n + align - 1) / align * align;
+}
+
+} // namespace
+
+int configure_elastic_context(LlamaContext* wrapper, int max_ctx, long long idle_shrink_ms) {
+    if (!wrapper->ctx) return 0;    // Freed by a failed resize or trim
+    const int n_ctx_train = llama_model_n_ctx_train(wrapper->model);
+    const int current = static_cast<int>(llama_n_ctx(wrapper->ctx));
+
+    ElasticContextConfig& elastic = wrapper->elastic;
+    elastic.enabled = true;
+    elastic.min_ctx = current;
+    elastic.max_ctx = max_ctx > 0 ? std::min(max_ctx, n_ctx_train) : n_ctx_train;
+    elastic.max_ctx = std::max(elastic.max_ctx, elastic.min_ctx);
+    elastic.idle_shrink_ms = idle_shrink_ms;
+
+    if (idle_shrink_ms > 0) {
+        IdleContextShrinker::instance().track(wrapper);
+    } else {
+        IdleContextShrinker::instance().untrack(wrapper);
+    }
+    LOGI("Elastic context: %d..%d tokens (trained %d), idle shrink %lld ms",
+         elastic.min_ctx, elastic.max_ctx, n_ctx_train, idle_shrink_ms);
+    return elastic.max_ctx;
+}
+
+uint32_t ensure_context_capacity(LlamaContext* wrapper, uint32_t needed) {
+    if (!wrapper->ctx) return 0;
+    uint32_t current = llama_n_ctx(wrapper->ctx);
+    const ElasticContextConfig& elastic = wrapper->elastic;
+    if (needed <= current || !elastic.enabled) return current;
+
+    const uint32_t max_ctx = static_cast<uint32_t>(elastic.max_ctx);
+    if (current >= max_ctx) return current;
+
+    // Double at least, so a run of slightly longer prompts does not resize every time
+    uint32_t target = std::max(align_up(needed, CONTEXT_GROWTH_ALIGN), current * 2);
+    target = std::min(target, max_ctx);
+
+    long long before_ms = wrapper->resize_stats.total_resize_ms;
+    resize_context(wrapper, target);
+    wrapper->resize_stats.last_request_resize_ms += wrapper->resize_stats.total_resize_ms - before_ms;
+    return wrapper->ctx ? llama_n_ctx(wrapper->ctx) : 0;
+}
+
+// ============================================================================
+// IdleContextShrinker
+// ============================================================================
+
+IdleContextShrinker& IdleContextShrinker::instance() {
+    static IdleContextShrinker shrinker;
+    return shrinker;
+}
+
+IdleContextShrinker::~IdleContextShrinker() {
+    shutdown();
+}
+
+void IdleContextShrinker::track(LlamaContext* wrapper) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tracked_.insert(wrapper);
+    if (!running_) {
+        // A previous thread that ran out of work has already left run()
+        if (thread_.joinable()) thread_.join();
+        stop_ = false;
+        running_ = true;
+        thread_ = std::thread(&IdleContextShrinker::run, this);
+    }
+}
+
+void IdleContextShrinker::untrack(LlamaContext* wrapper) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tracked_.erase(wrapper);
+    if (tracked_.empty()) wake_cv_.notify_all();
+}
+
+void IdleContextShrinker::shutdown() {
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        thread.swap(thread_);
+    }
+    wake_cv_.notify_all();
+    if (thread.joinable()) thread.join();
+}
+
+void IdleContextShrinker::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_ && !tracked_.empty()) {
+        wake_cv_.wait_for(lock, SHRINK_POLL_INTERVAL);
+        if (stop_ || tracked_.empty()) break;
+
+        auto now = std::chrono::steady_clock::now();
+        for (LlamaContext* wrapper : tracked_) {
+            // Never wait on a context that is serving a request
+            std::unique_lock<std::mutex> ctx_lock(wrapper->mutex, std::try_to_lock);
+            if (!ctx_lock.owns_lock() || !wrapper->ctx) continue;
+
+            const ElasticContextConfig& elastic = wrapper->elastic;
+            if (!elastic.enabled || elastic.idle_shrink_ms <= 0) continue;
+            if (llama_n_ctx(wrapper->ctx) <= static_cast<uint32_t>(elastic.min_ctx)) continue;
+
+            auto idle_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - wrapper->last_used).count();
+            if (idle_ms < elastic.idle_shrink_ms) continue;
+
+            LOGI("Context idle for %lld ms - shrinking to %d tokens", static_cast<long long>(idle_ms), elastic.min_ctx);
+            resize_context(wrapper, static_cast<uint32_t>(elastic.min_ctx));
+        }
+    }
+    running_ = false;
+}
+
+#endif // LLAMA_AVAILABLE
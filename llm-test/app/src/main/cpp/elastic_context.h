@@ -0,0 +1,68 @@
+/**
+ * Jeeves LLM Test Project - Elastic context sizing
+ *
+ * Most traffic is short classification, so the context starts small and is
+ * recreated larger only when a request needs more tokens (up to the model's
+ * trained length). A background shrinker returns idle contexts to their
+ * minimum size so a single long briefing does not pin a large KV cache.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#include "engine_context.h"
+
+#if LLAMA_AVAILABLE
+
+/** Grown contexts are rounded up to a multiple of this many tokens. */
+constexpr uint32_t CONTEXT_GROWTH_ALIGN = 256;
+
+/**
+ * Enable elastic sizing on [wrapper] using its current n_ctx as the minimum.
+ * Resolves max_ctx against the model's trained length and returns it, or
+ * returns 0 and changes nothing if the engine has no context.
+ */
+int configure_elastic_context(LlamaContext* wrapper, int max_ctx, long long idle_shrink_ms);
+
+/**
+ * Ensure wrapper->ctx can hold [needed] tokens, growing it if elastic sizing
+ * is enabled. Returns the resulting capacity, which is below [needed] when
+ * the maximum is reached. Caller holds wrapper->mutex.
+ */
+uint32_t ensure_context_capacity(LlamaContext* wrapper, uint32_t needed);
+
+/**
+ * Background thread that shrinks contexts idle for longer than their
+ * idle_shrink_ms. Busy contexts (mutex held by a request) are skipped. The
+ * thread exits once nothing is tracked and is restarted by the next track().
+ */
+class IdleContextShrinker {
+public:
+    static IdleContextShrinker& instance();
+
+    void track(LlamaContext* wrapper);
+    /** After this returns the shrinker no longer touches [wrapper]. */
+    void untrack(LlamaContext* wrapper);
+    /** Stop and join the thread. A later track() starts it again. */
+    void shutdown();
+
+    ~IdleContextShrinker();
+
+private:
+    IdleContextShrinker() = default;
+    void run();
+
+    std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::unordered_set<LlamaContext*> tracked_;
+    std::thread thread_;
+    bool running_ = false;
+    bool stop_ = false;
+};
+
+#endif // LLAMA_AVAILABLE
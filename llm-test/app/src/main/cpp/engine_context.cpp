@@ -0,0 +1,161 @@
+/**
+ * Jeeves LLM Test Project - Per-handle engine state
+ */
+
+#include "engine_context.h"
+
+void copy_engine_settings(const LlamaContext& from, LlamaContext& to) {
+    to.thread_control = from.thread_control;
+    to.profiler.configure(from.profiler.sample_rate());
+}
+
+#if LLAMA_AVAILABLE
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "engine_handles.h"
+#include "llama_log.h"
+#include "memory_budget.h"
+#include "memory_stats.h"
+#include "thread_pool.h"
+
+constexpr int MAX_FIT_ATTEMPTS = 4;
+constexpr size_t PREFETCH_CHUNK_BYTES = 4u << 20;
+
+void free_context(LlamaContext* wrapper) {
+    if (!wrapper->ctx) return;
+    SharedThreadPools::instance().detach(wrapper->ctx);
+    llama_free(wrapper->ctx);
+    wrapper->ctx = nullptr;
+}
+
+/**
+ * The KV buffer is cleared at creation so its pages show up in the anonymous
+ * delta; compute buffers are only touched on first decode, so they are taken
+ * as the larger of the measured remainder and the estimate.
+ */
+bool create_context(LlamaContext* wrapper, llama_context_params params, size_t budget_bytes) {
+    size_t available = 0;
+    if (budget_bytes > 0) {
+        size_t weights = wrapper->model_ref.size_bytes();
+        if (weights >= budget_bytes) {
+            LOGE("Memory budget %zu bytes is smaller than model weights (%zu bytes)", budget_bytes, weights);
+            return false;
+        }
+        available = budget_bytes - weights;
+        if (!fit_context_params(wrapper->model, params, available)) return false;
+    }
+    
+    // Declines every node unless the current request is profiled
+    params.cb_eval = ComputeProfiler::eval_callback;
+    params.cb_eval_user_data = &wrapper->profiler;
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int attempt = 0; attempt < MAX_FIT_ATTEMPTS; attempt++) {
+        ProcessMemory before, after;
+        read_process_memory(before);
+        llama_context* ctx = llama_init_from_model(wrapper->model, params);
+        if (!ctx) return false;
+        read_process_memory(after);
+        
+        size_t measured = after.anonymous_bytes > before.anonymous_bytes
+            ? after.anonymous_bytes - before.anonymous_bytes : 0;
+        size_t kv = estimate_kv_bytes(wrapper->model, llama_n_ctx(ctx), params.type_k, params.type_v);
+        size_t compute = std::max(measured > kv ? measured - kv : 0, estimate_compute_bytes(wrapper->model, params));
+        
+        if (budget_bytes == 0 || kv + compute <= available) {
+            SharedThreadPools::instance().attach(ctx);
+            wrapper->ctx = ctx;
+            wrapper->ctx_params = params;
+            wrapper->kv_cache_bytes = kv;
+            wrapper->compute_buffer_bytes = compute;
+            wrapper->cached_tokens.clear();
+            wrapper->context_create_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            return true;
+        }
+        
+        LOGW("Context uses %zu bytes, %zu available - shrinking", kv + compute, available);
+        llama_free(ctx);
+        if (!shrink_context_params(params)) return false;
+    }
+    return false;
+}
+
+bool resize_context(LlamaContext* wrapper, uint32_t n_ctx) {
+    auto start = std::chrono::steady_clock::now();
+    uint32_t old_ctx = wrapper->ctx ? llama_n_ctx(wrapper->ctx) : 0;
+    
+    llama_context_params params = wrapper->ctx_params;
+    params.n_ctx = n_ctx;
+    
+    // Free first: holding both contexts would double the KV peak we are trying to bound
+    free_context(wrapper);
+    bool ok = create_context(wrapper, params, wrapper->memory_budget_bytes);
+    if (!ok && old_ctx > 0) {
+        LOGE("Context resize %u -> %u failed, restoring previous size", old_ctx, n_ctx);
+        params.n_ctx = old_ctx;
+        create_context(wrapper, params, wrapper->memory_budget_bytes);
+    }
+    
+    long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    wrapper->resize_stats.resize_count++;
+    wrapper->resize_stats.total_resize_ms += elapsed;
+    wrapper->resize_stats.last_resize_ms = elapsed;
+    wrapper->memory_usage_bytes = wrapper->model_ref.size_bytes()
+        + wrapper->kv_cache_bytes + wrapper->compute_buffer_bytes;
+    EngineHandles::instance().publish(wrapper);
+    LOGI("Context resized %u -> %u in %lld ms", old_ctx,
+         wrapper->ctx ? llama_n_ctx(wrapper->ctx) : 0, elapsed);
+    return ok;
+}
+
+/**
+ * Read the model file through the page cache before the warm-up decode, so
+ * the decode (which holds the shared pools) takes minor faults only.
+ */
+static void prefetch_model_file(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    std::vector<char> buffer(PREFETCH_CHUNK_BYTES);
+    while (read(fd, buffer.data(), buffer.size()) > 0) {}
+    close(fd);
+}
+
+bool warm_up_context(LlamaContext* wrapper) {
+    if (!wrapper->ctx) return false;
+    auto start = std::chrono::steady_clock::now();
+    if (wrapper->model_ref.mapped_bytes() > 0) {
+        prefetch_model_file(wrapper->model_ref.path());
+    }
+    
+    // One token touches every weight matrix and sizes the compute buffers
+    llama_token token = llama_vocab_bos(llama_model_get_vocab(wrapper->model));
+    llama_batch batch = llama_batch_init(1, 0, 1);
+    batch.token[0] = token >= 0 ? token : 0;
+    batch.pos[0] = 0;
+    batch.n_seq_id[0] = 1;
+    batch.seq_id[0][0] = 0;
+    batch.logits[0] = true;
+    batch.n_tokens = 1;
+    int32_t status;
+    {
+        ThreadPoolRequest request(QOS_INTERACTIVE);
+        status = SharedThreadPools::instance().decode(wrapper->ctx, batch);
+    }
+    llama_batch_free(batch);
+    llama_memory_clear(llama_get_memory(wrapper->ctx), true);
+    wrapper->cached_tokens.clear();
+    
+    LOGI("Engine warmed up in %lld ms (decode status %d)", static_cast<long long>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()),
+        status);
+    return status == 0;
+}
+
+#endif // LLAMA_AVAILABLE
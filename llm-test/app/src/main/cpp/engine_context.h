@@ -0,0 +1,137 @@
+/**
+ * Jeeves LLM Test Project - Per-handle engine state
+ *
+ * One LlamaContext sits behind every jlong handle handed to Kotlin. It
+ * borrows shared weights from ModelRegistry and owns its llama_context.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "compute_profiler.h"
+#include "model_registry.h"
+#include "teardown.h"
+#include "thread_control.h"
+
+#if LLAMA_AVAILABLE
+#include "llama.h"
+#endif
+
+/**
+ * Elastic context sizing. The context starts at min_ctx, grows on demand up
+ * to max_ctx and falls back to min_ctx after idle_shrink_ms without requests.
+ */
+struct ElasticContextConfig {
+    bool enabled = false;
+    int min_ctx = 0;
+    int max_ctx = 0;            // 0 = model's trained context length
+    long long idle_shrink_ms = 0;   // 0 = never shrink
+};
+
+struct ContextResizeStats {
+    int resize_count = 0;
+    long long total_resize_ms = 0;
+    long long last_resize_ms = 0;
+    long long last_request_resize_ms = 0;   // Resize cost paid by the most recent request
+};
+
+struct LlamaContext;
+
+#if LLAMA_AVAILABLE
+/** Detach wrapper->ctx from the shared threadpool and free it. */
+void free_context(LlamaContext* wrapper);
+#endif
+
+struct LlamaContext {
+#if LLAMA_AVAILABLE
+    ModelRef model_ref;              // Shared weights, owned by ModelRegistry
+    llama_model* model = nullptr;    // Borrowed from model_ref
+    llama_context* ctx = nullptr;
+    llama_context_params ctx_params {};  // Effective params after budget fitting
+    std::string model_path;
+    ModelLoadParams load_params;
+
+    // Tokens whose KV is live in sequence 0, reused as a prompt prefix cache
+    std::vector<llama_token> cached_tokens;
+    // Set by TRIM_COMPRESS_KV: compressed sequence 0 state + the tokens it holds
+    std::vector<uint8_t> kv_blob;
+    size_t kv_blob_raw_size = 0;
+    std::vector<llama_token> kv_blob_tokens;
+#endif
+    std::mutex mutex;
+    // Interactive generate calls waiting for [mutex]; a background request
+    // holding it saves its KV before yielding, since they will reuse it
+    std::atomic<int> interactive_waiting{0};
+    unsigned long long engine_id = 0;   // Set by EngineHandles::add, never reused
+    bool is_stub = false;
+
+    long long load_time_ms = 0;
+    long long last_inference_time_ms = 0;
+    int last_tokens_generated = 0;
+    size_t memory_usage_bytes = 0;
+    size_t kv_cache_bytes = 0;
+    size_t compute_buffer_bytes = 0;
+    size_t memory_budget_bytes = 0;
+
+    // Observed costs, used to estimate what a trim will cost to undo
+    long long context_create_ms = 0;
+    double prompt_ms_per_token = 0.0;
+
+    ElasticContextConfig elastic;
+    ContextResizeStats resize_stats;
+    AdaptiveThreadConfig thread_control;
+    ComputeProfiler profiler;           // Per-op timing of sampled requests
+    std::chrono::steady_clock::time_point last_used = std::chrono::steady_clock::now();
+
+    LlamaContext() {
+#if !LLAMA_AVAILABLE
+        is_stub = true;
+#endif
+        note_engine_created();
+    }
+
+    ~LlamaContext() {
+#if LLAMA_AVAILABLE
+        free_context(this);
+        // model_ref releases the weights after the context is gone
+#endif
+        note_engine_destroyed();
+    }
+};
+
+/**
+ * Copy the settings configured from Kotlin on [from] to [to], so a hot-swap
+ * replacement keeps them. Caller holds both mutexes.
+ */
+void copy_engine_settings(const LlamaContext& from, LlamaContext& to);
+
+#if LLAMA_AVAILABLE
+
+/**
+ * Create the context for [wrapper] within [budget_bytes] for the whole engine
+ * (0 = no budget). On success wrapper->ctx, ctx_params and the KV/compute
+ * counters describe the new context.
+ */
+bool create_context(LlamaContext* wrapper, llama_context_params params, size_t budget_bytes);
+
+/**
+ * Replace wrapper->ctx with one of [n_ctx] tokens, keeping every other
+ * parameter. KV contents are dropped. Caller holds wrapper->mutex.
+ */
+bool resize_context(LlamaContext* wrapper, uint32_t n_ctx);
+
+/**
+ * Bring the weights into memory and run one decode, so the first request on
+ * a freshly loaded engine does not pay for page faults and first-use buffer
+ * setup. KV contents are dropped. Caller holds wrapper->mutex.
+ */
+bool warm_up_context(LlamaContext* wrapper);
+
+#endif
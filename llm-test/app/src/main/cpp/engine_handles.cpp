@@ -0,0 +1,239 @@
+/**
+ * Jeeves LLM Test Project - Handle table for loaded engines
+ */
+
+#include "engine_handles.h"
+
+#include <chrono>
+#include <utility>
+
+#include "engine_context.h"
+#include "llama_log.h"
+
+namespace {
+
+constexpr long long INDEX_MASK = 0xffffffffLL;
+
+long long make_handle(size_t index, uint32_t generation) {
+    // Index + 1 keeps every handle non-zero
+    return (static_cast<long long>(generation) << 32) | static_cast<long long>(index + 1);
+}
+
+/** Metrics as they stand on [engine]; caller holds its mutex or owns it. */
+EngineMetrics metrics_of(const LlamaContext* engine) {
+    EngineMetrics metrics;
+    metrics.memory_usage_bytes = static_cast<long long>(engine->memory_usage_bytes);
+    metrics.load_time_ms = engine->load_time_ms;
+    metrics.last_inference_time_ms = engine->last_inference_time_ms;
+    metrics.last_tokens_generated = engine->last_tokens_generated;
+#if LLAMA_AVAILABLE
+    metrics.context_size = engine->ctx ? static_cast<int>(llama_n_ctx(engine->ctx)) : 0;
+#endif
+    metrics.is_stub = engine->is_stub;
+    return metrics;
+}
+
+} // namespace
+
+EngineLease& EngineLease::operator=(EngineLease&& other) noexcept {
+    if (this != &other) {
+        reset();
+        engine_ = other.engine_;
+        other.engine_ = nullptr;
+    }
+    return *this;
+}
+
+void EngineLease::reset() {
+    if (!engine_) return;
+    EngineHandles::instance().release(engine_);
+    engine_ = nullptr;
+}
+
+void HandleStats::to_array(long long out[COUNT]) const {
+    out[LIVE] = live;
+    out[SWAPS] = swaps;
+    out[STALE_LOOKUPS] = stale_lookups;
+    out[DRAINED] = drained;
+    out[LAST_DRAIN_MS] = last_drain_ms;
+}
+
+EngineHandles& EngineHandles::instance() {
+    static EngineHandles handles;
+    return handles;
+}
+
+EngineHandles::EngineHandles() : published_(new PublishedSlot[MAX_ENGINES]) {
+    slots_.reserve(MAX_ENGINES);
+}
+
+EngineHandles::Slot* EngineHandles::resolve_locked(long long handle) {
+    const long long index = (handle & INDEX_MASK) - 1;
+    if (index < 0 || index >= static_cast<long long>(slots_.size())) return nullptr;
+    Slot& slot = slots_[index];
+    if (!slot.engine || slot.generation != static_cast<uint32_t>(handle >> 32)) return nullptr;
+    return &slot;
+}
+
+long long EngineHandles::add(std::unique_ptr<LlamaContext> engine) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_slots_.empty() && slots_.size() >= MAX_ENGINES) {
+        LOGE("Cannot load more than %zu engines at once", MAX_ENGINES);
+        return 0;
+    }
+    size_t index;
+    if (!free_slots_.empty()) {
+        index = free_slots_.back();
+        free_slots_.pop_back();
+    } else {
+        index = slots_.size();
+        slots_.emplace_back();
+    }
+    Slot& slot = slots_[index];
+    engine->engine_id = next_engine_id_++;
+    slot.engine = engine.release();
+    store_locked(index, slot.generation, metrics_of(slot.engine));
+    stats_.live++;
+    return make_handle(index, slot.generation);
+}
+
+EngineLease EngineHandles::acquire(long long handle) {
+    if (handle == 0) return EngineLease();
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot* slot = resolve_locked(handle);
+    if (!slot) {
+        stats_.stale_lookups++;
+        LOGW("Stale engine handle %llx", static_cast<unsigned long long>(handle));
+        return EngineLease();
+    }
+    leases_[slot->engine]++;
+    return EngineLease(slot->engine);
+}
+
+void EngineHandles::release(LlamaContext* engine) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = leases_.find(engine);
+        if (it == leases_.end() || --it->second > 0) return;
+        leases_.erase(it);
+    }
+    released_cv_.notify_all();
+}
+
+bool EngineHandles::swap(long long a, long long b) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot* slot_a = resolve_locked(a);
+    Slot* slot_b = resolve_locked(b);
+    if (!slot_a || !slot_b || slot_a == slot_b) return false;
+    std::swap(slot_a->engine, slot_b->engine);
+    const size_t index_a = static_cast<size_t>(slot_a - slots_.data());
+    const size_t index_b = static_cast<size_t>(slot_b - slots_.data());
+    const EngineMetrics metrics_a = load_locked(index_a);
+    store_locked(index_a, slot_a->generation, load_locked(index_b));
+    store_locked(index_b, slot_b->generation, metrics_a);
+    stats_.swaps++;
+    return true;
+}
+
+bool EngineHandles::swap_in(long long handle, long long replacement) {
+    {
+        EngineLease current = acquire(handle);
+        EngineLease next = acquire(replacement);
+        if (!current || !next || current.get() == next.get()) return false;
+        std::scoped_lock lock(current->mutex, next->mutex);
+        copy_engine_settings(*current.get(), *next.get());
+    }
+    return swap(handle, replacement);
+}
+
+std::unique_ptr<LlamaContext> EngineHandles::remove(long long handle) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Slot* slot = resolve_locked(handle);
+    if (!slot) {
+        stats_.stale_lookups++;
+        return nullptr;
+    }
+    LlamaContext* engine = slot->engine;
+    slot->engine = nullptr;
+    if (++slot->generation == 0) slot->generation = 1;
+    const size_t index = static_cast<size_t>(slot - slots_.data());
+    store_locked(index, 0, EngineMetrics());
+    free_slots_.push_back(index);
+    stats_.live--;
+
+    if (leases_.count(engine) == 0) return std::unique_ptr<LlamaContext>(engine);
+
+    auto start = std::chrono::steady_clock::now();
+    LOGI("Waiting for %d in-flight request(s) before unloading", leases_[engine]);
+    released_cv_.wait(lock, [&] { return leases_.count(engine) == 0; });
+    stats_.drained++;
+    stats_.last_drain_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return std::unique_ptr<LlamaContext>(engine);
+}
+
+HandleStats EngineHandles::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void EngineHandles::publish(const LlamaContext* engine) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < slots_.size(); i++) {
+        if (slots_[i].engine != engine) continue;
+        store_locked(i, slots_[i].generation, metrics_of(engine));
+        return;
+    }
+}
+
+bool EngineHandles::read_metrics(long long handle, EngineMetrics& out) const {
+    const long long index = (handle & INDEX_MASK) - 1;
+    if (index < 0 || index >= static_cast<long long>(MAX_ENGINES)) return false;
+    const uint32_t generation = static_cast<uint32_t>(handle >> 32);
+    const PublishedSlot& p = published_[index];
+    for (;;) {
+        const uint32_t before = p.sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;   // A write of a few stores is in progress
+        const uint32_t published = p.generation.load(std::memory_order_relaxed);
+        EngineMetrics metrics;
+        metrics.memory_usage_bytes = p.memory_usage_bytes.load(std::memory_order_relaxed);
+        metrics.load_time_ms = p.load_time_ms.load(std::memory_order_relaxed);
+        metrics.last_inference_time_ms = p.last_inference_time_ms.load(std::memory_order_relaxed);
+        metrics.last_tokens_generated = p.last_tokens_generated.load(std::memory_order_relaxed);
+        metrics.context_size = p.context_size.load(std::memory_order_relaxed);
+        metrics.is_stub = p.is_stub.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (p.sequence.load(std::memory_order_relaxed) != before) continue;
+
+        if (published == 0 || published != generation) return false;
+        out = metrics;
+        return true;
+    }
+}
+
+void EngineHandles::store_locked(size_t index, uint32_t generation, const EngineMetrics& metrics) {
+    PublishedSlot& p = published_[index];
+    const uint32_t sequence = p.sequence.load(std::memory_order_relaxed);
+    p.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    p.generation.store(generation, std::memory_order_relaxed);
+    p.memory_usage_bytes.store(metrics.memory_usage_bytes, std::memory_order_relaxed);
+    p.load_time_ms.store(metrics.load_time_ms, std::memory_order_relaxed);
+    p.last_inference_time_ms.store(metrics.last_inference_time_ms, std::memory_order_relaxed);
+    p.last_tokens_generated.store(metrics.last_tokens_generated, std::memory_order_relaxed);
+    p.context_size.store(metrics.context_size, std::memory_order_relaxed);
+    p.is_stub.store(metrics.is_stub, std::memory_order_relaxed);
+    p.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+EngineMetrics EngineHandles::load_locked(size_t index) const {
+    const PublishedSlot& p = published_[index];
+    EngineMetrics metrics;
+    metrics.memory_usage_bytes = p.memory_usage_bytes.load(std::memory_order_relaxed);
+    metrics.load_time_ms = p.load_time_ms.load(std::memory_order_relaxed);
+    metrics.last_inference_time_ms = p.last_inference_time_ms.load(std::memory_order_relaxed);
+    metrics.last_tokens_generated = p.last_tokens_generated.load(std::memory_order_relaxed);
+    metrics.context_size = p.context_size.load(std::memory_order_relaxed);
+    metrics.is_stub = p.is_stub.load(std::memory_order_relaxed);
+    return metrics;
+}
@@ -0,0 +1,182 @@
+/**
+ * Jeeves LLM Test Project - Handle table for loaded engines
+ *
+ * Kotlin holds each LlamaContext as a jlong handle. A handle is a slot index
+ * plus the slot's generation, not a pointer: unloading a handle moves its
+ * slot to the next generation, so a late getter or a racing generate on a
+ * stale handle resolves to nothing instead of a freed LlamaContext.
+ *
+ * JNI calls work through an EngineLease. remove() takes the engine out of
+ * the table first, so no new lease can reach it, then waits for the leases
+ * already handed out (in-flight requests) before the engine is freed.
+ *
+ * @CriticalNative getters must not block, so they skip the lease: each slot
+ * mirrors the engine's metrics in atomics, published by whoever changes
+ * them under the engine's mutex, and read_metrics() reads them seqlock-style
+ * from a fixed slot array that never moves.
+ *
+ * Hot swap: the replacement model is loaded under a handle of its own while
+ * the current one keeps serving, warmed up, and then swap_in() exchanges the
+ * engines behind the two handles. The replacement keeps the settings made
+ * on the current engine (thread control, profiler sample rate). Requests started before the swap
+ * finish on the old model; unloading the replacement handle drains and
+ * frees it.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct LlamaContext;
+
+/**
+ * Keeps an engine alive while a JNI call uses it. Empty for stale handles.
+ */
+class EngineLease {
+public:
+    EngineLease() = default;
+    ~EngineLease() { reset(); }
+
+    EngineLease(EngineLease&& other) noexcept : engine_(other.engine_) { other.engine_ = nullptr; }
+    EngineLease& operator=(EngineLease&& other) noexcept;
+    EngineLease(const EngineLease&) = delete;
+    EngineLease& operator=(const EngineLease&) = delete;
+
+    LlamaContext* get() const { return engine_; }
+    LlamaContext* operator->() const { return engine_; }
+    explicit operator bool() const { return engine_ != nullptr; }
+    void reset();
+
+private:
+    friend class EngineHandles;
+    explicit EngineLease(LlamaContext* engine) : engine_(engine) {}
+
+    LlamaContext* engine_ = nullptr;
+};
+
+/**
+ * Handle table counters since startup. Flattened for JNI as the Index fields.
+ */
+struct HandleStats {
+    enum Index {
+        LIVE = 0,                   // Handles currently loaded
+        SWAPS,
+        STALE_LOOKUPS,              // Calls made with an unloaded or unknown handle
+        DRAINED,                    // Unloads that waited for in-flight requests
+        LAST_DRAIN_MS,              // Wait of the most recent unload
+        COUNT
+    };
+
+    long long live = 0;
+    long long swaps = 0;
+    long long stale_lookups = 0;
+    long long drained = 0;
+    long long last_drain_ms = 0;
+
+    void to_array(long long out[COUNT]) const;
+};
+
+/** Per-engine values the @CriticalNative getters return. */
+struct EngineMetrics {
+    long long memory_usage_bytes = 0;
+    long long load_time_ms = 0;
+    long long last_inference_time_ms = 0;
+    int last_tokens_generated = 0;
+    int context_size = 0;
+    bool is_stub = false;
+};
+
+class EngineHandles {
+public:
+    /** Engines loaded at the same time; a slot array this size is never reallocated. */
+    static constexpr size_t MAX_ENGINES = 64;
+
+    static EngineHandles& instance();
+
+    /**
+     * Take ownership of [engine] and give it a new engine_id. Returns the
+     * handle, or 0 with the engine freed if MAX_ENGINES are already loaded.
+     */
+    long long add(std::unique_ptr<LlamaContext> engine);
+
+    /** Lease on the engine behind [handle]; empty for 0, unknown or unloaded handles. */
+    EngineLease acquire(long long handle);
+
+    /**
+     * Exchange the engines behind two live handles. New leases see the
+     * exchange at once; leases already out keep the engine they hold.
+     */
+    bool swap(long long a, long long b);
+
+    /**
+     * Hot swap: give the engine behind [replacement] the settings configured
+     * on the engine behind [handle], then swap() the two.
+     */
+    bool swap_in(long long handle, long long replacement);
+
+    /**
+     * Invalidate [handle], wait until no lease holds its engine and hand the
+     * engine back to be freed. Null for a stale handle. Must not be called
+     * while the calling thread holds a lease on the same engine.
+     */
+    std::unique_ptr<LlamaContext> remove(long long handle);
+
+    HandleStats stats();
+
+    /**
+     * Mirror [engine]'s metrics into its slot, if it has one. Call after
+     * changing them, holding engine->mutex (or owning the engine).
+     */
+    void publish(const LlamaContext* engine);
+
+    /**
+     * Metrics last published for [handle], without locking or blocking.
+     * False for 0, unknown or unloaded handles.
+     */
+    bool read_metrics(long long handle, EngineMetrics& out) const;
+
+private:
+    friend class EngineLease;
+
+    struct Slot {
+        LlamaContext* engine = nullptr;
+        uint32_t generation = 1;
+    };
+
+    /** Lock-free copy of a slot's generation and metrics. */
+    struct PublishedSlot {
+        std::atomic<uint32_t> sequence{0};     // Odd while a write is in progress
+        std::atomic<uint32_t> generation{0};   // 0 = no engine
+        std::atomic<long long> memory_usage_bytes{0};
+        std::atomic<long long> load_time_ms{0};
+        std::atomic<long long> last_inference_time_ms{0};
+        std::atomic<int> last_tokens_generated{0};
+        std::atomic<int> context_size{0};
+        std::atomic<bool> is_stub{false};
+    };
+
+    EngineHandles();
+
+    /** Slot of a live [handle], or nullptr. Caller holds mutex_. */
+    Slot* resolve_locked(long long handle);
+    void release(LlamaContext* engine);
+    /** Write slot [index]'s published copy; caller holds mutex_, the only writer. */
+    void store_locked(size_t index, uint32_t generation, const EngineMetrics& metrics);
+    EngineMetrics load_locked(size_t index) const;
+
+    std::mutex mutex_;
+    std::condition_variable released_cv_;
+    std::vector<Slot> slots_;
+    std::vector<size_t> free_slots_;
+    std::unique_ptr<PublishedSlot[]> published_;   // MAX_ENGINES entries, indexed like slots_
+    std::unordered_map<LlamaContext*, int> leases_;
+    unsigned long long next_engine_id_ = 1;
+    HandleStats stats_;
+};
@@ -0,0 +1,45 @@
+/**
+ * Jeeves LLM Test Project - Per-request generation result
+ */
+
+#include "generate_stats.h"
+
+#include <algorithm>
+
+namespace {
+
+/** Nearest-rank percentile of sorted [values]. */
+long long percentile(const std::vector<long long>& values, int pct) {
+    size_t rank = (values.size() * pct + 99) / 100;
+    return values[rank > 0 ? rank - 1 : 0];
+}
+
+} // namespace
+
+void GenerateStats::set_token_times(std::vector<long long>& token_us) {
+    if (token_us.empty()) return;
+    std::sort(token_us.begin(), token_us.end());
+    token_min_us = token_us.front();
+    token_p50_us = percentile(token_us, 50);
+    token_p90_us = percentile(token_us, 90);
+    token_max_us = token_us.back();
+}
+
+void GenerateStats::to_array(long long out[COUNT]) const {
+    out[STOP_REASON] = stop_reason;
+    out[PROMPT_TOKENS] = prompt_tokens;
+    out[CACHED_PROMPT_TOKENS] = cached_prompt_tokens;
+    out[GENERATED_TOKENS] = generated_tokens;
+    out[TOKENIZE_US] = tokenize_us;
+    out[PROMPT_EVAL_US] = prompt_eval_us;
+    out[FIRST_TOKEN_US] = first_token_us;
+    out[GENERATION_US] = generation_us;
+    out[TOTAL_US] = total_us;
+    out[TOKEN_MIN_US] = token_min_us;
+    out[TOKEN_P50_US] = token_p50_us;
+    out[TOKEN_P90_US] = token_p90_us;
+    out[TOKEN_MAX_US] = token_max_us;
+    out[CONTEXT_SIZE] = context_size;
+    out[CONTEXT_RESIZE_MS] = context_resize_ms;
+    out[PROFILED_NODES] = profiled_nodes;
+}
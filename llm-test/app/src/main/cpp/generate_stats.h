@@ -0,0 +1,78 @@
+/**
+ * Jeeves LLM Test Project - Per-request generation result
+ *
+ * Everything LlamaEngine.generate reports about one request, filled in by
+ * the request and returned in the same JNI call as its output. Reading the
+ * engine's last_* fields afterwards raced with the next request on the same
+ * engine. A single inference time also mixed tokenization, prompt
+ * evaluation and generation, so tokens/s understated decode speed for long
+ * prompts.
+ *
+ * The phases split at the points a caller can act on: prompt length and
+ * prefix reuse drive TOKENIZE_US and PROMPT_EVAL_US, FIRST_TOKEN_US is the
+ * latency the user sees, and GENERATION_US with the per-token spread is the
+ * decode speed.
+ */
+
+#pragma once
+
+#include <vector>
+
+/** Values mirror LlamaEngine.StopReason on the Kotlin side. */
+enum StopReason : int {
+    STOP_NONE = 0,              // No request ran (stale handle)
+    STOP_EOG,                   // The model ended the turn
+    STOP_MAX_TOKENS,
+    STOP_CONTEXT_FULL,          // The context could not grow to fit max tokens
+    STOP_OUTPUT_FULL,           // The caller's output buffer is full
+    STOP_DECODE_ERROR,          // Decode failed mid-generation; output so far is kept
+    STOP_ERROR,                 // Failed before the first token
+    STOP_ENGINE_CHANGED,        // Unloaded or swapped while a background request yielded
+};
+
+/**
+ * One request's phases and counts. Flattened for JNI as the Index fields.
+ */
+struct GenerateStats {
+    enum Index {
+        STOP_REASON = 0,
+        PROMPT_TOKENS,
+        CACHED_PROMPT_TOKENS,       // Reused from the previous request's KV cache
+        GENERATED_TOKENS,
+        TOKENIZE_US,
+        PROMPT_EVAL_US,
+        FIRST_TOKEN_US,             // Request start to the first generated token
+        GENERATION_US,              // End of prompt eval to the last decode
+        TOTAL_US,
+        TOKEN_MIN_US,               // Sample + decode time per generated token
+        TOKEN_P50_US,
+        TOKEN_P90_US,
+        TOKEN_MAX_US,
+        CONTEXT_SIZE,
+        CONTEXT_RESIZE_MS,          // Growing the context before decoding
+        PROFILED_NODES,             // Ops timed by ComputeProfiler; 0 when not sampled
+        COUNT
+    };
+
+    int stop_reason = STOP_NONE;
+    int prompt_tokens = 0;
+    int cached_prompt_tokens = 0;
+    int generated_tokens = 0;
+    long long tokenize_us = 0;
+    long long prompt_eval_us = 0;
+    long long first_token_us = 0;
+    long long generation_us = 0;
+    long long total_us = 0;
+    long long token_min_us = 0;
+    long long token_p50_us = 0;
+    long long token_p90_us = 0;
+    long long token_max_us = 0;
+    long long context_size = 0;
+    long long context_resize_ms = 0;
+    long long profiled_nodes = 0;
+
+    /** Set the TOKEN_* fields from per-token times (reordered in place). */
+    void set_token_times(std::vector<long long>& token_us);
+
+    void to_array(long long out[COUNT]) const;
+};
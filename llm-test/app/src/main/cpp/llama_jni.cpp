@@ -5,8 +5,8 @@
  */
 
 #include <jni.h>
-#include <android/log.h>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <mutex>
@@ -16,46 +16,31 @@
 #include <cmath>
 #include <iomanip>
 #include <thread>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
 
-#define LOG_TAG "LlamaJNI"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
-
-#if LLAMA_AVAILABLE
-#include "llama.h"
-#endif
-
-// ============================================================================
-// Context wrapper for thread-safe model access
-// ============================================================================
-
-struct LlamaContext {
-#if LLAMA_AVAILABLE
-    llama_model* model = nullptr;
-    llama_context* ctx = nullptr;
-#endif
-    std::mutex mutex;
-    bool is_stub = false;
-    
-    long long load_time_ms = 0;
-    long long last_inference_time_ms = 0;
-    int last_tokens_generated = 0;
-    size_t memory_usage_bytes = 0;
-    
-    LlamaContext() {
-#if !LLAMA_AVAILABLE
-        is_stub = true;
-#endif
-    }
-    
-    ~LlamaContext() {
-#if LLAMA_AVAILABLE
-        if (ctx) llama_free(ctx);
-        if (model) llama_model_free(model);
-#endif
-    }
-};
+#include "autotune.h"
+#include "context_options.h"
+#include "cpu_backend.h"
+#include "cpu_topology.h"
+#include "device_probe.h"
+#include "elastic_context.h"
+#include "engine_context.h"
+#include "engine_handles.h"
+#include "generate_stats.h"
+#include "llama_log.h"
+#include "memory_stats.h"
+#include "memory_trim.h"
+#include "model_archs.h"
+#include "perf_metrics.h"
+#include "pgo.h"
+#include "repack_cache.h"
+#include "requantize.h"
+#include "sha256.h"
+#include "teardown.h"
+#include "thread_control.h"
+#include "thread_pool.h"
 
 // ============================================================================
 // Stub implementation for testing without llama.cpp
@@ -133,6 +118,12 @@ std::string classify_eisenhower(const std::string& task_text) {
     return json.str();
 }
 
+/** Stub tokens are the prompt's UTF-8 bytes. */
+std::vector<int32_t> tokenize(std::string_view text) {
+    return std::vector<int32_t>(reinterpret_cast<const uint8_t*>(text.data()),
+                                reinterpret_cast<const uint8_t*>(text.data()) + text.size());
+}
+
 void simulate_delay(int tokens) {
     int delay_ms = (tokens * 1000) / SIMULATED_TOKENS_PER_SEC;
     std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
@@ -140,14 +131,419 @@ void simulate_delay(int tokens) {
 
 } // namespace stub
 
+// ============================================================================
+// Memory accounting
+// ============================================================================
+
+/** Caller holds wrapper->mutex: trim, restore and resize change what this reads. */
+static MemoryBreakdown collect_memory(LlamaContext* wrapper) {
+    MemoryBreakdown m;
+#if LLAMA_AVAILABLE
+    m.weights_mapped_bytes = wrapper->model_ref.mapped_bytes();
+    m.weights_resident_bytes = m.weights_mapped_bytes > 0
+        ? read_mapping_rss(wrapper->model_ref.path())
+        : wrapper->model_ref.size_bytes();
+    m.kv_cache_bytes = wrapper->kv_cache_bytes;
+    m.compute_buffer_bytes = wrapper->compute_buffer_bytes;
+#else
+    m.weights_mapped_bytes = stub::SIMULATED_MODEL_SIZE;
+    m.weights_resident_bytes = stub::SIMULATED_MODEL_SIZE;
+#endif
+    read_process_memory(m.process);
+    return m;
+}
+
+static std::vector<int> to_int_vector(JNIEnv* env, jintArray array) {
+    std::vector<int> values;
+    if (!array) return values;
+    values.resize(env->GetArrayLength(array));
+    env->GetIntArrayRegion(array, 0, static_cast<jsize>(values.size()), reinterpret_cast<jint*>(values.data()));
+    return values;
+}
+
+static jlongArray to_jlong_array(JNIEnv* env, const std::vector<long long>& values) {
+    jlongArray result = env->NewLongArray(static_cast<jsize>(values.size()));
+    if (!result) return result;
+    env->SetLongArrayRegion(result, 0, static_cast<jsize>(values.size()),
+                            reinterpret_cast<const jlong*>(values.data()));
+    return result;
+}
+
+static void append_utf8(std::string& out, uint32_t c) {
+    if (c < 0x80) {
+        out += static_cast<char>(c);
+    } else if (c < 0x800) {
+        out += static_cast<char>(0xC0 | (c >> 6));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        out += static_cast<char>(0xE0 | (c >> 12));
+        out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (c >> 18));
+        out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    }
+}
+
+/**
+ * Standard UTF-8 of [s]. GetStringUTFChars gives modified UTF-8, which
+ * encodes emoji and other supplementary characters as two 3-byte surrogates
+ * the tokenizer does not recognise.
+ */
+static std::string jstring_to_utf8(JNIEnv* env, jstring s) {
+    std::string out;
+    if (!s) return out;
+    const jsize len = env->GetStringLength(s);
+    const jchar* chars = env->GetStringCritical(s, nullptr);
+    if (!chars) return out;
+    out.reserve(len);
+    for (jsize i = 0; i < len; i++) {
+        uint32_t c = chars[i];
+        if (c >= 0xD800 && c <= 0xDBFF && i + 1 < len && chars[i + 1] >= 0xDC00 && chars[i + 1] <= 0xDFFF) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (chars[++i] - 0xDC00);
+        } else if (c >= 0xD800 && c <= 0xDFFF) {
+            c = 0xFFFD;
+        }
+        append_utf8(out, c);
+    }
+    env->ReleaseStringCritical(s, chars);
+    return out;
+}
+
+/**
+ * String from standard UTF-8; invalid or truncated sequences become U+FFFD.
+ * NewStringUTF expects modified UTF-8 and rejects 4-byte sequences.
+ */
+static jstring utf8_to_jstring(JNIEnv* env, const char* text, size_t size) {
+    static const uint32_t MIN_CODE_POINT[] = {0, 0x80, 0x800, 0x10000};
+    std::u16string out;
+    out.reserve(size);
+    const auto* bytes = reinterpret_cast<const uint8_t*>(text);
+    size_t i = 0;
+    while (i < size) {
+        const uint8_t b = bytes[i];
+        int extra = b < 0x80 ? 0 : (b & 0xE0) == 0xC0 ? 1 : (b & 0xF0) == 0xE0 ? 2 : (b & 0xF8) == 0xF0 ? 3 : -1;
+        uint32_t c = extra == 0 ? b : extra == 1 ? (b & 0x1F) : extra == 2 ? (b & 0x0F) : (b & 0x07);
+        int n = 1;
+        while (extra > 0 && n <= extra && i + n < size && (bytes[i + n] & 0xC0) == 0x80) {
+            c = (c << 6) | (bytes[i + n] & 0x3F);
+            n++;
+        }
+        if (extra < 0 || n != extra + 1 || c < MIN_CODE_POINT[extra] || c > 0x10FFFF ||
+            (c >= 0xD800 && c <= 0xDFFF)) {
+            out.push_back(0xFFFD);
+            i += n;
+            continue;
+        }
+        if (c >= 0x10000) {
+            out.push_back(static_cast<char16_t>(0xD800 + ((c - 0x10000) >> 10)));
+            out.push_back(static_cast<char16_t>(0xDC00 + ((c - 0x10000) & 0x3FF)));
+        } else {
+            out.push_back(static_cast<char16_t>(c));
+        }
+        i += n;
+    }
+    return env->NewString(reinterpret_cast<const jchar*>(out.data()), static_cast<jsize>(out.size()));
+}
+
+/** Start of a direct buffer holding at least [length] bytes, or nullptr. */
+static void* direct_buffer(JNIEnv* env, jobject buffer, jlong length) {
+    if (!buffer || length < 0) return nullptr;
+    void* address = env->GetDirectBufferAddress(buffer);
+    if (!address || env->GetDirectBufferCapacity(buffer) < length) return nullptr;
+    return address;
+}
+
+static jintArray to_jint_array(JNIEnv* env, const std::vector<int32_t>& values) {
+    jintArray result = env->NewIntArray(static_cast<jsize>(values.size()));
+    if (!result) return result;
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(values.size()),
+                           reinterpret_cast<const jint*>(values.data()));
+    return result;
+}
+
+// ============================================================================
+// Generation
+// ============================================================================
+
+/** One generate call. The prompt is UTF-8 [text], or [tokens] when set. */
+struct GenerateRequest {
+    std::string_view text;
+    const int32_t* tokens = nullptr;
+    size_t n_tokens = 0;
+    int max_tokens = 0;
+    float temperature = 0.0f;
+    float top_p = 0.0f;
+    int qos = QOS_INTERACTIVE;
+    long long enqueued_ns = 0;      // Caller's System.nanoTime() at submission; 0 = on entry
+};
+
+/**
+ * Generated UTF-8, token IDs and the request's stats. With [buffer] set the
+ * text is written there and generation stops before a piece would overflow
+ * [capacity].
+ */
+struct GenerateOutput {
+    char* buffer = nullptr;
+    size_t capacity = 0;
+    size_t bytes = 0;
+    std::string text;
+    std::vector<int32_t> tokens;
+    GenerateStats stats;
+    std::vector<long long> token_us;    // Per-token times, for PerfMetrics
+    ThrottleReport throttle;            // Thread control decisions
+    std::string profile;                // ComputeProfiler::report when sampled
+
+    bool append(const char* piece, size_t n) {
+        if (!buffer) {
+            text.append(piece, n);
+        } else if (bytes + n <= capacity) {
+            memcpy(buffer + bytes, piece, n);
+        } else {
+            return false;
+        }
+        bytes += n;
+        return true;
+    }
+};
+
+static long long elapsed_us(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - since).count();
+}
+
+/**
+ * Throttle report and profile of the calling thread's last generate call.
+ * LlamaEngine reads them right after the call on the same thread, so a
+ * request on the same engine finishing in between cannot replace them.
+ */
+struct LastRequest {
+    ThrottleReport throttle;
+    std::string profile;
+};
+
+static thread_local LastRequest last_request;
+
+/**
+ * The engine a generate call runs on: a lease on its handle and the engine
+ * mutex. A background request gives both back while it yields, so a pause
+ * or a long background generation never holds up interactive requests,
+ * unload or hot swap on the same engine.
+ */
+class EngineSession {
+public:
+    EngineSession(long long handle, int qos)
+        : handle_(handle), qos_(qos), lease_(EngineHandles::instance().acquire(handle)) {
+        if (lease_) lock();
+    }
+
+    EngineSession(const EngineSession&) = delete;
+    EngineSession& operator=(const EngineSession&) = delete;
+
+    LlamaContext* get() const { return lease_.get(); }
+    LlamaContext* operator->() const { return lease_.get(); }
+    explicit operator bool() const { return static_cast<bool>(lease_); }
+
+    /** Hand the engine back. Nothing may touch it until resume(). */
+    void release() {
+        lock_.unlock();
+        lease_.reset();
+    }
+
+    /** Take the engine back; false if the handle was unloaded or now leads to another engine. */
+    bool resume(unsigned long long engine_id) {
+        lease_ = EngineHandles::instance().acquire(handle_);
+        if (!lease_ || lease_->engine_id != engine_id) {
+            lease_.reset();
+            return false;
+        }
+        lock();
+        return true;
+    }
+
+private:
+    void lock() {
+        const bool interactive = qos_ != QOS_BACKGROUND;
+        if (interactive) lease_->interactive_waiting.fetch_add(1, std::memory_order_relaxed);
+        lock_ = std::unique_lock<std::mutex>(lease_->mutex);
+        if (interactive) lease_->interactive_waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    long long handle_;
+    int qos_;
+    EngineLease lease_;
+    std::unique_lock<std::mutex> lock_;     // Declared after lease_: unlocks before the lease ends
+};
+
+#if LLAMA_AVAILABLE
+/** Tokenize [text]; a negative llama_tokenize result is the required token count. */
+static bool tokenize_text(const llama_vocab* vocab, std::string_view text, bool add_special,
+                          std::vector<llama_token>& tokens) {
+    tokens.resize(text.size() + 16);
+    int n_tokens = llama_tokenize(vocab, text.data(), static_cast<int32_t>(text.size()),
+                                  tokens.data(), static_cast<int32_t>(tokens.size()), add_special, false);
+    if (n_tokens < 0) {
+        tokens.resize(-n_tokens);
+        n_tokens = llama_tokenize(vocab, text.data(), static_cast<int32_t>(text.size()),
+                                  tokens.data(), static_cast<int32_t>(tokens.size()), add_special, false);
+    }
+    if (n_tokens < 0) return false;
+    tokens.resize(n_tokens);
+    return true;
+}
+
+/** Caller-supplied IDs must be checked: llama indexes the vocabulary with them. */
+static bool tokens_in_vocab(const llama_vocab* vocab, const int32_t* tokens, size_t n) {
+    const int32_t n_vocab = llama_vocab_n_tokens(vocab);
+    for (size_t i = 0; i < n; i++) {
+        if (tokens[i] < 0 || tokens[i] >= n_vocab) {
+            LOGE("Token %d out of vocabulary range", tokens[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Decode tokens[from, to) into sequence 0 in n_batch chunks and append them
+ * to wrapper->cached_tokens. [logits_last] requests logits for the last one.
+ */
+static bool decode_tokens(LlamaContext* wrapper, const std::vector<llama_token>& tokens,
+                          int from, int to, bool logits_last, int qos) {
+    const int n_batch = static_cast<int>(llama_n_batch(wrapper->ctx));
+    llama_batch batch = llama_batch_init(n_batch, 0, 1);
+    bool ok = true;
+    for (int chunk = from; chunk < to && ok; chunk += n_batch) {
+        int n_chunk = std::min(n_batch, to - chunk);
+        for (int i = 0; i < n_chunk; i++) {
+            batch.token[i] = tokens[chunk + i];
+            batch.pos[i] = chunk + i;
+            batch.n_seq_id[i] = 1;
+            batch.seq_id[i][0] = 0;
+            batch.logits[i] = logits_last && chunk + i == to - 1;
+        }
+        batch.n_tokens = n_chunk;
+        
+        ok = SharedThreadPools::instance().decode(wrapper->ctx, batch, qos) == 0;
+        if (ok) {
+            wrapper->cached_tokens.insert(wrapper->cached_tokens.end(), tokens.begin() + chunk,
+                                          tokens.begin() + chunk + n_chunk);
+        }
+    }
+    llama_batch_free(batch);
+    return ok;
+}
+
+/**
+ * Make sequence 0 hold [held] again after a yield: as left, from the [saved]
+ * state, or by decoding what is missing after the longest prefix still there.
+ */
+static int restore_sequence(LlamaContext* wrapper, const std::vector<llama_token>& held,
+                            const std::vector<uint8_t>& saved, uint32_t needed_ctx) {
+    if (wrapper->ctx && wrapper->cached_tokens == held) return STOP_NONE;
+    if (!restore_engine(wrapper) || ensure_context_capacity(wrapper, needed_ctx) < needed_ctx) {
+        return STOP_DECODE_ERROR;
+    }
+    if (wrapper->cached_tokens == held) return STOP_NONE;
+    
+    llama_memory_t mem = llama_get_memory(wrapper->ctx);
+    if (!saved.empty()) {
+        llama_memory_clear(mem, true);
+        wrapper->cached_tokens.clear();
+        if (llama_state_seq_set_data(wrapper->ctx, saved.data(), saved.size(), 0) == saved.size()) {
+            wrapper->cached_tokens = held;
+            return STOP_NONE;
+        }
+    }
+    
+    size_t n_past = 0;
+    const auto& cached = wrapper->cached_tokens;
+    while (n_past < cached.size() && n_past < held.size() && cached[n_past] == held[n_past]) {
+        n_past++;
+    }
+    if (n_past == 0 || !llama_memory_seq_rm(mem, 0, static_cast<llama_pos>(n_past), -1)) {
+        n_past = 0;
+        llama_memory_clear(mem, true);
+    }
+    wrapper->cached_tokens.resize(n_past);
+    LOGD("Background request resumed: decoding %zu of %zu tokens again", held.size() - n_past, held.size());
+    if (!decode_tokens(wrapper, held, static_cast<int>(n_past), static_cast<int>(held.size()), false,
+                       QOS_BACKGROUND)) {
+        llama_memory_clear(mem, true);
+        wrapper->cached_tokens.clear();
+        return STOP_DECODE_ERROR;
+    }
+    return STOP_NONE;
+}
+
+/**
+ * Yield the engine of a background request while interactive requests run or
+ * background work is paused, then take it back with sequence 0 restored.
+ * Called between decodes, when the KV holds exactly wrapper->cached_tokens
+ * and no logits are pending.
+ * 
+ * If an interactive request is waiting for this engine it will reuse the
+ * sequence, so the KV is saved first. Otherwise it is usually untouched on
+ * resume; if another request or a trim changed it meanwhile, the missing
+ * tokens are decoded again. [needed_ctx] is the context the request was
+ * sized for; [threads] / [threads_batch] its thread counts.
+ * 
+ * @return STOP_NONE once the engine is back, else why the request must stop
+ */
+static int yield_engine(EngineSession& session, ProfiledRequest& profiled, uint32_t needed_ctx,
+                        int threads, int threads_batch) {
+    LlamaContext* wrapper = session.get();
+    const unsigned long long engine_id = wrapper->engine_id;
+    const std::vector<llama_token> held = wrapper->cached_tokens;
+    std::vector<uint8_t> saved;
+    if (wrapper->interactive_waiting.load(std::memory_order_relaxed) > 0 && !held.empty()) {
+        saved.resize(llama_state_seq_get_size(wrapper->ctx, 0));
+        if (llama_state_seq_get_data(wrapper->ctx, saved.data(), saved.size(), 0) != saved.size()) {
+            saved.clear();
+        }
+    }
+    // Requests that run meanwhile get the configured thread counts
+    llama_set_n_threads(wrapper->ctx, wrapper->ctx_params.n_threads, wrapper->ctx_params.n_threads_batch);
+    
+    profiled.suspend();
+    session.release();
+    SharedThreadPools::instance().wait_for_background_turn();
+    if (!session.resume(engine_id)) {
+        LOGW("Engine unloaded or replaced while a background request yielded");
+        return STOP_ENGINE_CHANGED;
+    }
+    profiled.resume(wrapper->profiler);
+    
+    const int stop = restore_sequence(wrapper, held, saved, needed_ctx);
+    if (stop == STOP_NONE) llama_set_n_threads(wrapper->ctx, threads, threads_batch);
+    return stop;
+}
+#endif
+
 // ============================================================================
 // JNI Functions
 // ============================================================================
 
-extern "C" {
+// Bound by RegisterNatives in JNI_OnLoad, not by exported symbol names, so
+// each engine class can live in any package.
+namespace {
 
-JNIEXPORT void JNICALL
-Java_app_jeeves_llmtest_engine_LlamaEngine_initBackend(JNIEnv* env, jobject thiz) {
+/**
+ * Load the best CPU backend variant (from [libDir], or the app's library
+ * path when null) and initialize llama.cpp. Only the first call loads.
+ */
+void JNICALL
+initBackend(JNIEnv* env, jobject thiz, jstring libDir) {
+    record_teardown_baseline();
+    std::string dir;
+    if (libDir) {
+        const char* d = env->GetStringUTFChars(libDir, nullptr);
+        dir = d;
+        env->ReleaseStringUTFChars(libDir, d);
+    }
+    load_cpu_backend(dir);
 #if LLAMA_AVAILABLE
     llama_backend_init();
     LOGI("llama.cpp backend initialized (real implementation)");
@@ -156,12 +552,38 @@ Java_app_jeeves_llmtest_engine_LlamaEngine_initBackend(JNIEnv* env, jobject thiz
 #endif
 }
 
-JNIEXPORT jlong JNICALL
-Java_app_jeeves_llmtest_engine_LlamaEngine_nativeLoadModel(
-    JNIEnv* env, jobject thiz, jstring modelPath, jint contextSize, jint nThreads
+jlong JNICALL
+nativeLoadModel(
+    JNIEnv* env, jobject thiz, jstring modelPath, jint contextSize, jint nThreads,
+    jlong memoryBudgetBytes, jint nThreadsBatch, jint nBatch, jint nUbatch, jint nSeqMax,
+    jint typeK, jint typeV, jint flashAttn
 ) {
+    ContextOptions options;
+    options.n_ctx = contextSize;
+    options.n_threads = nThreads;
+    options.n_threads_batch = nThreadsBatch;
+    options.n_batch = nBatch;
+    options.n_ubatch = nUbatch;
+    options.n_seq_max = nSeqMax;
+    options.type_k = typeK;
+    options.type_v = typeV;
+    options.flash_attn = flashAttn;
+    
+    // Threads, batch sizes and KV types passed as 0 are left to a tuned
+    // configuration for this model, then to the defaults
+    const int default_threads = system_cpu_topology().recommended_threads(CPU_POLICY_PERFORMANCE);
+    ContextOptions untuned = options;
+    untuned.fill_unset(default_threads);
+    std::string error;
+    if (!untuned.validate(error)) {
+        LOGE("Invalid context options: %s", error.c_str());
+        return 0;
+    }
+    
     const char* path = env->GetStringUTFChars(modelPath, nullptr);
-    LOGI("Loading model from: %s (context=%d, threads=%d)", path, contextSize, nThreads);
+    LOGI("Loading model from: %s (context=%d, threads=%d/%d, batch=%d/%d, seq=%d, kv=%d/%d, fa=%d)",
+         path, contextSize, nThreads, options.n_threads_batch, nBatch, nUbatch, nSeqMax,
+         typeK, typeV, flashAttn);
     
     // Check if file is readable
     FILE* f = fopen(path, "rb");
@@ -176,40 +598,54 @@ Java_app_jeeves_llmtest_engine_LlamaEngine_nativeLoadModel(
     LOGI("File size: %ld bytes", size);
     
     auto start = std::chrono::steady_clock::now();
-    auto* wrapper = new LlamaContext();
+    std::unique_ptr<LlamaContext> wrapper(new LlamaContext());
     
 #if LLAMA_AVAILABLE
-    LOGI("Creating model params...");
-    llama_model_params model_params = llama_model_default_params();
-    model_params.n_gpu_layers = 0;
+    ModelLoadParams load_params;
+    load_params.n_gpu_layers = 0;
     
-    LOGI("Calling llama_model_load_from_file...");
-    wrapper->model = llama_model_load_from_file(path, model_params);
+    LOGI("Acquiring model from registry...");
+    wrapper->model_path = path;
+    wrapper->load_params = load_params;
+    wrapper->model_ref = ModelRegistry::instance().acquire(path, load_params);
+    wrapper->model = wrapper->model_ref.get();
     if (!wrapper->model) {
-        LOGE("Failed to load model - llama_model_load_from_file returned null");
+        LOGE("Failed to load model");
         env->ReleaseStringUTFChars(modelPath, path);
-        delete wrapper;
         return 0;
     }
     LOGI("Model loaded successfully");
     
+    TunedConfig tuned;
+    if (autotune_store_configured() && load_tuned_config(autotune_key(wrapper->model), tuned)) {
+        tuned.apply(options);
+        options.fill_unset(default_threads);
+        if (options.validate(error)) {
+            LOGI("Using tuned config: threads=%d/%d, batch=%d/%d, kv=%d/%d",
+                 options.n_threads, options.n_threads_batch, options.n_batch, options.n_ubatch,
+                 options.type_k, options.type_v);
+        } else {
+            LOGW("Ignoring tuned config: %s", error.c_str());
+            options = untuned;
+        }
+    } else {
+        options = untuned;
+    }
+    
     llama_context_params ctx_params = llama_context_default_params();
-    ctx_params.n_ctx = contextSize;
-    ctx_params.n_threads = nThreads;
-    ctx_params.n_threads_batch = nThreads;
+    options.apply(ctx_params);
+    wrapper->memory_budget_bytes = memoryBudgetBytes > 0 ? static_cast<size_t>(memoryBudgetBytes) : 0;
     
     LOGI("Creating context...");
-    wrapper->ctx = llama_init_from_model(wrapper->model, ctx_params);
-    if (!wrapper->ctx) {
+    if (!create_context(wrapper.get(), ctx_params, wrapper->memory_budget_bytes)) {
         LOGE("Failed to create context");
-        llama_model_free(wrapper->model);
         env->ReleaseStringUTFChars(modelPath, path);
-        delete wrapper;
         return 0;
     }
-    LOGI("Context created successfully");
+    LOGI("Context created successfully (n_ctx=%u)", llama_n_ctx(wrapper->ctx));
     
-    wrapper->memory_usage_bytes = llama_state_get_size(wrapper->ctx);
+    wrapper->memory_usage_bytes = wrapper->model_ref.size_bytes()
+        + wrapper->kv_cache_bytes + wrapper->compute_buffer_bytes;
 #else
     std::this_thread::sleep_for(std::chrono::milliseconds(stub::SIMULATED_LOAD_TIME_MS));
     wrapper->is_stub = true;
@@ -220,83 +656,177 @@ Java_app_jeeves_llmtest_engine_LlamaEngine_nativeLoadModel(
     wrapper->load_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
     
     env->ReleaseStringUTFChars(modelPath, path);
-    LOGI("Model loaded in %lld ms. Memory: %zu bytes", wrapper->load_time_ms, wrapper->memory_usage_bytes);
+    LOGI("Model loaded in %lld ms. Memory: %zu bytes (kv=%zu, compute=%zu)", wrapper->load_time_ms,
+         wrapper->memory_usage_bytes, wrapper->kv_cache_bytes, wrapper->compute_buffer_bytes);
     
-    return reinterpret_cast<jlong>(wrapper);
+    return EngineHandles::instance().add(std::move(wrapper));
 }
 
-JNIEXPORT jstring JNICALL
-Java_app_jeeves_llmtest_engine_LlamaEngine_nativeGenerate(
-    JNIEnv* env, jobject thiz, jlong handle, jstring prompt,
-    jint maxTokens, jfloat temperature, jfloat topP
-) {
-    if (handle == 0) return env->NewStringUTF("");
-    
-    auto* wrapper = reinterpret_cast<LlamaContext*>(handle);
-    std::lock_guard<std::mutex> lock(wrapper->mutex);
-    
-    const char* promptStr = env->GetStringUTFChars(prompt, nullptr);
-    std::string promptCpp(promptStr);
-    env->ReleaseStringUTFChars(prompt, promptStr);
-    
+/**
+ * Run [request] on the engine of [session], appending to [out]. A background
+ * request yields the engine between decodes while interactive work runs or
+ * background work is paused.
+ */
+bool run_generate(EngineSession& session, const GenerateRequest& request, GenerateOutput& out) {
+    LlamaContext* wrapper = session.get();
     auto start = std::chrono::steady_clock::now();
-    std::string result;
     int tokens_generated = 0;
+    GenerateStats& stats = out.stats;
+    stats.stop_reason = STOP_ERROR;     // Until the first token
     
 #if LLAMA_AVAILABLE
+    const int qos = request.qos;
+    ProfiledRequest profiled(wrapper->profiler);
+    
+    // Undo any memory trim since the last request
+    if (!restore_engine(wrapper)) {
+        return false;
+    }
+    
     // Get vocabulary
     const llama_vocab* vocab = llama_model_get_vocab(wrapper->model);
     
-    // Tokenize input
-    std::vector<llama_token> tokens(llama_n_ctx(wrapper->ctx));
-    int n_tokens = llama_tokenize(vocab, promptCpp.c_str(), promptCpp.length(),
-                                   tokens.data(), tokens.size(), true, false);
-    if (n_tokens < 0) {
+    wrapper->last_used = start;
+    wrapper->resize_stats.last_request_resize_ms = 0;
+    
+    // Token IDs from the caller skip tokenization (cached system prompts)
+    std::vector<llama_token> tokens;
+    if (request.tokens) {
+        if (!tokens_in_vocab(vocab, request.tokens, request.n_tokens)) return false;
+        tokens.assign(request.tokens, request.tokens + request.n_tokens);
+    } else if (!tokenize_text(vocab, request.text, true, tokens)) {
         LOGE("Tokenization failed");
-        return env->NewStringUTF("");
+        return false;
     }
-    tokens.resize(n_tokens);
+    const int n_tokens = static_cast<int>(tokens.size());
+    if (n_tokens == 0) {
+        LOGE("Empty prompt");
+        return false;
+    }
+    stats.prompt_tokens = n_tokens;
+    stats.tokenize_us = elapsed_us(start);
     LOGD("Tokenized %d tokens", n_tokens);
     
-    // Clear KV cache
+    // Grow the context if prompt + generation does not fit
+    uint32_t capacity = ensure_context_capacity(wrapper, n_tokens + std::max(request.max_tokens, 0));
+    if (!wrapper->ctx || static_cast<uint32_t>(n_tokens) >= capacity) {
+        LOGE("Prompt of %d tokens does not fit context of %u tokens", n_tokens, capacity);
+        return false;
+    }
+    int max_new_tokens = std::min<int>(request.max_tokens, capacity - n_tokens);
+    const bool context_limited = max_new_tokens < request.max_tokens;
+    
+    // Reuse KV for the prefix shared with the previous request (system prompt,
+    // few-shot examples). At least the last prompt token is decoded for logits.
     llama_memory_t mem = llama_get_memory(wrapper->ctx);
-    llama_memory_clear(mem, true);
+    int n_past = 0;
+    const auto& cached = wrapper->cached_tokens;
+    while (n_past < static_cast<int>(cached.size()) && n_past < n_tokens - 1 &&
+           cached[n_past] == tokens[n_past]) {
+        n_past++;
+    }
+    if (n_past > 0 && !llama_memory_seq_rm(mem, 0, n_past, -1)) {
+        n_past = 0;
+    }
+    if (n_past == 0) {
+        llama_memory_clear(mem, true);
+    }
+    wrapper->cached_tokens.assign(tokens.begin(), tokens.begin() + n_past);
+    stats.cached_prompt_tokens = n_past;
+    LOGD("Prefix cache: reusing %d of %d prompt tokens", n_past, n_tokens);
+    
+    // Background requests fit the smaller background pool
+    const int config_threads = static_cast<int>(wrapper->ctx_params.n_threads);
+    const int config_threads_batch = static_cast<int>(wrapper->ctx_params.n_threads_batch);
+    int base_threads = config_threads;
+    int base_threads_batch = config_threads_batch;
+    if (qos == QOS_BACKGROUND) {
+        const int background = SharedThreadPools::instance().background_threads();
+        base_threads = std::min(base_threads, background);
+        base_threads_batch = std::min(base_threads_batch, background);
+        llama_set_n_threads(wrapper->ctx, base_threads, base_threads_batch);
+    }
     
-    // Create batch for prompt
-    llama_batch batch = llama_batch_init(tokens.size(), 0, 1);
-    for (size_t i = 0; i < tokens.size(); i++) {
-        batch.token[i] = tokens[i];
-        batch.pos[i] = i;
-        batch.n_seq_id[i] = 1;
-        batch.seq_id[i][0] = 0;
-        batch.logits[i] = (i == tokens.size() - 1);
+    // Between decodes a background request gives the engine to interactive work
+    const uint32_t needed_ctx = static_cast<uint32_t>(n_tokens + std::max(max_new_tokens, 0));
+    auto yield_point = [&](int threads) -> int {
+        if (qos != QOS_BACKGROUND || !SharedThreadPools::instance().background_must_yield()) return STOP_NONE;
+        const int stop = yield_engine(session, profiled, needed_ctx, threads, base_threads_batch);
+        if (stop == STOP_NONE) {
+            // A trim may have reloaded the model or recreated the context
+            vocab = llama_model_get_vocab(wrapper->model);
+            mem = llama_get_memory(wrapper->ctx);
+        }
+        return stop;
+    };
+    
+    // Decode the rest of the prompt in n_batch sized chunks
+    auto prompt_start = std::chrono::steady_clock::now();
+    const int n_batch = static_cast<int>(llama_n_batch(wrapper->ctx));
+    for (int chunk = n_past; chunk < n_tokens; chunk += n_batch) {
+        const int chunk_end = std::min(chunk + n_batch, n_tokens);
+        const int stop = yield_point(base_threads);
+        if (stop == STOP_ENGINE_CHANGED) {
+            stats.stop_reason = stop;
+            return false;
+        }
+        if (stop != STOP_NONE || !decode_tokens(wrapper, tokens, chunk, chunk_end, chunk_end == n_tokens, qos)) {
+            LOGE("Prompt decode failed");
+            wrapper->cached_tokens.clear();
+            if (wrapper->ctx) {
+                llama_set_n_threads(wrapper->ctx, config_threads, config_threads_batch);
+                llama_memory_clear(mem, true);
+            }
+            return false;
+        }
     }
-    batch.n_tokens = tokens.size();
     
-    if (llama_decode(wrapper->ctx, batch) != 0) {
-        LOGE("Prompt decode failed");
-        llama_batch_free(batch);
-        return env->NewStringUTF("");
+    stats.prompt_eval_us = elapsed_us(prompt_start);
+    auto generation_start = std::chrono::steady_clock::now();
+    double prompt_ms = stats.prompt_eval_us / 1000.0;
+    if (n_tokens > n_past) {
+        double per_token = prompt_ms / (n_tokens - n_past);
+        wrapper->prompt_ms_per_token = wrapper->prompt_ms_per_token > 0
+            ? 0.7 * wrapper->prompt_ms_per_token + 0.3 * per_token : per_token;
     }
-    llama_batch_free(batch);
     
     // Setup sampler
     llama_sampler* sampler = llama_sampler_chain_init(llama_sampler_chain_default_params());
-    llama_sampler_chain_add(sampler, llama_sampler_init_temp(temperature));
-    llama_sampler_chain_add(sampler, llama_sampler_init_top_p(topP, 1));
+    llama_sampler_chain_add(sampler, llama_sampler_init_temp(request.temperature));
+    llama_sampler_chain_add(sampler, llama_sampler_init_top_p(request.top_p, 1));
     llama_sampler_chain_add(sampler, llama_sampler_init_dist(42));
     
+    // Adapt the generate thread count to latency and temperature for this request
+    std::unique_ptr<AdaptiveThreadController> thread_control;
+    if (wrapper->thread_control.enabled) {
+        thread_control.reset(new AdaptiveThreadController(wrapper->thread_control, base_threads));
+    }
+    
     // Generate tokens
     int n_cur = tokens.size();
-    for (int i = 0; i < maxTokens; i++) {
+    int stop_reason = context_limited ? STOP_CONTEXT_FULL : STOP_MAX_TOKENS;
+    std::vector<long long>& token_us = out.token_us;
+    token_us.reserve(std::max(max_new_tokens, 0));
+    for (int i = 0; i < max_new_tokens; i++) {
+        auto token_start = std::chrono::steady_clock::now();
         llama_token new_token = llama_sampler_sample(sampler, wrapper->ctx, -1);
+        if (profiled.active()) {
+            wrapper->profiler.record("SAMPLE", "", nullptr, -1, elapsed_us(token_start));
+        }
         
-        if (llama_vocab_is_eog(vocab, new_token)) break;
+        if (llama_vocab_is_eog(vocab, new_token)) {
+            stop_reason = STOP_EOG;
+            break;
+        }
         
         char buf[256];
         int n = llama_token_to_piece(vocab, new_token, buf, sizeof(buf), 0, true);
-        if (n > 0) result.append(buf, n);
-        tokens_generated++;
+        if (n > 0 && !out.append(buf, n)) {
+            stop_reason = STOP_OUTPUT_FULL;
+            break;
+        }
+        out.tokens.push_back(new_token);
+        if (++tokens_generated == 1) stats.first_token_us = elapsed_us(start);
         
         // Decode next token
         llama_batch next_batch = llama_batch_init(1, 0, 1);
@@ -307,16 +837,68 @@ Java_app_jeeves_llmtest_engine_LlamaEngine_nativeGenerate(
         next_batch.logits[0] = true;
         next_batch.n_tokens = 1;
         
-        if (llama_decode(wrapper->ctx, next_batch) != 0) {
+        const auto yield_start = std::chrono::steady_clock::now();
+        const int stop = yield_point(thread_control ? thread_control->threads() : base_threads);
+        if (stop != STOP_NONE) {
+            llama_batch_free(next_batch);
+            stop_reason = stop;
+            break;
+        }
+        // Time spent yielded is not the token's
+        token_start += std::chrono::steady_clock::now() - yield_start;
+        
+        auto decode_start = std::chrono::steady_clock::now();
+        if (SharedThreadPools::instance().decode(wrapper->ctx, next_batch, qos) != 0) {
             llama_batch_free(next_batch);
+            stop_reason = STOP_DECODE_ERROR;
             break;
         }
         llama_batch_free(next_batch);
+        wrapper->cached_tokens.push_back(new_token);
         n_cur++;
+        token_us.push_back(elapsed_us(token_start));
+        
+        if (thread_control) {
+            double decode_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - decode_start).count();
+            if (thread_control->on_token(decode_ms)) {
+                llama_set_n_threads(wrapper->ctx, thread_control->threads(), base_threads_batch);
+            }
+            if (thread_control->pause_ms() > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(thread_control->pause_ms()));
+            }
+        }
     }
     llama_sampler_free(sampler);
+    stats.generation_us = elapsed_us(generation_start);
+    stats.stop_reason = stop_reason;
+    stats.set_token_times(token_us);
+    if (thread_control) {
+        out.throttle.final_threads = thread_control->threads();
+        out.throttle.total_pause_ms = thread_control->total_pause_ms();
+        out.throttle.last_temp_mc = thread_control->last_temp_mc();
+        out.throttle.decisions = thread_control->decisions();
+    }
+    if (!session) {
+        // Unloaded or replaced while yielded; the output so far is kept
+        stats.generated_tokens = tokens_generated;
+        stats.total_us = elapsed_us(start);
+        return true;
+    }
+    stats.context_size = wrapper->ctx ? llama_n_ctx(wrapper->ctx) : 0;
+    stats.profiled_nodes = profiled.active() ? wrapper->profiler.nodes() : 0;
+    if (stats.profiled_nodes > 0) out.profile = wrapper->profiler.report();
+    
+    if ((thread_control || qos == QOS_BACKGROUND) && wrapper->ctx) {
+        // The next request starts from the configured count
+        llama_set_n_threads(wrapper->ctx, config_threads, config_threads_batch);
+    }
 #else
     LOGD("Using stub implementation for generation");
+    const std::string promptCpp = request.tokens
+        ? std::string(request.tokens, request.tokens + request.n_tokens)
+        : std::string(request.text);
+    std::string result;
     if (promptCpp.find("Eisenhower") != std::string::npos || 
         promptCpp.find("quadrant") != std::string::npos ||
         promptCpp.find("classify") != std::string::npos) {
@@ -336,62 +918,972 @@ Java_app_jeeves_llmtest_engine_LlamaEngine_nativeGenerate(
         result = "This is a stub response.";
         tokens_generated = 20;
     }
+    stats.prompt_tokens = static_cast<int>(promptCpp.size());
+    auto generation_start = std::chrono::steady_clock::now();
     stub::simulate_delay(tokens_generated);
+    stats.generation_us = elapsed_us(generation_start);
+    std::vector<long long>& token_us = out.token_us;
+    token_us.assign(tokens_generated, stats.generation_us / tokens_generated);
+    stats.set_token_times(token_us);
+    stats.first_token_us = elapsed_us(start) - stats.generation_us + token_us.front();
+    if (out.append(result.data(), result.size())) {
+        out.tokens = stub::tokenize(result);
+        stats.stop_reason = STOP_EOG;
+    } else {
+        stats.stop_reason = STOP_OUTPUT_FULL;
+        tokens_generated = 0;
+    }
 #endif
     
     auto end = std::chrono::steady_clock::now();
-    wrapper->last_inference_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    stats.generated_tokens = tokens_generated;
+    stats.total_us = elapsed_us(start);
+    stats.context_resize_ms = wrapper->resize_stats.last_request_resize_ms;
+    wrapper->last_inference_time_ms = stats.total_us / 1000;
     wrapper->last_tokens_generated = tokens_generated;
+    wrapper->last_used = end;
+    EngineHandles::instance().publish(wrapper);
     
     LOGD("Generated %d tokens in %lld ms", tokens_generated, wrapper->last_inference_time_ms);
-    return env->NewStringUTF(result.c_str());
+    return true;
+}
+
+GenerateRequest make_request(jint maxTokens, jfloat temperature, jfloat topP, jint qos,
+                             jlong enqueuedNanos) {
+    GenerateRequest request;
+    request.max_tokens = maxTokens;
+    request.temperature = temperature;
+    request.top_p = topP;
+    request.qos = qos;
+    request.enqueued_ns = enqueuedNanos;
+    return request;
+}
+
+/**
+ * Run [request] on the engine behind [handle], record it in PerfMetrics and
+ * copy its GenerateStats into [stats] (as many fields as fit; may be null).
+ * False for a stale handle or a failed request.
+ */
+bool generate_on(JNIEnv* env, jlong handle, const GenerateRequest& request, GenerateOutput& out,
+                 jlongArray stats) {
+    // System.nanoTime() and steady_clock both read CLOCK_MONOTONIC
+    const auto entered = std::chrono::steady_clock::now();
+    auto submitted = entered;
+    if (request.enqueued_ns > 0) {
+        submitted = std::min(entered, std::chrono::steady_clock::time_point(
+            std::chrono::nanoseconds(request.enqueued_ns)));
+    }
+    
+    GenerateRequest checked = request;
+    if (!valid_qos(checked.qos)) {
+        LOGW("Unknown QoS %d - running as interactive", checked.qos);
+        checked.qos = QOS_INTERACTIVE;
+    }
+    
+    bool ok = false;
+    long long queue_wait_us = 0;
+    {
+#if LLAMA_AVAILABLE
+        // Keeps the shared threadpool hot for this request and parks it afterwards.
+        // An interactive request begins before waiting for its engine, so a
+        // background request holding the engine yields it.
+        ThreadPoolRequest pool_request(checked.qos);
+#endif
+        // The lease is held until the request finishes (or yields); an unload
+        // or swap of the handle waits for it
+        EngineSession session(handle, checked.qos);
+        if (session) {
+            queue_wait_us = elapsed_us(submitted);
+            ok = run_generate(session, checked, out);
+        }
+    }
+    last_request.throttle = std::move(out.throttle);
+    last_request.profile = std::move(out.profile);
+    PerfMetrics::instance().record(checked.qos, out.stats, out.token_us, queue_wait_us,
+                                   elapsed_us(submitted));
+    if (stats) {
+        long long values[GenerateStats::COUNT];
+        out.stats.to_array(values);
+        jsize n = std::min<jsize>(env->GetArrayLength(stats), GenerateStats::COUNT);
+        env->SetLongArrayRegion(stats, 0, n, reinterpret_cast<const jlong*>(values));
+    }
+    return ok;
+}
+
+/**
+ * Generate from a String prompt. Prompt and output are converted as standard
+ * UTF-8, so emoji survive; nativeGenerateUtf8 and nativeGenerateTokens avoid
+ * the conversions. Like them it returns the request's GenerateStats in
+ * [stats], so no follow-up getter can see a later request's numbers.
+ */
+jstring JNICALL
+nativeGenerate(
+    JNIEnv* env, jobject thiz, jlong handle, jstring prompt,
+    jint maxTokens, jfloat temperature, jfloat topP, jint qos, jlong enqueuedNanos, jlongArray stats
+) {
+    const std::string text = jstring_to_utf8(env, prompt);
+    GenerateRequest request = make_request(maxTokens, temperature, topP, qos, enqueuedNanos);
+    request.text = text;
+    GenerateOutput out;
+    generate_on(env, handle, request, out, stats);
+    return utf8_to_jstring(env, out.text.data(), out.text.size());
+}
+
+/**
+ * Generate from [promptLength] bytes of UTF-8 in the direct buffer [prompt]
+ * into the direct buffer [output]. The prompt is tokenized in place and
+ * pieces are written straight to [output]; generation stops when the next
+ * piece would not fit. Returns bytes written, or -1.
+ */
+jint JNICALL
+nativeGenerateUtf8(
+    JNIEnv* env, jobject thiz, jlong handle, jobject prompt, jint promptLength, jobject output,
+    jint maxTokens, jfloat temperature, jfloat topP, jint qos, jlong enqueuedNanos, jlongArray stats
+) {
+    const char* text = static_cast<const char*>(direct_buffer(env, prompt, promptLength));
+    GenerateOutput out;
+    out.buffer = static_cast<char*>(direct_buffer(env, output, 0));
+    if (!text || !out.buffer) {
+        LOGE("Generate: prompt and output must be direct buffers");
+        return -1;
+    }
+    out.capacity = static_cast<size_t>(env->GetDirectBufferCapacity(output));
+    
+    GenerateRequest request = make_request(maxTokens, temperature, topP, qos, enqueuedNanos);
+    request.text = std::string_view(text, promptLength);
+    return generate_on(env, handle, request, out, stats) ? static_cast<jint>(out.bytes) : -1;
+}
+
+/**
+ * Generate from prompt token IDs, e.g. a system prompt tokenized once with
+ * nativeTokenize plus the new turn. Returns the generated IDs, or null.
+ */
+jintArray JNICALL
+nativeGenerateTokens(
+    JNIEnv* env, jobject thiz, jlong handle, jintArray prompt,
+    jint maxTokens, jfloat temperature, jfloat topP, jint qos, jlong enqueuedNanos, jlongArray stats
+) {
+    const std::vector<int> tokens = to_int_vector(env, prompt);
+    GenerateRequest request = make_request(maxTokens, temperature, topP, qos, enqueuedNanos);
+    request.tokens = tokens.data();
+    request.n_tokens = tokens.size();
+    GenerateOutput out;
+    if (!generate_on(env, handle, request, out, stats)) return nullptr;
+    return to_jint_array(env, out.tokens);
+}
+
+/**
+ * Token IDs of [length] bytes of UTF-8 in the direct buffer [text], or null.
+ * [addSpecial] adds BOS, as generate does for text prompts.
+ */
+jintArray JNICALL
+nativeTokenize(JNIEnv* env, jobject thiz, jlong handle, jobject text, jint length, jboolean addSpecial) {
+    const char* bytes = static_cast<const char*>(direct_buffer(env, text, length));
+    if (!bytes) {
+        LOGE("Tokenize: text must be a direct buffer");
+        return nullptr;
+    }
+    EngineLease engine = EngineHandles::instance().acquire(handle);
+    if (!engine) return nullptr;
+    
+#if LLAMA_AVAILABLE
+    std::vector<llama_token> tokens;
+    {
+        std::lock_guard<std::mutex> lock(engine->mutex);
+        // A trimmed engine may have released its model
+        if (!restore_engine(engine.get())) return nullptr;
+        const llama_vocab* vocab = llama_model_get_vocab(engine->model);
+        if (!tokenize_text(vocab, std::string_view(bytes, length), addSpecial == JNI_TRUE, tokens)) {
+            return nullptr;
+        }
+    }
+    return to_jint_array(env, tokens);
+#else
+    return to_jint_array(env, stub::tokenize(std::string_view(bytes, length)));
+#endif
+}
+
+/**
+ * Write the UTF-8 text of [tokens] into the direct buffer [output]. Returns
+ * bytes written, or minus the size needed when [output] is too small.
+ */
+jint JNICALL
+nativeDetokenize(JNIEnv* env, jobject thiz, jlong handle, jintArray tokens, jobject output) {
+    char* buffer = static_cast<char*>(direct_buffer(env, output, 0));
+    if (!buffer) {
+        LOGE("Detokenize: output must be a direct buffer");
+        return 0;
+    }
+    const jlong capacity = env->GetDirectBufferCapacity(output);
+    const std::vector<int> ids = to_int_vector(env, tokens);
+    EngineLease engine = EngineHandles::instance().acquire(handle);
+    if (!engine) return 0;
+    
+#if LLAMA_AVAILABLE
+    std::lock_guard<std::mutex> lock(engine->mutex);
+    if (!restore_engine(engine.get())) return 0;
+    const llama_vocab* vocab = llama_model_get_vocab(engine->model);
+    if (!tokens_in_vocab(vocab, ids.data(), ids.size())) return 0;
+    return llama_detokenize(vocab, ids.data(), static_cast<int32_t>(ids.size()), buffer,
+                            static_cast<int32_t>(std::min<jlong>(capacity, INT32_MAX)), false, true);
+#else
+    if (static_cast<jlong>(ids.size()) > capacity) return -static_cast<jint>(ids.size());
+    for (size_t i = 0; i < ids.size(); i++) buffer[i] = static_cast<char>(ids[i]);
+    return static_cast<jint>(ids.size());
+#endif
+}
+
+/**
+ * Invalidate [handle] and free its engine once requests still running on it
+ * have finished. Stale handles are ignored.
+ */
+void JNICALL
+nativeUnloadModel(JNIEnv* env, jobject thiz, jlong handle) {
+    std::unique_ptr<LlamaContext> wrapper = EngineHandles::instance().remove(handle);
+    if (!wrapper) return;
+    
+    ProcessMemory before;
+    read_process_memory(before);
+    std::string model_path;
+#if LLAMA_AVAILABLE
+    IdleContextShrinker::instance().untrack(wrapper.get());
+    model_path = wrapper->model_ref.path();
+#endif
+    wrapper.reset();
+#if LLAMA_AVAILABLE
+    if (live_engine_count() == 0) {
+        IdleContextShrinker::instance().shutdown();
+        SharedThreadPools::instance().shutdown();
+    }
+#endif
+    LOGI("Model unloaded");
+    finish_teardown(model_path, before.anonymous_bytes);
+}
+
+/**
+ * Prefetch the weights of [handle] and run one decode, so its first request
+ * does not pay for page faults. Returns the time taken, or -1 on failure.
+ */
+jlong JNICALL
+nativeWarmUpModel(JNIEnv* env, jobject thiz, jlong handle) {
+    EngineLease engine = EngineHandles::instance().acquire(handle);
+    if (!engine) return -1;
+    auto start = std::chrono::steady_clock::now();
+#if LLAMA_AVAILABLE
+    std::lock_guard<std::mutex> lock(engine->mutex);
+    if (!warm_up_context(engine.get())) return -1;
+#endif
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Swap the warmed-up engine behind [other] in for the one behind [handle]
+ * (see EngineHandles::swap_in). Unloading [other] afterwards drains and
+ * frees the previous engine.
+ */
+jboolean JNICALL
+nativeSwapModels(JNIEnv* env, jobject thiz, jlong handle, jlong other) {
+    if (!EngineHandles::instance().swap_in(handle, other)) {
+        LOGE("Cannot swap engine handles %llx and %llx", static_cast<unsigned long long>(handle),
+             static_cast<unsigned long long>(other));
+        return JNI_FALSE;
+    }
+    LOGI("Engine swapped");
+    return JNI_TRUE;
+}
+
+/**
+ * [live, swaps, stale_lookups, drained, last_drain_ms]
+ */
+jlongArray JNICALL
+nativeGetHandleStats(JNIEnv* env, jobject thiz) {
+    jlongArray result = env->NewLongArray(HandleStats::COUNT);
+    if (!result) return result;
+    
+    long long values[HandleStats::COUNT];
+    EngineHandles::instance().stats().to_array(values);
+    env->SetLongArrayRegion(result, 0, HandleStats::COUNT, reinterpret_cast<const jlong*>(values));
+    return result;
+}
+
+/**
+ * Count a generate call cancelled before it reached the engine, e.g. while
+ * queued behind LlamaEngine's mutex.
+ */
+void JNICALL
+nativeCountCancelled(JNIEnv* env, jobject thiz, jint qos) {
+    PerfMetrics::instance().count(qos, COUNTER_CANCELLED);
+}
+
+/**
+ * Latency histograms and counters of every generate call in the process, as
+ * PerfMetrics::Row rows (all, interactive, background). [reset] starts a new
+ * window; records racing the reset land in one window or the next.
+ */
+jlongArray JNICALL
+nativeGetPerfSnapshot(JNIEnv* env, jobject thiz, jboolean reset) {
+    jlongArray result = env->NewLongArray(PerfMetrics::SNAPSHOT_FIELDS);
+    if (!result) return result;
+    
+    long long values[PerfMetrics::SNAPSHOT_FIELDS];
+    PerfMetrics::instance().snapshot(values, reset == JNI_TRUE);
+    env->SetLongArrayRegion(result, 0, PerfMetrics::SNAPSHOT_FIELDS, reinterpret_cast<const jlong*>(values));
+    return result;
+}
+
+// @CriticalNative metric getters: no JNIEnv or class argument, so they must
+// not call back into JNI or block. They read the metrics published to the
+// handle table's atomics, never the engine or the table lock.
+
+jlong JNICALL
+getMemoryUsage(jlong handle) {
+    EngineMetrics metrics;
+    return EngineHandles::instance().read_metrics(handle, metrics) ? metrics.memory_usage_bytes : 0;
+}
+
+jlongArray JNICALL
+nativeGetMemoryBreakdown(JNIEnv* env, jobject thiz, jlong handle) {
+    jlongArray result = env->NewLongArray(MemoryBreakdown::COUNT);
+    EngineLease engine = EngineHandles::instance().acquire(handle);
+    if (!engine || !result) return result;
+    
+    long long values[MemoryBreakdown::COUNT];
+    {
+        std::lock_guard<std::mutex> lock(engine->mutex);
+        collect_memory(engine.get()).to_array(values);
+    }
+    env->SetLongArrayRegion(result, 0, MemoryBreakdown::COUNT, reinterpret_cast<const jlong*>(values));
+    return result;
+}
+
+jint JNICALL
+getContextSize(jlong handle) {
+    EngineMetrics metrics;
+    return EngineHandles::instance().read_metrics(handle, metrics) ? metrics.context_size : 0;
+}
+
+jint JNICALL
+nativeConfigureElasticContext(
+    JNIEnv* env, jobject thiz, jlong handle, jint maxContextSize, jlong idleShrinkMs
+) {
+    EngineLease engine = EngineHandles::instance().acquire(handle);
+    if (!engine) return 0;
+#if LLAMA_AVAILABLE
+    std::lock_guard<std::mutex> lock(engine->mutex);
+    if (!engine->ctx) return 0;
+    return configure_elastic_context(engine.get(), maxContextSize, idleShrinkMs);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * [n_ctx, min_ctx, max_ctx, resize_count, total_resize_ms, last_resize_ms, last_request_resize_ms]
+ */
+jlongArray JNICALL
+nativeGetContextMetrics(JNIEnv* env, jobject thiz, jlong handle) {
+    constexpr int CONTEXT_METRICS_COUNT = 7;
+    jlongArray result = env->NewLongArray(CONTEXT_METRICS_COUNT);
+    EngineLease engine = EngineHandles::instance().acquire(handle);
+    if (!engine || !result) return result;
+    
+    LlamaContext* wrapper = engine.get();
+    std::lock_guard<std::mutex> lock(wrapper->mutex);
+    jlong values[CONTEXT_METRICS_COUNT] = {0};
+#if LLAMA_AVAILABLE
+    values[0] = wrapper->ctx ? llama_n_ctx(wrapper->ctx) : 0;
+#endif
+    values[1] = wrapper->elastic.min_ctx;
+    values[2] = wrapper->elastic.max_ctx;
+    values[3] = wrapper->resize_stats.resize_count;
+    values[4] = wrapper->resize_stats.total_resize_ms;
+    values[5] = wrapper->resize_stats.last_resize_ms;
+    values[6] = wrapper->resize_stats.last_request_resize_ms;
+    env->SetLongArrayRegion(result, 0, CONTEXT_METRICS_COUNT, values);
+    return result;
+}
+
+jlong JNICALL
+getLoadTimeMs(jlong handle) {
+    EngineMetrics metrics;
+    return EngineHandles::instance().read_metrics(handle, metrics) ? metrics.load_time_ms : 0;
+}
+
+jlong JNICALL
+getLastInferenceTimeMs(jlong handle) {
+    EngineMetrics metrics;
+    return EngineHandles::instance().read_metrics(handle, metrics) ? metrics.last_inference_time_ms : 0;
+}
+
+jint JNICALL
+getLastTokenCount(jlong handle) {
+    EngineMetrics metrics;
+    return EngineHandles::instance().read_metrics(handle, metrics) ? metrics.last_tokens_generated : 0;
+}
+
+jboolean JNICALL
+isStubImplementation(jlong handle) {
+    EngineMetrics metrics;
+    return !EngineHandles::instance().read_metrics(handle, metrics) || metrics.is_stub ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Returns [level, bytes_freed, rss_freed, restore_cost_ms] (see TrimResult).
+ */
+jlongArray JNICALL
+nativeTrimMemory(JNIEnv* env, jobject thiz, jlong handle, jint level) {
+    jlongArray result = env->NewLongArray(TrimResult::COUNT);
+    EngineLease engine = EngineHandles::instance().acquire(handle);
+    if (!engine || !result) return result;
+    
+    TrimResult trim;
+#if LLAMA_AVAILABLE
+    std::lock_guard<std::mutex> lock(engine->mutex);
+    trim = trim_engine(engine.get(), level);
+#endif
+    long long values[TrimResult::COUNT];
+    trim.to_array(values);
+    env->SetLongArrayRegion(result, 0, TrimResult::COUNT, reinterpret_cast<const jlong*>(values));
+    return result;
+}
+
+/**
+ * Configure the threadpool shared by every context. 0 thread counts size the
+ * pools to the contexts; poll is 0..100.
+ */
+jboolean JNICALL
+nativeConfigureThreadPool(
+    JNIEnv* env, jobject thiz, jint nThreads, jint nThreadsBatch, jint poll, jboolean separateBatchPool,
+    jint cpuPolicy
+) {
+    ThreadPoolConfig config;
+    config.n_threads = nThreads;
+    config.n_threads_batch = nThreadsBatch;
+    config.poll = poll;
+    config.separate_batch_pool = separateBatchPool == JNI_TRUE;
+    config.cpu_policy = cpuPolicy;
+    if (!config.valid()) {
+        LOGE("Invalid threadpool config: threads=%d batch=%d poll=%d policy=%d",
+             nThreads, nThreadsBatch, poll, cpuPolicy);
+        return JNI_FALSE;
+    }
+#if LLAMA_AVAILABLE
+    return SharedThreadPools::instance().configure(config) ? JNI_TRUE : JNI_FALSE;
+#else
+    return JNI_TRUE;
+#endif
+}
+
+/**
+ * [threads, threads_batch, poll, attached_contexts, decodes, contended_decodes, wait_ms,
+ *  cpu_policy, pinned_cpus]
+ */
+jlongArray JNICALL
+nativeGetThreadPoolStats(JNIEnv* env, jobject thiz) {
+    jlongArray result = env->NewLongArray(ThreadPoolStats::COUNT);
+    if (!result) return result;
+    
+    ThreadPoolStats stats;
+#if LLAMA_AVAILABLE
+    stats = SharedThreadPools::instance().stats();
+#endif
+    long long values[ThreadPoolStats::COUNT];
+    stats.to_array(values);
+    env->SetLongArrayRegion(result, 0, ThreadPoolStats::COUNT, reinterpret_cast<const jlong*>(values));
+    return result;
+}
+
+/**
+ * CPU backend in use (see CpuBackendInfo::to_array): [variant, cpu_features,
+ * variant_features, fallbacks, load_ms]
+ */
+jlongArray JNICALL
+nativeGetCpuBackend(JNIEnv* env, jobject thiz) {
+    jlongArray result = env->NewLongArray(CpuBackendInfo::COUNT);
+    if (!result) return result;
+    
+    long long values[CpuBackendInfo::COUNT];
+    cpu_backend_info().to_array(values);
+    env->SetLongArrayRegion(result, 0, CpuBackendInfo::COUNT, reinterpret_cast<const jlong*>(values));
+    return result;
+}
+
+/**
+ * Build configuration of the native library (see native_build_profile).
+ */
+jstring JNICALL
+nativeGetBuildProfile(JNIEnv* env, jobject thiz) {
+    return env->NewStringUTF(native_build_profile());
+}
+
+/**
+ * Whether GGUF models of [arch] can be loaded (see model_arch_built_in).
+ */
+jboolean JNICALL
+nativeIsArchitectureBuiltIn(JNIEnv* env, jobject thiz, jstring arch) {
+    const char* a = env->GetStringUTFChars(arch, nullptr);
+    if (!a) return JNI_FALSE;
+    bool built_in = model_arch_built_in(a);
+    env->ReleaseStringUTFChars(arch, a);
+    return built_in ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Write the PGO training profiles of an instrumented build into [dir].
+ */
+jint JNICALL
+nativeWritePgoProfiles(JNIEnv* env, jobject thiz, jstring dir) {
+    const char* d = env->GetStringUTFChars(dir, nullptr);
+    if (!d) return -1;
+    std::string path = d;
+    env->ReleaseStringUTFChars(dir, d);
+    return pgo_write_profiles(path);
+}
+
+/**
+ * Keep repacked weights in sidecar files under [dir] (null disables the cache).
+ */
+void JNICALL
+nativeConfigureRepackCache(JNIEnv* env, jobject thiz, jstring dir) {
+    std::string path;
+    if (dir) {
+        const char* d = env->GetStringUTFChars(dir, nullptr);
+        if (!d) return;
+        path = d;
+        env->ReleaseStringUTFChars(dir, d);
+    }
+    configure_repack_cache(path);
+}
+
+/**
+ * [hits, builds, stale, uncached, last_result, last_tensors, last_bytes, last_ms]
+ */
+jlongArray JNICALL
+nativeGetRepackCacheStats(JNIEnv* env, jobject thiz) {
+    jlongArray result = env->NewLongArray(RepackCacheStats::COUNT);
+    if (!result) return result;
+    
+    long long values[RepackCacheStats::COUNT];
+    repack_cache_stats().to_array(values);
+    env->SetLongArrayRegion(result, 0, RepackCacheStats::COUNT, reinterpret_cast<const jlong*>(values));
+    return result;
+}
+
+/**
+ * Weight type (ggml_type id) this CPU runs fastest, or -1 to keep the download.
+ */
+jint JNICALL
+nativeSelectRequantType(JNIEnv* env, jobject thiz) {
+    return select_requant_type(detect_cpu_features());
+}
+
+/**
+ * Requantize [input] into [output] (see requantize_model). Blocks; returns the
+ * final RequantizeState.
+ */
+jint JNICALL
+nativeRequantize(
+    JNIEnv* env, jobject thiz, jstring input, jstring output, jint targetType, jint threads
+) {
+    const char* in = env->GetStringUTFChars(input, nullptr);
+    if (!in) return REQUANT_FAILED;
+    std::string input_path = in;
+    env->ReleaseStringUTFChars(input, in);
+
+    const char* out = env->GetStringUTFChars(output, nullptr);
+    if (!out) return REQUANT_FAILED;
+    std::string output_path = out;
+    env->ReleaseStringUTFChars(output, out);
+
+    return requantize_model(input_path, output_path, targetType, threads);
+}
+
+void JNICALL
+nativeCancelRequantize(JNIEnv* env, jobject thiz) {
+    cancel_requantize();
+}
+
+/**
+ * [state, tensors_done, tensors_total, bytes_done, bytes_total, resumed_tensors,
+ *  converted_tensors, target_type, elapsed_ms]
+ */
+jlongArray JNICALL
+nativeGetRequantizeProgress(JNIEnv* env, jobject thiz) {
+    jlongArray result = env->NewLongArray(RequantizeProgress::COUNT);
+    if (!result) return result;
+    
+    long long values[RequantizeProgress::COUNT];
+    requantize_progress().to_array(values);
+    env->SetLongArrayRegion(result, 0, RequantizeProgress::COUNT, reinterpret_cast<const jlong*>(values));
+    return result;
+}
+
+/**
+ * Hex SHA-256 of the file at [path], or null if it failed or was cancelled
+ * (see nativeGetFileHashProgress). Blocks; [readers] 0 picks the read-ahead
+ * thread count.
+ */
+jstring JNICALL
+nativeSha256File(JNIEnv* env, jobject thiz, jstring path, jint readers) {
+    const char* p = env->GetStringUTFChars(path, nullptr);
+    if (!p) return nullptr;
+    std::string file_path = p;
+    env->ReleaseStringUTFChars(path, p);
+
+    std::string hex;
+    if (sha256_file(file_path, hex, readers) != HASH_DONE) return nullptr;
+    return env->NewStringUTF(hex.c_str());
+}
+
+void JNICALL
+nativeCancelFileHash(JNIEnv* env, jobject thiz) {
+    cancel_file_hash();
+}
+
+/**
+ * [state, bytes_done, bytes_total, kernel, readers, elapsed_ms]
+ */
+jlongArray JNICALL
+nativeGetFileHashProgress(JNIEnv* env, jobject thiz) {
+    jlongArray result = env->NewLongArray(FileHashProgress::COUNT);
+    if (!result) return result;
+    
+    long long values[FileHashProgress::COUNT];
+    file_hash_progress().to_array(values);
+    env->SetLongArrayRegion(result, 0, FileHashProgress::COUNT, reinterpret_cast<const jlong*>(values));
+    return result;
+}
+
+/**
+ * Hold (or release) background requests before their next decode.
+ */
+void JNICALL
+nativeSetBackgroundPaused(JNIEnv* env, jobject thiz, jboolean paused) {
+#if LLAMA_AVAILABLE
+    SharedThreadPools::instance().set_background_paused(paused == JNI_TRUE);
+#endif
+}
+
+/**
+ * CPU topology (see CpuTopology::to_array). [sysfsRoot] null reads this device.
+ */
+jlongArray JNICALL
+nativeGetCpuTopology(JNIEnv* env, jobject thiz, jstring sysfsRoot) {
+    std::vector<long long> values;
+    if (sysfsRoot) {
+        const char* root = env->GetStringUTFChars(sysfsRoot, nullptr);
+        values = detect_cpu_topology(root).to_array();
+        env->ReleaseStringUTFChars(sysfsRoot, root);
+    } else {
+        values = system_cpu_topology().to_array();
+    }
+    
+    jlongArray result = env->NewLongArray(static_cast<jsize>(values.size()));
+    if (!result) return result;
+    env->SetLongArrayRegion(result, 0, static_cast<jsize>(values.size()),
+                            reinterpret_cast<const jlong*>(values.data()));
+    return result;
+}
+
+/**
+ * Enable thermal/throughput-aware thread control for generations on [handle].
+ * targetTokensPerSec and maxTempC of 0 disable the respective goal.
+ */
+jboolean JNICALL
+nativeConfigureAdaptiveThreads(
+    JNIEnv* env, jobject thiz, jlong handle, jboolean enabled, jfloat targetTokensPerSec,
+    jfloat maxTempC, jint minThreads, jint windowTokens, jlong maxPauseMs
+) {
+    AdaptiveThreadConfig config;
+    config.enabled = enabled == JNI_TRUE;
+    config.target_tokens_per_sec = targetTokensPerSec;
+    config.max_temp_c = maxTempC;
+    config.min_threads = minThreads;
+    config.window_tokens = windowTokens;
+    config.max_pause_ms = maxPauseMs;
+    if (!config.valid()) {
+        LOGE("Invalid adaptive thread config");
+        return JNI_FALSE;
+    }
+    
+    EngineLease engine = EngineHandles::instance().acquire(handle);
+    if (!engine) return JNI_FALSE;
+    std::lock_guard<std::mutex> lock(engine->mutex);
+    engine->thread_control = config;
+    return JNI_TRUE;
+}
+
+/**
+ * Thread control decisions of the calling thread's last generation (see
+ * ThrottleReport::to_array).
+ */
+jlongArray JNICALL
+nativeGetThrottleReport(JNIEnv* env, jobject thiz) {
+    return to_jlong_array(env, last_request.throttle.to_array());
 }
 
-JNIEXPORT void JNICALL
-Java_app_jeeves_llmtest_engine_LlamaEngine_nativeUnloadModel(JNIEnv* env, jobject thiz, jlong handle) {
-    if (handle != 0) {
-        auto* wrapper = reinterpret_cast<LlamaContext*>(handle);
-        delete wrapper;
-        LOGI("Model unloaded");
+/**
+ * Profile [sampleRate] of the generations on [handle] per op and layer
+ * (0 disables). Profiled requests run noticeably slower; see compute_profiler.h.
+ */
+jboolean JNICALL
+nativeConfigureProfiler(JNIEnv* env, jobject thiz, jlong handle, jfloat sampleRate) {
+    if (!(sampleRate >= 0.0f && sampleRate <= 1.0f)) {
+        LOGE("Invalid profiler sample rate %f", sampleRate);
+        return JNI_FALSE;
     }
+    EngineLease engine = EngineHandles::instance().acquire(handle);
+    if (!engine) return JNI_FALSE;
+    std::lock_guard<std::mutex> lock(engine->mutex);
+    engine->profiler.configure(sampleRate);
+    return JNI_TRUE;
 }
 
-JNIEXPORT jlong JNICALL
-Java_app_jeeves_llmtest_engine_LlamaEngine_getMemoryUsage(JNIEnv* env, jobject thiz, jlong handle) {
-    if (handle == 0) return 0;
-    return static_cast<jlong>(reinterpret_cast<LlamaContext*>(handle)->memory_usage_bytes);
+/**
+ * Per-op report of the calling thread's last generation
+ * (ComputeProfiler::report), or null if it was not profiled.
+ */
+jstring JNICALL
+nativeGetComputeProfile(JNIEnv* env, jobject thiz) {
+    if (last_request.profile.empty()) return nullptr;
+    return env->NewStringUTF(last_request.profile.c_str());
 }
 
-JNIEXPORT jlong JNICALL
-Java_app_jeeves_llmtest_engine_LlamaEngine_getLoadTimeMs(JNIEnv* env, jobject thiz, jlong handle) {
-    if (handle == 0) return 0;
-    return static_cast<jlong>(reinterpret_cast<LlamaContext*>(handle)->load_time_ms);
+void JNICALL
+nativeSetModelCacheBudget(JNIEnv* env, jobject thiz, jlong budgetBytes) {
+    ModelRegistry::instance().set_budget(budgetBytes > 0 ? static_cast<size_t>(budgetBytes) : 0);
 }
 
-JNIEXPORT jlong JNICALL
-Java_app_jeeves_llmtest_engine_LlamaEngine_getLastInferenceTimeMs(JNIEnv* env, jobject thiz, jlong handle) {
-    if (handle == 0) return 0;
-    return static_cast<jlong>(reinterpret_cast<LlamaContext*>(handle)->last_inference_time_ms);
+jlong JNICALL
+nativeEvictIdleModels(JNIEnv* env, jobject thiz) {
+    size_t freed = ModelRegistry::instance().evict_idle();
+    LOGI("Evicted idle models: %zu bytes", freed);
+    return static_cast<jlong>(freed);
 }
 
-JNIEXPORT jint JNICALL
-Java_app_jeeves_llmtest_engine_LlamaEngine_getLastTokenCount(JNIEnv* env, jobject thiz, jlong handle) {
-    if (handle == 0) return 0;
-    return static_cast<jint>(reinterpret_cast<LlamaContext*>(handle)->last_tokens_generated);
+/**
+ * Keep tuned configurations in [storePath] (null disables the store) for
+ * [deviceKey]. nativeLoadModel applies a stored configuration from then on.
+ */
+void JNICALL
+nativeConfigureAutotune(
+    JNIEnv* env, jobject thiz, jstring storePath, jstring deviceKey
+) {
+    std::string path;
+    if (storePath) {
+        const char* p = env->GetStringUTFChars(storePath, nullptr);
+        path = p;
+        env->ReleaseStringUTFChars(storePath, p);
+    }
+    const char* device = env->GetStringUTFChars(deviceKey, nullptr);
+    configure_autotune_store(path, device);
+    env->ReleaseStringUTFChars(deviceKey, device);
 }
 
-JNIEXPORT jboolean JNICALL
-Java_app_jeeves_llmtest_engine_LlamaEngine_isStubImplementation(JNIEnv* env, jobject thiz, jlong handle) {
-    if (handle == 0) return JNI_TRUE;
-    return reinterpret_cast<LlamaContext*>(handle)->is_stub ? JNI_TRUE : JNI_FALSE;
+/**
+ * Sweep thread, batch and KV configurations on the model loaded in [handle]
+ * (see AutotuneResult::to_array). Null arrays use candidates derived from the
+ * CPU topology; [batchSizes] holds (n_batch, n_ubatch) pairs. With [save] the
+ * winner goes to the store for the next load.
+ */
+jlongArray JNICALL
+nativeAutotune(
+    JNIEnv* env, jobject thiz, jlong handle, jstring prompt, jint promptTokens, jint genTokens,
+    jintArray threads, jintArray threadsBatch, jintArray batchSizes, jintArray kvTypes, jboolean save
+) {
+    AutotuneSpec spec;
+    if (prompt) {
+        const char* p = env->GetStringUTFChars(prompt, nullptr);
+        spec.prompt = p;
+        env->ReleaseStringUTFChars(prompt, p);
+    }
+    spec.prompt_tokens = promptTokens;
+    spec.gen_tokens = genTokens;
+    spec.threads = to_int_vector(env, threads);
+    spec.threads_batch = to_int_vector(env, threadsBatch);
+    std::vector<int> batches = to_int_vector(env, batchSizes);
+    for (size_t i = 0; i + 1 < batches.size(); i += 2) spec.batch_sizes.emplace_back(batches[i], batches[i + 1]);
+    spec.kv_types = to_int_vector(env, kvTypes);
+    
+    AutotuneResult result;
+    if (handle == 0 || !spec.valid()) {
+        LOGE("Autotune: %s", handle == 0 ? "no model loaded" : "invalid candidates");
+        return to_jlong_array(env, result.to_array());
+    }
+    
+#if LLAMA_AVAILABLE
+    EngineLease engine = EngineHandles::instance().acquire(handle);
+    if (!engine) return to_jlong_array(env, result.to_array());
+    LlamaContext* wrapper = engine.get();
+    std::lock_guard<std::mutex> lock(wrapper->mutex);
+    if (!restore_engine(wrapper)) return to_jlong_array(env, result.to_array());
+    
+    result = run_autotune(wrapper->model, ContextOptions::from(wrapper->ctx_params), spec);
+    if (save == JNI_TRUE && result.best.n_threads > 0) {
+        result.saved = save_tuned_config(autotune_key(wrapper->model), result.best);
+    }
+#endif
+    return to_jlong_array(env, result.to_array());
 }
 
-JNIEXPORT void JNICALL
-Java_app_jeeves_llmtest_engine_LlamaEngine_cleanupBackend(JNIEnv* env, jobject thiz) {
+/**
+ * Measure memory bandwidth and int8/fp16 throughput on up to [threads]
+ * performance cores (0 = all) in about [budgetMs] (see DeviceProbe::to_array).
+ * Needs no model, so it also runs in stub builds.
+ */
+jlongArray JNICALL
+nativeProbeDevice(JNIEnv* env, jobject thiz, jint threads, jint budgetMs) {
+    return to_jlong_array(env, probe_device(threads, budgetMs > 0 ? budgetMs : 600).to_array());
+}
+
+void JNICALL
+cleanupBackend(JNIEnv* env, jobject thiz) {
+    ProcessMemory before;
+    read_process_memory(before);
+    ModelRegistry::instance().evict_idle();
 #if LLAMA_AVAILABLE
+    IdleContextShrinker::instance().shutdown();
+    SharedThreadPools::instance().shutdown();
     llama_backend_free();
 #endif
     LOGI("llama.cpp backend cleaned up");
+    finish_teardown("", before.anonymous_bytes);
 }
 
-} // extern "C"
+/**
+ * Last post-unload self-check (see TeardownReport::Index).
+ */
+jlongArray JNICALL
+nativeGetTeardownReport(JNIEnv* env, jobject thiz) {
+    jlongArray result = env->NewLongArray(TeardownReport::COUNT);
+    if (!result) return result;
+    
+    long long values[TeardownReport::COUNT];
+    last_teardown_report().to_array(values);
+    env->SetLongArrayRegion(result, 0, TeardownReport::COUNT, reinterpret_cast<const jlong*>(values));
+    return result;
+}
+
+} // namespace
+
+// ============================================================================
+// Registration
+// ============================================================================
+
+namespace {
+
+/** Engine classes sharing these natives; those absent from the app are skipped. */
+const char* const ENGINE_CLASSES[] = {
+    "app/prio/llmtest/engine/LlamaEngine",
+    "com/prio/core/aiprovider/llm/LlamaEngine",
+};
+
+#ifdef __ANDROID__
+#define CRITICAL_NATIVE(fn) reinterpret_cast<void*>(fn)
+#else
+// Desktop JVMs ignore @CriticalNative and pass JNIEnv and the class
+template <typename R, R (JNICALL *Fn)(jlong)>
+R JNICALL with_jni_args(JNIEnv*, jclass, jlong handle) {
+    return Fn(handle);
+}
+#define CRITICAL_NATIVE(fn) reinterpret_cast<void*>(&with_jni_args<decltype(fn(0)), fn>)
+#endif
+
+#define NATIVE(name, signature) { #name, signature, reinterpret_cast<void*>(name) }
+#define CRITICAL(name, signature) { #name, signature, CRITICAL_NATIVE(name) }
+
+const JNINativeMethod ENGINE_METHODS[] = {
+    NATIVE(initBackend, "(Ljava/lang/String;)V"),
+    NATIVE(nativeLoadModel, "(Ljava/lang/String;IIJIIIIIII)J"),
+    NATIVE(nativeGenerate, "(JLjava/lang/String;IFFIJ[J)Ljava/lang/String;"),
+    NATIVE(nativeGenerateUtf8, "(JLjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;IFFIJ[J)I"),
+    NATIVE(nativeGenerateTokens, "(J[IIFFIJ[J)[I"),
+    NATIVE(nativeTokenize, "(JLjava/nio/ByteBuffer;IZ)[I"),
+    NATIVE(nativeDetokenize, "(J[ILjava/nio/ByteBuffer;)I"),
+    NATIVE(nativeUnloadModel, "(J)V"),
+    NATIVE(nativeWarmUpModel, "(J)J"),
+    NATIVE(nativeSwapModels, "(JJ)Z"),
+    NATIVE(nativeGetHandleStats, "()[J"),
+    NATIVE(nativeCountCancelled, "(I)V"),
+    NATIVE(nativeGetPerfSnapshot, "(Z)[J"),
+    CRITICAL(getMemoryUsage, "(J)J"),
+    NATIVE(nativeGetMemoryBreakdown, "(J)[J"),
+    CRITICAL(getContextSize, "(J)I"),
+    NATIVE(nativeConfigureElasticContext, "(JIJ)I"),
+    NATIVE(nativeGetContextMetrics, "(J)[J"),
+    CRITICAL(getLoadTimeMs, "(J)J"),
+    CRITICAL(getLastInferenceTimeMs, "(J)J"),
+    CRITICAL(getLastTokenCount, "(J)I"),
+    CRITICAL(isStubImplementation, "(J)Z"),
+    NATIVE(nativeTrimMemory, "(JI)[J"),
+    NATIVE(nativeConfigureThreadPool, "(IIIZI)Z"),
+    NATIVE(nativeGetThreadPoolStats, "()[J"),
+    NATIVE(nativeGetCpuBackend, "()[J"),
+    NATIVE(nativeGetBuildProfile, "()Ljava/lang/String;"),
+    NATIVE(nativeIsArchitectureBuiltIn, "(Ljava/lang/String;)Z"),
+    NATIVE(nativeWritePgoProfiles, "(Ljava/lang/String;)I"),
+    NATIVE(nativeConfigureRepackCache, "(Ljava/lang/String;)V"),
+    NATIVE(nativeGetRepackCacheStats, "()[J"),
+    NATIVE(nativeSelectRequantType, "()I"),
+    NATIVE(nativeRequantize, "(Ljava/lang/String;Ljava/lang/String;II)I"),
+    NATIVE(nativeCancelRequantize, "()V"),
+    NATIVE(nativeGetRequantizeProgress, "()[J"),
+    NATIVE(nativeSha256File, "(Ljava/lang/String;I)Ljava/lang/String;"),
+    NATIVE(nativeCancelFileHash, "()V"),
+    NATIVE(nativeGetFileHashProgress, "()[J"),
+    NATIVE(nativeSetBackgroundPaused, "(Z)V"),
+    NATIVE(nativeGetCpuTopology, "(Ljava/lang/String;)[J"),
+    NATIVE(nativeConfigureAdaptiveThreads, "(JZFFIIJ)Z"),
+    NATIVE(nativeGetThrottleReport, "()[J"),
+    NATIVE(nativeConfigureProfiler, "(JF)Z"),
+    NATIVE(nativeGetComputeProfile, "()Ljava/lang/String;"),
+    NATIVE(nativeSetModelCacheBudget, "(J)V"),
+    NATIVE(nativeEvictIdleModels, "()J"),
+    NATIVE(nativeConfigureAutotune, "(Ljava/lang/String;Ljava/lang/String;)V"),
+    NATIVE(nativeAutotune, "(JLjava/lang/String;II[I[I[I[IZ)[J"),
+    NATIVE(nativeProbeDevice, "(II)[J"),
+    NATIVE(cleanupBackend, "()V"),
+    NATIVE(nativeGetTeardownReport, "()[J"),
+};
+
+#undef CRITICAL
+#undef NATIVE
+
+/**
+ * Bind ENGINE_METHODS on [clazz] one at a time, since an engine class need
+ * not declare every native. Returns how many were bound.
+ */
+int register_engine_natives(JNIEnv* env, jclass clazz, const char* name) {
+    int bound = 0;
+    for (const JNINativeMethod& method : ENGINE_METHODS) {
+        if (env->RegisterNatives(clazz, &method, 1) == JNI_OK) {
+            bound++;
+            continue;
+        }
+        env->ExceptionClear();
+        LOGD("%s does not declare %s%s", name, method.name, method.signature);
+    }
+    return bound;
+}
+
+} // namespace
+
+JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
+    JNIEnv* env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) return JNI_ERR;
+
+    int classes = 0;
+    for (const char* name : ENGINE_CLASSES) {
+        jclass clazz = env->FindClass(name);
+        if (!clazz) {
+            env->ExceptionClear();
+            continue;
+        }
+        int bound = register_engine_natives(env, clazz, name);
+        LOGI("Registered %d/%zu natives on %s", bound, std::size(ENGINE_METHODS), name);
+        env->DeleteLocalRef(clazz);
+        classes++;
+    }
+    if (classes == 0) LOGE("No engine class found; natives left unbound");
+    return JNI_VERSION_1_6;
+}
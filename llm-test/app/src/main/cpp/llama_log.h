@@ -0,0 +1,43 @@
+/**
+ * Jeeves LLM Test Project - Native logging macros
+ *
+ * Logcat on Android; stderr on Linux hosts, where the same library runs
+ * under the JVM for desktop benchmarks.
+ */
+
+#pragma once
+
+#define LOG_TAG "LlamaJNI"
+
+#if defined(__ANDROID__)
+
+#include <android/log.h>
+
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+#else
+
+#include <cstdarg>
+#include <cstdio>
+
+__attribute__((format(printf, 2, 3)))
+inline void llama_host_log(char level, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    flockfile(stderr);
+    std::fprintf(stderr, "%c/%s: ", level, LOG_TAG);
+    std::vfprintf(stderr, fmt, args);
+    std::fputc('\n', stderr);
+    funlockfile(stderr);
+    va_end(args);
+}
+
+#define LOGI(...) llama_host_log('I', __VA_ARGS__)
+#define LOGW(...) llama_host_log('W', __VA_ARGS__)
+#define LOGE(...) llama_host_log('E', __VA_ARGS__)
+#define LOGD(...) llama_host_log('D', __VA_ARGS__)
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ * Jeeves LLM Test Project - Load-time memory budget
+ */
+
+#include "memory_budget.h"
+
+#include <algorithm>
+
+#include "llama_log.h"
+
+bool shrink_context_shape(ContextShape& shape) {
+    if (!shape.flash_attn) {
+        shape.flash_attn = true;
+        LOGW("Memory budget: enabling flash attention");
+        return true;
+    }
+    if (shape.type_k == KvCacheType::F16 || shape.type_v == KvCacheType::F16) {
+        // Never raise a type the caller already quantized further
+        if (shape.type_k == KvCacheType::F16) shape.type_k = KvCacheType::Q8_0;
+        if (shape.type_v == KvCacheType::F16) shape.type_v = KvCacheType::Q8_0;
+        LOGW("Memory budget: quantizing KV cache to q8_0");
+        return true;
+    }
+    if (shape.n_ubatch > MIN_FIT_UBATCH * 2) {
+        shape.n_ubatch /= 2;
+        shape.n_batch = std::min(shape.n_batch, shape.n_ubatch);
+        LOGW("Memory budget: reducing ubatch to %u", shape.n_ubatch);
+        return true;
+    }
+    if (shape.n_ctx > MIN_FIT_CONTEXT) {
+        shape.n_ctx = std::max(MIN_FIT_CONTEXT, shape.n_ctx / 2);
+        LOGW("Memory budget: reducing context to %u", shape.n_ctx);
+        return true;
+    }
+    if (shape.type_k != KvCacheType::Q4_0 || shape.type_v != KvCacheType::Q4_0) {
+        shape.type_k = KvCacheType::Q4_0;
+        shape.type_v = KvCacheType::Q4_0;
+        LOGW("Memory budget: quantizing KV cache to q4_0");
+        return true;
+    }
+    return false;
+}
+
+bool fit_context_shape(ContextShape& shape, size_t available_bytes,
+                       const std::function<size_t(const ContextShape&)>& estimate_bytes) {
+    for (;;) {
+        size_t need = estimate_bytes(shape);
+        if (need <= available_bytes) return true;
+        if (!shrink_context_shape(shape)) {
+            LOGE("Memory budget: %zu bytes needed, %zu available at smallest configuration",
+                 need, available_bytes);
+            return false;
+        }
+    }
+}
+
+#if LLAMA_AVAILABLE
+
+namespace {
+
+KvCacheType kv_cache_type(ggml_type type) {
+    switch (type) {
+        case GGML_TYPE_F16: return KvCacheType::F16;
+        case GGML_TYPE_Q8_0: return KvCacheType::Q8_0;
+        case GGML_TYPE_Q4_0: return KvCacheType::Q4_0;
+        default: return KvCacheType::OTHER;
+    }
+}
+
+/** [original] unless the fitter moved it to another type. */
+ggml_type ggml_kv_type(KvCacheType type, ggml_type original) {
+    switch (type) {
+        case KvCacheType::F16: return GGML_TYPE_F16;
+        case KvCacheType::Q8_0: return GGML_TYPE_Q8_0;
+        case KvCacheType::Q4_0: return GGML_TYPE_Q4_0;
+        default: return original;
+    }
+}
+
+ContextShape context_shape(const llama_context_params& params) {
+    ContextShape shape;
+    shape.flash_attn = params.flash_attn_type == LLAMA_FLASH_ATTN_TYPE_ENABLED;
+    shape.type_k = kv_cache_type(params.type_k);
+    shape.type_v = kv_cache_type(params.type_v);
+    shape.n_ctx = params.n_ctx;
+    shape.n_batch = params.n_batch;
+    shape.n_ubatch = params.n_ubatch;
+    return shape;
+}
+
+void apply_context_shape(const ContextShape& shape, llama_context_params& params) {
+    if (shape.flash_attn) params.flash_attn_type = LLAMA_FLASH_ATTN_TYPE_ENABLED;
+    params.type_k = ggml_kv_type(shape.type_k, params.type_k);
+    params.type_v = ggml_kv_type(shape.type_v, params.type_v);
+    params.n_ctx = shape.n_ctx;
+    params.n_batch = shape.n_batch;
+    params.n_ubatch = shape.n_ubatch;
+}
+
+} // namespace
+
+size_t estimate_kv_bytes(const llama_model* model, uint32_t n_ctx, ggml_type type_k, ggml_type type_v) {
+    const int64_t n_layer = llama_model_n_layer(model);
+    const int64_t n_head = std::max(1, llama_model_n_head(model));
+    const int64_t n_head_kv = std::max(1, llama_model_n_head_kv(model));
+    const int64_t n_embd_kv = llama_model_n_embd(model) / n_head * n_head_kv;
+
+    const size_t per_token = ggml_row_size(type_k, n_embd_kv) + ggml_row_size(type_v, n_embd_kv);
+    return static_cast<size_t>(n_layer) * n_ctx * per_token;
+}
+
+size_t estimate_compute_bytes(const llama_model* model, const llama_context_params& params) {
+    const size_t n_ubatch = params.n_ubatch;
+    const size_t n_ctx = params.n_ctx;
+    const size_t n_embd = llama_model_n_embd(model);
+    const size_t n_head = std::max(1, llama_model_n_head(model));
+    const size_t n_vocab = llama_vocab_n_tokens(llama_model_get_vocab(model));
+
+    // Logits for one ubatch plus a handful of f32 activations per layer in flight
+    size_t bytes = n_ubatch * n_vocab * sizeof(float);
+    bytes += n_ubatch * n_embd * sizeof(float) * 16;
+    // Without flash attention the full KQ score matrix is materialized
+    if (params.flash_attn_type != LLAMA_FLASH_ATTN_TYPE_ENABLED) {
+        bytes += n_ubatch * n_ctx * n_head * sizeof(float);
+    }
+    return bytes;
+}
+
+bool shrink_context_params(llama_context_params& params) {
+    ContextShape shape = context_shape(params);
+    if (!shrink_context_shape(shape)) return false;
+    apply_context_shape(shape, params);
+    return true;
+}
+
+bool fit_context_params(const llama_model* model, llama_context_params& params, size_t available_bytes) {
+    ContextShape shape = context_shape(params);
+    bool fits = fit_context_shape(shape, available_bytes, [&](const ContextShape& candidate) {
+        llama_context_params p = params;
+        apply_context_shape(candidate, p);
+        return estimate_kv_bytes(model, p.n_ctx, p.type_k, p.type_v) + estimate_compute_bytes(model, p);
+    });
+    apply_context_shape(shape, params);
+    return fits;
+}
+
+#endif // LLAMA_AVAILABLE
@@ -0,0 +1,68 @@
+/**
+ * Jeeves LLM Test Project - Load-time memory budget
+ *
+ * Given a budget for the whole engine (weights + KV cache + compute buffers),
+ * degrade the context parameters step by step until the estimate fits instead
+ * of letting the low-memory killer take the app:
+ *   flash attention -> q8_0 KV -> smaller ubatch -> smaller n_ctx -> q4_0 KV
+ *
+ * The degradation order works on ContextShape, the part of the context
+ * parameters it touches, so it runs without llama on the host tests.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/** Minimum context the fitter will shrink to. */
+constexpr uint32_t MIN_FIT_CONTEXT = 512;
+
+/** Minimum micro-batch the fitter will shrink to. */
+constexpr uint32_t MIN_FIT_UBATCH = 64;
+
+/** KV cache types the fitter tells apart; OTHER is left alone until q4_0. */
+enum class KvCacheType { F16, Q8_0, Q4_0, OTHER };
+
+struct ContextShape {
+    bool flash_attn = false;
+    KvCacheType type_k = KvCacheType::F16;
+    KvCacheType type_v = KvCacheType::F16;
+    uint32_t n_ctx = 0;
+    uint32_t n_batch = 0;
+    uint32_t n_ubatch = 0;
+};
+
+/**
+ * Apply one degradation step to [shape]. Returns false when nothing is left to shrink.
+ */
+bool shrink_context_shape(ContextShape& shape);
+
+/**
+ * Shrink [shape] until [estimate_bytes] of it fits in [available_bytes].
+ * Returns false if even the smallest configuration does not fit.
+ */
+bool fit_context_shape(ContextShape& shape, size_t available_bytes,
+                       const std::function<size_t(const ContextShape&)>& estimate_bytes);
+
+#if LLAMA_AVAILABLE
+
+#include "llama.h"
+
+size_t estimate_kv_bytes(const llama_model* model, uint32_t n_ctx, ggml_type type_k, ggml_type type_v);
+
+size_t estimate_compute_bytes(const llama_model* model, const llama_context_params& params);
+
+/**
+ * Apply one degradation step to [params]. Returns false when nothing is left to shrink.
+ */
+bool shrink_context_params(llama_context_params& params);
+
+/**
+ * Shrink [params] until KV + compute estimates fit in [available_bytes].
+ * Returns false if even the smallest configuration does not fit.
+ */
+bool fit_context_params(const llama_model* model, llama_context_params& params, size_t available_bytes);
+
+#endif // LLAMA_AVAILABLE
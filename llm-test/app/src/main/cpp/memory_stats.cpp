@@ -0,0 +1,140 @@
+/**
+ * Jeeves LLM Test Project - Native memory accounting
+ */
+
+#include "memory_stats.h"
+
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// Parses "Key:   1234 kB" lines; returns bytes or 0 if the key does not match
+size_t parse_kb_field(const char* line, const char* key) {
+    size_t key_len = strlen(key);
+    if (strncmp(line, key, key_len) != 0 || line[key_len] != ':') return 0;
+    unsigned long long kb = 0;
+    if (sscanf(line + key_len + 1, "%llu", &kb) != 1) return 0;
+    return static_cast<size_t>(kb) * 1024;
+}
+
+bool read_statm(ProcessMemory& out, const std::string& proc_root) {
+    FILE* f = fopen((proc_root + "/statm").c_str(), "r");
+    if (!f) return false;
+    unsigned long long size = 0, resident = 0, shared = 0;
+    int n = fscanf(f, "%llu %llu %llu", &size, &resident, &shared);
+    fclose(f);
+    if (n != 3) return false;
+
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    out.rss_bytes = static_cast<size_t>(resident) * page;
+    out.anonymous_bytes = static_cast<size_t>(resident - shared) * page;
+    // statm has no PSS; RSS is the closest upper bound
+    out.pss_bytes = out.rss_bytes;
+    return true;
+}
+
+} // namespace
+
+void MemoryBreakdown::to_array(long long out[COUNT]) const {
+    out[WEIGHTS_MAPPED] = static_cast<long long>(weights_mapped_bytes);
+    out[WEIGHTS_RESIDENT] = static_cast<long long>(weights_resident_bytes);
+    out[KV_CACHE] = static_cast<long long>(kv_cache_bytes);
+    out[COMPUTE_BUFFERS] = static_cast<long long>(compute_buffer_bytes);
+    out[PROCESS_RSS] = static_cast<long long>(process.rss_bytes);
+    out[PROCESS_PSS] = static_cast<long long>(process.pss_bytes);
+    out[PROCESS_ANONYMOUS] = static_cast<long long>(process.anonymous_bytes);
+}
+
+bool read_process_memory(ProcessMemory& out, const std::string& proc_root) {
+    out = ProcessMemory();
+
+    // smaps_rollup (Linux 4.14+) is a single cheap read with real PSS
+    FILE* f = fopen((proc_root + "/smaps_rollup").c_str(), "r");
+    if (!f) return read_statm(out, proc_root);
+
+    char line[256];
+    size_t v;
+    while (fgets(line, sizeof(line), f)) {
+        if ((v = parse_kb_field(line, "Rss"))) out.rss_bytes = v;
+        else if ((v = parse_kb_field(line, "Pss"))) out.pss_bytes = v;
+        else if ((v = parse_kb_field(line, "Anonymous"))) out.anonymous_bytes = v;
+        else if ((v = parse_kb_field(line, "Swap"))) out.swap_bytes = v;
+    }
+    fclose(f);
+    return out.rss_bytes > 0 || read_statm(out, proc_root);
+}
+
+size_t read_mapping_rss(const std::string& path) {
+    if (path.empty()) return 0;
+
+    FILE* f = fopen("/proc/self/smaps", "r");
+    if (!f) return 0;
+
+    // Mapping header: "start-end perms offset dev inode   pathname"
+    char line[4096];
+    bool in_mapping = false;
+    size_t total = 0;
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long long start, end;
+        if (sscanf(line, "%llx-%llx ", &start, &end) == 2) {
+            const char* name = strchr(line, '/');
+            size_t len = name ? strcspn(name, "\n") : 0;
+            in_mapping = name && len == path.size() && strncmp(name, path.c_str(), len) == 0;
+            continue;
+        }
+        if (in_mapping) total += parse_kb_field(line, "Rss");
+    }
+    fclose(f);
+    return total;
+}
+
+size_t read_mapping_size(const std::string& path) {
+    if (path.empty()) return 0;
+
+    FILE* f = fopen("/proc/self/maps", "r");
+    if (!f) return 0;
+
+    char line[4096];
+    size_t total = 0;
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long long start, end;
+        if (sscanf(line, "%llx-%llx ", &start, &end) != 2) continue;
+        const char* name = strchr(line, '/');
+        size_t len = name ? strcspn(name, "\n") : 0;
+        if (name && len == path.size() && strncmp(name, path.c_str(), len) == 0) {
+            total += static_cast<size_t>(end - start);
+        }
+    }
+    fclose(f);
+    return total;
+}
+
+int read_thread_count() {
+    FILE* f = fopen("/proc/self/status", "r");
+    if (!f) return 0;
+
+    char line[256];
+    int threads = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "Threads: %d", &threads) == 1) break;
+    }
+    fclose(f);
+    return threads;
+}
+
+bool read_system_memory(size_t& total_bytes, size_t& available_bytes) {
+    total_bytes = available_bytes = 0;
+    FILE* f = fopen("/proc/meminfo", "r");
+    if (!f) return false;
+
+    char line[256];
+    size_t v;
+    while (fgets(line, sizeof(line), f)) {
+        if ((v = parse_kb_field(line, "MemTotal"))) total_bytes = v;
+        else if ((v = parse_kb_field(line, "MemAvailable"))) available_bytes = v;
+    }
+    fclose(f);
+    return total_bytes > 0;
+}
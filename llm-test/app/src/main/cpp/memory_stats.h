@@ -0,0 +1,69 @@
+/**
+ * Jeeves LLM Test Project - Native memory accounting
+ *
+ * llama_state_get_size() measures serialized state, not RAM, so the engine
+ * reports what the kernel actually sees instead:
+ * - Process RSS/PSS/anonymous from /proc/self/smaps_rollup (statm fallback)
+ * - Resident pages of the mmapped model file from /proc/self/smaps
+ * - KV cache and compute buffers per context
+ *
+ * The /proc/self root is a parameter so parsing can run against fixture files.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+constexpr const char* DEFAULT_PROC_SELF_ROOT = "/proc/self";
+
+struct ProcessMemory {
+    size_t rss_bytes = 0;
+    size_t pss_bytes = 0;
+    size_t anonymous_bytes = 0;
+    size_t swap_bytes = 0;
+};
+
+/**
+ * Per-engine breakdown, flattened to a jlongArray for Kotlin in this order.
+ */
+struct MemoryBreakdown {
+    enum Index {
+        WEIGHTS_MAPPED = 0,
+        WEIGHTS_RESIDENT,
+        KV_CACHE,
+        COMPUTE_BUFFERS,
+        PROCESS_RSS,
+        PROCESS_PSS,
+        PROCESS_ANONYMOUS,
+        COUNT
+    };
+
+    size_t weights_mapped_bytes = 0;
+    size_t weights_resident_bytes = 0;
+    size_t kv_cache_bytes = 0;
+    size_t compute_buffer_bytes = 0;
+    ProcessMemory process;
+
+    /** Engine-attributable footprint: resident weights + KV + compute. */
+    size_t engine_bytes() const {
+        return weights_resident_bytes + kv_cache_bytes + compute_buffer_bytes;
+    }
+
+    void to_array(long long out[COUNT]) const;
+};
+
+/** Read process totals under [proc_root]. Returns false only if /proc is unreadable. */
+bool read_process_memory(ProcessMemory& out, const std::string& proc_root = DEFAULT_PROC_SELF_ROOT);
+
+/** Sum of Rss over every mapping of [path] in /proc/self/smaps. */
+size_t read_mapping_rss(const std::string& path);
+
+/** Total size of every mapping of [path] in /proc/self/maps, resident or not. */
+size_t read_mapping_size(const std::string& path);
+
+/** Threads in this process, from /proc/self/status. 0 if unreadable. */
+int read_thread_count();
+
+/** MemTotal and MemAvailable from /proc/meminfo. Returns false if unreadable. */
+bool read_system_memory(size_t& total_bytes, size_t& available_bytes);
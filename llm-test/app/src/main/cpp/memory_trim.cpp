@@ -0,0 +1,194 @@
+/**
+ * Jeeves LLM Test Project - Graded memory trim for onTrimMemory
+ */
+
+#include "memory_trim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "engine_handles.h"
+#include "llama_log.h"
+#include "memory_stats.h"
+
+#if LLAMA_AVAILABLE
+#include <zlib.h>
+
+#include "elastic_context.h"
+#endif
+
+void TrimResult::to_array(long long out[COUNT]) const {
+    out[LEVEL] = level;
+    out[BYTES_FREED] = static_cast<long long>(bytes_freed);
+    out[RSS_FREED] = static_cast<long long>(rss_freed);
+    out[RESTORE_COST_MS] = restore_cost_ms;
+}
+
+#if LLAMA_AVAILABLE
+
+namespace {
+
+// Conservative single-core inflate throughput for restore estimates
+constexpr double INFLATE_BYTES_PER_MS = 200.0 * 1024.0;
+
+long long prefill_cost_ms(const LlamaContext* wrapper, size_t tokens) {
+    return static_cast<long long>(wrapper->prompt_ms_per_token * tokens);
+}
+
+bool compress_kv(LlamaContext* wrapper) {
+    size_t raw_size = llama_state_seq_get_size(wrapper->ctx, 0);
+    if (raw_size == 0) return false;
+
+    std::vector<uint8_t> raw(raw_size);
+    if (llama_state_seq_get_data(wrapper->ctx, raw.data(), raw.size(), 0) != raw_size) {
+        LOGE("KV snapshot failed");
+        return false;
+    }
+
+    uLongf compressed_size = compressBound(raw_size);
+    wrapper->kv_blob.resize(compressed_size);
+    if (compress2(wrapper->kv_blob.data(), &compressed_size, raw.data(), raw_size, Z_BEST_SPEED) != Z_OK) {
+        LOGE("KV compression failed");
+        wrapper->kv_blob.clear();
+        return false;
+    }
+    wrapper->kv_blob.resize(compressed_size);
+    wrapper->kv_blob.shrink_to_fit();
+    wrapper->kv_blob_raw_size = raw_size;
+    wrapper->kv_blob_tokens = wrapper->cached_tokens;
+    LOGI("KV compressed %zu -> %zu bytes (%zu tokens)", raw_size, wrapper->kv_blob.size(),
+         wrapper->kv_blob_tokens.size());
+    return true;
+}
+
+void drop_kv_blob(LlamaContext* wrapper) {
+    std::vector<uint8_t>().swap(wrapper->kv_blob);
+    std::vector<llama_token>().swap(wrapper->kv_blob_tokens);
+    wrapper->kv_blob_raw_size = 0;
+}
+
+size_t release_context(LlamaContext* wrapper) {
+    if (!wrapper->ctx) return 0;
+    size_t freed = wrapper->kv_cache_bytes + wrapper->compute_buffer_bytes;
+    free_context(wrapper);
+    wrapper->kv_cache_bytes = 0;
+    wrapper->compute_buffer_bytes = 0;
+    wrapper->cached_tokens.clear();
+    // Recreate at the elastic floor; requests grow it again as needed
+    if (wrapper->elastic.enabled) {
+        wrapper->ctx_params.n_ctx = std::max<uint32_t>(
+            wrapper->elastic.min_ctx, static_cast<uint32_t>(wrapper->kv_blob_tokens.size() + 1));
+    }
+    return freed;
+}
+
+} // namespace
+
+TrimResult trim_engine(LlamaContext* wrapper, int level) {
+    TrimResult result;
+    result.level = std::max(static_cast<int>(TRIM_NONE), std::min(level, static_cast<int>(TRIM_ALL)));
+    if (result.level == TRIM_NONE) return result;
+
+    ProcessMemory before, after;
+    read_process_memory(before);
+    const size_t cached = wrapper->cached_tokens.size();
+    const size_t blob_before = wrapper->kv_blob.size();
+
+    switch (result.level) {
+    case TRIM_PREFIX_CACHE: {
+        size_t kv_before = wrapper->kv_cache_bytes;
+        drop_kv_blob(wrapper);
+        wrapper->cached_tokens.clear();
+        if (wrapper->ctx) {
+            llama_memory_clear(llama_get_memory(wrapper->ctx), true);
+            if (wrapper->elastic.enabled && llama_n_ctx(wrapper->ctx) > static_cast<uint32_t>(wrapper->elastic.min_ctx)) {
+                resize_context(wrapper, static_cast<uint32_t>(wrapper->elastic.min_ctx));
+            }
+        }
+        result.bytes_freed = blob_before + (kv_before > wrapper->kv_cache_bytes ? kv_before - wrapper->kv_cache_bytes : 0);
+        result.restore_cost_ms = prefill_cost_ms(wrapper, cached);
+        break;
+    }
+    case TRIM_COMPRESS_KV: {
+        if (wrapper->ctx && !wrapper->cached_tokens.empty()) {
+            drop_kv_blob(wrapper);
+            compress_kv(wrapper);
+        }
+        size_t freed = release_context(wrapper);
+        result.bytes_freed = freed > wrapper->kv_blob.size() ? freed - wrapper->kv_blob.size() : 0;
+        result.restore_cost_ms = wrapper->context_create_ms
+            + static_cast<long long>(wrapper->kv_blob_raw_size / INFLATE_BYTES_PER_MS);
+        if (wrapper->kv_blob.empty()) result.restore_cost_ms += prefill_cost_ms(wrapper, cached);
+        break;
+    }
+    case TRIM_CONTEXT:
+    case TRIM_ALL: {
+        drop_kv_blob(wrapper);
+        result.bytes_freed = blob_before + release_context(wrapper);
+        result.restore_cost_ms = wrapper->context_create_ms + prefill_cost_ms(wrapper, cached);
+        if (result.level == TRIM_ALL && wrapper->model_ref) {
+            // Weights only leave memory if no other engine shares them
+            if (wrapper->model_ref.use_count() == 1) result.bytes_freed += wrapper->model_ref.size_bytes();
+            wrapper->model_ref.reset();
+            wrapper->model = nullptr;
+            result.restore_cost_ms = wrapper->load_time_ms + prefill_cost_ms(wrapper, cached);
+        }
+        break;
+    }
+    }
+
+    wrapper->memory_usage_bytes = wrapper->model_ref.size_bytes()
+        + wrapper->kv_cache_bytes + wrapper->compute_buffer_bytes;
+    EngineHandles::instance().publish(wrapper);
+    read_process_memory(after);
+    result.rss_freed = before.rss_bytes > after.rss_bytes ? before.rss_bytes - after.rss_bytes : 0;
+    LOGI("Trim level %d: freed %zu bytes (rss -%zu), restore ~%lld ms", result.level,
+         result.bytes_freed, result.rss_freed, result.restore_cost_ms);
+    return result;
+}
+
+bool restore_engine(LlamaContext* wrapper) {
+    if (wrapper->model && wrapper->ctx) return true;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!wrapper->model) {
+        wrapper->model_ref = ModelRegistry::instance().acquire(wrapper->model_path, wrapper->load_params);
+        wrapper->model = wrapper->model_ref.get();
+        if (!wrapper->model) {
+            LOGE("Restore failed: cannot reacquire %s", wrapper->model_path.c_str());
+            return false;
+        }
+    }
+
+    if (!wrapper->ctx) {
+        if (!create_context(wrapper, wrapper->ctx_params, wrapper->memory_budget_bytes)) {
+            LOGE("Restore failed: cannot recreate context");
+            return false;
+        }
+        wrapper->memory_usage_bytes = wrapper->model_ref.size_bytes()
+            + wrapper->kv_cache_bytes + wrapper->compute_buffer_bytes;
+        EngineHandles::instance().publish(wrapper);
+
+        if (!wrapper->kv_blob.empty()) {
+            std::vector<uint8_t> raw(wrapper->kv_blob_raw_size);
+            uLongf raw_size = raw.size();
+            bool ok = uncompress(raw.data(), &raw_size, wrapper->kv_blob.data(), wrapper->kv_blob.size()) == Z_OK
+                && raw_size == raw.size()
+                && llama_state_seq_set_data(wrapper->ctx, raw.data(), raw.size(), 0) == raw.size();
+            if (ok) {
+                wrapper->cached_tokens = wrapper->kv_blob_tokens;
+            } else {
+                LOGW("KV blob restore failed - prefix will be recomputed");
+                llama_memory_clear(llama_get_memory(wrapper->ctx), true);
+            }
+            drop_kv_blob(wrapper);
+        }
+    }
+
+    LOGI("Engine restored in %lld ms", static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count()));
+    return true;
+}
+
+#endif // LLAMA_AVAILABLE
@@ -0,0 +1,58 @@
+/**
+ * Jeeves LLM Test Project - Graded memory trim for onTrimMemory
+ *
+ * Unloading throws away ~1.5 s of model load plus prefill, so the engine
+ * offers cheaper steps first. Each level reports what it freed and what the
+ * next request will pay to undo it; restore happens lazily on that request.
+ *
+ *   TRIM_PREFIX_CACHE  drop cached prompt prefix, shrink elastic context
+ *   TRIM_COMPRESS_KV   compress live KV into a zlib blob, free the context
+ *   TRIM_CONTEXT       free KV + compute buffers, keep the model mapped
+ *   TRIM_ALL           also release the model reference
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "engine_context.h"
+
+/** Values match LlamaEngine.TrimLevel on the Kotlin side. */
+enum TrimLevel : int {
+    TRIM_NONE = 0,
+    TRIM_PREFIX_CACHE = 1,
+    TRIM_COMPRESS_KV = 2,
+    TRIM_CONTEXT = 3,
+    TRIM_ALL = 4,
+};
+
+struct TrimResult {
+    enum Index {
+        LEVEL = 0,
+        BYTES_FREED,        // From engine accounting
+        RSS_FREED,          // Measured process RSS drop (allocator permitting)
+        RESTORE_COST_MS,    // Expected extra latency on the next request
+        COUNT
+    };
+
+    int level = TRIM_NONE;
+    size_t bytes_freed = 0;
+    size_t rss_freed = 0;
+    long long restore_cost_ms = 0;
+
+    void to_array(long long out[COUNT]) const;
+};
+
+#if LLAMA_AVAILABLE
+
+/** Apply [level] to [wrapper]. Caller holds wrapper->mutex. */
+TrimResult trim_engine(LlamaContext* wrapper, int level);
+
+/**
+ * Bring a trimmed engine back: reacquire the model, recreate the context and
+ * restore a compressed KV blob. No-op when nothing was trimmed. Caller holds
+ * wrapper->mutex.
+ */
+bool restore_engine(LlamaContext* wrapper);
+
+#endif // LLAMA_AVAILABLE
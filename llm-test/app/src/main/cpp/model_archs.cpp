@@ -0,0 +1,47 @@
+/**
+ * Jeeves LLM Test Project - Compiled-in model architectures
+ */
+
+#include "model_archs.h"
+
+#include <sstream>
+
+#if LLAMA_AVAILABLE
+#include "gguf.h"
+#endif
+
+#ifndef LLAMA_MODEL_ARCHS
+#define LLAMA_MODEL_ARCHS "all"
+#endif
+
+const char* built_in_model_archs() {
+    return LLAMA_MODEL_ARCHS;
+}
+
+bool model_arch_built_in(const std::string& arch) {
+    if (arch.empty()) return false;
+
+    std::istringstream archs(LLAMA_MODEL_ARCHS);
+    std::string name;
+    while (std::getline(archs, name, ',')) {
+        if (name == "all" || arch == name) return true;
+        if (arch.size() > name.size() && arch.compare(0, name.size(), name) == 0 && arch[name.size()] == '-') {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string read_model_arch(const std::string& path) {
+    std::string arch;
+#if LLAMA_AVAILABLE
+    // Metadata only; no tensor data is read
+    gguf_init_params params = {/*no_alloc =*/ true, /*ctx =*/ nullptr};
+    gguf_context* ctx = gguf_init_from_file(path.c_str(), params);
+    if (!ctx) return arch;
+    const int64_t key = gguf_find_key(ctx, "general.architecture");
+    if (key >= 0 && gguf_get_kv_type(ctx, key) == GGUF_TYPE_STRING) arch = gguf_get_val_str(ctx, key);
+    gguf_free(ctx);
+#endif
+    return arch;
+}
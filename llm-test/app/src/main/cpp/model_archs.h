@@ -0,0 +1,25 @@
+/**
+ * Jeeves LLM Test Project - Compiled-in model architectures
+ *
+ * llama.cpp ships a graph builder for every architecture it supports, and
+ * compiling all of them dominates libllama_jni.so. The build keeps only the
+ * architectures in LLAMA_MODEL_ARCHS (CMakeLists.txt) - the families
+ * ModelRegistry ships - and stubs the rest. Models of any other architecture
+ * are refused here, from the GGUF header, before their weights are mapped.
+ */
+
+#pragma once
+
+#include <string>
+
+/** Comma-separated GGUF architecture names built in, or "all". */
+const char* built_in_model_archs();
+
+/**
+ * True when GGUF architecture [arch] is built in: it is listed, or starts
+ * with a listed name and '-' (variants such as "gemma-embedding").
+ */
+bool model_arch_built_in(const std::string& arch);
+
+/** general.architecture of the GGUF file at [path]; empty if unreadable. */
+std::string read_model_arch(const std::string& path);
@@ -0,0 +1,377 @@
+/**
+ * Jeeves LLM Test Project - Process-wide model registry
+ */
+
+#include "model_registry.h"
+
+#include <sys/stat.h>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <algorithm>
+#include <sstream>
+
+#include "llama_log.h"
+#include "model_archs.h"
+#include "repack_cache.h"
+
+struct ModelRef::Entry {
+    std::string key;
+    std::string path;
+    llama_model* model = nullptr;
+    size_t bytes = 0;
+    size_t file_size = 0;
+    bool use_mmap = true;
+    int refs = 0;
+    bool loading = false;
+};
+
+// ============================================================================
+// ModelRef
+// ============================================================================
+
+ModelRef& ModelRef::operator=(ModelRef&& other) noexcept {
+    if (this != &other) {
+        reset();
+        entry_ = other.entry_;
+        other.entry_ = nullptr;
+    }
+    return *this;
+}
+
+void ModelRef::reset() {
+    if (entry_) {
+        ModelRegistry::instance().release(entry_);
+        entry_ = nullptr;
+    }
+}
+
+llama_model* ModelRef::get() const {
+    return entry_ ? entry_->model : nullptr;
+}
+
+size_t ModelRef::size_bytes() const {
+    return entry_ ? entry_->bytes : 0;
+}
+
+size_t ModelRef::mapped_bytes() const {
+    return entry_ && entry_->use_mmap ? entry_->file_size : 0;
+}
+
+const std::string& ModelRef::key() const {
+    static const std::string empty;
+    return entry_ ? entry_->key : empty;
+}
+
+int ModelRef::use_count() const {
+    if (!entry_) return 0;
+    std::lock_guard<std::mutex> lock(ModelRegistry::instance().mutex_);
+    return entry_->refs;
+}
+
+const std::string& ModelRef::path() const {
+    static const std::string empty;
+    return entry_ ? entry_->path : empty;
+}
+
+// ============================================================================
+// ModelRegistry
+// ============================================================================
+
+namespace {
+
+// Canonical path plus file identity, so a model replaced in place (download,
+// requantization) is never served from a stale mapping.
+bool make_key(const std::string& path, const ModelLoadParams& params,
+              std::string& canonical, size_t& file_size, std::string& key) {
+    char resolved[PATH_MAX];
+    if (!realpath(path.c_str(), resolved)) {
+        LOGE("Cannot resolve model path: %s (errno=%d)", path.c_str(), errno);
+        return false;
+    }
+    struct stat st {};
+    if (stat(resolved, &st) != 0) {
+        LOGE("Cannot stat model file: %s (errno=%d)", resolved, errno);
+        return false;
+    }
+    canonical = resolved;
+    file_size = static_cast<size_t>(st.st_size);
+
+    std::ostringstream k;
+    k << canonical
+      << "|dev=" << st.st_dev << "|ino=" << st.st_ino
+      << "|size=" << st.st_size << "|mtime=" << st.st_mtime
+      << "|ngl=" << params.n_gpu_layers
+      << "|mmap=" << params.use_mmap
+      << "|mlock=" << params.use_mlock;
+    key = k.str();
+    return true;
+}
+
+class LlamaModelLoader : public ModelLoader {
+public:
+    llama_model* load(const std::string& path, const ModelLoadParams& params, size_t& bytes) override {
+#if LLAMA_AVAILABLE
+        llama_model_params model_params = llama_model_default_params();
+        model_params.n_gpu_layers = params.n_gpu_layers;
+        model_params.use_mmap = params.use_mmap;
+        model_params.use_mlock = params.use_mlock;
+        std::unique_ptr<RepackCacheLoad> repack_cache = RepackCacheLoad::prepare(path, params.n_gpu_layers);
+        if (repack_cache) model_params.tensor_buft_overrides = repack_cache->overrides();
+        llama_model* model = llama_model_load_from_file(path.c_str(), model_params);
+        if (repack_cache) repack_cache->finish(model != nullptr);
+        if (!model) {
+            LOGE("Failed to load model - llama_model_load_from_file returned null");
+            return nullptr;
+        }
+        bytes = static_cast<size_t>(llama_model_size(model));
+        return model;
+#else
+        return nullptr;
+#endif
+    }
+
+    void unload(llama_model* model) override {
+#if LLAMA_AVAILABLE
+        llama_model_free(model);
+#endif
+    }
+};
+
+LlamaModelLoader& llama_loader() {
+    static LlamaModelLoader loader;
+    return loader;
+}
+
+} // namespace
+
+ModelRegistry& ModelRegistry::instance() {
+    static ModelRegistry registry;
+    return registry;
+}
+
+ModelRegistry::ModelRegistry() : loader_(&llama_loader()) {}
+
+void ModelRegistry::set_loader(ModelLoader* loader) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    loader_ = loader ? loader : &llama_loader();
+}
+
+ModelRef ModelRegistry::acquire(const std::string& path, const ModelLoadParams& params) {
+    std::string canonical;
+    std::string key;
+    size_t file_size = 0;
+    if (!make_key(path, params, canonical, file_size, key)) {
+        return {};
+    }
+
+#if LLAMA_AVAILABLE
+    const std::string arch = read_model_arch(canonical);
+    if (!arch.empty() && !model_arch_built_in(arch)) {
+        LOGE("Model %s is a %s model; this build only includes %s",
+             canonical.c_str(), arch.c_str(), built_in_model_archs());
+        return {};
+    }
+#endif
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        auto it = entries_.begin();
+        for (; it != entries_.end(); ++it) {
+            if ((*it)->key == key) break;
+        }
+        if (it == entries_.end()) break;
+
+        Entry* entry = it->get();
+        if (entry->loading) {
+            // Another caller is loading the same weights - share its result
+            loaded_cv_.wait(lock);
+            continue;
+        }
+        entry->refs++;
+        entries_.splice(entries_.begin(), entries_, it);
+        hits_++;
+        LOGI("Model registry hit: %s (refs=%d)", canonical.c_str(), entry->refs);
+        return ModelRef(entry);
+    }
+
+    std::vector<Entry*> evicted;
+    if (!make_room_locked(file_size, nullptr, evicted)) {
+        LOGE("Model %s (%zu bytes) does not fit registry budget of %zu bytes",
+             canonical.c_str(), file_size, budget_bytes_);
+        lock.unlock();
+        free_retired(evicted);
+        return {};
+    }
+
+    auto owned = std::make_unique<Entry>();
+    Entry* entry = owned.get();
+    entry->key = key;
+    entry->path = canonical;
+    entry->bytes = file_size;
+    entry->file_size = file_size;
+    entry->use_mmap = params.use_mmap;
+    entry->refs = 1;
+    entry->loading = true;
+    entries_.push_front(std::move(owned));
+    ModelLoader* loader = loader_;
+
+    // Load without holding the lock so other models stay available
+    lock.unlock();
+    free_retired(evicted);
+    LOGI("Model registry loading: %s", canonical.c_str());
+    size_t bytes = file_size;
+    llama_model* model = loader->load(canonical, params, bytes);
+    lock.lock();
+
+    entry->loading = false;
+    if (!model) {
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->get() == entry) {
+                entries_.erase(it);
+                break;
+            }
+        }
+        loaded_cv_.notify_all();
+        return {};
+    }
+
+    entry->model = model;
+    entry->bytes = bytes;
+    loads_++;
+    loaded_cv_.notify_all();
+    LOGI("Model registry loaded: %s (%zu bytes)", canonical.c_str(), entry->bytes);
+    return ModelRef(entry);
+}
+
+void ModelRegistry::release(Entry* entry) {
+    std::vector<Entry*> retired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--entry->refs > 0) return;
+
+        if (budget_bytes_ == 0) {
+            // No budget configured - nothing bounds an idle cache, free right away
+            for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+                if (it->get() == entry) {
+                    retire_locked(it, retired);
+                    break;
+                }
+            }
+        } else {
+            make_room_locked(0, nullptr, retired);
+        }
+    }
+    free_retired(retired);
+}
+
+void ModelRegistry::set_budget(size_t bytes) {
+    std::vector<Entry*> retired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        budget_bytes_ = bytes;
+        if (budget_bytes_ == 0) {
+            for (auto it = entries_.begin(); it != entries_.end();) {
+                auto next = std::next(it);
+                if ((*it)->refs == 0 && !(*it)->loading) retire_locked(it, retired);
+                it = next;
+            }
+        } else {
+            make_room_locked(0, nullptr, retired);
+        }
+    }
+    free_retired(retired);
+    LOGI("Model registry budget set to %zu bytes", bytes);
+}
+
+size_t ModelRegistry::evict_idle() {
+    std::vector<Entry*> retired;
+    size_t freed = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            auto next = std::next(it);
+            if ((*it)->refs == 0 && !(*it)->loading) {
+                freed += (*it)->bytes;
+                retire_locked(it, retired);
+                evictions_++;
+            }
+            it = next;
+        }
+    }
+    free_retired(retired);
+    return freed;
+}
+
+ModelRegistryStats ModelRegistry::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ModelRegistryStats s;
+    for (const auto& entry : entries_) {
+        if (entry->loading) continue;
+        s.loaded_models++;
+        if (entry->refs == 0) s.idle_models++;
+    }
+    s.resident_bytes = resident_bytes_locked();
+    s.budget_bytes = budget_bytes_;
+    s.loads = loads_;
+    s.hits = hits_;
+    s.evictions = evictions_;
+    return s;
+}
+
+bool ModelRegistry::holds(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const EntryList* list : {&entries_, &freeing_}) {
+        for (const auto& entry : *list) {
+            if (entry->path == path) return true;
+        }
+    }
+    return false;
+}
+
+size_t ModelRegistry::resident_bytes_locked() const {
+    size_t total = 0;
+    for (const auto& entry : entries_) total += entry->bytes;
+    return total;
+}
+
+bool ModelRegistry::make_room_locked(size_t needed, const Entry* exclude, std::vector<Entry*>& retired) {
+    if (budget_bytes_ == 0) return true;
+
+    while (resident_bytes_locked() + needed > budget_bytes_) {
+        // Walk from the back: least recently used idle model goes first
+        auto victim = entries_.end();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            const Entry* e = it->get();
+            if (e != exclude && e->refs == 0 && !e->loading) victim = it;
+        }
+        if (victim == entries_.end()) return false;
+
+        LOGI("Model registry evicting idle model: %s (%zu bytes)",
+             (*victim)->path.c_str(), (*victim)->bytes);
+        retire_locked(victim, retired);
+        evictions_++;
+    }
+    return true;
+}
+
+void ModelRegistry::retire_locked(EntryList::iterator it, std::vector<Entry*>& retired) {
+    retired.push_back(it->get());
+    freeing_.splice(freeing_.end(), entries_, it);
+}
+
+void ModelRegistry::free_retired(const std::vector<Entry*>& retired) {
+    if (retired.empty()) return;
+    ModelLoader* loader;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        loader = loader_;
+    }
+    for (Entry* entry : retired) {
+        if (entry->model) loader->unload(entry->model);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    freeing_.remove_if([&](const std::unique_ptr<Entry>& e) {
+        return std::find(retired.begin(), retired.end(), e.get()) != retired.end();
+    });
+}
@@ -0,0 +1,153 @@
+/**
+ * Jeeves LLM Test Project - Process-wide model registry
+ *
+ * Every engine instance (llm-test harness, core:ai-provider, benchmarks,
+ * workers) loads its weights through this registry so that one GGUF file is
+ * mapped once per process, no matter how many contexts are created on top.
+ *
+ * - Models are keyed by canonical path, file identity and load parameters
+ * - ModelRef is a refcounted RAII handle; the last ref makes the model idle
+ * - Idle models stay cached only while a memory budget is configured, and
+ *   are evicted least-recently-used first when a new load needs room
+ * - Evicted models leave the table under the lock but are freed after it,
+ *   so hits and stats never wait for weights being unmapped
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if LLAMA_AVAILABLE
+#include "llama.h"
+#else
+struct llama_model;
+#endif
+
+struct ModelLoadParams {
+    int n_gpu_layers = 0;
+    bool use_mmap = true;
+    bool use_mlock = false;
+};
+
+struct ModelRegistryStats {
+    size_t loaded_models = 0;
+    size_t idle_models = 0;
+    size_t resident_bytes = 0;
+    size_t budget_bytes = 0;
+    long long loads = 0;
+    long long hits = 0;
+    long long evictions = 0;
+};
+
+/**
+ * Loads and frees the registry's weights: llama.cpp by default, a fake in
+ * the host tests.
+ */
+class ModelLoader {
+public:
+    virtual ~ModelLoader() = default;
+
+    /** Load [path] and set [bytes] to the size of its weights; nullptr on failure. */
+    virtual llama_model* load(const std::string& path, const ModelLoadParams& params, size_t& bytes) = 0;
+    virtual void unload(llama_model* model) = 0;
+};
+
+class ModelRegistry;
+
+/**
+ * Refcounted reference to a registry-owned model. Movable, not copyable.
+ */
+class ModelRef {
+public:
+    ModelRef() = default;
+    ~ModelRef() { reset(); }
+
+    ModelRef(const ModelRef&) = delete;
+    ModelRef& operator=(const ModelRef&) = delete;
+    ModelRef(ModelRef&& other) noexcept : entry_(other.entry_) { other.entry_ = nullptr; }
+    ModelRef& operator=(ModelRef&& other) noexcept;
+
+    explicit operator bool() const { return entry_ != nullptr; }
+    void reset();
+
+    llama_model* get() const;
+    size_t size_bytes() const;
+    /** Bytes of the model file mapped into the address space (0 without mmap). */
+    size_t mapped_bytes() const;
+    const std::string& key() const;
+    const std::string& path() const;
+    /** Number of live refs to the same model, including this one. */
+    int use_count() const;
+
+private:
+    friend class ModelRegistry;
+    struct Entry;
+    explicit ModelRef(Entry* entry) : entry_(entry) {}
+
+    Entry* entry_ = nullptr;
+};
+
+class ModelRegistry {
+public:
+    static ModelRegistry& instance();
+
+    /**
+     * Return a reference to the model at [path], loading it on first use.
+     * Concurrent callers for the same key wait for a single load.
+     * Returns an empty ref if the file cannot be loaded or does not fit the budget.
+     */
+    ModelRef acquire(const std::string& path, const ModelLoadParams& params);
+
+    /**
+     * Set the global budget for registry-owned weights. 0 disables the budget
+     * and idle models are then freed as soon as their last ref goes away.
+     */
+    void set_budget(size_t bytes);
+
+    /** Free every idle model. Returns the number of bytes released. */
+    size_t evict_idle();
+
+    ModelRegistryStats stats();
+
+    /** True while any loaded model (referenced, cached or being freed) comes from [path]. */
+    bool holds(const std::string& path);
+
+    /**
+     * Load through [loader] from now on; nullptr restores llama.cpp. Only
+     * with no models loaded (host tests).
+     */
+    void set_loader(ModelLoader* loader);
+
+private:
+    friend class ModelRef;
+    using Entry = ModelRef::Entry;
+    using EntryList = std::list<std::unique_ptr<Entry>>;
+
+    ModelRegistry();
+
+    void release(Entry* entry);
+    size_t resident_bytes_locked() const;
+    bool make_room_locked(size_t needed, const Entry* exclude, std::vector<Entry*>& retired);
+    /** Move [it] out of entries_ into freeing_ and append it to [retired]. */
+    void retire_locked(EntryList::iterator it, std::vector<Entry*>& retired);
+    /** Free the models in [retired] without holding mutex_, then drop their entries. */
+    void free_retired(const std::vector<Entry*>& retired);
+
+    std::mutex mutex_;
+    std::condition_variable loaded_cv_;
+    // Front = most recently used
+    EntryList entries_;
+    EntryList freeing_;   // Retired, model not freed yet
+    ModelLoader* loader_;
+    size_t budget_bytes_ = 0;
+    long long loads_ = 0;
+    long long hits_ = 0;
+    long long evictions_ = 0;
+};
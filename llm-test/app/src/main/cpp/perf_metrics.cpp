@@ -0,0 +1,181 @@
+/**
+ * Jeeves LLM Test Project - Process-wide latency histograms and counters
+ */
+
+#include "perf_metrics.h"
+
+#include <algorithm>
+
+#include "generate_stats.h"
+#include "thread_pool.h"
+
+namespace {
+
+/** Lower [target] to [value] unless it holds a smaller one (-1 = unset). */
+void store_min(std::atomic<long long>& target, long long value) {
+    long long current = target.load(std::memory_order_relaxed);
+    while ((current < 0 || value < current) &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void store_max(std::atomic<long long>& target, long long value) {
+    long long current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+int highest_bit(uint64_t value) {
+    return 63 - __builtin_clzll(value);
+}
+
+} // namespace
+
+void LatencySummary::to_array(long long out[COUNT]) const {
+    out[SAMPLES] = samples;
+    out[MIN] = min;
+    out[MAX] = max;
+    out[MEAN] = mean;
+    out[P50] = p50;
+    out[P90] = p90;
+    out[P95] = p95;
+    out[P99] = p99;
+}
+
+int LatencyHistogram::bucket_of(uint64_t value) {
+    if (value < static_cast<uint64_t>(SUB_BUCKETS)) return static_cast<int>(value);
+    const uint64_t limit = (1ULL << MAX_BITS) - 1;
+    value = std::min(value, limit);
+    const int shift = highest_bit(value) - SUB_BITS;
+    return (shift + 1) * SUB_BUCKETS + static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+uint64_t LatencyHistogram::bucket_high(int bucket) {
+    if (bucket < SUB_BUCKETS) return static_cast<uint64_t>(bucket);
+    const int shift = bucket / SUB_BUCKETS - 1;
+    const uint64_t low = static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+    return low + (1ULL << shift) - 1;
+}
+
+void LatencyHistogram::record(long long value) {
+    value = std::max(value, 0LL);
+    buckets_[bucket_of(static_cast<uint64_t>(value))].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    store_min(min_, value);
+    store_max(max_, value);
+}
+
+void LatencyHistogram::drain(Counts& counts, bool reset) {
+    Counts drained;
+    for (int i = 0; i < BUCKETS; i++) {
+        drained.buckets[i] = reset ? buckets_[i].exchange(0, std::memory_order_relaxed)
+                                   : buckets_[i].load(std::memory_order_relaxed);
+    }
+    drained.sum = reset ? sum_.exchange(0, std::memory_order_relaxed) : sum_.load(std::memory_order_relaxed);
+    drained.min = reset ? min_.exchange(-1, std::memory_order_relaxed) : min_.load(std::memory_order_relaxed);
+    drained.max = reset ? max_.exchange(0, std::memory_order_relaxed) : max_.load(std::memory_order_relaxed);
+    counts.merge(drained);
+}
+
+void LatencyHistogram::Counts::merge(const Counts& other) {
+    for (int i = 0; i < BUCKETS; i++) buckets[i] += other.buckets[i];
+    sum += other.sum;
+    if (other.min >= 0) min = min < 0 ? other.min : std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+LatencySummary LatencyHistogram::Counts::summarize() const {
+    LatencySummary summary;
+    uint64_t total = 0;
+    for (uint64_t n : buckets) total += n;
+    if (total == 0) return summary;
+
+    summary.samples = static_cast<long long>(total);
+    summary.min = std::max(min, 0LL);
+    summary.max = max;
+    summary.mean = sum / summary.samples;
+
+    // Nearest rank, reported as the bucket's highest value capped at the true max
+    const int pcts[] = {50, 90, 95, 99};
+    long long* fields[] = {&summary.p50, &summary.p90, &summary.p95, &summary.p99};
+    int next = 0;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS && next < 4; i++) {
+        seen += buckets[i];
+        while (next < 4 && seen * 100 >= total * pcts[next]) {
+            *fields[next++] = std::min(static_cast<long long>(bucket_high(i)), max);
+        }
+    }
+    return summary;
+}
+
+PerfMetrics& PerfMetrics::instance() {
+    static PerfMetrics metrics;
+    return metrics;
+}
+
+int PerfMetrics::class_of(int qos) {
+    return qos == QOS_BACKGROUND ? ROW_BACKGROUND - 1 : ROW_INTERACTIVE - 1;
+}
+
+void PerfMetrics::record(int qos, const GenerateStats& stats, const std::vector<long long>& token_us,
+                         long long queue_wait_us, long long end_to_end_us) {
+    const int c = class_of(qos);
+    LatencyHistogram* h = histograms_[c];
+
+    counters_[c][COUNTER_REQUESTS].fetch_add(1, std::memory_order_relaxed);
+    if (stats.cached_prompt_tokens > 0) {
+        counters_[c][COUNTER_CACHE_HITS].fetch_add(1, std::memory_order_relaxed);
+    }
+    if (stats.stop_reason == STOP_NONE || stats.stop_reason == STOP_ERROR ||
+        stats.stop_reason == STOP_DECODE_ERROR || stats.stop_reason == STOP_ENGINE_CHANGED) {
+        counters_[c][COUNTER_FAILED].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (stats.stop_reason == STOP_NONE) return;     // Never reached an engine
+    h[HIST_QUEUE_WAIT_US].record(queue_wait_us);
+    h[HIST_END_TO_END_US].record(end_to_end_us);
+    if (stats.generated_tokens > 0) {
+        h[HIST_FIRST_TOKEN_US].record(queue_wait_us + stats.first_token_us);
+    }
+    const int uncached = stats.prompt_tokens - stats.cached_prompt_tokens;
+    if (uncached > 0 && stats.prompt_eval_us > 0) {
+        h[HIST_PROMPT_TOKENS_PER_SEC].record(uncached * 1000000LL / stats.prompt_eval_us);
+    }
+    for (long long us : token_us) h[HIST_TOKEN_US].record(us);
+}
+
+void PerfMetrics::count(int qos, PerfCounter counter) {
+    counters_[class_of(qos)][counter].fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerfMetrics::snapshot(long long out[SNAPSHOT_FIELDS], bool reset) {
+    LatencyHistogram::Counts all[HIST_COUNT];
+    long long all_counters[COUNTER_COUNT] = {};
+
+    for (int c = 0; c < CLASSES; c++) {
+        long long* row = out + (c + 1) * ROW_FIELDS;
+        for (int m = 0; m < HIST_COUNT; m++) {
+            LatencyHistogram::Counts counts;
+            histograms_[c][m].drain(counts, reset);
+            counts.summarize().to_array(row + m * LatencySummary::COUNT);
+
+            all[m].merge(counts);
+        }
+        for (int k = 0; k < COUNTER_COUNT; k++) {
+            long long n = reset ? counters_[c][k].exchange(0, std::memory_order_relaxed)
+                                : counters_[c][k].load(std::memory_order_relaxed);
+            row[HIST_COUNT * LatencySummary::COUNT + k] = n;
+            all_counters[k] += n;
+        }
+    }
+
+    long long* row = out + ROW_ALL * ROW_FIELDS;
+    for (int m = 0; m < HIST_COUNT; m++) {
+        all[m].summarize().to_array(row + m * LatencySummary::COUNT);
+    }
+    for (int k = 0; k < COUNTER_COUNT; k++) {
+        row[HIST_COUNT * LatencySummary::COUNT + k] = all_counters[k];
+    }
+}
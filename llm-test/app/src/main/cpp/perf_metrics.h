@@ -0,0 +1,147 @@
+/**
+ * Jeeves LLM Test Project - Process-wide latency histograms and counters
+ *
+ * GenerateStats describes one request, and last_inference_time_ms only the
+ * latest one. Tuning and regression tests need distributions: a p99 time to
+ * first token, not a single sample. Every generate call therefore records
+ * into HDR-style log-linear histograms: 16 linear sub-buckets per power of
+ * two, so a percentile is within 1/16 (6.25%) of the true value at any
+ * magnitude in a fixed 4.7 KB per histogram. Recording is a few relaxed
+ * atomic increments with no lock, so it costs nothing measurable next to a
+ * decode and never serialises concurrent engines.
+ *
+ * Histograms are kept per request class (the QoS a request ran at):
+ *   - FIRST_TOKEN_US     submit to the first generated token
+ *   - PROMPT_TOKENS_PER_SEC  uncached prompt tokens / prompt evaluation time
+ *   - TOKEN_US           sample + decode of each generated token
+ *   - QUEUE_WAIT_US      submit to holding the engine
+ *   - END_TO_END_US      submit to the output being ready
+ * "Submit" is the caller's System.nanoTime(), taken before LlamaEngine's
+ * mutex, so waiting behind other Kotlin callers counts as queue time.
+ *
+ * snapshot() merges the classes into an ALL row and can reset as it reads.
+ * Buckets are exchanged with zero, so a record racing a snapshot lands in
+ * either that snapshot or the next, never in neither.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+struct GenerateStats;
+
+/** Percentile summary of one histogram. Flattened for JNI as the Index fields. */
+struct LatencySummary {
+    enum Index {
+        SAMPLES = 0,
+        MIN,
+        MAX,
+        MEAN,
+        P50,
+        P90,
+        P95,
+        P99,
+        COUNT
+    };
+
+    long long samples = 0;
+    long long min = 0;
+    long long max = 0;
+    long long mean = 0;
+    long long p50 = 0;
+    long long p90 = 0;
+    long long p95 = 0;
+    long long p99 = 0;
+
+    void to_array(long long out[COUNT]) const;
+};
+
+/** Lock-free log-linear histogram of non-negative values. */
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int MAX_BITS = 40;     // Larger values (~12 days in µs) are clamped
+    static constexpr int BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+    /** Plain copy of a histogram; merged across classes before summarising. */
+    struct Counts {
+        uint64_t buckets[BUCKETS] = {};
+        long long sum = 0;
+        long long min = -1;                 // -1 while empty
+        long long max = 0;
+
+        void merge(const Counts& other);
+        LatencySummary summarize() const;
+    };
+
+    void record(long long value);
+
+    /** Add the recorded values to [counts], zeroing them if [reset]. */
+    void drain(Counts& counts, bool reset);
+
+    static int bucket_of(uint64_t value);
+    /** Highest value that falls in [bucket]; percentiles report this. */
+    static uint64_t bucket_high(int bucket);
+
+private:
+    std::atomic<uint64_t> buckets_[BUCKETS] = {};
+    std::atomic<long long> sum_{0};
+    std::atomic<long long> min_{-1};        // -1 until the first record
+    std::atomic<long long> max_{0};
+};
+
+enum PerfHistogram : int {
+    HIST_FIRST_TOKEN_US = 0,
+    HIST_PROMPT_TOKENS_PER_SEC,
+    HIST_TOKEN_US,
+    HIST_QUEUE_WAIT_US,
+    HIST_END_TO_END_US,
+    HIST_COUNT
+};
+
+enum PerfCounter : int {
+    COUNTER_REQUESTS = 0,
+    COUNTER_CACHE_HITS,         // Requests that reused part of the prompt's KV cache
+    COUNTER_CANCELLED,          // Cancelled by the caller before the engine ran them
+    COUNTER_FAILED,             // Stale handle, error, decode error or engine gone while yielded
+    COUNTER_COUNT
+};
+
+class PerfMetrics {
+public:
+    /** Snapshot rows: every class merged, then one row per QoS. */
+    enum Row {
+        ROW_ALL = 0,
+        ROW_INTERACTIVE,
+        ROW_BACKGROUND,
+        ROW_COUNT
+    };
+
+    /** Per row: HIST_COUNT LatencySummary blocks, then the counters. */
+    static constexpr int ROW_FIELDS = HIST_COUNT * LatencySummary::COUNT + COUNTER_COUNT;
+    static constexpr int SNAPSHOT_FIELDS = ROW_COUNT * ROW_FIELDS;
+
+    static PerfMetrics& instance();
+
+    /**
+     * Record a finished request. [token_us] holds per-token times,
+     * [queue_wait_us] and [end_to_end_us] are measured from submission.
+     */
+    void record(int qos, const GenerateStats& stats, const std::vector<long long>& token_us,
+                long long queue_wait_us, long long end_to_end_us);
+
+    void count(int qos, PerfCounter counter);
+
+    void snapshot(long long out[SNAPSHOT_FIELDS], bool reset);
+
+private:
+    static constexpr int CLASSES = ROW_COUNT - 1;
+
+    static int class_of(int qos);
+
+    LatencyHistogram histograms_[CLASSES][HIST_COUNT];
+    std::atomic<long long> counters_[CLASSES][COUNTER_COUNT] = {};
+};
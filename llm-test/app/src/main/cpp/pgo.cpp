@@ -0,0 +1,77 @@
+/**
+ * Jeeves LLM Test Project - Native build profile and PGO training
+ */
+
+#include "pgo.h"
+
+#include "llama_log.h"
+
+#if defined(LLAMA_PGO_GENERATE)
+#include <dlfcn.h>
+#include <link.h>
+
+#include <cstring>
+#include <vector>
+#endif
+
+#ifndef LLAMA_BUILD_PROFILE
+#define LLAMA_BUILD_PROFILE "default"
+#endif
+
+const char* native_build_profile() {
+    return LLAMA_BUILD_PROFILE;
+}
+
+#if defined(LLAMA_PGO_GENERATE)
+
+namespace {
+
+using WriteProfileFn = int (*)(const char*);
+
+// Paths of the loaded libraries built from this tree (libllama_jni, libggml*)
+std::vector<std::string> instrumented_libraries() {
+    std::vector<std::string> paths;
+    dl_iterate_phdr([](dl_phdr_info* info, size_t, void* data) {
+        const char* path = info->dlpi_name;
+        if (!path || !*path) return 0;
+        const char* slash = std::strrchr(path, '/');
+        const char* base = slash ? slash + 1 : path;
+        if (std::strncmp(base, "libllama", 8) == 0 || std::strncmp(base, "libggml", 7) == 0) {
+            static_cast<std::vector<std::string>*>(data)->push_back(path);
+        }
+        return 0;
+    }, &paths);
+    return paths;
+}
+
+} // namespace
+
+int pgo_write_profiles(const std::string& dir) {
+    int written = 0;
+    for (const std::string& path : instrumented_libraries()) {
+        void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_NOLOAD);
+        if (!handle) continue;
+
+        // The library's own definition comes before those of its dependencies
+        auto write = reinterpret_cast<WriteProfileFn>(dlsym(handle, "llama_pgo_write_profile"));
+        std::string base = path.substr(path.find_last_of('/') + 1);
+        std::string out = dir + "/" + base.substr(0, base.rfind(".so")) + ".profraw";
+        if (write && write(out.c_str()) == 0) {
+            written++;
+        } else {
+            LOGW("No PGO profile written for %s", base.c_str());
+        }
+        dlclose(handle);
+    }
+    LOGI("Wrote %d PGO profiles to %s", written, dir.c_str());
+    return written;
+}
+
+#else
+
+int pgo_write_profiles(const std::string&) {
+    LOGW("PGO profiles requested from a library built without LLAMA_PGO=GENERATE");
+    return -1;
+}
+
+#endif // LLAMA_PGO_GENERATE
@@ -0,0 +1,24 @@
+/**
+ * Jeeves LLM Test Project - Native build profile and PGO training
+ *
+ * Release builds link ggml, llama and llama_jni with LTO and can be compiled
+ * against a profile (LLAMA_PGO in CMakeLists.txt). The profile comes from an
+ * instrumented LLAMA_PGO=GENERATE build running the training workload
+ * (PgoTrainingTest): app processes are killed rather than exiting, so the
+ * counters never reach disk on their own and are written here instead.
+ * pgo_train.sh pulls and merges them.
+ */
+
+#pragma once
+
+#include <string>
+
+/** How this library was built, e.g. "Release+lto+pgo". */
+const char* native_build_profile();
+
+/**
+ * Write <dir>/<library>.profraw for llama_jni and every loaded ggml library.
+ * Returns the number of profiles written, or -1 when the build is not
+ * instrumented.
+ */
+int pgo_write_profiles(const std::string& dir);
@@ -0,0 +1,27 @@
+/**
+ * Jeeves LLM Test Project - Per-library PGO profile writer
+ *
+ * Compiled into every library the build instruments (llama_jni, ggml-base
+ * and each CPU backend variant). Each shared library links its own copy of
+ * the profile runtime with hidden symbols, so this is the one exported entry
+ * point pgo.cpp finds with dlsym to write that library's counters.
+ * Empty unless LLAMA_PGO=GENERATE.
+ */
+
+#if defined(LLAMA_PGO_GENERATE)
+
+extern "C" {
+
+// clang profile runtime, linked by -fprofile-generate
+void __llvm_profile_set_filename(const char* name);
+int __llvm_profile_write_file(void);
+
+__attribute__((visibility("default")))
+int llama_pgo_write_profile(const char* path) {
+    __llvm_profile_set_filename(path);
+    return __llvm_profile_write_file();
+}
+
+} // extern "C"
+
+#endif // LLAMA_PGO_GENERATE
@@ -0,0 +1,587 @@
+/**
+ * Jeeves LLM Test Project - On-disk cache of repacked weights
+ */
+
+#include "repack_cache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "cpu_backend.h"
+#include "llama_log.h"
+
+#if LLAMA_AVAILABLE
+#include "ggml-backend-impl.h"
+#include "gguf.h"
+#endif
+
+namespace {
+
+struct CacheState {
+    std::mutex mutex;
+    std::string dir;
+    RepackCacheStats stats;
+};
+
+CacheState& state() {
+    static CacheState s;
+    return s;
+}
+
+} // namespace
+
+void RepackCacheStats::to_array(long long out[COUNT]) const {
+    out[HITS] = hits;
+    out[BUILDS] = builds;
+    out[STALE] = stale;
+    out[UNCACHED] = uncached;
+    out[LAST_RESULT] = last_result;
+    out[LAST_TENSORS] = last_tensors;
+    out[LAST_BYTES] = last_bytes;
+    out[LAST_MS] = last_ms;
+}
+
+void configure_repack_cache(const std::string& dir) {
+    if (!dir.empty() && mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        LOGE("Cannot create repack cache dir %s (errno=%d)", dir.c_str(), errno);
+        return;
+    }
+    CacheState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.dir = dir;
+    LOGI("Repack cache: %s", dir.empty() ? "disabled" : dir.c_str());
+}
+
+RepackCacheStats repack_cache_stats() {
+    CacheState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.stats;
+}
+
+// ============================================================================
+// Index, pattern and decisions
+// ============================================================================
+
+namespace {
+
+constexpr const char* INDEX_MAGIC = "repack-cache 1";
+
+std::string regex_escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (strchr(".^$|()[]{}*+?\\", c)) out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+void split_tensor_name(const std::string& name, std::string& kind, std::string& layer) {
+    kind = name;
+    layer.clear();
+    if (name.compare(0, 4, "blk.") != 0) return;
+    size_t dot = name.find('.', 4);
+    if (dot == std::string::npos) return;
+    layer = name.substr(4, dot - 4);
+    kind = "blk." + name.substr(dot + 1);
+}
+
+std::string build_repack_pattern(const std::map<std::string, RepackKind>& kinds) {
+    std::string pattern;
+    for (const auto& kind : kinds) {
+        const std::vector<std::string>& layers = kind.second.layers;
+        if (layers.empty()) continue;
+        if (!pattern.empty()) pattern += '|';
+        if (kind.first.compare(0, 4, "blk.") != 0) {
+            pattern += regex_escape(kind.first);
+            continue;
+        }
+        std::string rest = regex_escape(kind.first.substr(4));
+        if (static_cast<int>(layers.size()) == kind.second.tensors) {
+            pattern += "blk\\.\\d+\\." + rest;
+        } else {
+            pattern += "blk\\.(?:";
+            for (size_t i = 0; i < layers.size(); i++) pattern += (i ? "|" : "") + layers[i];
+            pattern += ")\\." + rest;
+        }
+    }
+    return pattern.empty() ? pattern : "^(?:" + pattern + ")$";
+}
+
+bool read_repack_index(const std::string& path, const std::string& key, size_t& size,
+                       std::vector<RepackIndexEntry>& entries) {
+    std::ifstream in(path);
+    std::string line;
+    if (!std::getline(in, line) || line != INDEX_MAGIC) return false;
+    if (!std::getline(in, line) || line != key) return false;
+    size_t count = 0;
+    if (!(in >> size >> count)) return false;
+    entries.resize(count);
+    for (RepackIndexEntry& e : entries) {
+        if (!(in >> e.name >> e.offset >> e.bytes)) return false;
+    }
+    return true;
+}
+
+bool write_repack_index(const std::string& path, const std::string& key, size_t size,
+                        const std::vector<RepackIndexEntry>& entries) {
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << INDEX_MAGIC << "\n" << key << "\n" << size << " " << entries.size() << "\n";
+        for (const RepackIndexEntry& e : entries) out << e.name << " " << e.offset << " " << e.bytes << "\n";
+        if (!out.flush()) return false;
+    }
+    return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+void RepackCachePlan::choose(bool first_buffer, const std::vector<RepackIndexEntry>* index, size_t index_size,
+                             size_t size, const std::function<bool()>& map_sidecar,
+                             const std::function<bool()>& create_part) {
+    mode = RepackBufferMode::UNCACHED;
+    if (!first_buffer) return;
+    if (index && index_size == size && map_sidecar()) {
+        mode = RepackBufferMode::HIT;
+        expected = *index;
+    } else if (create_part()) {
+        mode = RepackBufferMode::BUILD;
+    }
+}
+
+bool RepackCachePlan::needs_repack(const std::function<bool()>& first_tensor_matches) {
+    if (!checked) {
+        // llama places every tensor before it loads the first one
+        checked = true;
+        if (mode == RepackBufferMode::HIT && (entries != expected || !first_tensor_matches())) {
+            LOGW("Repack cache sidecar does not match this build; repacking in memory");
+            mode = RepackBufferMode::STALE;
+        }
+    }
+    if (mode == RepackBufferMode::HIT) return false;
+    written++;
+    return true;
+}
+
+int RepackCachePlan::result(const std::function<bool()>& publish) const {
+    switch (mode) {
+        case RepackBufferMode::HIT:
+            return REPACK_CACHE_HIT;
+        case RepackBufferMode::BUILD:
+            return written == entries.size() && publish() ? REPACK_CACHE_BUILT : REPACK_CACHE_UNCACHED;
+        case RepackBufferMode::STALE:
+            return REPACK_CACHE_STALE;
+        case RepackBufferMode::UNCACHED:
+            break;
+    }
+    return REPACK_CACHE_UNCACHED;
+}
+
+long long RepackCachePlan::bytes() const {
+    long long total = 0;
+    for (const RepackIndexEntry& e : entries) total += static_cast<long long>(e.bytes);
+    return total;
+}
+
+#if LLAMA_AVAILABLE
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr const char* REPACK_BUFT_NAME = "CPU_REPACK";
+// Batch of the probe matmul; llama's weight_buft_supported uses the same
+constexpr int64_t PROBE_BATCH = 512;
+
+// ggml's CPU_REPACK buffer type, and a small buffer of it whose
+// init_tensor / set_tensor (the actual repacking) the cache delegates to
+struct RepackBackend {
+    ggml_backend_dev_t dev = nullptr;
+    ggml_backend_buffer_type_t buft = nullptr;
+    ggml_backend_buffer_t probe = nullptr;
+};
+
+const RepackBackend* repack_backend() {
+    static std::mutex mutex;
+    static RepackBackend backend;
+    static bool resolved = false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (resolved) return backend.probe ? &backend : nullptr;
+
+    // Not resolved until the CPU backend is registered (load_cpu_backend)
+    ggml_backend_dev_t dev = ggml_backend_dev_by_type(GGML_BACKEND_DEVICE_TYPE_CPU);
+    if (!dev) return nullptr;
+    resolved = true;
+
+    auto get_extra_bufts = reinterpret_cast<ggml_backend_dev_get_extra_bufts_t>(
+        ggml_backend_reg_get_proc_address(ggml_backend_dev_backend_reg(dev), "ggml_backend_dev_get_extra_bufts"));
+    if (!get_extra_bufts) return nullptr;
+    for (ggml_backend_buffer_type_t* buft = get_extra_bufts(dev); buft && *buft; ++buft) {
+        if (strcmp(ggml_backend_buft_name(*buft), REPACK_BUFT_NAME) == 0) backend.buft = *buft;
+    }
+    if (!backend.buft) {
+        LOGI("CPU backend has no %s buffer type; repack cache unused", REPACK_BUFT_NAME);
+        return nullptr;
+    }
+    backend.dev = dev;
+    backend.probe = ggml_backend_buft_alloc_buffer(backend.buft, ggml_backend_buft_get_alignment(backend.buft));
+    return backend.probe ? &backend : nullptr;
+}
+
+// Whether ggml would repack [t]: the check llama runs before choosing CPU_REPACK
+bool repacked_by_ggml(const RepackBackend& repack, ggml_context* ctx, ggml_tensor* t) {
+    ggml_backend_buffer_t saved = t->buffer;
+    t->buffer = repack.probe;
+    ggml_tensor* b = ggml_new_tensor_4d(ctx, GGML_TYPE_F32, t->ne[0], PROBE_BATCH, t->ne[2], t->ne[3]);
+    bool supported = ggml_backend_dev_supports_op(repack.dev, ggml_mul_mat(ctx, t, b));
+    t->buffer = saved;
+    return supported;
+}
+
+uint64_t fnv1a(const std::string& s) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+std::string hex(uint64_t v) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+    return buf;
+}
+
+// Context of one cache-backed buffer; lives as long as the model's buffer
+struct CacheBuffer {
+    const RepackBackend* repack = nullptr;
+    RepackCachePlan plan;
+    uint8_t* base = nullptr;
+    size_t size = 0;
+    int fd = -1;
+    bool mapped = false;
+    bool published = false;
+    std::string part_path;
+    Clock::duration repack_time{};
+};
+
+CacheBuffer* cache_buffer(ggml_backend_buffer_t buffer) {
+    return static_cast<CacheBuffer*>(buffer->context);
+}
+
+void cache_buffer_free(ggml_backend_buffer_t buffer) {
+    CacheBuffer* cb = cache_buffer(buffer);
+    if (cb->mapped) {
+        munmap(cb->base, cb->size);
+    } else {
+        free(cb->base);
+    }
+    if (cb->fd >= 0) close(cb->fd);
+    // A sidecar the load never published (load failed or was incomplete)
+    if (cb->plan.mode == RepackBufferMode::BUILD && !cb->published) unlink(cb->part_path.c_str());
+    delete cb;
+}
+
+void* cache_buffer_get_base(ggml_backend_buffer_t buffer) {
+    return cache_buffer(buffer)->base;
+}
+
+ggml_status cache_buffer_init_tensor(ggml_backend_buffer_t buffer, ggml_tensor* tensor) {
+    CacheBuffer* cb = cache_buffer(buffer);
+    ggml_status status = cb->repack->probe->iface.init_tensor(buffer, tensor);
+    if (status != GGML_STATUS_SUCCESS || !tensor->extra) {
+        LOGE("Tensor %s has no repacked layout", tensor->name);
+        return GGML_STATUS_FAILED;
+    }
+    RepackIndexEntry entry;
+    entry.name = tensor->name;
+    entry.offset = static_cast<size_t>(static_cast<uint8_t*>(tensor->data) - cb->base);
+    entry.bytes = ggml_nbytes(tensor);
+    cb->plan.entries.push_back(entry);
+    return GGML_STATUS_SUCCESS;
+}
+
+void repack(CacheBuffer* cb, ggml_backend_buffer_t buffer, ggml_tensor* tensor, const void* data, size_t offset,
+            size_t size) {
+    Clock::time_point start = Clock::now();
+    cb->repack->probe->iface.set_tensor(buffer, tensor, data, offset, size);
+    cb->repack_time += Clock::now() - start;
+}
+
+// Repacking the first tensor reproduces the sidecar's bytes (same ggml layout)
+bool first_tensor_matches(CacheBuffer* cb, ggml_backend_buffer_t buffer, ggml_tensor* tensor, const void* data,
+                          size_t size) {
+    void* scratch = nullptr;
+    if (posix_memalign(&scratch, 64, size) != 0) return false;
+    ggml_tensor copy = *tensor;
+    copy.data = scratch;
+    repack(cb, buffer, &copy, data, 0, size);
+    bool same = memcmp(scratch, tensor->data, size) == 0;
+    free(scratch);
+    return same;
+}
+
+void cache_buffer_set_tensor(ggml_backend_buffer_t buffer, ggml_tensor* tensor, const void* data, size_t offset,
+                             size_t size) {
+    CacheBuffer* cb = cache_buffer(buffer);
+    if (!cb->plan.needs_repack([&] { return first_tensor_matches(cb, buffer, tensor, data, size); })) return;
+    repack(cb, buffer, tensor, data, offset, size);
+}
+
+void cache_buffer_clear(ggml_backend_buffer_t buffer, uint8_t value) {
+    CacheBuffer* cb = cache_buffer(buffer);
+    memset(cb->base, value, cb->size);
+}
+
+bool map_file(CacheBuffer* cb, const std::string& path, bool create) {
+    cb->fd = create ? ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600)
+                    : ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (cb->fd < 0) return false;
+    if (create && ftruncate(cb->fd, static_cast<off_t>(cb->size)) != 0) return false;
+    // Read-only file, private writable mapping: untouched pages stay shared page cache
+    void* base = mmap(nullptr, cb->size, PROT_READ | PROT_WRITE, create ? MAP_SHARED : MAP_PRIVATE, cb->fd, 0);
+    if (base == MAP_FAILED) return false;
+    cb->base = static_cast<uint8_t*>(base);
+    cb->mapped = true;
+    return true;
+}
+
+void unmap_file(CacheBuffer* cb) {
+    if (cb->mapped) munmap(cb->base, cb->size);
+    if (cb->fd >= 0) close(cb->fd);
+    cb->base = nullptr;
+    cb->mapped = false;
+    cb->fd = -1;
+}
+
+void remove_other_sidecars(const std::string& dir, const std::string& prefix, const std::string& keep) {
+    DIR* d = opendir(dir.c_str());
+    if (!d) return;
+    while (dirent* e = readdir(d)) {
+        std::string name = e->d_name;
+        if (name.compare(0, prefix.size(), prefix) == 0 && name.compare(0, keep.size(), keep) != 0) {
+            unlink((dir + "/" + name).c_str());
+        }
+    }
+    closedir(d);
+}
+
+} // namespace
+
+struct RepackCacheLoad::Impl {
+    const RepackBackend* repack = nullptr;
+    ggml_backend_buffer_type buft{};
+    std::string pattern;
+    llama_model_tensor_buft_override overrides[2]{};
+
+    std::string dir;
+    std::string model_prefix;       // <hash of path>-, shared by every sidecar of the model
+    std::string name;               // <model_prefix><hash of key>
+    std::string key;
+    bool have_index = false;
+    size_t index_size = 0;
+    std::vector<RepackIndexEntry> index;
+
+    CacheBuffer* buffer = nullptr;  // Owned by the model once allocated
+
+    std::string path(const char* ext) const { return dir + "/" + name + ext; }
+};
+
+namespace {
+
+ggml_backend_buffer_t cache_buft_alloc_buffer(ggml_backend_buffer_type_t buft, size_t size) {
+    auto* load = static_cast<RepackCacheLoad::Impl*>(buft->context);
+    auto* cb = new CacheBuffer();
+    cb->repack = load->repack;
+    cb->size = size;
+    cb->part_path = load->path(".bin.part");
+
+    // llama allocates one buffer per buffer type; anything more stays uncached
+    cb->plan.choose(
+        load->buffer == nullptr, load->have_index ? &load->index : nullptr, load->index_size, size,
+        [&] {
+            if (map_file(cb, load->path(".bin"), false)) return true;
+            unmap_file(cb);
+            return false;
+        },
+        [&] {
+            if (map_file(cb, cb->part_path, true)) return true;
+            LOGW("Cannot create repack cache sidecar %s (errno=%d)", cb->part_path.c_str(), errno);
+            unmap_file(cb);
+            unlink(cb->part_path.c_str());
+            return false;
+        });
+    if (cb->plan.mode == RepackBufferMode::UNCACHED) {
+        void* base = nullptr;
+        if (posix_memalign(&base, 64, size) != 0) {
+            delete cb;
+            return nullptr;
+        }
+        cb->base = static_cast<uint8_t*>(base);
+    }
+    if (!load->buffer) load->buffer = cb;
+
+    ggml_backend_buffer_i iface = {};
+    iface.free_buffer = cache_buffer_free;
+    iface.get_base = cache_buffer_get_base;
+    iface.init_tensor = cache_buffer_init_tensor;
+    iface.set_tensor = cache_buffer_set_tensor;
+    iface.clear = cache_buffer_clear;
+    // Reported as CPU_REPACK, so the CPU backend runs its repacked kernels on these weights
+    return ggml_backend_buffer_init(load->repack->buft, iface, cb, size);
+}
+
+const char* cache_buft_get_name(ggml_backend_buffer_type_t buft) {
+    return "CPU_REPACK_CACHE";
+}
+
+size_t cache_buft_get_alignment(ggml_backend_buffer_type_t buft) {
+    auto* load = static_cast<RepackCacheLoad::Impl*>(buft->context);
+    return ggml_backend_buft_get_alignment(load->repack->buft);
+}
+
+} // namespace
+
+std::unique_ptr<RepackCacheLoad> RepackCacheLoad::prepare(const std::string& path, int n_gpu_layers) {
+    std::string dir;
+    {
+        CacheState& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        dir = s.dir;
+    }
+    if (dir.empty() || n_gpu_layers != 0) return nullptr;
+    const RepackBackend* repack = repack_backend();
+    if (!repack) return nullptr;
+
+    char resolved[PATH_MAX];
+    struct stat st;
+    if (!realpath(path.c_str(), resolved) || stat(resolved, &st) != 0) return nullptr;
+
+    ggml_context* meta = nullptr;
+    gguf_init_params params = {/*no_alloc =*/ true, /*ctx =*/ &meta};
+    gguf_context* gguf = gguf_init_from_file(resolved, params);
+    if (!gguf) return nullptr;
+
+    const int64_t n_tensors = gguf_get_n_tensors(gguf);
+    ggml_init_params probe_params = {static_cast<size_t>(2 * n_tensors + 1) * ggml_tensor_overhead(), nullptr, true};
+    ggml_context* probe = ggml_init(probe_params);
+
+    std::map<std::string, RepackKind> kinds;
+    int repacked = 0;
+    for (int64_t i = 0; probe && i < n_tensors; i++) {
+        std::string name = gguf_get_tensor_name(gguf, i);
+        ggml_tensor* t = ggml_get_tensor(meta, name.c_str());
+        std::string kind;
+        std::string layer;
+        split_tensor_name(name, kind, layer);
+        RepackKind& entry = kinds[kind];
+        entry.tensors++;
+        // Token embeddings feed get_rows, which has no repacked kernel
+        const bool weight = name.size() > 7 && name.compare(name.size() - 7, 7, ".weight") == 0 &&
+                            name != "token_embd.weight";
+        if (t && weight && ggml_n_dims(t) == 2 && repacked_by_ggml(*repack, probe, t)) {
+            entry.layers.push_back(layer);
+            repacked++;
+        }
+    }
+    if (probe) ggml_free(probe);
+    gguf_free(gguf);
+    if (meta) ggml_free(meta);
+    if (repacked == 0) return nullptr;
+
+    auto impl = std::make_unique<Impl>();
+    impl->repack = repack;
+    impl->pattern = build_repack_pattern(kinds);
+    impl->dir = dir;
+
+    const CpuBackendInfo cpu = cpu_backend_info();
+    std::ostringstream key;
+    key << resolved << "|dev=" << st.st_dev << "|ino=" << st.st_ino << "|size=" << st.st_size
+        << "|mtime=" << st.st_mtime << "|variant=" << cpu_variant_name(cpu.variant)
+        << "|features=" << cpu.cpu_features << "|align=" << ggml_backend_buft_get_alignment(repack->buft)
+        << "|tensors=" << impl->pattern;
+    impl->key = key.str();
+    impl->model_prefix = hex(fnv1a(resolved)) + "-";
+    impl->name = impl->model_prefix + hex(fnv1a(impl->key));
+    impl->have_index = read_repack_index(impl->path(".idx"), impl->key, impl->index_size, impl->index);
+
+    impl->buft.iface.get_name = cache_buft_get_name;
+    impl->buft.iface.alloc_buffer = cache_buft_alloc_buffer;
+    impl->buft.iface.get_alignment = cache_buft_get_alignment;
+    impl->buft.device = repack->dev;
+    impl->buft.context = impl.get();
+    impl->overrides[0] = {impl->pattern.c_str(), &impl->buft};
+    impl->overrides[1] = {nullptr, nullptr};
+
+    LOGI("Repack cache: %d tensors of %s, sidecar %s (%s)", repacked, resolved, impl->name.c_str(),
+         impl->have_index ? "cached" : "new");
+    return std::unique_ptr<RepackCacheLoad>(new RepackCacheLoad(std::move(impl)));
+}
+
+RepackCacheLoad::RepackCacheLoad(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
+
+RepackCacheLoad::~RepackCacheLoad() = default;
+
+const llama_model_tensor_buft_override* RepackCacheLoad::overrides() const {
+    return impl_->overrides;
+}
+
+void RepackCacheLoad::finish(bool loaded) {
+    // On failure llama has already freed the buffer (and its unpublished sidecar)
+    CacheBuffer* cb = loaded ? impl_->buffer : nullptr;
+    impl_->buffer = nullptr;
+    if (!cb) return;
+
+    const RepackCachePlan& plan = cb->plan;
+    const int result = plan.result([&] {
+        return fdatasync(cb->fd) == 0 && rename(cb->part_path.c_str(), impl_->path(".bin").c_str()) == 0 &&
+               write_repack_index(impl_->path(".idx"), impl_->key, cb->size, plan.entries);
+    });
+    if (result == REPACK_CACHE_BUILT) {
+        cb->published = true;
+        remove_other_sidecars(impl_->dir, impl_->model_prefix, impl_->name + ".");
+    } else if (plan.mode == RepackBufferMode::BUILD) {
+        LOGW("Repack cache sidecar %s not written (errno=%d)", impl_->name.c_str(), errno);
+        unlink(cb->part_path.c_str());
+    } else if (result == REPACK_CACHE_STALE) {
+        unlink(impl_->path(".idx").c_str());
+        unlink(impl_->path(".bin").c_str());
+    }
+
+    const long long bytes = plan.bytes();
+    const long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(cb->repack_time).count();
+
+    CacheState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    RepackCacheStats& stats = s.stats;
+    stats.hits += result == REPACK_CACHE_HIT;
+    stats.builds += result == REPACK_CACHE_BUILT;
+    stats.stale += result == REPACK_CACHE_STALE;
+    stats.uncached += result == REPACK_CACHE_UNCACHED;
+    stats.last_result = result;
+    stats.last_tensors = static_cast<long long>(plan.entries.size());
+    stats.last_bytes = bytes;
+    stats.last_ms = ms;
+    LOGI("Repack cache result %d: %zu tensors, %lld bytes, %lld ms repacking",
+         result, plan.entries.size(), bytes, ms);
+}
+
+#endif // LLAMA_AVAILABLE
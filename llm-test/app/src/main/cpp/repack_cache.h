@@ -0,0 +1,203 @@
+/**
+ * Jeeves LLM Test Project - On-disk cache of repacked weights
+ *
+ * On arm64 (dotprod / i8mm) and AVX2 the ggml CPU backend moves Q4_0,
+ * Q4_K, IQ4_NL and Q8_0 matmul weights into its CPU_REPACK buffer type,
+ * interleaving the blocks for its GEMM kernels. Stock ggml does this on
+ * every load, into anonymous memory, next to the mmapped file.
+ *
+ * With a cache directory configured, ModelRegistry routes those weights
+ * through a buffer type of its own (llama tensor_buft_overrides). Its
+ * buffers report CPU_REPACK, so the kernels are unchanged, but their memory
+ * is a sidecar file keyed by model identity and CPU variant:
+ *
+ * - First load: the repacked weights are written straight into a new
+ *   MAP_SHARED sidecar, which is published once the model has loaded
+ * - Later loads: the sidecar is mapped and repacking is skipped. The first
+ *   tensor is still repacked and compared, so a sidecar from another ggml
+ *   layout is detected and rebuilt on the next load
+ *
+ * Either way the repacked weights are file-backed page cache the kernel can
+ * reclaim, not anonymous memory. Only CPU-only loads (n_gpu_layers 0) use it.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#if LLAMA_AVAILABLE
+#include <memory>
+
+#include "llama.h"
+#endif
+
+/** Values mirror LlamaEngine.RepackCacheResult on the Kotlin side. */
+enum RepackCacheResult : int {
+    REPACK_CACHE_NONE = 0,      // Disabled, or no tensor of the model is repacked
+    REPACK_CACHE_HIT,           // Repacked weights mapped from the sidecar
+    REPACK_CACHE_BUILT,         // Repacked at load and written to a new sidecar
+    REPACK_CACHE_STALE,         // Sidecar did not match; repacked in memory, rebuilt next load
+    REPACK_CACHE_UNCACHED,      // Sidecar could not be written; repacked in memory
+};
+
+/**
+ * Cache counters since startup. Flattened for JNI as the Index fields.
+ */
+struct RepackCacheStats {
+    enum Index {
+        HITS = 0,
+        BUILDS,
+        STALE,
+        UNCACHED,
+        LAST_RESULT,                // RepackCacheResult of the last load
+        LAST_TENSORS,               // Tensors routed through the cache by the last load
+        LAST_BYTES,                 // Their repacked size
+        LAST_MS,                    // Time spent repacking (the first tensor only, on a hit)
+        COUNT
+    };
+
+    long long hits = 0;
+    long long builds = 0;
+    long long stale = 0;
+    long long uncached = 0;
+    int last_result = REPACK_CACHE_NONE;
+    long long last_tensors = 0;
+    long long last_bytes = 0;
+    long long last_ms = 0;
+
+    void to_array(long long out[COUNT]) const;
+};
+
+/**
+ * Keep sidecars in [dir] (created if missing); empty disables the cache.
+ * Applies to models loaded from then on.
+ */
+void configure_repack_cache(const std::string& dir);
+
+RepackCacheStats repack_cache_stats();
+
+// ============================================================================
+// Sidecar index, override pattern and per-load decisions. Independent of
+// ggml and the file mappings so the host tests can drive them.
+// ============================================================================
+
+/** A tensor as ggml placed it in the repacked buffer. */
+struct RepackIndexEntry {
+    std::string name;
+    size_t offset = 0;
+    size_t bytes = 0;
+
+    bool operator==(const RepackIndexEntry& o) const {
+        return name == o.name && offset == o.offset && bytes == o.bytes;
+    }
+    bool operator!=(const RepackIndexEntry& o) const { return !(*this == o); }
+};
+
+/** Tensors of one kind ("blk.ffn_up.weight") and the layers whose tensor ggml repacks. */
+struct RepackKind {
+    int tensors = 0;
+    std::vector<std::string> layers;
+};
+
+/**
+ * Split a tensor name into its kind and layer: "blk.3.ffn_up.weight" is
+ * kind "blk.ffn_up.weight", layer "3". Other names are their own kind.
+ */
+void split_tensor_name(const std::string& name, std::string& kind, std::string& layer);
+
+/**
+ * tensor_buft_overrides regex for the repacked tensors: one alternative per
+ * kind, "blk\.\d+\.<rest>" when every layer's tensor is repacked, else the
+ * layers spelled out. Empty when nothing is repacked.
+ */
+std::string build_repack_pattern(const std::map<std::string, RepackKind>& kinds);
+
+/** Sidecar index at [path]; false if missing, corrupt or written for another [key]. */
+bool read_repack_index(const std::string& path, const std::string& key, size_t& size,
+                       std::vector<RepackIndexEntry>& entries);
+
+/** Write the index through a temp file. */
+bool write_repack_index(const std::string& path, const std::string& key, size_t size,
+                        const std::vector<RepackIndexEntry>& entries);
+
+enum class RepackBufferMode {
+    HIT,        // Mapped from a published sidecar, private and copy-on-write
+    BUILD,      // Mapped from a new sidecar, shared
+    STALE,      // Sidecar mapping failed verification; repacked into its private pages
+    UNCACHED,   // Heap memory
+};
+
+/** What the cache decides for the repacked buffer of one load, in call order. */
+struct RepackCachePlan {
+    RepackBufferMode mode = RepackBufferMode::UNCACHED;
+    std::vector<RepackIndexEntry> entries;      // As placed by ggml, in init_tensor order
+    std::vector<RepackIndexEntry> expected;     // From the sidecar index (HIT)
+    bool checked = false;
+    size_t written = 0;
+
+    /**
+     * Pick the mode of a buffer of [size]. Only the first buffer of a load
+     * is cached: a matching [index] tries [map_sidecar], anything else (or
+     * a failed mapping) tries [create_part], and failing both is UNCACHED.
+     */
+    void choose(bool first_buffer, const std::vector<RepackIndexEntry>* index, size_t index_size, size_t size,
+                const std::function<bool()>& map_sidecar, const std::function<bool()>& create_part);
+
+    /**
+     * Before each set_tensor: true if the tensor must be repacked into the
+     * buffer. The first call turns a HIT STALE unless ggml placed the same
+     * tensors as the index and [first_tensor_matches].
+     */
+    bool needs_repack(const std::function<bool()>& first_tensor_matches);
+
+    /**
+     * RepackCacheResult of a successful load. A BUILD calls [publish] once
+     * every tensor was written, and is UNCACHED if it was not or failed.
+     */
+    int result(const std::function<bool()>& publish) const;
+
+    long long bytes() const;
+};
+
+#if LLAMA_AVAILABLE
+
+/**
+ * Cache state for one llama_model_load_from_file call.
+ *
+ *   auto cache = RepackCacheLoad::prepare(path, params.n_gpu_layers);
+ *   if (cache) model_params.tensor_buft_overrides = cache->overrides();
+ *   llama_model* model = llama_model_load_from_file(...);
+ *   if (cache) cache->finish(model != nullptr);
+ */
+class RepackCacheLoad {
+public:
+    /**
+     * Null when the cache is disabled, the CPU backend has no CPU_REPACK
+     * buffer type, or none of the model's weights would be repacked.
+     */
+    static std::unique_ptr<RepackCacheLoad> prepare(const std::string& path, int n_gpu_layers);
+
+    ~RepackCacheLoad();
+
+    RepackCacheLoad(const RepackCacheLoad&) = delete;
+    RepackCacheLoad& operator=(const RepackCacheLoad&) = delete;
+
+    /** Null-terminated override table; valid until this object is destroyed. */
+    const llama_model_tensor_buft_override* overrides() const;
+
+    /** Publish a newly written sidecar once the load succeeded, and record stats. */
+    void finish(bool loaded);
+
+    struct Impl;
+
+private:
+    explicit RepackCacheLoad(std::unique_ptr<Impl> impl);
+
+    std::unique_ptr<Impl> impl_;
+};
+
+#endif // LLAMA_AVAILABLE
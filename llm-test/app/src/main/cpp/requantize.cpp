@@ -0,0 +1,629 @@
+/**
+ * Jeeves LLM Test Project - On-device requantization
+ */
+
+#include "requantize.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "cpu_topology.h"
+#include "device_probe.h"
+#include "llama_log.h"
+#include "thread_pool.h"
+
+#if LLAMA_AVAILABLE
+#include "ggml.h"
+#include "gguf.h"
+#include "llama.h"
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int64_t CHUNK_ELEMENTS = 1 << 20;        // f32 scratch per worker (4 MB)
+constexpr size_t COPY_CHUNK_BYTES = 8u << 20;
+
+// Logit check: the requantized model must predict this prompt like the original
+constexpr const char* CHECK_PROMPT =
+    "Classify the task into an Eisenhower quadrant and explain briefly: "
+    "the payment server is down and customers cannot check out. "
+    "Reply with DO, SCHEDULE, DELEGATE or ELIMINATE.";
+constexpr int CHECK_CTX = 128;
+constexpr double CHECK_MAX_MEAN_KL = 0.25;          // Nats per position
+constexpr double CHECK_MIN_TOP1_AGREEMENT = 0.7;    // Positions whose most likely token matches
+
+struct JobState {
+    std::mutex run_mutex;           // Held for the whole job
+    std::mutex progress_mutex;
+    RequantizeProgress progress;
+    Clock::time_point start;
+    std::atomic<bool> cancel{false};
+};
+
+JobState& job() {
+    static JobState s;
+    return s;
+}
+
+template <typename Update>
+void update_progress(Update update) {
+    JobState& s = job();
+    std::lock_guard<std::mutex> lock(s.progress_mutex);
+    update(s.progress);
+}
+
+#if LLAMA_AVAILABLE
+
+struct MappedFile {
+    int fd = -1;
+    void* data = MAP_FAILED;
+    size_t size = 0;
+
+    ~MappedFile() {
+        if (data != MAP_FAILED) munmap(data, size);
+        if (fd >= 0) close(fd);
+    }
+
+    bool open(const std::string& path, struct stat& st) {
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0 || fstat(fd, &st) != 0 || st.st_size <= 0) return false;
+        size = static_cast<size_t>(st.st_size);
+        data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) return false;
+        madvise(data, size, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    const uint8_t* bytes() const { return static_cast<const uint8_t*>(data); }
+};
+
+struct GgufFile {
+    gguf_context* gguf = nullptr;
+    ggml_context* meta = nullptr;
+
+    ~GgufFile() {
+        if (gguf) gguf_free(gguf);
+        if (meta) ggml_free(meta);
+    }
+};
+
+struct TensorPlan {
+    std::string name;
+    ggml_type src_type;
+    ggml_type dst_type;
+    int64_t n_per_row = 0;
+    int64_t rows = 0;
+    size_t src_offset = 0;      // Absolute, in the input
+    size_t dst_offset = 0;      // Absolute, in the output
+    size_t dst_bytes = 0;
+};
+
+struct OutputLayout {
+    GgufFile gguf;
+    std::vector<TensorPlan> tensors;
+    std::vector<uint8_t> meta;  // Header, metadata and tensor infos, padded to the data alignment
+    size_t total_bytes = 0;
+    int converted = 0;
+};
+
+bool convertible(const ggml_tensor* t, ggml_type target) {
+    return t->type == GGML_TYPE_Q4_K && ggml_n_dims(t) >= 2 && t->ne[0] % ggml_blck_size(target) == 0 &&
+           ggml_get_type_traits(t->type)->to_float != nullptr;
+}
+
+// Tensor types and offsets of the output; metadata is copied with the new file type
+bool plan_output(const GgufFile& in, size_t data_offset, ggml_type target, OutputLayout& out) {
+    const int64_t n = gguf_get_n_tensors(in.gguf);
+    ggml_init_params params = {static_cast<size_t>(n) * ggml_tensor_overhead(), nullptr, true};
+    out.gguf.meta = ggml_init(params);
+    out.gguf.gguf = gguf_init_empty();
+    if (!out.gguf.meta || !out.gguf.gguf) return false;
+
+    gguf_set_kv(out.gguf.gguf, in.gguf);
+    gguf_set_val_u32(out.gguf.gguf, "general.file_type", LLAMA_FTYPE_MOSTLY_Q4_0);
+
+    for (int64_t i = 0; i < n; i++) {
+        const char* name = gguf_get_tensor_name(in.gguf, i);
+        const ggml_tensor* src = ggml_get_tensor(in.meta, name);
+        if (!src) return false;
+
+        TensorPlan plan;
+        plan.name = name;
+        plan.src_type = src->type;
+        plan.dst_type = convertible(src, target) ? target : src->type;
+        plan.n_per_row = src->ne[0];
+        plan.rows = ggml_nrows(src);
+        plan.src_offset = data_offset + gguf_get_tensor_offset(in.gguf, i);
+        if (plan.dst_type != plan.src_type) out.converted++;
+
+        ggml_tensor* dst = ggml_new_tensor(out.gguf.meta, plan.dst_type, ggml_n_dims(src), src->ne);
+        ggml_set_name(dst, name);
+        gguf_add_tensor(out.gguf.gguf, dst);
+        plan.dst_bytes = ggml_nbytes(dst);
+        out.tensors.push_back(plan);
+    }
+
+    out.meta.resize(gguf_get_meta_size(out.gguf.gguf));
+    gguf_get_meta_data(out.gguf.gguf, out.meta.data());
+    for (int64_t i = 0; i < n; i++) {
+        TensorPlan& plan = out.tensors[i];
+        plan.dst_offset = out.meta.size() + gguf_get_tensor_offset(out.gguf.gguf, i);
+        out.total_bytes = std::max(out.total_bytes, plan.dst_offset + plan.dst_bytes);
+    }
+    return true;
+}
+
+bool pwrite_all(int fd, const void* data, size_t bytes, size_t offset) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (bytes > 0) {
+        ssize_t n = pwrite(fd, p, bytes, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            LOGE("Requantize write failed (errno=%d)", errno);
+            return false;
+        }
+        p += n;
+        offset += static_cast<size_t>(n);
+        bytes -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool copy_tensor(const TensorPlan& t, const uint8_t* src, int fd) {
+    for (size_t done = 0; done < t.dst_bytes; done += COPY_CHUNK_BYTES) {
+        if (job().cancel.load(std::memory_order_relaxed)) return false;
+        size_t n = std::min(COPY_CHUNK_BYTES, t.dst_bytes - done);
+        if (!pwrite_all(fd, src + t.src_offset + done, n, t.dst_offset + done)) return false;
+    }
+    return true;
+}
+
+// Rows [begin, end): dequantize to f32, quantize to the target type
+bool convert_rows(const TensorPlan& t, const uint8_t* src, int fd, int64_t begin, int64_t end) {
+    const size_t src_row = ggml_row_size(t.src_type, t.n_per_row);
+    const size_t dst_row = ggml_row_size(t.dst_type, t.n_per_row);
+    const int64_t chunk_rows = std::max<int64_t>(1, CHUNK_ELEMENTS / t.n_per_row);
+    const ggml_to_float_t to_float = ggml_get_type_traits(t.src_type)->to_float;
+
+    std::vector<float> f32(static_cast<size_t>(chunk_rows * t.n_per_row));
+    std::vector<uint8_t> quantized(static_cast<size_t>(chunk_rows) * dst_row);
+    for (int64_t row = begin; row < end; row += chunk_rows) {
+        if (job().cancel.load(std::memory_order_relaxed)) return false;
+        const int64_t n = std::min(chunk_rows, end - row);
+        to_float(src + t.src_offset + row * src_row, f32.data(), n * t.n_per_row);
+        size_t bytes = ggml_quantize_chunk(t.dst_type, f32.data(), quantized.data(), 0, n, t.n_per_row, nullptr);
+        if (!pwrite_all(fd, quantized.data(), bytes, t.dst_offset + row * dst_row)) return false;
+    }
+    return true;
+}
+
+bool convert_tensor(const TensorPlan& t, const uint8_t* src, int fd, int threads) {
+    const int64_t workers = std::max<int64_t>(1, std::min<int64_t>(threads, t.rows));
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> pool;
+    for (int64_t w = 0; w < workers; w++) {
+        int64_t begin = t.rows * w / workers;
+        int64_t end = t.rows * (w + 1) / workers;
+        pool.emplace_back([&, begin, end] {
+            if (!convert_rows(t, src, fd, begin, end)) failed = true;
+        });
+    }
+    for (std::thread& worker : pool) worker.join();
+    return !failed;
+}
+
+void fsync_parent(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : path.substr(0, slash);
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+    fsync(fd);
+    close(fd);
+}
+
+// Re-read the written file as a reader would and check every tensor's blocks
+int verify_output(const std::string& part, const OutputLayout& layout) {
+    struct stat st;
+    MappedFile file;
+    if (!file.open(part, st) || file.size != layout.total_bytes) {
+        LOGE("Requantized file has the wrong size");
+        return REQUANT_FAILED;
+    }
+
+    GgufFile written;
+    gguf_init_params params = {/*no_alloc =*/ true, /*ctx =*/ &written.meta};
+    written.gguf = gguf_init_from_file(part.c_str(), params);
+    if (!written.gguf || gguf_get_n_tensors(written.gguf) != static_cast<int64_t>(layout.tensors.size())) {
+        LOGE("Requantized file has an unreadable header");
+        return REQUANT_FAILED;
+    }
+
+    const size_t data_offset = gguf_get_data_offset(written.gguf);
+    for (size_t i = 0; i < layout.tensors.size(); i++) {
+        if (job().cancel.load(std::memory_order_relaxed)) return REQUANT_CANCELLED;
+        const TensorPlan& t = layout.tensors[i];
+        const int64_t id = static_cast<int64_t>(i);
+        if (t.name != gguf_get_tensor_name(written.gguf, id) || gguf_get_tensor_type(written.gguf, id) != t.dst_type ||
+            data_offset + gguf_get_tensor_offset(written.gguf, id) != t.dst_offset) {
+            LOGE("Requantized tensor %s does not match the plan", t.name.c_str());
+            return REQUANT_FAILED;
+        }
+        if (!ggml_validate_row_data(t.dst_type, file.bytes() + t.dst_offset, t.dst_bytes)) {
+            LOGE("Requantized tensor %s has invalid data", t.name.c_str());
+            return REQUANT_FAILED;
+        }
+    }
+    return REQUANT_DONE;
+}
+
+/** Model and a context that fits the check prompt, both freed with it. */
+struct CheckModel {
+    llama_model* model = nullptr;
+    llama_context* ctx = nullptr;
+
+    ~CheckModel() {
+        if (ctx) llama_free(ctx);
+        if (model) llama_model_free(model);
+    }
+
+    bool load(const std::string& path) {
+        llama_model_params model_params = llama_model_default_params();
+        model_params.n_gpu_layers = 0;
+        model = llama_model_load_from_file(path.c_str(), model_params);
+        if (!model) return false;
+
+        llama_context_params params = llama_context_default_params();
+        params.n_ctx = params.n_batch = params.n_ubatch = CHECK_CTX;
+        params.n_seq_max = 1;
+        params.n_threads = params.n_threads_batch = SharedThreadPools::instance().background_threads();
+        ctx = llama_init_from_model(model, params);
+        return ctx != nullptr;
+    }
+};
+
+/**
+ * Log-softmax of the next-token logits at every position of [tokens], one
+ * row of n_vocab values per position, into [out]. Decodes as background work.
+ */
+int prompt_log_probs(CheckModel& m, const std::vector<llama_token>& tokens, std::vector<float>& out) {
+    SharedThreadPools& pools = SharedThreadPools::instance();
+    if (pools.background_must_yield()) pools.wait_for_background_turn();
+    if (job().cancel.load(std::memory_order_relaxed)) return REQUANT_CANCELLED;
+
+    const int n = static_cast<int>(tokens.size());
+    llama_batch batch = llama_batch_init(n, 0, 1);
+    for (int i = 0; i < n; i++) {
+        batch.token[i] = tokens[i];
+        batch.pos[i] = i;
+        batch.n_seq_id[i] = 1;
+        batch.seq_id[i][0] = 0;
+        batch.logits[i] = true;
+    }
+    batch.n_tokens = n;
+    const int32_t result = pools.decode(m.ctx, batch, QOS_BACKGROUND);
+    llama_batch_free(batch);
+    if (result != 0) return REQUANT_FAILED;
+
+    const int n_vocab = llama_vocab_n_tokens(llama_model_get_vocab(m.model));
+    out.resize(static_cast<size_t>(n) * n_vocab);
+    for (int i = 0; i < n; i++) {
+        const float* logits = llama_get_logits_ith(m.ctx, i);
+        if (!logits) return REQUANT_FAILED;
+        const float max = *std::max_element(logits, logits + n_vocab);
+        double sum = 0.0;
+        for (int v = 0; v < n_vocab; v++) sum += std::exp(static_cast<double>(logits[v] - max));
+        const float log_sum = static_cast<float>(std::log(sum));
+        float* row = out.data() + static_cast<size_t>(i) * n_vocab;
+        for (int v = 0; v < n_vocab; v++) row[v] = logits[v] - max - log_sum;
+    }
+    return REQUANT_DONE;
+}
+
+// Compare what the original at [input] and the requantized [part] predict for CHECK_PROMPT
+int compare_logits(const std::string& input, const std::string& part) {
+    ThreadPoolRequest request(QOS_BACKGROUND);
+    std::vector<llama_token> tokens(CHECK_CTX);
+    std::vector<float> reference;
+    std::vector<float> candidate;
+    {
+        CheckModel original;
+        if (!original.load(input)) {
+            LOGE("Cannot load %s for the logit check", input.c_str());
+            return REQUANT_FAILED;
+        }
+        const int n = llama_tokenize(llama_model_get_vocab(original.model), CHECK_PROMPT,
+                                     static_cast<int32_t>(strlen(CHECK_PROMPT)), tokens.data(),
+                                     static_cast<int32_t>(tokens.size()), true, false);
+        if (n <= 1) return REQUANT_FAILED;
+        tokens.resize(n);
+        const int state = prompt_log_probs(original, tokens, reference);
+        if (state != REQUANT_DONE) return state;
+    }
+    {
+        CheckModel requantized;
+        if (!requantized.load(part)) {
+            LOGE("Requantized model does not load");
+            return REQUANT_FAILED;
+        }
+        const int state = prompt_log_probs(requantized, tokens, candidate);
+        if (state == REQUANT_CANCELLED) return state;
+        if (state != REQUANT_DONE || candidate.size() != reference.size()) {
+            LOGE("Requantized model cannot evaluate the check prompt");
+            return REQUANT_FAILED;
+        }
+    }
+
+    const size_t n_vocab = reference.size() / tokens.size();
+    double kl = 0.0;
+    int agree = 0;
+    for (size_t i = 0; i < tokens.size(); i++) {
+        const float* p = reference.data() + i * n_vocab;
+        const float* q = candidate.data() + i * n_vocab;
+        for (size_t v = 0; v < n_vocab; v++) kl += std::exp(static_cast<double>(p[v])) * (p[v] - q[v]);
+        if (std::max_element(p, p + n_vocab) - p == std::max_element(q, q + n_vocab) - q) agree++;
+    }
+    const double mean_kl = kl / static_cast<double>(tokens.size());
+    const double agreement = static_cast<double>(agree) / static_cast<double>(tokens.size());
+    LOGI("Requantized model vs original over %zu positions: mean KL %.4f, top-1 agreement %.0f%%",
+         tokens.size(), mean_kl, agreement * 100.0);
+    if (!(mean_kl <= CHECK_MAX_MEAN_KL) || agreement < CHECK_MIN_TOP1_AGREEMENT) {
+        LOGE("Requantized model diverges from the original; keeping the original");
+        return REQUANT_FAILED;
+    }
+    return REQUANT_DONE;
+}
+
+int run_requantize(const std::string& input, const std::string& output, int target_type, int threads) {
+    if (target_type != REQUANT_TYPE_Q4_0) {
+        LOGE("Unsupported requantize target type %d", target_type);
+        return REQUANT_FAILED;
+    }
+    const ggml_type target = static_cast<ggml_type>(target_type);
+
+    struct stat input_st;
+    MappedFile in_file;
+    if (!in_file.open(input, input_st)) {
+        LOGE("Cannot map %s for requantization (errno=%d)", input.c_str(), errno);
+        return REQUANT_FAILED;
+    }
+    struct stat output_st;
+    if (output == input || (stat(output.c_str(), &output_st) == 0 && output_st.st_dev == input_st.st_dev &&
+                            output_st.st_ino == input_st.st_ino)) {
+        LOGE("Requantize output must not replace its input %s", input.c_str());
+        return REQUANT_FAILED;
+    }
+    GgufFile in;
+    gguf_init_params params = {/*no_alloc =*/ true, /*ctx =*/ &in.meta};
+    in.gguf = gguf_init_from_file(input.c_str(), params);
+    if (!in.gguf) {
+        LOGE("%s is not a readable GGUF file", input.c_str());
+        return REQUANT_FAILED;
+    }
+
+    OutputLayout layout;
+    if (!plan_output(in, gguf_get_data_offset(in.gguf), target, layout)) {
+        LOGE("Cannot plan requantized layout for %s", input.c_str());
+        return REQUANT_FAILED;
+    }
+    if (layout.converted == 0) {
+        LOGI("%s has no tensors to requantize; keep using it", input.c_str());
+        return REQUANT_FAILED;
+    }
+
+    const std::string part = output + ".part";
+    const std::string state_path = part + ".state";
+    const std::string key = requantize_resume_key(input_st, target_type, layout.tensors.size());
+
+    size_t next = read_resume_point(state_path, key);
+    struct stat part_st;
+    int fd = -1;
+    if (next > 0 && stat(part.c_str(), &part_st) == 0 && static_cast<size_t>(part_st.st_size) == layout.total_bytes) {
+        fd = ::open(part.c_str(), O_WRONLY | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        next = 0;
+        fd = ::open(part.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd < 0 || ftruncate(fd, static_cast<off_t>(layout.total_bytes)) != 0 ||
+            !pwrite_all(fd, layout.meta.data(), layout.meta.size(), 0)) {
+            LOGE("Cannot create %s (errno=%d)", part.c_str(), errno);
+            if (fd >= 0) close(fd);
+            unlink(part.c_str());
+            return REQUANT_FAILED;
+        }
+    }
+
+    size_t resumed_bytes = layout.meta.size();
+    for (size_t i = 0; i < next && i < layout.tensors.size(); i++) resumed_bytes += layout.tensors[i].dst_bytes;
+    update_progress([&](RequantizeProgress& p) {
+        p.tensors_total = static_cast<long long>(layout.tensors.size());
+        p.tensors_done = static_cast<long long>(next);
+        p.resumed_tensors = static_cast<long long>(next);
+        p.converted_tensors = layout.converted;
+        p.bytes_total = static_cast<long long>(layout.total_bytes);
+        p.bytes_done = static_cast<long long>(resumed_bytes);
+    });
+    LOGI("Requantizing %s to %s: %d of %zu tensors converted, resuming at %zu",
+         input.c_str(), ggml_type_name(target), layout.converted, layout.tensors.size(), next);
+
+    const int hardware = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    if (threads <= 0) threads = system_cpu_topology().recommended_threads(CPU_POLICY_EFFICIENCY);
+    threads = std::max(1, std::min(threads, hardware));
+    ggml_quantize_init(target);
+
+    auto write_tensor = [&](size_t i) {
+        const TensorPlan& t = layout.tensors[i];
+        bool ok = t.dst_type == t.src_type ? copy_tensor(t, in_file.bytes(), fd)
+                                           : convert_tensor(t, in_file.bytes(), fd, threads);
+        if (!ok || fdatasync(fd) != 0) {
+            if (!job().cancel.load(std::memory_order_relaxed)) LOGE("Requantize failed at tensor %s", t.name.c_str());
+            return false;
+        }
+        update_progress([&](RequantizeProgress& p) {
+            p.tensors_done = static_cast<long long>(i + 1);
+            p.bytes_done += static_cast<long long>(t.dst_bytes);
+        });
+        return true;
+    };
+    const int written = run_resumable_steps(state_path, key, next, layout.tensors.size(), job().cancel, write_tensor);
+    close(fd);
+    if (written == REQUANT_CANCELLED) {
+        LOGI("Requantize cancelled after %lld of %zu tensors", requantize_progress().tensors_done,
+             layout.tensors.size());
+        return REQUANT_CANCELLED;
+    }
+    if (written != REQUANT_DONE) {
+        unlink(part.c_str());
+        unlink(state_path.c_str());
+        return REQUANT_FAILED;
+    }
+
+    update_progress([](RequantizeProgress& p) { p.state = REQUANT_VERIFYING; });
+    int verified = verify_output(part, layout);
+    if (verified == REQUANT_DONE) verified = compare_logits(input, part);
+    if (verified != REQUANT_DONE) {
+        if (verified == REQUANT_FAILED) {
+            unlink(part.c_str());
+            unlink(state_path.c_str());
+        }
+        return verified;
+    }
+
+    if (rename(part.c_str(), output.c_str()) != 0) {
+        LOGE("Cannot replace %s (errno=%d)", output.c_str(), errno);
+        return REQUANT_FAILED;
+    }
+    fsync_parent(output);
+    unlink(state_path.c_str());
+    return REQUANT_DONE;
+}
+
+#endif // LLAMA_AVAILABLE
+
+} // namespace
+
+void RequantizeProgress::to_array(long long out[COUNT]) const {
+    out[STATE] = state;
+    out[TENSORS_DONE] = tensors_done;
+    out[TENSORS_TOTAL] = tensors_total;
+    out[BYTES_DONE] = bytes_done;
+    out[BYTES_TOTAL] = bytes_total;
+    out[RESUMED_TENSORS] = resumed_tensors;
+    out[CONVERTED_TENSORS] = converted_tensors;
+    out[TARGET_TYPE] = target_type;
+    out[ELAPSED_MS] = elapsed_ms;
+}
+
+std::string requantize_resume_key(const struct stat& input, int target_type, size_t n_tensors) {
+    std::ostringstream key;
+    key << "size=" << input.st_size << " mtime=" << input.st_mtime << " ino=" << input.st_ino
+        << " target=" << target_type << " tensors=" << n_tensors;
+    return key.str();
+}
+
+size_t read_resume_point(const std::string& state_path, const std::string& key) {
+    std::ifstream in(state_path);
+    std::string line;
+    size_t next = 0;
+    if (!std::getline(in, line) || line != key || !(in >> next)) return 0;
+    return next;
+}
+
+bool write_resume_point(const std::string& state_path, const std::string& key, size_t next) {
+    const std::string tmp = state_path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << key << "\n" << next << "\n";
+        if (!out.flush()) return false;
+    }
+    return rename(tmp.c_str(), state_path.c_str()) == 0;
+}
+
+int run_resumable_steps(const std::string& state_path, const std::string& key, size_t next, size_t count,
+                        const std::atomic<bool>& cancel, const std::function<bool(size_t)>& step) {
+    for (size_t i = next; i < count; i++) {
+        const bool ok = step(i);
+        if (cancel.load(std::memory_order_relaxed)) return REQUANT_CANCELLED;
+        if (!ok) return REQUANT_FAILED;
+        // The step's data first, then the resume point that covers it
+        if (!write_resume_point(state_path, key, i + 1)) {
+            LOGE("Cannot record the resume point in %s", state_path.c_str());
+            return REQUANT_FAILED;
+        }
+    }
+    return REQUANT_DONE;
+}
+
+int select_requant_type(int features) {
+    // Q4_0 is what ggml repacks for the dotprod / i8mm / AVX2 kernels
+    constexpr int REPACKED_Q4_0 = CPU_FEATURE_DOTPROD | CPU_FEATURE_I8MM | CPU_FEATURE_AVX2;
+    return (features & REPACKED_Q4_0) ? REQUANT_TYPE_Q4_0 : REQUANT_TYPE_NONE;
+}
+
+int requantize_model(const std::string& input, const std::string& output, int target_type, int threads) {
+    JobState& s = job();
+    std::unique_lock<std::mutex> run(s.run_mutex, std::try_to_lock);
+    if (!run.owns_lock()) {
+        LOGW("Requantize already running; %s not started", input.c_str());
+        return REQUANT_FAILED;
+    }
+
+    s.cancel.store(false);
+    s.start = Clock::now();
+    update_progress([&](RequantizeProgress& p) {
+        p = RequantizeProgress();
+        p.state = REQUANT_RUNNING;
+        p.target_type = target_type;
+    });
+
+    int state = REQUANT_FAILED;
+#if LLAMA_AVAILABLE
+    {
+        // Background work: efficiency cores at low priority; the workers inherit both
+        ScopedCpuAffinity affinity(system_cpu_topology().cpus_for_policy(CPU_POLICY_EFFICIENCY));
+        ScopedThreadPriority priority(BACKGROUND_NICE);
+        state = run_requantize(input, output, target_type, threads);
+    }
+#else
+    LOGE("Requantize requires llama.cpp");
+#endif
+
+    const long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - s.start).count();
+    update_progress([&](RequantizeProgress& p) {
+        p.state = state;
+        p.elapsed_ms = elapsed;
+    });
+    LOGI("Requantize of %s finished: state %d in %lld ms", input.c_str(), state, elapsed);
+    return state;
+}
+
+void cancel_requantize() {
+    job().cancel.store(true);
+}
+
+RequantizeProgress requantize_progress() {
+    JobState& s = job();
+    std::lock_guard<std::mutex> lock(s.progress_mutex);
+    RequantizeProgress p = s.progress;
+    if (p.state == REQUANT_RUNNING || p.state == REQUANT_VERIFYING) {
+        p.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - s.start).count();
+    }
+    return p;
+}
@@ -0,0 +1,121 @@
+/**
+ * Jeeves LLM Test Project - On-device requantization
+ *
+ * Every device downloads the same Q4_K_M file, but ggml's ARM (dotprod,
+ * i8mm) and AVX2 kernels are fastest on Q4_0 weights, which the CPU backend
+ * repacks into interleaved blocks at load. requantize_model converts a
+ * downloaded GGUF tensor by tensor: Q4_K weights are dequantized and
+ * re-quantized to the target type, everything else (Q6_K output and
+ * attention tensors, norms, metadata) is copied unchanged.
+ *
+ * The job runs on efficiency cores at background priority and writes
+ * <output>.part, recording each finished tensor in <output>.part.state, so
+ * a cancelled or killed job resumes where it stopped. The output is a
+ * separate variant file: the download keeps the layout its SHA-256 was
+ * verified for, and stays the fallback if the variant is rejected.
+ *
+ * Before the rename to [output] the result is checked twice. Structurally:
+ * header, layout and ggml_validate_row_data on every tensor. Then by what
+ * it computes: the original and the variant each evaluate a fixed prompt
+ * (one model loaded at a time), and the variant's next-token distributions
+ * must stay close to the original's. Q4_0 costs a little accuracy, so the
+ * bounds only reject a broken conversion, which shows up as several nats
+ * of divergence and near-random top tokens.
+ */
+
+#pragma once
+
+#include <sys/stat.h>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+/** Weight types requantize_model produces (values are ggml_type ids). */
+enum RequantType : int {
+    REQUANT_TYPE_NONE = -1,
+    REQUANT_TYPE_Q4_0 = 2,
+};
+
+/** Values mirror LlamaEngine.RequantizeState on the Kotlin side. */
+enum RequantizeState : int {
+    REQUANT_IDLE = 0,
+    REQUANT_RUNNING,
+    REQUANT_VERIFYING,
+    REQUANT_DONE,
+    REQUANT_FAILED,
+    REQUANT_CANCELLED,      // Partial output kept for resuming
+};
+
+/**
+ * Progress of the current (or last) job. Flattened for JNI as the Index fields.
+ */
+struct RequantizeProgress {
+    enum Index {
+        STATE = 0,
+        TENSORS_DONE,
+        TENSORS_TOTAL,
+        BYTES_DONE,                 // Output bytes written, including resumed ones
+        BYTES_TOTAL,
+        RESUMED_TENSORS,            // Tensors a previous run had finished
+        CONVERTED_TENSORS,          // Tensors whose type changes
+        TARGET_TYPE,                // RequantType
+        ELAPSED_MS,
+        COUNT
+    };
+
+    int state = REQUANT_IDLE;
+    long long tensors_done = 0;
+    long long tensors_total = 0;
+    long long bytes_done = 0;
+    long long bytes_total = 0;
+    long long resumed_tensors = 0;
+    long long converted_tensors = 0;
+    int target_type = REQUANT_TYPE_NONE;
+    long long elapsed_ms = 0;
+
+    void to_array(long long out[COUNT]) const;
+};
+
+/**
+ * Weight type that runs fastest on a CPU with CpuFeature bits [features], or
+ * REQUANT_TYPE_NONE when the downloaded layout is already the best choice.
+ */
+int select_requant_type(int features);
+
+/**
+ * Convert the GGUF at [input] so its Q4_K weights become [target_type] and
+ * atomically replace [output] with the checked result. [output] must be
+ * another file; [input] is never modified. Fails if no tensor would change.
+ * Blocks until done, failed or cancelled; one job runs at a time.
+ * [threads] 0 uses one thread per efficiency core.
+ * Returns the final RequantizeState.
+ */
+int requantize_model(const std::string& input, const std::string& output, int target_type, int threads = 0);
+
+/** Stop the running job after its current chunk; its progress is kept. */
+void cancel_requantize();
+
+RequantizeProgress requantize_progress();
+
+// Resuming. <output>.part.state holds a key naming the input and plan the
+// partial output belongs to, then the index of the next tensor to write.
+
+/** Key of [input] converted to [target_type] in [n_tensors] steps. */
+std::string requantize_resume_key(const struct stat& input, int target_type, size_t n_tensors);
+
+/** First step still to run; 0 when [state_path] is missing, unreadable or for another key. */
+size_t read_resume_point(const std::string& state_path, const std::string& key);
+
+/** Atomically record [next] as the first step still to run. */
+bool write_resume_point(const std::string& state_path, const std::string& key, size_t next);
+
+/**
+ * Run [step] for steps [next, count), recording the resume point after each
+ * one that succeeds. Returns REQUANT_CANCELLED once [cancel] is set (the
+ * interrupted step runs again on resume), REQUANT_FAILED when a step or the
+ * resume point fails, else REQUANT_DONE.
+ */
+int run_resumable_steps(const std::string& state_path, const std::string& key, size_t next, size_t count,
+                        const std::atomic<bool>& cancel, const std::function<bool(size_t)>& step);
@@ -0,0 +1,345 @@
+/**
+ * Jeeves LLM Test Project - SHA-256 of downloaded model files
+ */
+
+#include "sha256.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cpu_topology.h"
+#include "device_probe.h"
+#include "llama_log.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t CHUNK_BYTES = 4u << 20;
+// Chunks the readers may run ahead of the hashing thread (64 MB of page cache)
+constexpr size_t READ_AHEAD_CHUNKS = 16;
+constexpr int MAX_READERS = 3;
+
+constexpr uint32_t INITIAL_STATE[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+inline uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+struct JobState {
+    std::mutex run_mutex;           // Held for the whole hash
+    std::mutex progress_mutex;
+    FileHashProgress progress;
+    Clock::time_point start;
+    std::atomic<long long> bytes_done{0};
+    std::atomic<bool> cancel{false};
+};
+
+JobState& job() {
+    static JobState s;
+    return s;
+}
+
+// Faults in chunks ahead of the hashing thread so reads overlap with hashing
+class ReadAhead {
+public:
+    ReadAhead(const uint8_t* base, size_t size, int threads) : base_(base), size_(size) {
+        chunks_ = (size + CHUNK_BYTES - 1) / CHUNK_BYTES;
+        page_ = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        for (int i = 0; i < threads; i++) threads_.emplace_back([this] { run(); });
+    }
+
+    ~ReadAhead() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (std::thread& t : threads_) t.join();
+    }
+
+    ReadAhead(const ReadAhead&) = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+
+    void hashed(size_t chunks) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            hashed_ = chunks;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    void run() {
+        for (;;) {
+            size_t chunk = next_.fetch_add(1);
+            if (chunk >= chunks_) return;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [&] { return stop_ || chunk < hashed_ + READ_AHEAD_CHUNKS; });
+                if (stop_) return;
+            }
+            const size_t end = std::min(size_, (chunk + 1) * CHUNK_BYTES);
+            unsigned sum = 0;
+            for (size_t off = chunk * CHUNK_BYTES; off < end; off += page_) {
+                sum += reinterpret_cast<const volatile uint8_t*>(base_)[off];
+            }
+            (void) sum;
+        }
+    }
+
+    const uint8_t* base_;
+    size_t size_;
+    size_t chunks_ = 0;
+    size_t page_ = 4096;
+    std::atomic<size_t> next_{0};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t hashed_ = 0;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+};
+
+int hash_file(const std::string& path, std::string& hex, int readers, Sha256Blocks kernel) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        LOGE("Cannot open %s for hashing (errno=%d)", path.c_str(), errno);
+        if (fd >= 0) close(fd);
+        return HASH_FAILED;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    {
+        JobState& s = job();
+        std::lock_guard<std::mutex> lock(s.progress_mutex);
+        s.progress.bytes_total = static_cast<long long>(size);
+    }
+
+    Sha256 sha(kernel);
+    if (size == 0) {
+        close(fd);
+        hex = sha.finish();
+        return HASH_DONE;
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        LOGE("Cannot map %s for hashing (errno=%d)", path.c_str(), errno);
+        return HASH_FAILED;
+    }
+    const uint8_t* base = static_cast<const uint8_t*>(mapped);
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    int state = HASH_DONE;
+    {
+        ReadAhead read_ahead(base, size, readers);
+        size_t chunk = 0;
+        for (size_t off = 0; off < size; off += CHUNK_BYTES) {
+            if (job().cancel.load(std::memory_order_relaxed)) {
+                state = HASH_CANCELLED;
+                break;
+            }
+            const size_t len = std::min(CHUNK_BYTES, size - off);
+            sha.update(base + off, len);
+            read_ahead.hashed(++chunk);
+            // Keep the pages in page cache for the model load, out of this mapping
+            madvise(const_cast<uint8_t*>(base + off), len, MADV_DONTNEED);
+            job().bytes_done.store(static_cast<long long>(off + len), std::memory_order_relaxed);
+        }
+    }
+    munmap(mapped, size);
+    if (state == HASH_DONE) hex = sha.finish();
+    return state;
+}
+
+} // namespace
+
+// ============================================================================
+// SHA-256
+// ============================================================================
+
+const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+void sha256_blocks_portable(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    for (; blocks > 0; blocks--, data += 64) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t(data[4 * i]) << 24) | (uint32_t(data[4 * i + 1]) << 16) |
+                   (uint32_t(data[4 * i + 2]) << 8) | uint32_t(data[4 * i + 3]);
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+            uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+Sha256Blocks select_sha256_kernel(int features, int* kernel) {
+    Sha256Blocks blocks = nullptr;
+    int selected = SHA256_KERNEL_PORTABLE;
+    if (features & CPU_FEATURE_SHA2) {
+        if ((blocks = sha256_blocks_armv8())) {
+            selected = SHA256_KERNEL_ARMV8;
+        } else if ((blocks = sha256_blocks_shani())) {
+            selected = SHA256_KERNEL_SHANI;
+        }
+    }
+    if (kernel) *kernel = selected;
+    return blocks ? blocks : sha256_blocks_portable;
+}
+
+Sha256::Sha256(Sha256Blocks blocks) : blocks_(blocks) {
+    memcpy(state_, INITIAL_STATE, sizeof(state_));
+}
+
+void Sha256::update(const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    total_ += size;
+    if (buffered_ > 0) {
+        size_t n = std::min(size, sizeof(buffer_) - buffered_);
+        memcpy(buffer_ + buffered_, p, n);
+        buffered_ += n;
+        p += n;
+        size -= n;
+        if (buffered_ < sizeof(buffer_)) return;
+        blocks_(state_, buffer_, 1);
+        buffered_ = 0;
+    }
+    if (size >= 64) {
+        blocks_(state_, p, size / 64);
+        p += size & ~size_t(63);
+        size &= 63;
+    }
+    memcpy(buffer_, p, size);
+    buffered_ = size;
+}
+
+std::string Sha256::finish() {
+    const uint64_t bits = total_ * 8;
+    uint8_t pad[72] = {0x80};
+    const size_t pad_len = (buffered_ < 56 ? 56 : 120) - buffered_;
+    for (int i = 0; i < 8; i++) pad[pad_len + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+    update(pad, pad_len + 8);
+
+    static const char DIGITS[] = "0123456789abcdef";
+    std::string hex(64, '0');
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 8; j++) hex[8 * i + j] = DIGITS[(state_[i] >> (28 - 4 * j)) & 0xf];
+    }
+    return hex;
+}
+
+// ============================================================================
+// Files
+// ============================================================================
+
+void FileHashProgress::to_array(long long out[COUNT]) const {
+    out[STATE] = state;
+    out[BYTES_DONE] = bytes_done;
+    out[BYTES_TOTAL] = bytes_total;
+    out[KERNEL] = kernel;
+    out[READERS] = readers;
+    out[ELAPSED_MS] = elapsed_ms;
+}
+
+int sha256_file(const std::string& path, std::string& hex, int readers) {
+    JobState& s = job();
+    std::unique_lock<std::mutex> run(s.run_mutex, std::try_to_lock);
+    if (!run.owns_lock()) {
+        LOGW("File hash already running; %s not hashed", path.c_str());
+        return HASH_FAILED;
+    }
+
+    int kernel = SHA256_KERNEL_PORTABLE;
+    Sha256Blocks blocks = select_sha256_kernel(detect_cpu_features(), &kernel);
+    if (readers <= 0) {
+        int hardware = static_cast<int>(std::thread::hardware_concurrency());
+        readers = std::max(1, std::min(MAX_READERS, hardware - 1));
+    }
+
+    s.cancel.store(false);
+    s.bytes_done.store(0);
+    s.start = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(s.progress_mutex);
+        s.progress = FileHashProgress();
+        s.progress.state = HASH_RUNNING;
+        s.progress.kernel = kernel;
+        s.progress.readers = readers;
+    }
+
+    int state;
+    {
+        // Compression is the bottleneck once reads overlap; keep it on a big core
+        ScopedCpuAffinity affinity(system_cpu_topology().cpus_for_policy(CPU_POLICY_PERFORMANCE));
+        state = hash_file(path, hex, readers, blocks);
+    }
+
+    const long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - s.start).count();
+    long long bytes = s.bytes_done.load();
+    {
+        std::lock_guard<std::mutex> lock(s.progress_mutex);
+        s.progress.state = state;
+        s.progress.bytes_done = bytes;
+        s.progress.elapsed_ms = elapsed;
+    }
+    LOGI("SHA-256 of %s: state %d, %lld bytes in %lld ms (kernel %d, %d readers)",
+         path.c_str(), state, bytes, elapsed, kernel, readers);
+    return state;
+}
+
+void cancel_file_hash() {
+    job().cancel.store(true);
+}
+
+FileHashProgress file_hash_progress() {
+    JobState& s = job();
+    std::lock_guard<std::mutex> lock(s.progress_mutex);
+    FileHashProgress p = s.progress;
+    if (p.state == HASH_RUNNING) {
+        p.bytes_done = s.bytes_done.load(std::memory_order_relaxed);
+        p.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - s.start).count();
+    }
+    return p;
+}
@@ -0,0 +1,111 @@
+/**
+ * Jeeves LLM Test Project - SHA-256 of downloaded model files
+ *
+ * ModelDownloadManager verifies 2-4 GB GGUF files against the catalogue's
+ * SHA-256 before they are loaded. A Kotlin stream with an 8 KB buffer and a
+ * JVM-side digest runs far below storage speed.
+ *
+ * SHA-256 is a chain - block n needs the state left by block n-1 - so one
+ * file digest cannot be split across cores, and a tree of per-chunk digests
+ * would no longer match the published hash. The time is instead cut in the
+ * two places that allow it:
+ *
+ * - Compression uses the ARMv8 SHA2 or x86 SHA-NI instructions when the CPU
+ *   has them (several times the portable code, above UFS read speed)
+ * - The file is mmapped and reader threads fault in the chunks ahead of the
+ *   hashing thread, within a bounded window, so page-ins overlap with
+ *   hashing and the storage queue stays busy
+ *
+ * Verification then runs at roughly disk-read speed. One file is hashed at a
+ * time; progress and cancellation work like requantize.h.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/** Values mirror LlamaEngine.HashState on the Kotlin side. */
+enum HashState : int {
+    HASH_IDLE = 0,
+    HASH_RUNNING,
+    HASH_DONE,
+    HASH_FAILED,
+    HASH_CANCELLED,
+};
+
+/** Values mirror LlamaEngine.Sha256Kernel on the Kotlin side. */
+enum Sha256Kernel : int {
+    SHA256_KERNEL_PORTABLE = 0,
+    SHA256_KERNEL_ARMV8,        // ARMv8 SHA2 extension
+    SHA256_KERNEL_SHANI,        // x86 SHA-NI
+};
+
+/** Round constants, shared with the instruction-set kernels. */
+extern const uint32_t SHA256_K[64];
+
+/** Compress [blocks] 64-byte blocks of [data] into [state]. */
+using Sha256Blocks = void (*)(uint32_t state[8], const uint8_t* data, size_t blocks);
+
+void sha256_blocks_portable(uint32_t state[8], const uint8_t* data, size_t blocks);
+
+// Null when this build has no such kernel (other architecture or compiler);
+// defined in sha256_armv8.cpp / sha256_x86.cpp, which get the ISA flags
+Sha256Blocks sha256_blocks_armv8();
+Sha256Blocks sha256_blocks_shani();
+
+/** Fastest kernel for CpuFeature bits [features]; its Sha256Kernel goes to [kernel]. */
+Sha256Blocks select_sha256_kernel(int features, int* kernel = nullptr);
+
+/** Incremental SHA-256. */
+class Sha256 {
+public:
+    explicit Sha256(Sha256Blocks blocks = sha256_blocks_portable);
+
+    void update(const void* data, size_t size);
+    /** Lowercase hex digest; the object must not be updated afterwards. */
+    std::string finish();
+
+private:
+    Sha256Blocks blocks_;
+    uint32_t state_[8];
+    uint8_t buffer_[64];
+    size_t buffered_ = 0;
+    uint64_t total_ = 0;
+};
+
+/**
+ * Progress of the current (or last) file hash. Flattened for JNI as the Index fields.
+ */
+struct FileHashProgress {
+    enum Index {
+        STATE = 0,
+        BYTES_DONE,
+        BYTES_TOTAL,
+        KERNEL,                     // Sha256Kernel
+        READERS,                    // Read-ahead threads
+        ELAPSED_MS,
+        COUNT
+    };
+
+    int state = HASH_IDLE;
+    long long bytes_done = 0;
+    long long bytes_total = 0;
+    int kernel = SHA256_KERNEL_PORTABLE;
+    int readers = 0;
+    long long elapsed_ms = 0;
+
+    void to_array(long long out[COUNT]) const;
+};
+
+/**
+ * SHA-256 of the file at [path] into [hex]. Blocks; [readers] 0 picks the
+ * read-ahead thread count. Returns the final HashState.
+ */
+int sha256_file(const std::string& path, std::string& hex, int readers = 0);
+
+/** Stop the running hash after its current chunk. */
+void cancel_file_hash();
+
+FileHashProgress file_hash_progress();
@@ -0,0 +1,58 @@
+/**
+ * Jeeves LLM Test Project - SHA-256 with the ARMv8 SHA2 extension
+ */
+
+#include "sha256.h"
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_SHA2)
+
+#include <arm_neon.h>
+
+namespace {
+
+void blocks_armv8(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    uint32x4_t abcd = vld1q_u32(state);
+    uint32x4_t efgh = vld1q_u32(state + 4);
+
+    for (; blocks > 0; blocks--, data += 64) {
+        const uint32x4_t abcd_in = abcd;
+        const uint32x4_t efgh_in = efgh;
+
+        uint32x4_t msg[4];
+        for (int i = 0; i < 4; i++) {
+            msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+        }
+
+        // Four rounds per step; msg[i & 3] is rolled forward to the words of step i + 4
+        for (int i = 0; i < 16; i++) {
+            const uint32x4_t wk = vaddq_u32(msg[i & 3], vld1q_u32(SHA256_K + 4 * i));
+            const uint32x4_t prev = abcd;
+            abcd = vsha256hq_u32(abcd, efgh, wk);
+            efgh = vsha256h2q_u32(efgh, prev, wk);
+            if (i < 12) {
+                msg[i & 3] = vsha256su1q_u32(vsha256su0q_u32(msg[i & 3], msg[(i + 1) & 3]),
+                                             msg[(i + 2) & 3], msg[(i + 3) & 3]);
+            }
+        }
+
+        abcd = vaddq_u32(abcd, abcd_in);
+        efgh = vaddq_u32(efgh, efgh_in);
+    }
+
+    vst1q_u32(state, abcd);
+    vst1q_u32(state + 4, efgh);
+}
+
+} // namespace
+
+Sha256Blocks sha256_blocks_armv8() {
+    return blocks_armv8;
+}
+
+#else
+
+Sha256Blocks sha256_blocks_armv8() {
+    return nullptr;
+}
+
+#endif
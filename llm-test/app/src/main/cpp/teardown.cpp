@@ -0,0 +1,122 @@
+/**
+ * Jeeves LLM Test Project - Post-unload teardown and self-check
+ */
+
+#include "teardown.h"
+
+#include <malloc.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "llama_log.h"
+#include "memory_stats.h"
+#include "model_registry.h"
+
+namespace {
+
+std::mutex g_mutex;
+size_t g_baseline_anon = 0;
+int g_baseline_threads = 0;
+TeardownReport g_last_report;
+std::atomic<long long> g_live_engines {0};
+
+void purge_allocator() {
+#if defined(__BIONIC__)
+    // M_PURGE_ALL (API 34) also releases the thread caches; older releases
+    // reject it and fall back to M_PURGE (API 28)
+    int purged = 0;
+#if defined(M_PURGE_ALL)
+    purged = mallopt(M_PURGE_ALL, 0);
+#endif
+#if defined(M_PURGE)
+    if (!purged) mallopt(M_PURGE, 0);
+#endif
+    (void)purged;
+#elif defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
+
+} // namespace
+
+void TeardownReport::to_array(long long out[COUNT]) const {
+    out[MODEL_MAPPED_BYTES] = static_cast<long long>(model_mapped_bytes);
+    out[REGISTRY_BYTES] = static_cast<long long>(registry_bytes);
+    out[LIVE_ENGINES] = live_engines;
+    out[ANON_FREED] = static_cast<long long>(anon_freed);
+    out[HEAP_TRIMMED] = static_cast<long long>(heap_trimmed);
+    out[RESIDUAL_ANON] = static_cast<long long>(residual_anon);
+    out[EXTRA_THREADS] = extra_threads;
+}
+
+void record_teardown_baseline() {
+    ProcessMemory mem;
+    read_process_memory(mem);
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_baseline_anon = mem.anonymous_bytes;
+    g_baseline_threads = read_thread_count();
+    LOGD("Teardown baseline: anon %zu bytes, %d threads", g_baseline_anon, g_baseline_threads);
+}
+
+void note_engine_created() {
+    g_live_engines++;
+}
+
+void note_engine_destroyed() {
+    g_live_engines--;
+}
+
+long long live_engine_count() {
+    return g_live_engines.load();
+}
+
+size_t trim_heap() {
+    ProcessMemory before, after;
+    read_process_memory(before);
+    purge_allocator();
+    read_process_memory(after);
+    return before.rss_bytes > after.rss_bytes ? before.rss_bytes - after.rss_bytes : 0;
+}
+
+TeardownReport finish_teardown(const std::string& model_path, size_t anon_before) {
+    TeardownReport report;
+    report.heap_trimmed = trim_heap();
+
+    ProcessMemory after;
+    read_process_memory(after);
+    report.anon_freed = anon_before > after.anonymous_bytes ? anon_before - after.anonymous_bytes : 0;
+
+    // A mapping of the model file is only a leak when nothing is meant to hold it
+    ModelRegistry& registry = ModelRegistry::instance();
+    if (!model_path.empty() && !registry.holds(model_path)) {
+        report.model_mapped_bytes = read_mapping_size(model_path);
+    }
+    report.registry_bytes = registry.stats().resident_bytes;
+    report.live_engines = g_live_engines.load();
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_baseline_threads > 0) {
+        // Anonymous memory includes the Java heap, so this is an upper bound
+        report.residual_anon = after.anonymous_bytes > g_baseline_anon ? after.anonymous_bytes - g_baseline_anon : 0;
+        report.extra_threads = read_thread_count() - g_baseline_threads;
+    }
+    g_last_report = report;
+
+    if (report.model_mapped_bytes > 0) {
+        LOGE("Teardown: %s still mapped (%zu bytes) with no registry reference",
+             model_path.c_str(), report.model_mapped_bytes);
+    }
+    if (report.live_engines == 0 && report.extra_threads > 0) {
+        LOGW("Teardown: %d threads above baseline with no live engine", report.extra_threads);
+    }
+    LOGI("Teardown: freed %zu anon bytes (heap trim %zu), residual %zu, registry %zu, live engines %lld",
+         report.anon_freed, report.heap_trimmed, report.residual_anon, report.registry_bytes,
+         report.live_engines);
+    return report;
+}
+
+TeardownReport last_teardown_report() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_last_report;
+}
@@ -0,0 +1,71 @@
+/**
+ * Jeeves LLM Test Project - Post-unload teardown and self-check
+ *
+ * Freeing the model and context is not enough for the process to shrink:
+ * the allocator keeps freed arenas, idle helper threads keep their stacks,
+ * and a missed reference keeps the model file mapped. After every unload the
+ * engine trims the heap and checks what is still held against the baseline
+ * taken at initBackend, so a backgrounded session can be verified to be back
+ * to app-only memory.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Result of the last teardown, flattened to a jlongArray in this order.
+ * Memory still held by the registry (shared with another engine, or cached
+ * within the model cache budget) is expected and reported separately from
+ * leftovers.
+ */
+struct TeardownReport {
+    enum Index {
+        MODEL_MAPPED_BYTES = 0,  // Unloaded model file still mapped although nothing holds it
+        REGISTRY_BYTES,          // Weights still held on purpose by ModelRegistry
+        LIVE_ENGINES,            // Handles not yet unloaded
+        ANON_FREED,              // Anonymous memory released by unload + heap trim
+        HEAP_TRIMMED,            // RSS returned by the heap trim alone
+        RESIDUAL_ANON,           // Anonymous memory above the pre-load baseline
+        EXTRA_THREADS,           // Threads above the pre-load baseline
+        COUNT
+    };
+
+    size_t model_mapped_bytes = 0;
+    size_t registry_bytes = 0;
+    long long live_engines = 0;
+    size_t anon_freed = 0;
+    size_t heap_trimmed = 0;
+    size_t residual_anon = 0;
+    int extra_threads = 0;
+
+    /** No leaked mapping, and no helper thread left behind once every engine is gone. */
+    bool clean() const { return model_mapped_bytes == 0 && (live_engines > 0 || extra_threads <= 0); }
+
+    void to_array(long long out[COUNT]) const;
+};
+
+/** Record process memory and thread count before any model is loaded. */
+void record_teardown_baseline();
+
+/** Engine handle bookkeeping, so the check knows whether anything is still live. */
+void note_engine_created();
+void note_engine_destroyed();
+long long live_engine_count();
+
+/**
+ * Return freed heap pages to the kernel (mallopt(M_PURGE*) on bionic,
+ * malloc_trim on glibc). Returns the measured RSS drop.
+ */
+size_t trim_heap();
+
+/**
+ * Trim the heap and check what is still held after [model_path] was unloaded
+ * (empty for a full backend cleanup). [anon_before] is the anonymous memory
+ * measured before the unload. The result is logged and kept as the last report.
+ */
+TeardownReport finish_teardown(const std::string& model_path, size_t anon_before);
+
+/** Most recent finish_teardown() result. */
+TeardownReport last_teardown_report();
@@ -0,0 +1,180 @@
+/**
+ * Jeeves LLM Test Project - Thermal- and throughput-aware thread control
+ */
+
+#include "thread_control.h"
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "llama_log.h"
+
+namespace {
+
+constexpr double SLOWDOWN_FACTOR = 1.25;
+constexpr double TARGET_TOLERANCE = 0.10;
+constexpr int THERMAL_HYSTERESIS_MC = 3000;
+
+// Zones that do not track SoC heat
+bool ignored_zone(const char* type) {
+    return strstr(type, "battery") || strstr(type, "charger") || strstr(type, "usb") || strstr(type, "pmic");
+}
+
+} // namespace
+
+// ============================================================================
+// Thermal zones
+// ============================================================================
+
+int read_max_thermal_mc(const std::string& root) {
+    DIR* dir = opendir(root.c_str());
+    if (!dir) return -1;
+
+    int hottest = -1;
+    while (dirent* entry = readdir(dir)) {
+        if (strncmp(entry->d_name, "thermal_zone", 12) != 0) continue;
+        std::string zone = root + "/" + entry->d_name;
+
+        char type[64] = {0};
+        if (FILE* f = fopen((zone + "/type").c_str(), "r")) {
+            if (!fgets(type, sizeof(type), f)) type[0] = '\0';
+            fclose(f);
+        }
+        if (ignored_zone(type)) continue;
+
+        FILE* f = fopen((zone + "/temp").c_str(), "r");
+        if (!f) continue;
+        int temp = 0;
+        bool ok = fscanf(f, "%d", &temp) == 1;
+        fclose(f);
+        if (!ok || temp <= 0) continue;
+        // A few drivers report whole degrees
+        if (temp < 200) temp *= 1000;
+        hottest = std::max(hottest, temp);
+    }
+    closedir(dir);
+    return hottest;
+}
+
+// ============================================================================
+// AdaptiveThreadController
+// ============================================================================
+
+AdaptiveThreadController::AdaptiveThreadController(const AdaptiveThreadConfig& config, int max_threads)
+    : config_(config),
+      max_threads_(std::max(1, max_threads)),
+      threads_(std::max(1, max_threads)) {
+    config_.min_threads = std::min(config_.min_threads, max_threads_);
+}
+
+bool AdaptiveThreadController::on_token(double decode_ms) {
+    threads_changed_ = false;
+    tokens_++;
+    window_ms_ += decode_ms;
+    if (++window_count_ >= config_.window_tokens) {
+        evaluate();
+        window_count_ = 0;
+        window_ms_ = 0.0;
+    }
+    // The caller sleeps pause_ms() before the next decode
+    total_pause_ms_ += pause_ms_;
+    return threads_changed_;
+}
+
+void AdaptiveThreadController::evaluate() {
+    const double window_ms = window_ms_ / window_count_;
+    const int temp_mc = config_.max_temp_c > 0.0f ? read_max_thermal_mc(config_.thermal_root) : -1;
+    last_temp_mc_ = temp_mc;
+
+    const int limit_mc = static_cast<int>(config_.max_temp_c * 1000.0f);
+    const bool hot = temp_mc >= 0 && limit_mc > 0 && temp_mc >= limit_mc;
+    const bool cool = temp_mc < 0 || limit_mc == 0 || temp_mc < limit_mc - THERMAL_HYSTERESIS_MC;
+
+    auto best = best_ms_.find(threads_);
+    const bool slowdown = best != best_ms_.end() && window_ms > best->second * SLOWDOWN_FACTOR;
+    if (best == best_ms_.end() || window_ms < best->second) best_ms_[threads_] = window_ms;
+
+    const double target = config_.target_tokens_per_sec;
+    const double achieved = 1000.0 / (window_ms + static_cast<double>(pause_ms_));
+    // Pause that brings this window's latency down to the target rate
+    const long long target_pause = target > 0.0
+        ? std::max(0LL, static_cast<long long>(1000.0 / target - window_ms)) : 0;
+
+    if (hot || slowdown) {
+        const int reason = hot ? THROTTLE_REASON_THERMAL : THROTTLE_REASON_SLOWDOWN;
+        if (threads_ > config_.min_threads) {
+            threads_--;
+            decide(THROTTLE_THREADS_DOWN, reason, window_ms, temp_mc);
+        } else if (pause_ms_ < config_.max_pause_ms) {
+            pause_ms_ = std::min(config_.max_pause_ms, std::max(pause_ms_ * 2, static_cast<long long>(window_ms / 4) + 1));
+            decide(THROTTLE_PAUSE_UP, reason, window_ms, temp_mc);
+        }
+    } else if (target > 0.0 && achieved > target * (1.0 + TARGET_TOLERANCE)) {
+        // Fewer threads cost less power than spinning then sleeping
+        if (threads_ > config_.min_threads) {
+            threads_--;
+            decide(THROTTLE_THREADS_DOWN, THROTTLE_REASON_ABOVE_TARGET, window_ms, temp_mc);
+        } else if (target_pause > pause_ms_) {
+            pause_ms_ = std::min(config_.max_pause_ms, target_pause);
+            decide(THROTTLE_PAUSE_UP, THROTTLE_REASON_ABOVE_TARGET, window_ms, temp_mc);
+        }
+    } else if (target > 0.0 && achieved < target * (1.0 - TARGET_TOLERANCE) && cool) {
+        if (pause_ms_ > 0) {
+            pause_ms_ = std::min(pause_ms_ - 1, target_pause);
+            decide(THROTTLE_PAUSE_DOWN, THROTTLE_REASON_BELOW_TARGET, window_ms, temp_mc);
+        } else if (threads_ < max_threads_) {
+            threads_++;
+            decide(THROTTLE_THREADS_UP, THROTTLE_REASON_BELOW_TARGET, window_ms, temp_mc);
+        }
+    } else if (target <= 0.0 && cool && temp_mc >= 0) {
+        // Only a readable, cooled-down zone justifies stepping back up
+        if (pause_ms_ > 0) {
+            pause_ms_ /= 2;
+            decide(THROTTLE_PAUSE_DOWN, THROTTLE_REASON_RECOVERED, window_ms, temp_mc);
+        } else if (threads_ < max_threads_) {
+            threads_++;
+            decide(THROTTLE_THREADS_UP, THROTTLE_REASON_RECOVERED, window_ms, temp_mc);
+        }
+    }
+}
+
+void AdaptiveThreadController::decide(int action, int reason, double window_ms, int temp_mc) {
+    ThrottleDecision d;
+    d.token = tokens_;
+    d.action = action;
+    d.reason = reason;
+    d.threads = threads_;
+    d.pause_ms = pause_ms_;
+    d.window_us_per_token = static_cast<long long>(window_ms * 1000.0);
+    d.temp_mc = temp_mc;
+    decisions_.push_back(d);
+    if (action == THROTTLE_THREADS_DOWN || action == THROTTLE_THREADS_UP) threads_changed_ = true;
+    LOGD("Thread control @%d: action %d reason %d -> %d threads, %lld ms pause (%.1f ms/token, %d mC)",
+         d.token, action, reason, threads_, pause_ms_, window_ms, temp_mc);
+}
+
+// ============================================================================
+// ThrottleReport
+// ============================================================================
+
+std::vector<long long> ThrottleReport::to_array() const {
+    std::vector<long long> out;
+    out.reserve(4 + decisions.size() * ThrottleDecision::FIELDS);
+    out.push_back(static_cast<long long>(decisions.size()));
+    out.push_back(final_threads);
+    out.push_back(total_pause_ms);
+    out.push_back(last_temp_mc);
+    for (const ThrottleDecision& d : decisions) {
+        out.push_back(d.token);
+        out.push_back(d.action);
+        out.push_back(d.reason);
+        out.push_back(d.threads);
+        out.push_back(d.pause_ms);
+        out.push_back(d.window_us_per_token);
+        out.push_back(d.temp_mc);
+    }
+    return out;
+}
@@ -0,0 +1,118 @@
+/**
+ * Jeeves LLM Test Project - Thermal- and throughput-aware thread control
+ *
+ * A long briefing keeps every inference thread busy for seconds; the SoC
+ * heats up, clocks drop and tokens/s degrades while power stays high. The
+ * controller watches decode latency per window of tokens (and thermal zones
+ * when readable) and steps the generate thread count down, or inserts
+ * duty-cycle pauses once at the minimum, to hold a target tokens/s or stay
+ * under a temperature limit. It steps back up when there is headroom. Every
+ * step is recorded so the request's metrics show why it ran as it did.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+constexpr const char* DEFAULT_THERMAL_SYSFS_ROOT = "/sys/class/thermal";
+
+struct AdaptiveThreadConfig {
+    bool enabled = false;
+    float target_tokens_per_sec = 0.0f;   // 0 = as fast as thermals allow
+    float max_temp_c = 0.0f;              // 0 = ignore thermal zones
+    int min_threads = 1;
+    int window_tokens = 8;                // Tokens per evaluation
+    long long max_pause_ms = 200;         // Upper bound on the per-token pause
+    std::string thermal_root = DEFAULT_THERMAL_SYSFS_ROOT;
+
+    bool valid() const {
+        return target_tokens_per_sec >= 0.0f && max_temp_c >= 0.0f && min_threads >= 1
+            && window_tokens >= 1 && max_pause_ms >= 0;
+    }
+};
+
+/** Values mirror LlamaEngine.ThrottleDecision on the Kotlin side. */
+enum ThrottleAction : int {
+    THROTTLE_THREADS_DOWN = 1,
+    THROTTLE_THREADS_UP = 2,
+    THROTTLE_PAUSE_UP = 3,
+    THROTTLE_PAUSE_DOWN = 4,
+};
+
+enum ThrottleReason : int {
+    THROTTLE_REASON_THERMAL = 1,       // Zone temperature at or above max_temp_c
+    THROTTLE_REASON_SLOWDOWN = 2,      // Latency 25% above the best seen at this thread count
+    THROTTLE_REASON_ABOVE_TARGET = 3,  // Faster than needed; spend less power
+    THROTTLE_REASON_BELOW_TARGET = 4,
+    THROTTLE_REASON_RECOVERED = 5,     // Cooled down / latency back to normal
+};
+
+struct ThrottleDecision {
+    static constexpr int FIELDS = 7;
+
+    int token = 0;              // Generated-token index the decision applies from
+    int action = 0;
+    int reason = 0;
+    int threads = 0;            // After the decision
+    long long pause_ms = 0;     // After the decision
+    long long window_us_per_token = 0;
+    int temp_mc = -1;           // Hottest matching zone in milli-degrees C, -1 = unreadable
+};
+
+/**
+ * Per-request controller. Feed it every decode latency; apply threads() and
+ * sleep pause_ms() between tokens.
+ */
+class AdaptiveThreadController {
+public:
+    AdaptiveThreadController(const AdaptiveThreadConfig& config, int max_threads);
+
+    /** Record one generated token. Returns true when threads() changed. */
+    bool on_token(double decode_ms);
+
+    int threads() const { return threads_; }
+    long long pause_ms() const { return pause_ms_; }
+    long long total_pause_ms() const { return total_pause_ms_; }
+    int last_temp_mc() const { return last_temp_mc_; }
+    const std::vector<ThrottleDecision>& decisions() const { return decisions_; }
+
+private:
+    void evaluate();
+    void decide(int action, int reason, double window_ms, int temp_mc);
+
+    AdaptiveThreadConfig config_;
+    int max_threads_;
+    int threads_;
+    long long pause_ms_ = 0;
+    long long total_pause_ms_ = 0;
+    int last_temp_mc_ = -1;
+
+    int tokens_ = 0;
+    int window_count_ = 0;
+    double window_ms_ = 0.0;
+    std::map<int, double> best_ms_;   // Best window latency per thread count
+    bool threads_changed_ = false;
+    std::vector<ThrottleDecision> decisions_;
+};
+
+/**
+ * Hottest CPU/SoC/skin thermal zone under [root] in milli-degrees C, or -1
+ * when none is readable (SELinux blocks most zones for apps on some devices).
+ */
+int read_max_thermal_mc(const std::string& root = DEFAULT_THERMAL_SYSFS_ROOT);
+
+/**
+ * What the controller did during the last request, flattened for JNI as
+ * [count, final_threads, total_pause_ms, last_temp_mc, then per decision:
+ * token, action, reason, threads, pause_ms, window_us_per_token, temp_mc].
+ */
+struct ThrottleReport {
+    int final_threads = 0;
+    long long total_pause_ms = 0;
+    int last_temp_mc = -1;
+    std::vector<ThrottleDecision> decisions;
+
+    std::vector<long long> to_array() const;
+};
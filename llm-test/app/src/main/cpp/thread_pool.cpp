@@ -0,0 +1,323 @@
+/**
+ * Jeeves LLM Test Project - Shared ggml threadpool
+ */
+
+#include "thread_pool.h"
+
+void ThreadPoolStats::to_array(long long out[COUNT]) const {
+    out[THREADS] = n_threads;
+    out[THREADS_BATCH] = n_threads_batch;
+    out[POLL] = poll;
+    out[ATTACHED_CONTEXTS] = attached_contexts;
+    out[DECODES] = decodes;
+    out[CONTENDED_DECODES] = contended_decodes;
+    out[WAIT_MS] = wait_ms;
+    out[CPU_POLICY] = cpu_policy;
+    out[PINNED_CPUS] = pinned_cpus;
+    out[BACKGROUND_THREADS] = background_threads;
+    out[BACKGROUND_DECODES] = background_decodes;
+    out[BACKGROUND_YIELD_MS] = background_yield_ms;
+    out[BACKGROUND_PAUSED] = background_paused ? 1 : 0;
+}
+
+#if LLAMA_AVAILABLE
+
+#include <algorithm>
+#include <chrono>
+
+#include "cpu_backend.h"
+#include "llama_log.h"
+
+namespace {
+
+ggml_threadpool* new_pool(int n_threads, int poll, const std::vector<int>& cpus,
+                          ggml_sched_priority prio = GGML_SCHED_PRIO_NORMAL) {
+    ggml_threadpool_params params = ggml_threadpool_params_default(n_threads);
+    params.poll = static_cast<uint32_t>(poll);
+    params.prio = prio;
+    // Every worker may use any allowed core; the scheduler balances within the set
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < GGML_MAX_N_THREADS) params.cpumask[cpu] = true;
+    }
+    params.strict_cpu = false;
+    // Workers start parked; the first graph compute resumes them
+    params.paused = true;
+    return cpu_threadpool_new(&params);
+}
+
+int pool_threads(const ggml_threadpool* pool) {
+    return pool ? cpu_threadpool_get_n_threads(pool) : 0;
+}
+
+// Generate and prompt pool sizes for [config]; equal sizes mean one shared pool
+void pool_sizes(const ThreadPoolConfig& config, int& n_threads, int& n_threads_batch) {
+    n_threads = config.n_threads;
+    n_threads_batch = config.n_threads_batch > 0 ? config.n_threads_batch : n_threads;
+    if (!config.separate_batch_pool) {
+        // One pool serves both phases, so it must fit the larger
+        n_threads = n_threads_batch = std::max(n_threads, n_threads_batch);
+    }
+}
+
+} // namespace
+
+SharedThreadPools& SharedThreadPools::instance() {
+    static SharedThreadPools pools;
+    return pools;
+}
+
+SharedThreadPools::~SharedThreadPools() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_pools_locked();
+}
+
+bool SharedThreadPools::configure(const ThreadPoolConfig& config) {
+    if (!config.valid()) return false;
+    std::lock_guard<std::mutex> compute_lock(compute_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+
+    // Automatic sizes keep what the attached contexts already needed
+    ThreadPoolConfig wanted = config;
+    if (wanted.n_threads == 0) wanted.n_threads = pool_threads(pool_);
+    if (wanted.n_threads_batch == 0 && batch_pool_) wanted.n_threads_batch = pool_threads(batch_pool_);
+    if (wanted.n_threads == 0) {
+        // Nothing to size against yet; built on the next attach
+        for (llama_context* ctx : attached_) llama_detach_threadpool(ctx);
+        free_pools_locked();
+        return true;
+    }
+    return rebuild_locked(wanted);
+}
+
+void SharedThreadPools::attach(llama_context* ctx) {
+    std::lock_guard<std::mutex> compute_lock(compute_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Pools sized automatically grow to the largest context; explicit sizes
+    // are kept and ggml clamps a context asking for more
+    ThreadPoolConfig wanted = config_;
+    const int current = pool_threads(pool_);
+    const int current_batch = batch_pool_ ? pool_threads(batch_pool_) : current;
+    if (config_.n_threads == 0) wanted.n_threads = std::max(current, static_cast<int>(llama_n_threads(ctx)));
+    if (config_.n_threads_batch == 0) {
+        wanted.n_threads_batch = std::max(current_batch, static_cast<int>(llama_n_threads_batch(ctx)));
+    }
+
+    int n_threads, n_threads_batch;
+    pool_sizes(wanted, n_threads, n_threads_batch);
+    if (!pool_ || n_threads != current || n_threads_batch != current_batch) {
+        rebuild_locked(wanted);
+    }
+    attach_locked(ctx);
+    attached_.insert(ctx);
+}
+
+void SharedThreadPools::detach(llama_context* ctx) {
+    std::lock_guard<std::mutex> compute_lock(compute_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (attached_.erase(ctx)) llama_detach_threadpool(ctx);
+}
+
+int32_t SharedThreadPools::decode_interactive(llama_context* ctx, const llama_batch& batch) {
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> compute_lock(compute_mutex_, std::try_to_lock);
+    bool contended = !compute_lock.owns_lock();
+    if (contended) compute_lock.lock();
+    long long waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        decodes_++;
+        if (contended) contended_decodes_++;
+        wait_ms_ += waited;
+    }
+    return llama_decode(ctx, batch);
+}
+
+int32_t SharedThreadPools::decode_exclusive(llama_context* ctx, const llama_batch& batch, double& compute_s) {
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> compute_lock(compute_mutex_);
+    auto locked = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        decodes_++;
+        wait_ms_ += std::chrono::duration_cast<std::chrono::milliseconds>(locked - start).count();
+    }
+    int32_t result = llama_decode(ctx, batch);
+    compute_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - locked).count();
+    return result;
+}
+
+int32_t SharedThreadPools::decode(llama_context* ctx, const llama_batch& batch, int qos) {
+    if (qos != QOS_BACKGROUND) return decode_interactive(ctx, batch);
+
+    std::lock_guard<std::mutex> compute_lock(compute_mutex_);
+    ggml_threadpool* pool;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        decodes_++;
+        background_decodes_++;
+        pool = background_pool_locked();
+        if (pool) llama_attach_threadpool(ctx, pool, pool);
+    }
+    int32_t result = llama_decode(ctx, batch);
+    if (pool) {
+        // Back on the shared pools for the context's next interactive request
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pool_ && attached_.count(ctx)) {
+            attach_locked(ctx);
+        } else {
+            llama_detach_threadpool(ctx);
+        }
+    }
+    return result;
+}
+
+void SharedThreadPools::begin_request(int qos) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_requests_++;
+    if (qos != QOS_BACKGROUND) interactive_requests_++;
+}
+
+void SharedThreadPools::end_request(int qos) {
+    std::lock_guard<std::mutex> compute_lock(compute_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (qos != QOS_BACKGROUND && --interactive_requests_ <= 0) {
+        interactive_requests_ = 0;
+        background_cv_.notify_all();
+    }
+    if (--active_requests_ > 0) return;
+    active_requests_ = 0;
+    // Park the workers instead of letting them spin out their poll budget
+    if (pool_) cpu_threadpool_pause(pool_);
+    if (batch_pool_) cpu_threadpool_pause(batch_pool_);
+    if (background_pool_) cpu_threadpool_pause(background_pool_);
+}
+
+void SharedThreadPools::set_background_paused(bool paused) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (background_paused_ == paused) return;
+    background_paused_ = paused;
+    LOGI("Background inference %s", paused ? "paused" : "resumed");
+    if (!paused) background_cv_.notify_all();
+}
+
+bool SharedThreadPools::background_must_yield() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return interactive_requests_ > 0 || background_paused_;
+}
+
+void SharedThreadPools::wait_for_background_turn() {
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    background_cv_.wait(lock, [this] { return interactive_requests_ == 0 && !background_paused_; });
+    background_yield_ms_ += std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+int SharedThreadPools::background_threads() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return background_threads_locked();
+}
+
+void SharedThreadPools::shutdown() {
+    std::lock_guard<std::mutex> compute_lock(compute_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!attached_.empty()) {
+        LOGW("Threadpool shutdown skipped: %zu contexts attached", attached_.size());
+        return;
+    }
+    free_pools_locked();
+}
+
+ThreadPoolStats SharedThreadPools::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ThreadPoolStats s;
+    s.n_threads = pool_threads(pool_);
+    s.n_threads_batch = pool_threads(batch_pool_);
+    s.poll = config_.poll;
+    s.attached_contexts = static_cast<int>(attached_.size());
+    s.decodes = decodes_;
+    s.contended_decodes = contended_decodes_;
+    s.wait_ms = wait_ms_;
+    s.cpu_policy = config_.cpu_policy;
+    s.pinned_cpus = static_cast<int>(cpus_.size());
+    s.background_threads = pool_threads(background_pool_);
+    s.background_decodes = background_decodes_;
+    s.background_yield_ms = background_yield_ms_;
+    s.background_paused = background_paused_;
+    return s;
+}
+
+std::vector<int> SharedThreadPools::pinned_cpus(int qos) {
+    if (qos == QOS_BACKGROUND) return system_cpu_topology().cpus_for_policy(CPU_POLICY_EFFICIENCY);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cpus_;
+}
+
+bool SharedThreadPools::rebuild_locked(const ThreadPoolConfig& config) {
+    for (llama_context* ctx : attached_) llama_detach_threadpool(ctx);
+    free_pools_locked();
+
+    cpus_ = system_cpu_topology().cpus_for_policy(config.cpu_policy);
+    int n_threads, n_threads_batch;
+    pool_sizes(config, n_threads, n_threads_batch);
+    if (n_threads > 0) {
+        pool_ = new_pool(n_threads, config.poll, cpus_);
+        if (pool_ && n_threads_batch != n_threads) {
+            batch_pool_ = new_pool(n_threads_batch, config.poll, cpus_);
+        }
+    }
+
+    if (!pool_ || (n_threads_batch != n_threads && !batch_pool_)) {
+        LOGE("Threadpool creation failed (%d / %d threads) - contexts fall back to per-decode threads",
+             n_threads, n_threads_batch);
+        free_pools_locked();
+        return false;
+    }
+
+    for (llama_context* ctx : attached_) attach_locked(ctx);
+    LOGI("Threadpool: %d generate threads, %d prompt threads%s, poll %d, pinned to %zu cores",
+         n_threads, n_threads_batch, batch_pool_ ? "" : " (shared)", config.poll, cpus_.size());
+    return true;
+}
+
+void SharedThreadPools::free_pools_locked() {
+    if (background_pool_) cpu_threadpool_free(background_pool_);
+    if (batch_pool_) cpu_threadpool_free(batch_pool_);
+    if (pool_) cpu_threadpool_free(pool_);
+    background_pool_ = nullptr;
+    batch_pool_ = nullptr;
+    pool_ = nullptr;
+}
+
+void SharedThreadPools::attach_locked(llama_context* ctx) {
+    if (!pool_) return;
+    llama_attach_threadpool(ctx, pool_, batch_pool_ ? batch_pool_ : pool_);
+}
+
+int SharedThreadPools::background_threads_locked() const {
+    // The efficiency cluster; half the generate pool on single-cluster devices
+    int n = static_cast<int>(system_cpu_topology().cpus_for_policy(CPU_POLICY_EFFICIENCY).size());
+    if (n == 0) n = std::max(1, pool_threads(pool_) / 2);
+    return n;
+}
+
+ggml_threadpool* SharedThreadPools::background_pool_locked() {
+    if (!background_pool_) {
+        const int n_threads = background_threads_locked();
+        // No spinning: background tokens are not latency sensitive
+        background_pool_ = new_pool(n_threads, 0, system_cpu_topology().cpus_for_policy(CPU_POLICY_EFFICIENCY),
+                                    GGML_SCHED_PRIO_LOW);
+        if (background_pool_) {
+            LOGI("Background threadpool: %d low-priority threads", n_threads);
+        } else {
+            LOGW("Background threadpool creation failed - background decodes use per-decode threads");
+        }
+    }
+    return background_pool_;
+}
+
+#endif // LLAMA_AVAILABLE
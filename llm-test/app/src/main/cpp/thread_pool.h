@@ -0,0 +1,220 @@
+/**
+ * Jeeves LLM Test Project - Shared ggml threadpool
+ *
+ * Without an attached threadpool ggml starts and joins its workers on every
+ * graph compute, and each context sizes its own worker set, so two contexts
+ * decoding at once put twice the threads on the same cores. Every context
+ * attaches to one process-wide pair of pools instead: a generate pool and an
+ * optional separate prompt (batch) pool. Decodes are serialized on the pools,
+ * workers stay hot between tokens (spinning up to the configured poll level)
+ * and the pools are paused when no request is running so idle workers do not
+ * burn CPU.
+ *
+ * Background requests (briefing prefetch, workers) run on a third, smaller
+ * pool pinned to the efficiency cores at low priority with no spinning. They
+ * yield between decodes while an interactive request is running or waiting
+ * for its engine, or background work is paused, so they never compete with
+ * quick capture. Yielding hands the engine back (see run_generate), so an
+ * interactive request on the same engine is not stuck behind them.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "cpu_topology.h"
+
+/** Values mirror LlamaEngine.Qos on the Kotlin side. */
+enum RequestQos : int {
+    QOS_INTERACTIVE = 0,
+    QOS_BACKGROUND = 1,   // Efficiency cores, fewer threads, low priority, yields to interactive
+};
+
+// Nice value for threads serving background requests (THREAD_PRIORITY_BACKGROUND).
+// Not SCHED_IDLE: a starved thread holding the pools would stall interactive decodes.
+constexpr int BACKGROUND_NICE = 10;
+
+inline bool valid_qos(int qos) { return qos == QOS_INTERACTIVE || qos == QOS_BACKGROUND; }
+
+/** Values mirror LlamaEngine.ThreadPoolConfig on the Kotlin side. */
+struct ThreadPoolConfig {
+    int n_threads = 0;          // Generate pool size; 0 = size to the first context
+    int n_threads_batch = 0;    // Prompt pool size; 0 = same as n_threads
+    int poll = 50;              // 0 = sleep immediately, 100 = spin longest before sleeping
+    bool separate_batch_pool = true;
+    int cpu_policy = CPU_POLICY_PERFORMANCE;
+
+    bool valid() const {
+        return n_threads >= 0 && n_threads_batch >= 0 && poll >= 0 && poll <= 100
+            && valid_cpu_policy(cpu_policy);
+    }
+};
+
+/**
+ * Snapshot for metrics, flattened to a jlongArray in this order.
+ */
+struct ThreadPoolStats {
+    enum Index {
+        THREADS = 0,
+        THREADS_BATCH,      // 0 when prompts share the generate pool
+        POLL,
+        ATTACHED_CONTEXTS,
+        DECODES,
+        CONTENDED_DECODES,  // Decodes that waited for another context
+        WAIT_MS,            // Total time decodes waited for the pools
+        CPU_POLICY,
+        PINNED_CPUS,        // Cores the pools are pinned to, 0 = unpinned
+        BACKGROUND_THREADS, // Background pool size, 0 = not built yet
+        BACKGROUND_DECODES,
+        BACKGROUND_YIELD_MS, // Time background decodes waited for interactive work or a pause
+        BACKGROUND_PAUSED,
+        COUNT
+    };
+
+    int n_threads = 0;
+    int n_threads_batch = 0;
+    int poll = 0;
+    int attached_contexts = 0;
+    long long decodes = 0;
+    long long contended_decodes = 0;
+    long long wait_ms = 0;
+    int cpu_policy = CPU_POLICY_ALL;
+    int pinned_cpus = 0;
+    int background_threads = 0;
+    long long background_decodes = 0;
+    long long background_yield_ms = 0;
+    bool background_paused = false;
+
+    void to_array(long long out[COUNT]) const;
+};
+
+#if LLAMA_AVAILABLE
+
+#include <condition_variable>
+#include <mutex>
+#include <unordered_set>
+
+#include "llama.h"
+#include "ggml-cpu.h"
+
+class SharedThreadPools {
+public:
+    static SharedThreadPools& instance();
+
+    /**
+     * Replace the pools with ones built from [config]. Attached contexts are
+     * moved to the new pools. Returns false if the pools cannot be created.
+     */
+    bool configure(const ThreadPoolConfig& config);
+
+    /**
+     * Attach [ctx] to the shared pools, creating or growing them so the
+     * context's n_threads / n_threads_batch fit.
+     */
+    void attach(llama_context* ctx);
+    void detach(llama_context* ctx);
+
+    /**
+     * llama_decode on the shared pools, serialized with every other context.
+     * A background decode runs on the background pool; the caller yields to
+     * interactive work before it (background_must_yield).
+     */
+    int32_t decode(llama_context* ctx, const llama_batch& batch, int qos = QOS_INTERACTIVE);
+
+    /**
+     * llama_decode on the threadpools [ctx] brought itself (autotune trials
+     * measure pool sizes the shared pools do not have), serialized with the
+     * shared pools all the same. [compute_s] gets the decode time without
+     * the wait for the other contexts.
+     */
+    int32_t decode_exclusive(llama_context* ctx, const llama_batch& batch, double& compute_s);
+
+    /** Mark a request running; the pools are paused when the last one ends. */
+    void begin_request(int qos = QOS_INTERACTIVE);
+    void end_request(int qos = QOS_INTERACTIVE);
+
+    /** Hold background decodes before their next token until resumed. */
+    void set_background_paused(bool paused);
+
+    /** True while an interactive request is active or background work is paused. */
+    bool background_must_yield();
+
+    /**
+     * Block until background_must_yield() is false. Callers hold no engine
+     * while waiting; the wait counts towards BACKGROUND_YIELD_MS.
+     */
+    void wait_for_background_turn();
+
+    /** Thread count background requests run with. */
+    int background_threads();
+
+    /** Cores the pools for [qos] (and threads calling decode) are pinned to; empty = unpinned. */
+    std::vector<int> pinned_cpus(int qos = QOS_INTERACTIVE);
+
+    /** Free the pools and join their workers. Only valid with nothing attached. */
+    void shutdown();
+
+    ThreadPoolStats stats();
+
+    ~SharedThreadPools();
+
+private:
+    SharedThreadPools() = default;
+
+    bool rebuild_locked(const ThreadPoolConfig& config);
+    void free_pools_locked();
+    void attach_locked(llama_context* ctx);
+    int32_t decode_interactive(llama_context* ctx, const llama_batch& batch);
+    int background_threads_locked() const;
+    ggml_threadpool* background_pool_locked();
+
+    // Lock order: compute_mutex_ before mutex_. compute_mutex_ is held for a
+    // whole llama_decode; mutex_ only guards the fields below.
+    std::mutex compute_mutex_;
+    std::mutex mutex_;
+    ThreadPoolConfig config_;
+    ggml_threadpool* pool_ = nullptr;
+    ggml_threadpool* batch_pool_ = nullptr;   // nullptr = prompts use pool_
+    ggml_threadpool* background_pool_ = nullptr;   // Built on the first background decode
+    std::unordered_set<llama_context*> attached_;
+    std::vector<int> cpus_;
+    int active_requests_ = 0;
+    int interactive_requests_ = 0;
+    bool background_paused_ = false;
+    std::condition_variable background_cv_;   // Signalled under mutex_
+
+    long long decodes_ = 0;
+    long long contended_decodes_ = 0;
+    long long wait_ms_ = 0;
+    long long background_decodes_ = 0;
+    long long background_yield_ms_ = 0;
+};
+
+/**
+ * RAII begin_request / end_request for one nativeGenerate call. The calling
+ * thread joins every graph compute, so it is pinned like the workers (and for
+ * background requests deprioritized like them) for the duration of the request.
+ * Interactive requests begin before waiting for their engine, so background
+ * work on that engine sees them and yields it.
+ */
+class ThreadPoolRequest {
+public:
+    explicit ThreadPoolRequest(int qos = QOS_INTERACTIVE)
+        : qos_(qos),
+          affinity_(SharedThreadPools::instance().pinned_cpus(qos)),
+          priority_(qos == QOS_BACKGROUND ? BACKGROUND_NICE : 0) {
+        SharedThreadPools::instance().begin_request(qos_);
+    }
+    ~ThreadPoolRequest() { SharedThreadPools::instance().end_request(qos_); }
+
+    ThreadPoolRequest(const ThreadPoolRequest&) = delete;
+    ThreadPoolRequest& operator=(const ThreadPoolRequest&) = delete;
+
+private:
+    int qos_;
+    ScopedCpuAffinity affinity_;
+    ScopedThreadPriority priority_;
+};
+
+#endif // LLAMA_AVAILABLE
@@ -53,7 +53,6 @@ class LlmBenchmark(
      * Run complete benchmark suite.
      */
     suspend fun runFullBenchmark(modelPath: String? = null): BenchmarkReport = withContext(Dispatchers.IO) {
-        val deviceInfo = collectDeviceInfo()
         val benchmarkResults = mutableListOf<BenchmarkResult>()
         
         // Load model
@@ -63,6 +62,8 @@ class LlmBenchmark(
             // Use stub for testing
             llamaEngine.loadStubModel()
         }
+        // After the load, which selects the CPU backend
+        val deviceInfo = collectDeviceInfo()
         
         if (!loadResult.success) {
             return@withContext BenchmarkReport(
@@ -188,10 +189,23 @@ class LlmBenchmark(
             cpuAbi = Build.SUPPORTED_ABIS.firstOrNull() ?: "unknown",
             totalMemoryMb = runtime.maxMemory() / (1024 * 1024),
             availableMemoryMb = runtime.freeMemory() / (1024 * 1024),
-            cpuCores = runtime.availableProcessors()
+            cpuCores = runtime.availableProcessors(),
+            cpuBackend = llamaEngine.getCpuBackend().variant.name.lowercase(),
+            nativeBuild = llamaEngine.getNativeBuildProfile(),
+            nativeLibraryBytes = nativeLibraryBytes(),
+            libraryLoadTimeMs = LlamaEngine.libraryLoadTimeMs + llamaEngine.getCpuBackend().loadTimeMs
         )
     }
     
+    /**
+     * Size of the extracted llama_jni and ggml libraries; 0 when they are
+     * mapped straight from the APK (extractNativeLibs=false).
+     */
+    private fun nativeLibraryBytes(): Long =
+        File(context.applicationInfo.nativeLibraryDir)
+            .listFiles { file -> file.name.startsWith("libllama") || file.name.startsWith("libggml") }
+            ?.sumOf { it.length() } ?: 0L
+    
     private fun calculateStdDev(values: List<Long>): Double {
         if (values.isEmpty()) return 0.0
         val mean = values.average()
@@ -215,7 +229,14 @@ data class DeviceInfo(
     val cpuAbi: String,
     val totalMemoryMb: Long,
     val availableMemoryMb: Long,
-    val cpuCores: Int
+    val cpuCores: Int,
+    /** ggml CPU backend variant, e.g. "dotprod". */
+    val cpuBackend: String,
+    /** Native build configuration, e.g. "Release+lto+pgo". */
+    val nativeBuild: String,
+    val nativeLibraryBytes: Long,
+    /** loadLibrary plus CPU backend variant load. */
+    val libraryLoadTimeMs: Long
 )
 
 data class ModelInfo(
@@ -260,6 +281,9 @@ data class BenchmarkReport(
         appendLine("|----------|-------|")
         appendLine("| Device | ${deviceInfo.manufacturer} ${deviceInfo.model} |")
         appendLine("| CPU | ${deviceInfo.cpuCores} cores (${deviceInfo.cpuAbi}) |")
+        appendLine("| CPU Backend | ${deviceInfo.cpuBackend} |")
+        appendLine("| Native Build | ${deviceInfo.nativeBuild} |")
+        appendLine("| Native Libraries | ${deviceInfo.nativeLibraryBytes / 1_000} KB, loaded in ${deviceInfo.libraryLoadTimeMs} ms |")
         appendLine("| RAM | ${deviceInfo.totalMemoryMb} MB total |")
         appendLine("| Android | API ${deviceInfo.sdkVersion} |")
         appendLine()
@@ -0,0 +1,102 @@
+/**
+ * Jeeves LLM Test Project - Tuned configuration host tests
+ */
+
+#include "autotune.h"
+#include "context_options.h"
+#include "test_support.h"
+
+namespace {
+
+/** Options as nativeLoadModel builds them when Kotlin sets nothing. */
+ContextOptions unset_options() {
+    ContextOptions options;
+    options.n_threads = 0;
+    options.n_threads_batch = 0;
+    options.n_batch = 0;
+    options.n_ubatch = 0;
+    options.type_k = 0;
+    options.type_v = 0;
+    return options;
+}
+
+TunedConfig tuned_config() {
+    TunedConfig tuned;
+    tuned.n_threads = 3;
+    tuned.n_threads_batch = 6;
+    tuned.n_batch = 256;
+    tuned.n_ubatch = 128;
+    tuned.type_k = KV_CACHE_Q8_0;
+    tuned.type_v = KV_CACHE_Q8_0;
+    return tuned;
+}
+
+} // namespace
+
+TEST(tuned_values_fill_unset_fields) {
+    ContextOptions options = unset_options();
+    tuned_config().apply(options);
+    options.fill_unset(4);
+    CHECK(options.n_threads == 3);
+    CHECK(options.n_threads_batch == 6);
+    CHECK(options.n_batch == 256);
+    CHECK(options.n_ubatch == 128);
+    CHECK(options.type_k == KV_CACHE_Q8_0);
+    CHECK(options.type_v == KV_CACHE_Q8_0);
+    std::string error;
+    CHECK(options.validate(error));
+}
+
+TEST(explicit_settings_win_over_tuned_values) {
+    ContextOptions options = unset_options();
+    options.n_threads = 2;
+    options.n_batch = 512;
+    options.type_k = KV_CACHE_F16;
+    tuned_config().apply(options);
+    options.fill_unset(4);
+    CHECK(options.n_threads == 2);
+    CHECK(options.n_threads_batch == 6);
+    // Pairs are only taken whole, so the explicit half keeps the other at its default
+    CHECK(options.n_batch == 512);
+    CHECK(options.n_ubatch == 512);
+    CHECK(options.type_k == KV_CACHE_F16);
+    CHECK(options.type_v == KV_CACHE_F16);
+}
+
+TEST(quantized_v_is_not_applied_without_flash_attention) {
+    ContextOptions options = unset_options();
+    options.flash_attn = FLASH_ATTN_DISABLED;
+    tuned_config().apply(options);
+    options.fill_unset(4);
+    CHECK(options.type_v == KV_CACHE_F16);
+    std::string error;
+    CHECK(options.validate(error));
+}
+
+TEST(fill_unset_uses_defaults) {
+    ContextOptions options = unset_options();
+    options.fill_unset(0);
+    const ContextOptions defaults;
+    CHECK(options.n_threads == defaults.n_threads);
+    CHECK(options.n_threads_batch == 0);
+    CHECK(options.n_batch == defaults.n_batch);
+    CHECK(options.n_ubatch == defaults.n_ubatch);
+    CHECK(options.type_k == defaults.type_k);
+    CHECK(options.type_v == defaults.type_v);
+
+    // An explicit ubatch larger than the default batch grows the batch with it
+    options = unset_options();
+    options.n_ubatch = 1024;
+    options.fill_unset(6);
+    CHECK(options.n_threads == 6);
+    CHECK(options.n_batch == 1024);
+    std::string error;
+    CHECK(options.validate(error));
+
+    options = unset_options();
+    options.n_batch = 128;
+    options.fill_unset(6);
+    CHECK(options.n_ubatch == 128);
+}
+
+TEST_MAIN()
@@ -0,0 +1,75 @@
+/**
+ * Jeeves LLM Test Project - CPU backend variant selection host tests
+ */
+
+#include <string>
+
+#include "cpu_backend.h"
+#include "device_probe.h"
+#include "test_support.h"
+
+#if defined(__x86_64__)
+
+TEST(best_x86_variant_the_cpu_supports_is_selected) {
+    CHECK(select_cpu_variant(0) == CPU_VARIANT_X86_64);
+    CHECK(select_cpu_variant(CPU_FEATURE_AVX2) == CPU_VARIANT_AVX2);
+    CHECK(select_cpu_variant(CPU_FEATURE_AVX2 | CPU_FEATURE_AVX512) == CPU_VARIANT_AVX512);
+    // The avx512 module also needs AVX2
+    CHECK(select_cpu_variant(CPU_FEATURE_AVX512) == CPU_VARIANT_X86_64);
+    // ARM bits never pick an x86 module
+    CHECK(select_cpu_variant(CPU_FEATURE_DOTPROD | CPU_FEATURE_I8MM) == CPU_VARIANT_X86_64);
+}
+
+TEST(x86_variant_features_match_the_modules) {
+    CHECK(cpu_variant_features(CPU_VARIANT_X86_64) == 0);
+    CHECK(cpu_variant_features(CPU_VARIANT_AVX2) == CPU_FEATURE_AVX2);
+    CHECK(cpu_variant_features(CPU_VARIANT_AVX512) == (CPU_FEATURE_AVX2 | CPU_FEATURE_AVX512));
+    CHECK(cpu_variant_features(CPU_VARIANT_SVE) == 0);
+}
+
+#else
+
+TEST(best_arm_variant_the_cpu_supports_is_selected) {
+    const int dotprod = CPU_FEATURE_DOTPROD | CPU_FEATURE_FP16;
+    CHECK(select_cpu_variant(0) == CPU_VARIANT_ARMV8);
+    // dotprod without fp16 arithmetic is still the baseline
+    CHECK(select_cpu_variant(CPU_FEATURE_DOTPROD) == CPU_VARIANT_ARMV8);
+    CHECK(select_cpu_variant(dotprod) == CPU_VARIANT_DOTPROD);
+    CHECK(select_cpu_variant(dotprod | CPU_FEATURE_I8MM) == CPU_VARIANT_I8MM);
+    CHECK(select_cpu_variant(dotprod | CPU_FEATURE_I8MM | CPU_FEATURE_SVE) == CPU_VARIANT_SVE);
+    // SVE without i8mm does not skip a level
+    CHECK(select_cpu_variant(dotprod | CPU_FEATURE_SVE) == CPU_VARIANT_DOTPROD);
+}
+
+TEST(arm_variant_features_match_the_modules) {
+    CHECK(cpu_variant_features(CPU_VARIANT_ARMV8) == 0);
+    CHECK(cpu_variant_features(CPU_VARIANT_I8MM) == (CPU_FEATURE_DOTPROD | CPU_FEATURE_FP16 | CPU_FEATURE_I8MM));
+    CHECK(cpu_variant_features(CPU_VARIANT_AVX2) == 0);
+}
+
+#endif
+
+TEST(variant_selected_for_this_cpu_is_supported) {
+    const int features = detect_cpu_features();
+    const int variant = select_cpu_variant(features);
+    CHECK((features & cpu_variant_features(variant)) == cpu_variant_features(variant));
+}
+
+TEST(static_build_reports_the_linked_backend) {
+    const CpuBackendInfo& info = load_cpu_backend();
+    CHECK(info.variant == CPU_VARIANT_STATIC);
+    CHECK(info.fallbacks == 0);
+    CHECK(info.cpu_features == detect_cpu_features());
+    // Loads once per process
+    CHECK(&load_cpu_backend("/elsewhere") == &info);
+    CHECK(cpu_backend_info().variant == CPU_VARIANT_STATIC);
+}
+
+TEST(variant_names_match_module_suffixes) {
+    CHECK(std::string(cpu_variant_name(CPU_VARIANT_I8MM)) == "i8mm");
+    CHECK(std::string(cpu_variant_name(CPU_VARIANT_AVX512)) == "avx512");
+    CHECK(std::string(cpu_variant_name(CPU_VARIANT_NONE)) == "none");
+    CHECK(std::string(cpu_variant_name(99)) == "none");
+}
+
+TEST_MAIN()
@@ -0,0 +1,106 @@
+/**
+ * Jeeves LLM Test Project - CPU topology detection host tests
+ */
+
+#include <string>
+#include <vector>
+
+#include "cpu_topology.h"
+#include "test_support.h"
+
+namespace {
+
+using test_support::TempDir;
+
+/** cpu[id] under [dir] with the given sysfs values; 0 leaves a file out. */
+void write_cpu(TempDir& dir, int id, long capacity, long max_freq_khz, int online = -1) {
+    const std::string cpu = "cpu" + std::to_string(id);
+    if (capacity > 0) dir.write(cpu + "/cpu_capacity", std::to_string(capacity) + "\n");
+    if (max_freq_khz > 0) dir.write(cpu + "/cpufreq/cpuinfo_max_freq", std::to_string(max_freq_khz) + "\n");
+    if (online >= 0) dir.write(cpu + "/online", std::to_string(online) + "\n");
+}
+
+/** Tensor G4: 4x A520, 3x A720, 1x X4. */
+void write_tensor_g4(TempDir& dir) {
+    for (int id = 0; id < 4; id++) write_cpu(dir, id, 255, 1950000, id == 0 ? -1 : 1);
+    for (int id = 4; id < 7; id++) write_cpu(dir, id, 861, 2600000, 1);
+    write_cpu(dir, 7, 1024, 3100000, 1);
+}
+
+} // namespace
+
+TEST(clusters_are_grouped_by_capacity_fastest_first) {
+    TempDir dir;
+    write_tensor_g4(dir);
+    // Siblings that are not cores
+    dir.write("cpufreq/policy0/scaling_governor", "schedutil\n");
+    dir.write("cpuidle/current_driver", "psci_idle\n");
+    dir.write("possible", "0-7\n");
+
+    const CpuTopology topology = detect_cpu_topology(dir.path());
+    REQUIRE(topology.cores.size() == 8);
+    const std::vector<std::vector<int>> clusters = {{7}, {4, 5, 6}, {0, 1, 2, 3}};
+    CHECK(topology.clusters == clusters);
+    CHECK(topology.cores[0].id == 0);
+    CHECK(topology.cores[0].cluster == 2);
+    CHECK(topology.cores[7].cluster == 0);
+    CHECK(topology.cores[7].capacity == 1024);
+    CHECK(topology.cores[7].max_freq_khz == 3100000);
+}
+
+TEST(policies_select_clusters) {
+    TempDir dir;
+    write_tensor_g4(dir);
+    const CpuTopology topology = detect_cpu_topology(dir.path());
+
+    CHECK(topology.cpus_for_policy(CPU_POLICY_PERFORMANCE) == std::vector<int>({4, 5, 6, 7}));
+    CHECK(topology.cpus_for_policy(CPU_POLICY_EFFICIENCY) == std::vector<int>({0, 1, 2, 3}));
+    CHECK(topology.cpus_for_policy(CPU_POLICY_ALL).empty());
+    CHECK(topology.recommended_threads(CPU_POLICY_PERFORMANCE) == 4);
+    CHECK(topology.recommended_threads(CPU_POLICY_ALL) == 8);
+}
+
+TEST(max_frequency_is_used_without_capacity) {
+    TempDir dir;
+    write_cpu(dir, 0, 0, 1800000);
+    write_cpu(dir, 1, 0, 1800000);
+    write_cpu(dir, 2, 0, 2400000);
+
+    const CpuTopology topology = detect_cpu_topology(dir.path());
+    CHECK(topology.clusters == std::vector<std::vector<int>>({{2}, {0, 1}}));
+}
+
+TEST(offline_cores_are_skipped) {
+    TempDir dir;
+    write_tensor_g4(dir);
+    write_cpu(dir, 8, 1024, 3100000, 0);
+    dir.write("cpu5/online", "0\n");
+
+    const CpuTopology topology = detect_cpu_topology(dir.path());
+    CHECK(topology.cores.size() == 7);
+    CHECK(topology.clusters == std::vector<std::vector<int>>({{7}, {4, 6}, {0, 1, 2, 3}}));
+}
+
+TEST(uniform_or_missing_topology_never_pins) {
+    TempDir dir;
+    write_cpu(dir, 0, 1024, 0);
+    write_cpu(dir, 1, 1024, 0);
+    const CpuTopology uniform = detect_cpu_topology(dir.path());
+    CHECK(uniform.clusters.size() == 1);
+    CHECK(uniform.cpus_for_policy(CPU_POLICY_PERFORMANCE).empty());
+    CHECK(uniform.recommended_threads(CPU_POLICY_PERFORMANCE) == 2);
+
+    const CpuTopology missing = detect_cpu_topology(dir.path() + "/absent");
+    CHECK(missing.cores.empty());
+    CHECK(missing.recommended_threads(CPU_POLICY_PERFORMANCE) == 0);
+}
+
+TEST(array_layout_is_header_then_four_fields_per_core) {
+    TempDir dir;
+    write_cpu(dir, 0, 255, 1950000);
+    write_cpu(dir, 1, 1024, 3100000);
+    const std::vector<long long> expected = {2, 2, 0, 1, 255, 1950000, 1, 0, 1024, 3100000};
+    CHECK(detect_cpu_topology(dir.path()).to_array() == expected);
+}
+
+TEST_MAIN()
@@ -0,0 +1,284 @@
+/**
+ * Jeeves LLM Test Project - EngineHandles host tests
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "engine_context.h"
+#include "engine_handles.h"
+#include "test_support.h"
+
+namespace {
+
+long long add_engine() {
+    return EngineHandles::instance().add(std::make_unique<LlamaContext>());
+}
+
+} // namespace
+
+TEST(acquire_after_remove_fails) {
+    EngineHandles& handles = EngineHandles::instance();
+    const long long handle = add_engine();
+    CHECK(handles.acquire(handle));
+
+    const long long stale_before = handles.stats().stale_lookups;
+    CHECK(handles.remove(handle) != nullptr);
+    CHECK(!handles.acquire(handle));
+    CHECK(handles.remove(handle) == nullptr);
+    CHECK(handles.stats().stale_lookups == stale_before + 2);
+    CHECK(!handles.acquire(0));
+}
+
+TEST(stale_generation_is_rejected) {
+    EngineHandles& handles = EngineHandles::instance();
+    const long long old_handle = add_engine();
+    handles.remove(old_handle);
+
+    // The freed slot is reused under the next generation
+    const long long new_handle = add_engine();
+    CHECK(new_handle != old_handle);
+    CHECK((new_handle & 0xffffffffLL) == (old_handle & 0xffffffffLL));
+    CHECK(!handles.acquire(old_handle));
+    CHECK(handles.acquire(new_handle));
+    CHECK(!handles.swap(old_handle, new_handle));
+
+    handles.remove(new_handle);
+}
+
+TEST(remove_waits_for_outstanding_leases) {
+    EngineHandles& handles = EngineHandles::instance();
+    const long long handle = add_engine();
+    EngineLease lease = handles.acquire(handle);
+    REQUIRE(lease);
+    LlamaContext* engine = lease.get();
+
+    const long long drained_before = handles.stats().drained;
+    std::atomic<bool> removed{false};
+    std::unique_ptr<LlamaContext> freed;
+    std::thread unloader([&] {
+        freed = handles.remove(handle);
+        removed = true;
+    });
+
+    // New leases fail at once, the outstanding one keeps the engine alive
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (handles.acquire(handle) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    CHECK(!handles.acquire(handle));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(!removed);
+    CHECK(lease->engine_id == engine->engine_id);
+
+    lease.reset();
+    unloader.join();
+    CHECK(removed);
+    CHECK(freed.get() == engine);
+    CHECK(handles.stats().drained == drained_before + 1);
+}
+
+TEST(swap_keeps_handles_valid) {
+    EngineHandles& handles = EngineHandles::instance();
+    const long long a = add_engine();
+    const long long b = add_engine();
+    EngineLease before_a = handles.acquire(a);
+    EngineLease before_b = handles.acquire(b);
+    REQUIRE(before_a && before_b);
+
+    const long long swaps_before = handles.stats().swaps;
+    REQUIRE(handles.swap(a, b));
+    CHECK(handles.stats().swaps == swaps_before + 1);
+
+    // Both handles stay live and now resolve to each other's engine;
+    // leases taken before the swap keep the engine they hold
+    EngineLease after_a = handles.acquire(a);
+    EngineLease after_b = handles.acquire(b);
+    REQUIRE(after_a && after_b);
+    CHECK(after_a.get() == before_b.get());
+    CHECK(after_b.get() == before_a.get());
+    CHECK(before_a->engine_id != after_a->engine_id);
+
+    before_a.reset();
+    before_b.reset();
+    after_a.reset();
+    after_b.reset();
+    CHECK(handles.remove(a) != nullptr);
+    CHECK(handles.remove(b) != nullptr);
+}
+
+TEST(swap_in_keeps_engine_settings) {
+    EngineHandles& handles = EngineHandles::instance();
+    const long long current = add_engine();
+    const long long replacement = add_engine();
+    {
+        EngineLease engine = handles.acquire(current);
+        REQUIRE(engine);
+        engine->thread_control.enabled = true;
+        engine->thread_control.target_tokens_per_sec = 7.5f;
+        engine->thread_control.min_threads = 2;
+        engine->thread_control.max_pause_ms = 50;
+        engine->profiler.configure(0.25f);
+    }
+    unsigned long long replacement_id;
+    {
+        EngineLease engine = handles.acquire(replacement);
+        REQUIRE(engine);
+        replacement_id = engine->engine_id;
+    }
+
+    REQUIRE(handles.swap_in(current, replacement));
+
+    EngineLease engine = handles.acquire(current);
+    REQUIRE(engine);
+    CHECK(engine->engine_id == replacement_id);
+    CHECK(engine->thread_control.enabled);
+    CHECK(engine->thread_control.target_tokens_per_sec == 7.5f);
+    CHECK(engine->thread_control.min_threads == 2);
+    CHECK(engine->thread_control.max_pause_ms == 50);
+    CHECK(engine->profiler.sample_rate() == 0.25f);
+    engine.reset();
+
+    handles.remove(replacement);
+    handles.remove(current);
+}
+
+TEST(swap_in_rejects_stale_and_identical_handles) {
+    EngineHandles& handles = EngineHandles::instance();
+    const long long current = add_engine();
+    const long long stale = add_engine();
+    handles.remove(stale);
+
+    CHECK(!handles.swap_in(current, stale));
+    CHECK(!handles.swap_in(stale, current));
+    CHECK(!handles.swap_in(current, current));
+    CHECK(handles.acquire(current));
+
+    handles.remove(current);
+}
+
+TEST(read_metrics_follows_published_values) {
+    EngineHandles& handles = EngineHandles::instance();
+    auto fresh = std::make_unique<LlamaContext>();
+    fresh->load_time_ms = 120;
+    fresh->is_stub = true;
+    const long long handle = handles.add(std::move(fresh));
+
+    EngineMetrics metrics;
+    REQUIRE(handles.read_metrics(handle, metrics));
+    CHECK(metrics.load_time_ms == 120);
+    CHECK(metrics.is_stub);
+    CHECK(metrics.last_tokens_generated == 0);
+
+    // Changes are invisible to the getters until published
+    EngineLease engine = handles.acquire(handle);
+    REQUIRE(engine);
+    engine->last_inference_time_ms = 45;
+    engine->last_tokens_generated = 9;
+    engine->memory_usage_bytes = 4096;
+    REQUIRE(handles.read_metrics(handle, metrics));
+    CHECK(metrics.last_tokens_generated == 0);
+    handles.publish(engine.get());
+    engine.reset();
+
+    REQUIRE(handles.read_metrics(handle, metrics));
+    CHECK(metrics.last_inference_time_ms == 45);
+    CHECK(metrics.last_tokens_generated == 9);
+    CHECK(metrics.memory_usage_bytes == 4096);
+
+    handles.remove(handle);
+    CHECK(!handles.read_metrics(handle, metrics));
+    CHECK(!handles.read_metrics(0, metrics));
+    CHECK(!handles.read_metrics(static_cast<long long>(EngineHandles::MAX_ENGINES + 1), metrics));
+}
+
+TEST(read_metrics_rejects_stale_generation) {
+    EngineHandles& handles = EngineHandles::instance();
+    const long long old_handle = add_engine();
+    handles.remove(old_handle);
+    auto fresh = std::make_unique<LlamaContext>();
+    fresh->load_time_ms = 77;
+    const long long new_handle = handles.add(std::move(fresh));
+
+    EngineMetrics metrics;
+    CHECK(!handles.read_metrics(old_handle, metrics));
+    REQUIRE(handles.read_metrics(new_handle, metrics));
+    CHECK(metrics.load_time_ms == 77);
+
+    handles.remove(new_handle);
+}
+
+TEST(read_metrics_follow_engines_across_swap) {
+    EngineHandles& handles = EngineHandles::instance();
+    auto first = std::make_unique<LlamaContext>();
+    first->load_time_ms = 1;
+    auto second = std::make_unique<LlamaContext>();
+    second->load_time_ms = 2;
+    const long long a = handles.add(std::move(first));
+    const long long b = handles.add(std::move(second));
+
+    REQUIRE(handles.swap(a, b));
+    EngineMetrics metrics;
+    REQUIRE(handles.read_metrics(a, metrics));
+    CHECK(metrics.load_time_ms == 2);
+    REQUIRE(handles.read_metrics(b, metrics));
+    CHECK(metrics.load_time_ms == 1);
+
+    handles.remove(a);
+    handles.remove(b);
+}
+
+TEST(read_metrics_is_consistent_under_concurrent_publish) {
+    EngineHandles& handles = EngineHandles::instance();
+    const long long handle = add_engine();
+    EngineLease lease = handles.acquire(handle);
+    REQUIRE(lease);
+    LlamaContext* engine = lease.get();
+
+    // The writer keeps every field equal, so a torn read shows up as a mismatch
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (int i = 1; i <= 20000; i++) {
+            engine->last_inference_time_ms = i;
+            engine->last_tokens_generated = i;
+            engine->memory_usage_bytes = static_cast<size_t>(i);
+            handles.publish(engine);
+        }
+        done = true;
+    });
+    bool consistent = true;
+    EngineMetrics metrics;
+    while (!done) {
+        if (!handles.read_metrics(handle, metrics)) { consistent = false; break; }
+        consistent &= metrics.last_inference_time_ms == metrics.last_tokens_generated
+            && metrics.memory_usage_bytes == metrics.last_tokens_generated;
+    }
+    writer.join();
+    CHECK(consistent);
+
+    lease.reset();
+    handles.remove(handle);
+}
+
+TEST(add_refuses_engines_past_the_limit) {
+    EngineHandles& handles = EngineHandles::instance();
+    std::vector<long long> added;
+    long long handle;
+    while ((handle = add_engine()) != 0) {
+        added.push_back(handle);
+        REQUIRE(added.size() <= EngineHandles::MAX_ENGINES);
+    }
+    CHECK(handles.stats().live == static_cast<long long>(EngineHandles::MAX_ENGINES));
+
+    handles.remove(added.back());
+    added.pop_back();
+    handle = add_engine();
+    CHECK(handle != 0);
+    added.push_back(handle);
+    for (long long h : added) handles.remove(h);
+}
+
+TEST_MAIN()
@@ -0,0 +1,61 @@
+/**
+ * Jeeves LLM Test Project - Per-request generation stats host tests
+ */
+
+#include <vector>
+
+#include "generate_stats.h"
+#include "test_support.h"
+
+TEST(token_times_use_nearest_rank_percentiles) {
+    GenerateStats stats;
+    std::vector<long long> token_us = {90, 10, 50, 20, 80, 30, 70, 40, 100, 60};
+    stats.set_token_times(token_us);
+    CHECK(stats.token_min_us == 10);
+    CHECK(stats.token_p50_us == 50);
+    CHECK(stats.token_p90_us == 90);
+    CHECK(stats.token_max_us == 100);
+}
+
+TEST(single_token_is_every_percentile) {
+    GenerateStats stats;
+    std::vector<long long> token_us = {42};
+    stats.set_token_times(token_us);
+    CHECK(stats.token_min_us == 42);
+    CHECK(stats.token_p50_us == 42);
+    CHECK(stats.token_p90_us == 42);
+    CHECK(stats.token_max_us == 42);
+}
+
+TEST(p90_of_few_tokens_is_the_slowest) {
+    GenerateStats stats;
+    std::vector<long long> token_us = {30, 10, 20};
+    stats.set_token_times(token_us);
+    CHECK(stats.token_p50_us == 20);
+    CHECK(stats.token_p90_us == 30);
+}
+
+TEST(no_tokens_leaves_times_unset) {
+    GenerateStats stats;
+    std::vector<long long> token_us;
+    stats.set_token_times(token_us);
+    CHECK(stats.token_min_us == 0);
+    CHECK(stats.token_max_us == 0);
+}
+
+TEST(array_follows_index_order) {
+    GenerateStats stats;
+    stats.stop_reason = STOP_MAX_TOKENS;
+    stats.generated_tokens = 64;
+    stats.token_max_us = 90000;
+    stats.profiled_nodes = 1850;
+    long long out[GenerateStats::COUNT] = {};
+    stats.to_array(out);
+    CHECK(out[GenerateStats::STOP_REASON] == STOP_MAX_TOKENS);
+    CHECK(out[GenerateStats::GENERATED_TOKENS] == 64);
+    CHECK(out[GenerateStats::TOKEN_MAX_US] == 90000);
+    CHECK(out[GenerateStats::PROFILED_NODES] == 1850);
+    CHECK(GenerateStats::COUNT == 16);
+}
+
+TEST_MAIN()
@@ -0,0 +1,120 @@
+/**
+ * Jeeves LLM Test Project - Memory budget fitter host tests
+ */
+
+#include <string>
+#include <vector>
+
+#include "memory_budget.h"
+#include "test_support.h"
+
+namespace {
+
+ContextShape default_shape() {
+    ContextShape shape;
+    shape.n_ctx = 4096;
+    shape.n_batch = 512;
+    shape.n_ubatch = 512;
+    return shape;
+}
+
+const char* type_name(KvCacheType type) {
+    switch (type) {
+        case KvCacheType::F16: return "f16";
+        case KvCacheType::Q8_0: return "q8_0";
+        case KvCacheType::Q4_0: return "q4_0";
+        default: return "other";
+    }
+}
+
+std::string describe(const ContextShape& shape) {
+    return std::string(shape.flash_attn ? "fa " : "") + type_name(shape.type_k) + "/" + type_name(shape.type_v)
+         + " ub" + std::to_string(shape.n_ubatch) + " b" + std::to_string(shape.n_batch)
+         + " ctx" + std::to_string(shape.n_ctx);
+}
+
+/** Every shape shrink_context_shape() walks through from [shape]. */
+std::vector<std::string> shrink_steps(ContextShape shape) {
+    std::vector<std::string> steps;
+    while (shrink_context_shape(shape)) steps.push_back(describe(shape));
+    return steps;
+}
+
+} // namespace
+
+TEST(shrinks_fa_then_q8_then_ubatch_then_context_then_q4) {
+    const std::vector<std::string> expected = {
+        "fa f16/f16 ub512 b512 ctx4096",
+        "fa q8_0/q8_0 ub512 b512 ctx4096",
+        "fa q8_0/q8_0 ub256 b256 ctx4096",
+        "fa q8_0/q8_0 ub128 b128 ctx4096",
+        "fa q8_0/q8_0 ub128 b128 ctx2048",
+        "fa q8_0/q8_0 ub128 b128 ctx1024",
+        "fa q8_0/q8_0 ub128 b128 ctx512",
+        "fa q4_0/q4_0 ub128 b128 ctx512",
+    };
+    CHECK(shrink_steps(default_shape()) == expected);
+}
+
+TEST(context_never_drops_below_the_floor) {
+    ContextShape shape = default_shape();
+    shape.flash_attn = true;
+    shape.type_k = shape.type_v = KvCacheType::Q4_0;
+    shape.n_ubatch = shape.n_batch = MIN_FIT_UBATCH;
+    shape.n_ctx = 700;
+    REQUIRE(shrink_context_shape(shape));
+    CHECK(shape.n_ctx == MIN_FIT_CONTEXT);
+    CHECK(!shrink_context_shape(shape));
+    CHECK(shape.n_ctx == MIN_FIT_CONTEXT);
+}
+
+TEST(already_quantized_kv_is_never_raised) {
+    ContextShape shape = default_shape();
+    shape.flash_attn = true;
+    shape.type_k = KvCacheType::Q4_0;
+    REQUIRE(shrink_context_shape(shape));
+    CHECK(shape.type_k == KvCacheType::Q4_0);
+    CHECK(shape.type_v == KvCacheType::Q8_0);
+
+    // Neither side is f16: the q8_0 step is skipped
+    shape = default_shape();
+    shape.flash_attn = true;
+    shape.type_k = shape.type_v = KvCacheType::OTHER;
+    REQUIRE(shrink_context_shape(shape));
+    CHECK(shape.type_k == KvCacheType::OTHER);
+    CHECK(shape.n_ubatch == 256);
+}
+
+TEST(batch_follows_ubatch_down_only) {
+    ContextShape shape = default_shape();
+    shape.flash_attn = true;
+    shape.type_k = shape.type_v = KvCacheType::Q8_0;
+    shape.n_batch = 64;
+    REQUIRE(shrink_context_shape(shape));
+    CHECK(shape.n_ubatch == 256);
+    CHECK(shape.n_batch == 64);
+}
+
+TEST(fit_stops_at_the_first_shape_that_fits) {
+    ContextShape shape = default_shape();
+    int estimates = 0;
+    // Only fits once the context is halved
+    CHECK(fit_context_shape(shape, 2048, [&](const ContextShape& s) {
+        estimates++;
+        return static_cast<size_t>(s.n_ctx);
+    }));
+    CHECK(describe(shape) == "fa q8_0/q8_0 ub128 b128 ctx2048");
+    CHECK(estimates == 6);
+
+    ContextShape fits = default_shape();
+    CHECK(fit_context_shape(fits, 4096, [](const ContextShape& s) { return static_cast<size_t>(s.n_ctx); }));
+    CHECK(describe(fits) == describe(default_shape()));
+}
+
+TEST(fit_fails_at_the_smallest_shape) {
+    ContextShape shape = default_shape();
+    CHECK(!fit_context_shape(shape, 0, [](const ContextShape&) { return size_t(1); }));
+    CHECK(describe(shape) == "fa q4_0/q4_0 ub128 b128 ctx512");
+}
+
+TEST_MAIN()
@@ -0,0 +1,87 @@
+/**
+ * Jeeves LLM Test Project - Process memory parsing host tests
+ */
+
+#include <unistd.h>
+
+#include "memory_stats.h"
+#include "test_support.h"
+
+namespace {
+
+using test_support::TempDir;
+
+const size_t PAGE = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+const char* SMAPS_ROLLUP =
+    "5582c8a9e000-7ffd2b5f6000 ---p 00000000 00:00 0                          [rollup]\n"
+    "Rss:              812344 kB\n"
+    "Pss:              790112 kB\n"
+    "Pss_Anon:         301220 kB\n"
+    "Pss_File:         488892 kB\n"
+    "Shared_Clean:      20480 kB\n"
+    "Anonymous:        301220 kB\n"
+    "AnonHugePages:         0 kB\n"
+    "Swap:               1024 kB\n"
+    "SwapPss:            1024 kB\n"
+    "Locked:                0 kB\n";
+
+} // namespace
+
+TEST(smaps_rollup_fields_are_read_in_bytes) {
+    TempDir dir;
+    dir.write("smaps_rollup", SMAPS_ROLLUP);
+    dir.write("statm", "1 2 1\n");
+
+    ProcessMemory mem;
+    REQUIRE(read_process_memory(mem, dir.path()));
+    CHECK(mem.rss_bytes == 812344ull * 1024);
+    CHECK(mem.pss_bytes == 790112ull * 1024);
+    // Pss_Anon and AnonHugePages share a prefix but are other fields
+    CHECK(mem.anonymous_bytes == 301220ull * 1024);
+    CHECK(mem.swap_bytes == 1024ull * 1024);
+}
+
+TEST(statm_is_the_fallback_without_smaps_rollup) {
+    TempDir dir;
+    dir.write("statm", "52000 20000 5000 10 0 30000 0\n");
+
+    ProcessMemory mem;
+    REQUIRE(read_process_memory(mem, dir.path()));
+    CHECK(mem.rss_bytes == 20000 * PAGE);
+    CHECK(mem.anonymous_bytes == 15000 * PAGE);
+    // statm has no PSS
+    CHECK(mem.pss_bytes == mem.rss_bytes);
+    CHECK(mem.swap_bytes == 0);
+}
+
+TEST(statm_is_the_fallback_when_smaps_rollup_has_no_rss) {
+    TempDir dir;
+    dir.write("smaps_rollup", "Pss:      100 kB\n");
+    dir.write("statm", "300 200 50\n");
+
+    ProcessMemory mem;
+    REQUIRE(read_process_memory(mem, dir.path()));
+    CHECK(mem.rss_bytes == 200 * PAGE);
+    CHECK(mem.anonymous_bytes == 150 * PAGE);
+}
+
+TEST(unreadable_proc_reports_zero) {
+    TempDir dir;
+    ProcessMemory mem;
+    mem.rss_bytes = 1;
+    CHECK(!read_process_memory(mem, dir.path()));
+    CHECK(mem.rss_bytes == 0);
+
+    dir.write("statm", "garbage\n");
+    CHECK(!read_process_memory(mem, dir.path()));
+}
+
+TEST(live_process_memory_is_readable) {
+    ProcessMemory mem;
+    REQUIRE(read_process_memory(mem));
+    CHECK(mem.rss_bytes > 0);
+    CHECK(mem.pss_bytes > 0);
+}
+
+TEST_MAIN()
@@ -0,0 +1,260 @@
+/**
+ * Jeeves LLM Test Project - ModelRegistry host tests
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model_registry.h"
+#include "test_support.h"
+
+namespace {
+
+using test_support::TempDir;
+
+/** Hands out fake models, one per load, and checks the registry frees each once. */
+class FakeLoader : public ModelLoader {
+public:
+    llama_model* load(const std::string& path, const ModelLoadParams&, size_t&) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiting_++;
+        gate_cv_.wait(lock, [&] { return open_; });
+        waiting_--;
+        loads_.push_back(path);
+        llama_model* model = reinterpret_cast<llama_model*>(new char);
+        live_.insert(model);
+        return model;
+    }
+
+    void unload(llama_model* model) override {
+        if (during_unload) during_unload();
+        std::lock_guard<std::mutex> lock(mutex_);
+        CHECK(live_.erase(model) == 1);
+        unloads_++;
+        delete reinterpret_cast<char*>(model);
+    }
+
+    /** Hold loads until open(). */
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = false;
+    }
+    void open() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = true;
+        gate_cv_.notify_all();
+    }
+
+    std::vector<std::string> loads() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return loads_;
+    }
+    int unloads() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return unloads_;
+    }
+    int waiting() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return waiting_;
+    }
+    size_t live() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return live_.size();
+    }
+
+    std::function<void()> during_unload;
+
+private:
+    std::mutex mutex_;
+    std::condition_variable gate_cv_;
+    bool open_ = true;
+    int waiting_ = 0;
+    std::vector<std::string> loads_;
+    std::set<llama_model*> live_;
+    int unloads_ = 0;
+};
+
+/** Registry on a FakeLoader without a budget; frees everything it loaded on exit. */
+struct RegistryFixture {
+    RegistryFixture() {
+        registry.set_budget(0);
+        registry.set_loader(&loader);
+    }
+    ~RegistryFixture() {
+        registry.set_budget(0);
+        registry.evict_idle();
+        CHECK(loader.live() == 0);
+        registry.set_loader(nullptr);
+    }
+
+    /** A model file of [bytes] bytes; the registry sizes it by the file. */
+    std::string model(const std::string& name, size_t bytes) {
+        return dir.write(name, std::string(bytes, 'x'));
+    }
+
+    ModelRegistry& registry = ModelRegistry::instance();
+    FakeLoader loader;
+    TempDir dir;
+};
+
+} // namespace
+
+TEST(hits_share_one_load_and_count_refs) {
+    RegistryFixture f;
+    const std::string path = f.model("a.gguf", 100);
+    const ModelRegistryStats before = f.registry.stats();
+
+    ModelRef first = f.registry.acquire(path, {});
+    REQUIRE(first);
+    ModelRef second = f.registry.acquire(path, {});
+    REQUIRE(second);
+    CHECK(first.get() == second.get());
+    CHECK(first.use_count() == 2);
+    CHECK(first.size_bytes() == 100);
+    CHECK(f.loader.loads().size() == 1);
+    CHECK(f.registry.stats().hits == before.hits + 1);
+
+    // Other load parameters are another model
+    ModelLoadParams no_mmap;
+    no_mmap.use_mmap = false;
+    ModelRef third = f.registry.acquire(path, no_mmap);
+    REQUIRE(third);
+    CHECK(third.get() != first.get());
+    CHECK(third.mapped_bytes() == 0);
+    CHECK(first.mapped_bytes() == 100);
+    third.reset();
+
+    second.reset();
+    CHECK(first.use_count() == 1);
+    CHECK(f.loader.unloads() == 1);
+}
+
+TEST(last_release_frees_without_a_budget) {
+    RegistryFixture f;
+    const std::string path = f.model("a.gguf", 100);
+    ModelRef ref = f.registry.acquire(path, {});
+    REQUIRE(ref);
+    const std::string canonical = ref.path();
+    CHECK(f.registry.holds(canonical));
+
+    ref.reset();
+    CHECK(f.loader.unloads() == 1);
+    CHECK(!f.registry.holds(canonical));
+    CHECK(f.registry.stats().loaded_models == 0);
+}
+
+TEST(concurrent_acquires_wait_for_one_load) {
+    RegistryFixture f;
+    const std::string path = f.model("a.gguf", 100);
+    f.loader.close();
+
+    ModelRef refs[2];
+    std::thread first([&] { refs[0] = f.registry.acquire(path, {}); });
+    while (f.loader.waiting() == 0) std::this_thread::yield();
+    // The second caller finds the entry loading and waits for its result
+    std::thread second([&] { refs[1] = f.registry.acquire(path, {}); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    f.loader.open();
+    first.join();
+    second.join();
+
+    REQUIRE(refs[0] && refs[1]);
+    CHECK(refs[0].get() == refs[1].get());
+    CHECK(refs[0].use_count() == 2);
+    CHECK(f.loader.loads().size() == 1);
+}
+
+TEST(budget_evicts_least_recently_used_idle_model) {
+    RegistryFixture f;
+    const std::string a = f.model("a.gguf", 100);
+    const std::string b = f.model("b.gguf", 100);
+    const std::string c = f.model("c.gguf", 100);
+    f.registry.set_budget(250);
+
+    std::string canonical_a, canonical_b;
+    {
+        ModelRef ref_a = f.registry.acquire(a, {});
+        ModelRef ref_b = f.registry.acquire(b, {});
+        REQUIRE(ref_a && ref_b);
+        canonical_a = ref_a.path();
+        canonical_b = ref_b.path();
+    }
+    // Idle models stay cached within the budget
+    CHECK(f.loader.unloads() == 0);
+    CHECK(f.registry.stats().idle_models == 2);
+
+    // Touch a, so b is least recently used when c needs room
+    f.registry.acquire(a, {}).reset();
+    const long long evictions = f.registry.stats().evictions;
+    ModelRef ref_c = f.registry.acquire(c, {});
+    REQUIRE(ref_c);
+    CHECK(f.loader.unloads() == 1);
+    CHECK(f.registry.holds(canonical_a));
+    CHECK(!f.registry.holds(canonical_b));
+    CHECK(f.registry.stats().evictions == evictions + 1);
+    CHECK(f.registry.stats().resident_bytes == 200);
+}
+
+TEST(referenced_models_are_never_evicted) {
+    RegistryFixture f;
+    const std::string a = f.model("a.gguf", 100);
+    const std::string b = f.model("b.gguf", 100);
+    f.registry.set_budget(150);
+
+    ModelRef ref_a = f.registry.acquire(a, {});
+    REQUIRE(ref_a);
+    CHECK(!f.registry.acquire(b, {}));
+    CHECK(f.loader.loads().size() == 1);
+    CHECK(f.loader.unloads() == 0);
+
+    ref_a.reset();
+    CHECK(f.registry.acquire(b, {}));
+    CHECK(f.loader.unloads() == 1);
+}
+
+TEST(evict_idle_frees_only_idle_models) {
+    RegistryFixture f;
+    const std::string a = f.model("a.gguf", 100);
+    const std::string b = f.model("b.gguf", 60);
+    f.registry.set_budget(1000);
+
+    ModelRef held = f.registry.acquire(a, {});
+    f.registry.acquire(b, {}).reset();
+    REQUIRE(held);
+    CHECK(f.registry.stats().idle_models == 1);
+
+    CHECK(f.registry.evict_idle() == 60);
+    CHECK(f.loader.unloads() == 1);
+    CHECK(f.registry.stats().loaded_models == 1);
+    CHECK(f.registry.evict_idle() == 0);
+    CHECK(held.use_count() == 1);
+}
+
+TEST(models_are_freed_outside_the_registry_lock) {
+    RegistryFixture f;
+    const std::string path = f.model("a.gguf", 100);
+    ModelRef ref = f.registry.acquire(path, {});
+    REQUIRE(ref);
+    const std::string canonical = ref.path();
+
+    // Another thread can use the registry while the weights are freed, and
+    // still sees the model until they are
+    std::atomic<bool> held_during_unload{false};
+    f.loader.during_unload = [&] {
+        std::thread other([&] { held_during_unload = f.registry.holds(canonical); });
+        other.join();
+    };
+    ref.reset();
+    f.loader.during_unload = nullptr;
+    CHECK(held_during_unload);
+    CHECK(!f.registry.holds(canonical));
+}
+
+TEST_MAIN()
@@ -0,0 +1,192 @@
+/**
+ * Jeeves LLM Test Project - Latency histogram and PerfMetrics host tests
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "generate_stats.h"
+#include "perf_metrics.h"
+#include "test_support.h"
+#include "thread_pool.h"
+
+namespace {
+
+LatencySummary summarize(LatencyHistogram& histogram, bool reset = false) {
+    LatencyHistogram::Counts counts;
+    histogram.drain(counts, reset);
+    return counts.summarize();
+}
+
+/** Field [field] of histogram [hist] in snapshot row [row]. */
+long long snapshot_field(const long long* out, int row, int hist, int field) {
+    return out[row * PerfMetrics::ROW_FIELDS + hist * LatencySummary::COUNT + field];
+}
+
+long long snapshot_counter(const long long* out, int row, int counter) {
+    return out[row * PerfMetrics::ROW_FIELDS + HIST_COUNT * LatencySummary::COUNT + counter];
+}
+
+} // namespace
+
+TEST(small_values_have_exact_buckets) {
+    for (uint64_t v = 0; v < LatencyHistogram::SUB_BUCKETS; v++) {
+        CHECK(LatencyHistogram::bucket_of(v) == static_cast<int>(v));
+        CHECK(LatencyHistogram::bucket_high(static_cast<int>(v)) == v);
+    }
+}
+
+TEST(bucket_bounds_are_contiguous_and_within_a_sixteenth) {
+    for (int b = 0; b < LatencyHistogram::BUCKETS - 1; b++) {
+        const uint64_t high = LatencyHistogram::bucket_high(b);
+        const uint64_t low = b == 0 ? 0 : LatencyHistogram::bucket_high(b - 1) + 1;
+        CHECK(LatencyHistogram::bucket_of(low) == b);
+        CHECK(LatencyHistogram::bucket_of(high) == b);
+        CHECK(LatencyHistogram::bucket_of(high + 1) == b + 1);
+        // Relative width: every value in the bucket is within 1/16 of its top
+        CHECK((high - low) * LatencyHistogram::SUB_BUCKETS <= low || low < LatencyHistogram::SUB_BUCKETS);
+    }
+    CHECK(LatencyHistogram::bucket_of(1000) == LatencyHistogram::bucket_of(1023));
+    CHECK(LatencyHistogram::bucket_of(1023) + 1 == LatencyHistogram::bucket_of(1024));
+}
+
+TEST(overflow_values_clamp_to_the_last_bucket) {
+    const int last = LatencyHistogram::BUCKETS - 1;
+    const uint64_t limit = (1ULL << LatencyHistogram::MAX_BITS) - 1;
+    CHECK(LatencyHistogram::bucket_of(limit) == last);
+    CHECK(LatencyHistogram::bucket_of(limit + 1) == last);
+    CHECK(LatencyHistogram::bucket_of(UINT64_MAX) == last);
+    CHECK(LatencyHistogram::bucket_high(last) == limit);
+
+    LatencyHistogram histogram;
+    histogram.record(1LL << 50);
+    LatencySummary s = summarize(histogram);
+    CHECK(s.samples == 1);
+    CHECK(s.max == 1LL << 50);
+    CHECK(s.p50 == static_cast<long long>(limit));
+    CHECK(s.p99 == static_cast<long long>(limit));
+}
+
+TEST(empty_histogram_summarizes_to_zero) {
+    LatencyHistogram histogram;
+    LatencySummary s = summarize(histogram);
+    CHECK(s.samples == 0);
+    CHECK(s.min == 0);
+    CHECK(s.max == 0);
+    CHECK(s.mean == 0);
+    CHECK(s.p50 == 0);
+    CHECK(s.p99 == 0);
+}
+
+TEST(single_sample_reports_itself) {
+    LatencyHistogram histogram;
+    histogram.record(1000);
+    LatencySummary s = summarize(histogram);
+    CHECK(s.samples == 1);
+    CHECK(s.min == 1000);
+    CHECK(s.max == 1000);
+    CHECK(s.mean == 1000);
+    // Bucket [992, 1023] is capped at the true max
+    CHECK(s.p50 == 1000);
+    CHECK(s.p90 == 1000);
+    CHECK(s.p95 == 1000);
+    CHECK(s.p99 == 1000);
+}
+
+TEST(negative_values_record_as_zero) {
+    LatencyHistogram histogram;
+    histogram.record(-5);
+    LatencySummary s = summarize(histogram);
+    CHECK(s.samples == 1);
+    CHECK(s.min == 0);
+    CHECK(s.p99 == 0);
+}
+
+TEST(percentiles_of_known_latencies) {
+    LatencyHistogram histogram;
+    for (long long v = 100; v >= 1; v--) histogram.record(v);
+    LatencySummary s = summarize(histogram);
+    CHECK(s.samples == 100);
+    CHECK(s.min == 1);
+    CHECK(s.max == 100);
+    CHECK(s.mean == 50);
+    // Nearest rank, reported as the top of the bucket holding it
+    CHECK(s.p50 == 51);     // 50 in [50, 51]
+    CHECK(s.p90 == 91);     // 90 in [88, 91]
+    CHECK(s.p95 == 95);     // 95 in [92, 95]
+    CHECK(s.p99 == 99);     // 99 in [96, 99]
+
+    // One slow outlier among fast requests only moves the tail
+    LatencyHistogram skewed;
+    for (int i = 0; i < 99; i++) skewed.record(2000);
+    skewed.record(500000);
+    s = summarize(skewed);
+    CHECK(s.p50 == 2047);   // 2000 in [1984, 2047]
+    CHECK(s.p99 == 2047);
+    CHECK(s.max == 500000);
+}
+
+TEST(drain_resets_only_when_asked) {
+    LatencyHistogram histogram;
+    histogram.record(10);
+    histogram.record(20);
+
+    CHECK(summarize(histogram, false).samples == 2);
+    LatencySummary drained = summarize(histogram, true);
+    CHECK(drained.samples == 2);
+    CHECK(drained.min == 10);
+    CHECK(drained.max == 20);
+
+    LatencySummary after = summarize(histogram);
+    CHECK(after.samples == 0);
+    CHECK(after.min == 0);
+    histogram.record(30);
+    after = summarize(histogram);
+    CHECK(after.samples == 1);
+    CHECK(after.min == 30);
+    CHECK(after.max == 30);
+}
+
+TEST(snapshot_merges_classes_and_resets) {
+    PerfMetrics& metrics = PerfMetrics::instance();
+    std::vector<long long> out(PerfMetrics::SNAPSHOT_FIELDS);
+    metrics.snapshot(out.data(), true);
+
+    GenerateStats stats;
+    stats.stop_reason = STOP_MAX_TOKENS;
+    stats.prompt_tokens = 10;
+    stats.generated_tokens = 2;
+    stats.first_token_us = 900;
+    metrics.record(QOS_INTERACTIVE, stats, {100, 200}, 100, 5000);
+    metrics.record(QOS_BACKGROUND, stats, {300}, 300, 7000);
+    stats.stop_reason = STOP_ERROR;
+    metrics.record(QOS_BACKGROUND, stats, {}, 0, 10);
+    metrics.count(QOS_INTERACTIVE, COUNTER_CANCELLED);
+
+    metrics.snapshot(out.data(), false);
+    const long long* o = out.data();
+    CHECK(snapshot_counter(o, PerfMetrics::ROW_ALL, COUNTER_REQUESTS) == 3);
+    CHECK(snapshot_counter(o, PerfMetrics::ROW_INTERACTIVE, COUNTER_REQUESTS) == 1);
+    CHECK(snapshot_counter(o, PerfMetrics::ROW_BACKGROUND, COUNTER_REQUESTS) == 2);
+    CHECK(snapshot_counter(o, PerfMetrics::ROW_BACKGROUND, COUNTER_FAILED) == 1);
+    CHECK(snapshot_counter(o, PerfMetrics::ROW_ALL, COUNTER_CANCELLED) == 1);
+    CHECK(snapshot_field(o, PerfMetrics::ROW_ALL, HIST_TOKEN_US, LatencySummary::SAMPLES) == 3);
+    CHECK(snapshot_field(o, PerfMetrics::ROW_ALL, HIST_TOKEN_US, LatencySummary::MIN) == 100);
+    CHECK(snapshot_field(o, PerfMetrics::ROW_ALL, HIST_TOKEN_US, LatencySummary::MAX) == 300);
+    CHECK(snapshot_field(o, PerfMetrics::ROW_INTERACTIVE, HIST_FIRST_TOKEN_US, LatencySummary::P50) == 1000);
+    CHECK(snapshot_field(o, PerfMetrics::ROW_ALL, HIST_END_TO_END_US, LatencySummary::SAMPLES) == 3);
+
+    // Reading without reset keeps the window; reading with reset ends it
+    metrics.snapshot(out.data(), true);
+    CHECK(snapshot_counter(o, PerfMetrics::ROW_ALL, COUNTER_REQUESTS) == 3);
+    metrics.snapshot(out.data(), false);
+    for (int row = 0; row < PerfMetrics::ROW_COUNT; row++) {
+        for (int k = 0; k < COUNTER_COUNT; k++) CHECK(snapshot_counter(o, row, k) == 0);
+        for (int m = 0; m < HIST_COUNT; m++) {
+            CHECK(snapshot_field(o, row, m, LatencySummary::SAMPLES) == 0);
+            CHECK(snapshot_field(o, row, m, LatencySummary::P99) == 0);
+        }
+    }
+}
+
+TEST_MAIN()
@@ -0,0 +1,185 @@
+/**
+ * Jeeves LLM Test Project - Repack cache host tests
+ */
+
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "repack_cache.h"
+#include "test_support.h"
+
+namespace {
+
+using test_support::TempDir;
+
+RepackIndexEntry index_entry(const std::string& name, size_t offset, size_t bytes) {
+    RepackIndexEntry e;
+    e.name = name;
+    e.offset = offset;
+    e.bytes = bytes;
+    return e;
+}
+
+/** Kinds of a [layers]-layer model where [repacked] layers' ffn_up is repacked. */
+std::map<std::string, RepackKind> ffn_up_kinds(int layers, const std::vector<std::string>& repacked) {
+    std::map<std::string, RepackKind> kinds;
+    RepackKind& kind = kinds["blk.ffn_up.weight"];
+    kind.tensors = layers;
+    kind.layers = repacked;
+    return kinds;
+}
+
+bool matches(const std::string& pattern, const std::string& name) {
+    // llama matches overrides with std::regex_search
+    return std::regex_search(name, std::regex(pattern));
+}
+
+/** A plan after choose() for the first buffer of a load with [index]. */
+RepackCachePlan planned(const std::vector<RepackIndexEntry>* index, bool sidecar_maps = true) {
+    RepackCachePlan plan;
+    plan.choose(true, index, 64, 64, [&] { return sidecar_maps; }, [] { return true; });
+    return plan;
+}
+
+} // namespace
+
+TEST(tensor_names_split_into_kind_and_layer) {
+    std::string kind, layer;
+    split_tensor_name("blk.12.ffn_up.weight", kind, layer);
+    CHECK(kind == "blk.ffn_up.weight");
+    CHECK(layer == "12");
+    split_tensor_name("output.weight", kind, layer);
+    CHECK(kind == "output.weight");
+    CHECK(layer.empty());
+    split_tensor_name("blk.", kind, layer);
+    CHECK(kind == "blk.");
+    CHECK(layer.empty());
+}
+
+TEST(pattern_covers_every_layer_of_a_fully_repacked_kind) {
+    const std::string pattern = build_repack_pattern(ffn_up_kinds(3, {"0", "1", "2"}));
+    CHECK(pattern == "^(?:blk\\.\\d+\\.ffn_up\\.weight)$");
+    CHECK(matches(pattern, "blk.0.ffn_up.weight"));
+    CHECK(matches(pattern, "blk.31.ffn_up.weight"));
+    CHECK(!matches(pattern, "blk.0.ffn_down.weight"));
+    CHECK(!matches(pattern, "blk.0.ffn_upXweight"));
+    CHECK(!matches(pattern, "xblk.0.ffn_up.weight"));
+}
+
+TEST(pattern_lists_layers_of_a_partly_repacked_kind) {
+    std::map<std::string, RepackKind> kinds = ffn_up_kinds(4, {"1", "3"});
+    kinds["output.weight"] = {1, {""}};
+    kinds["blk.attn_q.weight"] = {4, {}};
+    const std::string pattern = build_repack_pattern(kinds);
+    CHECK(matches(pattern, "blk.1.ffn_up.weight"));
+    CHECK(matches(pattern, "blk.3.ffn_up.weight"));
+    CHECK(!matches(pattern, "blk.0.ffn_up.weight"));
+    CHECK(!matches(pattern, "blk.13.ffn_up.weight"));
+    CHECK(matches(pattern, "output.weight"));
+    CHECK(!matches(pattern, "outputXweight"));
+    CHECK(!matches(pattern, "blk.1.attn_q.weight"));
+
+    CHECK(build_repack_pattern(ffn_up_kinds(4, {})).empty());
+}
+
+TEST(index_round_trips_for_its_key_only) {
+    TempDir dir;
+    const std::string path = dir.file("model.idx");
+    const std::vector<RepackIndexEntry> entries = {index_entry("blk.0.ffn_up.weight", 0, 4096),
+                                                   index_entry("blk.1.ffn_up.weight", 4096, 4096)};
+    REQUIRE(write_repack_index(path, "key|variant=armv8.2", 8192, entries));
+
+    size_t size = 0;
+    std::vector<RepackIndexEntry> read;
+    REQUIRE(read_repack_index(path, "key|variant=armv8.2", size, read));
+    CHECK(size == 8192);
+    CHECK(read == entries);
+
+    CHECK(!read_repack_index(path, "key|variant=armv8.6", size, read));
+    CHECK(!read_repack_index(dir.file("missing.idx"), "key|variant=armv8.2", size, read));
+    const std::string truncated = dir.write("truncated.idx", "repack-cache 1\nkey\n8192 2\nblk.0.ffn_up.weight 0 4096\n");
+    CHECK(!read_repack_index(truncated, "key", size, read));
+    const std::string other = dir.write("other.idx", "repack-cache 2\nkey\n0 0\n");
+    CHECK(!read_repack_index(other, "key", size, read));
+}
+
+TEST(matching_index_maps_the_sidecar) {
+    const std::vector<RepackIndexEntry> index = {index_entry("a", 0, 32), index_entry("b", 32, 32)};
+    bool created = false;
+    RepackCachePlan plan;
+    plan.choose(true, &index, 64, 64, [] { return true; }, [&] { return created = true; });
+    CHECK(plan.mode == RepackBufferMode::HIT);
+    CHECK(plan.expected == index);
+    CHECK(!created);
+}
+
+TEST(unusable_index_builds_a_new_sidecar) {
+    const std::vector<RepackIndexEntry> index = {index_entry("a", 0, 64)};
+    bool mapped = false;
+    RepackCachePlan plan;
+    // Size mismatch: the sidecar is not even mapped
+    plan.choose(true, &index, 128, 64, [&] { return mapped = true; }, [] { return true; });
+    CHECK(plan.mode == RepackBufferMode::BUILD);
+    CHECK(!mapped);
+
+    plan.choose(true, &index, 64, 64, [] { return false; }, [] { return true; });
+    CHECK(plan.mode == RepackBufferMode::BUILD);
+    plan.choose(true, nullptr, 0, 64, [] { return true; }, [] { return false; });
+    CHECK(plan.mode == RepackBufferMode::UNCACHED);
+    // Only the first buffer of a load is cached
+    plan.choose(false, &index, 64, 64, [] { return true; }, [] { return true; });
+    CHECK(plan.mode == RepackBufferMode::UNCACHED);
+}
+
+TEST(hit_skips_repacking_when_the_first_tensor_matches) {
+    const std::vector<RepackIndexEntry> index = {index_entry("a", 0, 32), index_entry("b", 32, 32)};
+    RepackCachePlan plan = planned(&index);
+    plan.entries = index;
+    int checks = 0;
+    CHECK(!plan.needs_repack([&] { checks++; return true; }));
+    CHECK(!plan.needs_repack([&] { checks++; return true; }));
+    CHECK(checks == 1);
+    CHECK(plan.mode == RepackBufferMode::HIT);
+    CHECK(plan.result([] { return false; }) == REPACK_CACHE_HIT);
+    CHECK(plan.bytes() == 64);
+}
+
+TEST(hit_goes_stale_on_other_layout_or_bytes) {
+    const std::vector<RepackIndexEntry> index = {index_entry("a", 0, 32), index_entry("b", 32, 32)};
+
+    // ggml placed the tensors elsewhere: stale without repacking a probe
+    RepackCachePlan moved = planned(&index);
+    moved.entries = {index_entry("a", 0, 32), index_entry("b", 64, 32)};
+    bool probed = false;
+    CHECK(moved.needs_repack([&] { return probed = true; }));
+    CHECK(!probed);
+    CHECK(moved.mode == RepackBufferMode::STALE);
+    CHECK(moved.needs_repack([] { return true; }));
+    CHECK(moved.result([] { return true; }) == REPACK_CACHE_STALE);
+
+    // Same placement, but this ggml repacks to other bytes
+    RepackCachePlan changed = planned(&index);
+    changed.entries = index;
+    CHECK(changed.needs_repack([] { return false; }));
+    CHECK(changed.mode == RepackBufferMode::STALE);
+}
+
+TEST(build_publishes_only_when_every_tensor_was_written) {
+    RepackCachePlan plan = planned(nullptr);
+    REQUIRE(plan.mode == RepackBufferMode::BUILD);
+    plan.entries = {index_entry("a", 0, 32), index_entry("b", 32, 32)};
+
+    bool published = false;
+    CHECK(plan.needs_repack([] { return false; }));
+    CHECK(plan.result([&] { return published = true; }) == REPACK_CACHE_UNCACHED);
+    CHECK(!published);
+
+    CHECK(plan.needs_repack([] { return false; }));
+    CHECK(plan.result([] { return false; }) == REPACK_CACHE_UNCACHED);
+    CHECK(plan.result([&] { return published = true; }) == REPACK_CACHE_BUILT);
+    CHECK(published);
+}
+
+TEST_MAIN()
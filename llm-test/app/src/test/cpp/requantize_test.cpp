@@ -0,0 +1,132 @@
+/**
+ * Jeeves LLM Test Project - Requantize resume state host tests
+ */
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "requantize.h"
+#include "test_support.h"
+
+namespace {
+
+using test_support::TempDir;
+
+void write_text(const std::string& path, const std::string& text) {
+    std::ofstream out(path, std::ios::trunc);
+    out << text;
+}
+
+struct stat stat_of(const std::string& path) {
+    struct stat st {};
+    REQUIRE(stat(path.c_str(), &st) == 0);
+    return st;
+}
+
+} // namespace
+
+TEST(resume_point_round_trips) {
+    TempDir dir;
+    const std::string state = dir.file("model.Q4_0.gguf.part.state");
+    const std::string key = "size=100 mtime=1 ino=2 target=2 tensors=10";
+
+    CHECK(read_resume_point(state, key) == 0);
+    REQUIRE(write_resume_point(state, key, 7));
+    CHECK(read_resume_point(state, key) == 7);
+    REQUIRE(write_resume_point(state, key, 10));
+    CHECK(read_resume_point(state, key) == 10);
+    CHECK(access((state + ".tmp").c_str(), F_OK) != 0);
+}
+
+TEST(resume_point_of_another_job_is_ignored) {
+    TempDir dir;
+    const std::string state = dir.file("state");
+    REQUIRE(write_resume_point(state, "size=100 mtime=1 ino=2 target=2 tensors=10", 5));
+    CHECK(read_resume_point(state, "size=100 mtime=1 ino=2 target=2 tensors=11") == 0);
+    CHECK(read_resume_point(state, "size=100 mtime=1 ino=2 target=2") == 0);
+
+    write_text(state, "size=100 mtime=1 ino=2 target=2 tensors=10\n");
+    CHECK(read_resume_point(state, "size=100 mtime=1 ino=2 target=2 tensors=10") == 0);
+    write_text(state, "garbage");
+    CHECK(read_resume_point(state, "garbage") == 0);
+}
+
+TEST(resume_key_follows_the_input) {
+    TempDir dir;
+    const std::string input = dir.file("model.gguf");
+    write_text(input, "weights");
+    const struct stat before = stat_of(input);
+
+    const std::string key = requantize_resume_key(before, 2, 10);
+    CHECK(key == requantize_resume_key(stat_of(input), 2, 10));
+    CHECK(key != requantize_resume_key(before, 8, 10));
+    CHECK(key != requantize_resume_key(before, 2, 11));
+
+    // A re-downloaded file of another size must not resume the old output
+    write_text(input, "other weights");
+    CHECK(key != requantize_resume_key(stat_of(input), 2, 10));
+}
+
+TEST(cancelled_job_resumes_at_the_interrupted_step) {
+    TempDir dir;
+    const std::string state = dir.file("state");
+    const std::string key = "job";
+    std::atomic<bool> cancel{false};
+    std::vector<size_t> ran;
+    auto step = [&](size_t i) {
+        ran.push_back(i);
+        if (i == 3 && ran.size() == 4) cancel = true;   // Cancelled during the first run of step 3
+        return !cancel;
+    };
+
+    CHECK(run_resumable_steps(state, key, read_resume_point(state, key), 6, cancel, step) == REQUANT_CANCELLED);
+    CHECK((ran == std::vector<size_t>{0, 1, 2, 3}));
+    CHECK(read_resume_point(state, key) == 3);
+
+    cancel = false;
+    ran.clear();
+    CHECK(run_resumable_steps(state, key, read_resume_point(state, key), 6, cancel, step) == REQUANT_DONE);
+    CHECK((ran == std::vector<size_t>{3, 4, 5}));
+    CHECK(read_resume_point(state, key) == 6);
+
+    // A finished job has nothing left to run
+    ran.clear();
+    CHECK(run_resumable_steps(state, key, read_resume_point(state, key), 6, cancel, step) == REQUANT_DONE);
+    CHECK(ran.empty());
+}
+
+TEST(failed_step_keeps_the_last_resume_point) {
+    TempDir dir;
+    const std::string state = dir.file("state");
+    std::atomic<bool> cancel{false};
+    auto step = [](size_t i) { return i != 2; };
+
+    CHECK(run_resumable_steps(state, "job", 0, 5, cancel, step) == REQUANT_FAILED);
+    CHECK(read_resume_point(state, "job") == 2);
+}
+
+TEST(unwritable_resume_point_fails_the_job) {
+    std::atomic<bool> cancel{false};
+    int steps = 0;
+    auto step = [&](size_t) { steps++; return true; };
+
+    CHECK(run_resumable_steps("/nonexistent/dir/state", "job", 0, 5, cancel, step) == REQUANT_FAILED);
+    CHECK(steps == 1);
+}
+
+TEST(requantize_without_llama_fails_cleanly) {
+    TempDir dir;
+    const std::string input = dir.file("model.gguf");
+    write_text(input, "weights");
+    CHECK(requantize_model(input, dir.file("model.Q4_0.gguf"), REQUANT_TYPE_Q4_0) == REQUANT_FAILED);
+    RequantizeProgress progress = requantize_progress();
+    CHECK(progress.state == REQUANT_FAILED);
+    CHECK(progress.target_type == REQUANT_TYPE_Q4_0);
+}
+
+TEST_MAIN()
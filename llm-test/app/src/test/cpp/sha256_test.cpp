@@ -0,0 +1,166 @@
+/**
+ * Jeeves LLM Test Project - SHA-256 kernel and file hash host tests
+ *
+ * Every kernel the CPU supports is checked against the NIST vectors; kernels
+ * the CPU or build lacks are reported as skipped.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "device_probe.h"
+#include "sha256.h"
+#include "test_support.h"
+
+namespace {
+
+struct Vector {
+    std::string message;
+    const char* digest;
+};
+
+const std::vector<Vector>& nist_vectors() {
+    static const std::vector<Vector> vectors = {
+        {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+        {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+        // 448 bits: the padding no longer fits, so the digest takes two blocks
+        {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+         "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+        {"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+         "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"},
+        {std::string(1000000, 'a'), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+    };
+    return vectors;
+}
+
+// 18 read-ahead chunks (4 MB) and a partial one: more than the reader window
+constexpr size_t PATTERN_BYTES = 18 * (4u << 20) + 12345;
+constexpr const char* PATTERN_DIGEST = "1097547546cb135fd0211b8431b46f21ea050a181ccd25c713f2daa5f1b340d7";
+
+std::string pattern(size_t size) {
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; i++) data[i] = static_cast<char>((i * 31 + 7) & 0xff);
+    return data;
+}
+
+std::string digest(Sha256Blocks kernel, const std::string& message) {
+    Sha256 sha(kernel);
+    sha.update(message.data(), message.size());
+    return sha.finish();
+}
+
+/** Feed [message] in uneven pieces so every buffering path runs. */
+std::string digest_in_pieces(Sha256Blocks kernel, const std::string& message) {
+    static const size_t PIECES[] = {1, 63, 64, 65, 7, 128, 200};
+    Sha256 sha(kernel);
+    size_t off = 0;
+    for (size_t i = 0; off < message.size(); i++) {
+        size_t n = std::min(PIECES[i % 7], message.size() - off);
+        sha.update(message.data() + off, n);
+        off += n;
+    }
+    return sha.finish();
+}
+
+void check_kernel(const char* name, Sha256Blocks kernel) {
+    if (!kernel) {
+        std::printf("  %s kernel not available on this CPU or build, skipped\n", name);
+        return;
+    }
+    for (const Vector& v : nist_vectors()) {
+        CHECK(digest(kernel, v.message) == v.digest);
+        CHECK(digest_in_pieces(kernel, v.message) == v.digest);
+    }
+    CHECK(digest(kernel, pattern(PATTERN_BYTES)) == PATTERN_DIGEST);
+}
+
+/** [kernel] if the CPU has the SHA2 instructions, else null. */
+Sha256Blocks supported(Sha256Blocks kernel) {
+    return (detect_cpu_features() & CPU_FEATURE_SHA2) ? kernel : nullptr;
+}
+
+class TempFile {
+public:
+    explicit TempFile(const std::string& contents) {
+        const char* dir = getenv("TMPDIR");
+        path_ = std::string(dir && *dir ? dir : "/tmp") + "/sha256_test_XXXXXX";
+        int fd = mkstemp(&path_[0]);
+        REQUIRE(fd >= 0);
+        size_t written = 0;
+        while (written < contents.size()) {
+            ssize_t n = write(fd, contents.data() + written, contents.size() - written);
+            REQUIRE(n > 0);
+            written += static_cast<size_t>(n);
+        }
+        close(fd);
+    }
+    ~TempFile() { unlink(path_.c_str()); }
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+} // namespace
+
+TEST(portable_kernel_matches_nist_vectors) {
+    check_kernel("portable", sha256_blocks_portable);
+}
+
+TEST(armv8_kernel_matches_nist_vectors) {
+    check_kernel("ARMv8", supported(sha256_blocks_armv8()));
+}
+
+TEST(shani_kernel_matches_nist_vectors) {
+    check_kernel("SHA-NI", supported(sha256_blocks_shani()));
+}
+
+TEST(selected_kernel_matches_cpu_features) {
+    int kernel = -1;
+    Sha256Blocks blocks = select_sha256_kernel(0, &kernel);
+    CHECK(kernel == SHA256_KERNEL_PORTABLE);
+    CHECK(blocks == sha256_blocks_portable);
+
+    blocks = select_sha256_kernel(detect_cpu_features(), &kernel);
+    REQUIRE(blocks);
+    CHECK(digest(blocks, "abc") == nist_vectors()[1].digest);
+}
+
+TEST(file_hash_matches_in_memory_digest) {
+    for (const Vector& v : nist_vectors()) {
+        TempFile file(v.message);
+        std::string hex;
+        CHECK(sha256_file(file.path(), hex, 1) == HASH_DONE);
+        CHECK(hex == v.digest);
+    }
+}
+
+TEST(file_hash_read_ahead_spans_many_chunks) {
+    TempFile file(pattern(PATTERN_BYTES));
+    for (int readers : {1, 3}) {
+        std::string hex;
+        CHECK(sha256_file(file.path(), hex, readers) == HASH_DONE);
+        CHECK(hex == PATTERN_DIGEST);
+
+        FileHashProgress progress = file_hash_progress();
+        CHECK(progress.state == HASH_DONE);
+        CHECK(progress.bytes_done == static_cast<long long>(PATTERN_BYTES));
+        CHECK(progress.bytes_total == static_cast<long long>(PATTERN_BYTES));
+        CHECK(progress.readers == readers);
+    }
+}
+
+TEST(missing_file_fails) {
+    std::string hex = "unchanged";
+    CHECK(sha256_file("/nonexistent/sha256_test", hex) == HASH_FAILED);
+    CHECK(hex == "unchanged");
+    CHECK(file_hash_progress().state == HASH_FAILED);
+}
+
+TEST_MAIN()
@@ -0,0 +1,135 @@
+/**
+ * Jeeves LLM Test Project - Minimal host test harness
+ *
+ * TEST(name) registers a case; CHECK records a failure and continues,
+ * REQUIRE stops the case. TEST_MAIN() runs every case and returns non-zero
+ * if any failed, which is what ctest looks at. TempDir gives a case its
+ * own scratch directory.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace test_support {
+
+struct Case {
+    const char* name;
+    std::function<void()> run;
+};
+
+inline std::vector<Case>& cases() {
+    static std::vector<Case> all;
+    return all;
+}
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+struct Registrar {
+    Registrar(const char* name, std::function<void()> run) { cases().push_back({name, std::move(run)}); }
+};
+
+struct Abort {};
+
+inline int run_all() {
+    int failed_cases = 0;
+    for (const Case& c : cases()) {
+        const int before = failures();
+        try {
+            c.run();
+        } catch (const Abort&) {
+        }
+        const bool ok = failures() == before;
+        if (!ok) failed_cases++;
+        std::printf("[%s] %s\n", ok ? "PASS" : "FAIL", c.name);
+    }
+    std::printf("%zu cases, %d failed\n", cases().size(), failed_cases);
+    return failed_cases == 0 ? 0 : 1;
+}
+
+} // namespace test_support
+
+#define TEST(name)                                                              \
+    static void name();                                                         \
+    static test_support::Registrar name##_registrar(#name, name);              \
+    static void name()
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            test_support::failures()++;                                         \
+        }                                                                       \
+    } while (0)
+
+#define REQUIRE(cond)                                                           \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            std::printf("%s:%d: REQUIRE(%s) failed\n", __FILE__, __LINE__, #cond); \
+            test_support::failures()++;                                         \
+            throw test_support::Abort();                                        \
+        }                                                                       \
+    } while (0)
+
+#define TEST_MAIN() \
+    int main() { return test_support::run_all(); }
+
+namespace test_support {
+
+/** Fresh directory under $TMPDIR, removed with the files the test names. */
+class TempDir {
+public:
+    TempDir() {
+        const char* dir = getenv("TMPDIR");
+        path_ = std::string(dir && *dir ? dir : "/tmp") + "/native_test_XXXXXX";
+        REQUIRE(mkdtemp(&path_[0]) != nullptr);
+    }
+    ~TempDir() {
+        for (const std::string& file : files_) unlink(file.c_str());
+        for (auto it = dirs_.rbegin(); it != dirs_.rend(); ++it) rmdir(it->c_str());
+        rmdir(path_.c_str());
+    }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    const std::string& path() const { return path_; }
+
+    /** Path of [name] in the directory; it and its .tmp sibling are removed with it. */
+    std::string file(const std::string& name) {
+        files_.push_back(path_ + "/" + name);
+        files_.push_back(files_.back() + ".tmp");
+        return files_[files_.size() - 2];
+    }
+
+    /** file([name]) holding [content]; subdirectories in [name] are created. */
+    std::string write(const std::string& name, const std::string& content) {
+        for (size_t slash = name.find('/'); slash != std::string::npos; slash = name.find('/', slash + 1)) {
+            const std::string dir = path_ + "/" + name.substr(0, slash);
+            if (mkdir(dir.c_str(), 0700) == 0) dirs_.push_back(dir);
+        }
+        const std::string path = file(name);
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << content;
+        return path;
+    }
+
+private:
+    std::string path_;
+    std::vector<std::string> files_;
+    std::vector<std::string> dirs_;
+};
+
+} // namespace test_support
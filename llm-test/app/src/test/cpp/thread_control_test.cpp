@@ -0,0 +1,178 @@
+/**
+ * Jeeves LLM Test Project - Adaptive thread control host tests
+ */
+
+#include <string>
+#include <vector>
+
+#include "test_support.h"
+#include "thread_control.h"
+
+namespace {
+
+using test_support::TempDir;
+
+void write_zone(TempDir& dir, int zone, const std::string& type, const std::string& temp) {
+    const std::string name = "thermal_zone" + std::to_string(zone);
+    dir.write(name + "/type", type + "\n");
+    if (!temp.empty()) dir.write(name + "/temp", temp + "\n");
+}
+
+AdaptiveThreadConfig config(int window_tokens = 1) {
+    AdaptiveThreadConfig c;
+    c.enabled = true;
+    c.window_tokens = window_tokens;
+    c.thermal_root = "/nonexistent";
+    return c;
+}
+
+/** Feeds [decode_ms] per token; returns the tokens on_token() reported a thread change for. */
+std::vector<int> feed(AdaptiveThreadController& controller, const std::vector<double>& decode_ms) {
+    std::vector<int> changed;
+    for (size_t i = 0; i < decode_ms.size(); i++) {
+        if (controller.on_token(decode_ms[i])) changed.push_back(static_cast<int>(i) + 1);
+    }
+    return changed;
+}
+
+bool decision_is(const ThrottleDecision& d, int token, int action, int reason, int threads, long long pause_ms) {
+    return d.token == token && d.action == action && d.reason == reason && d.threads == threads
+        && d.pause_ms == pause_ms;
+}
+
+} // namespace
+
+TEST(hottest_soc_zone_is_reported) {
+    TempDir dir;
+    write_zone(dir, 0, "cpu-0-0", "65000");
+    write_zone(dir, 1, "battery", "90000");
+    // Whole degrees from some drivers
+    write_zone(dir, 2, "skin-therm", "70");
+    write_zone(dir, 3, "gpu", "");
+    write_zone(dir, 4, "modem", "-273000");
+    dir.write("cooling_device0/type", "thermal-cpufreq-0\n");
+
+    CHECK(read_max_thermal_mc(dir.path()) == 70000);
+    CHECK(read_max_thermal_mc(dir.path() + "/absent") == -1);
+}
+
+TEST(slowdown_steps_threads_down_then_pauses) {
+    AdaptiveThreadConfig c = config(2);
+    c.min_threads = 3;
+    AdaptiveThreadController controller(c, 4);
+
+    // Best window at 4 threads is 10 ms; 20 ms is a slowdown
+    CHECK(feed(controller, {10, 10, 20, 20}) == std::vector<int>({4}));
+    CHECK(controller.threads() == 3);
+    // Best at 3 threads is 10 ms; at the minimum the next slowdown pauses instead
+    CHECK(feed(controller, {10, 10, 20, 20}).empty());
+    CHECK(controller.threads() == 3);
+    CHECK(controller.pause_ms() == 6);
+    CHECK(controller.total_pause_ms() == 6);
+
+    const std::vector<ThrottleDecision>& d = controller.decisions();
+    REQUIRE(d.size() == 2);
+    CHECK(decision_is(d[0], 4, THROTTLE_THREADS_DOWN, THROTTLE_REASON_SLOWDOWN, 3, 0));
+    CHECK(d[0].window_us_per_token == 20000);
+    CHECK(d[0].temp_mc == -1);
+    CHECK(decision_is(d[1], 8, THROTTLE_PAUSE_UP, THROTTLE_REASON_SLOWDOWN, 3, 6));
+}
+
+TEST(pause_doubles_up_to_the_limit) {
+    AdaptiveThreadConfig c = config();
+    c.min_threads = 1;
+    c.max_pause_ms = 20;
+    AdaptiveThreadController controller(c, 1);
+
+    feed(controller, {10, 20, 20, 20, 20});
+    std::vector<long long> pauses;
+    for (const ThrottleDecision& d : controller.decisions()) pauses.push_back(d.pause_ms);
+    CHECK(pauses == std::vector<long long>({6, 12, 20}));
+    CHECK(controller.pause_ms() == 20);
+}
+
+TEST(thermal_limit_steps_down_and_recovers_below_hysteresis) {
+    TempDir dir;
+    write_zone(dir, 0, "cpu-1-0", "61000");
+    AdaptiveThreadConfig c = config();
+    c.max_temp_c = 60.0f;
+    c.thermal_root = dir.path();
+    AdaptiveThreadController controller(c, 4);
+
+    feed(controller, {10});
+    CHECK(controller.threads() == 3);
+    CHECK(controller.last_temp_mc() == 61000);
+
+    // Under the limit but within the 3 C hysteresis: hold
+    write_zone(dir, 0, "cpu-1-0", "58000");
+    feed(controller, {10});
+    CHECK(controller.threads() == 3);
+
+    write_zone(dir, 0, "cpu-1-0", "56000");
+    feed(controller, {10});
+    CHECK(controller.threads() == 4);
+
+    const std::vector<ThrottleDecision>& d = controller.decisions();
+    REQUIRE(d.size() == 2);
+    CHECK(decision_is(d[0], 1, THROTTLE_THREADS_DOWN, THROTTLE_REASON_THERMAL, 3, 0));
+    CHECK(d[0].temp_mc == 61000);
+    CHECK(decision_is(d[1], 3, THROTTLE_THREADS_UP, THROTTLE_REASON_RECOVERED, 4, 0));
+}
+
+TEST(unreadable_zones_never_step_back_up) {
+    AdaptiveThreadConfig c = config();
+    c.max_temp_c = 60.0f;
+    AdaptiveThreadController controller(c, 4);
+    feed(controller, {10, 10, 10});
+    CHECK(controller.decisions().empty());
+    CHECK(controller.last_temp_mc() == -1);
+}
+
+TEST(target_rate_trades_threads_and_pauses) {
+    AdaptiveThreadConfig c = config();
+    c.target_tokens_per_sec = 10.0f;
+    AdaptiveThreadController controller(c, 2);
+
+    // 11.1 tok/s: fewer threads, then a pause once at the minimum
+    // 8.2 tok/s: drop the pause, then add a thread back
+    CHECK(feed(controller, {90, 90, 112, 112}) == std::vector<int>({1, 4}));
+
+    const std::vector<ThrottleDecision>& d = controller.decisions();
+    REQUIRE(d.size() == 4);
+    CHECK(decision_is(d[0], 1, THROTTLE_THREADS_DOWN, THROTTLE_REASON_ABOVE_TARGET, 1, 0));
+    CHECK(decision_is(d[1], 2, THROTTLE_PAUSE_UP, THROTTLE_REASON_ABOVE_TARGET, 1, 10));
+    CHECK(decision_is(d[2], 3, THROTTLE_PAUSE_DOWN, THROTTLE_REASON_BELOW_TARGET, 1, 0));
+    CHECK(decision_is(d[3], 4, THROTTLE_THREADS_UP, THROTTLE_REASON_BELOW_TARGET, 2, 0));
+    CHECK(controller.total_pause_ms() == 10);
+}
+
+TEST(min_threads_is_capped_at_max) {
+    AdaptiveThreadConfig c = config();
+    c.min_threads = 8;
+    AdaptiveThreadController controller(c, 2);
+    feed(controller, {10, 20});
+    CHECK(controller.threads() == 2);
+    REQUIRE(controller.decisions().size() == 1);
+    CHECK(controller.decisions()[0].action == THROTTLE_PAUSE_UP);
+}
+
+TEST(report_array_is_header_then_seven_fields_per_decision) {
+    ThrottleReport report;
+    report.final_threads = 2;
+    report.total_pause_ms = 150;
+    report.last_temp_mc = 71000;
+    ThrottleDecision d;
+    d.token = 16;
+    d.action = THROTTLE_THREADS_DOWN;
+    d.reason = THROTTLE_REASON_SLOWDOWN;
+    d.threads = 3;
+    d.pause_ms = 0;
+    d.window_us_per_token = 180000;
+    d.temp_mc = 68000;
+    report.decisions.push_back(d);
+
+    const std::vector<long long> expected = {1, 2, 150, 71000, 16, 1, 2, 3, 0, 180000, 68000};
+    CHECK(report.to_array() == expected);
+}
+
+TEST_MAIN()
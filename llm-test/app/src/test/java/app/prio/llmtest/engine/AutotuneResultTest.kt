@@ -0,0 +1,54 @@
+package app.prio.llmtest.engine
+
+import app.prio.llmtest.engine.LlamaEngine.AutotuneResult
+import app.prio.llmtest.engine.LlamaEngine.AutotuneSpec
+import app.prio.llmtest.engine.LlamaEngine.AutotuneTrial
+import app.prio.llmtest.engine.LlamaEngine.KvCacheType
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for autotune specs and results parsed from native arrays.
+ */
+class AutotuneResultTest {
+
+    @Test
+    fun `default spec derives candidates natively`() {
+        val spec = AutotuneSpec()
+        assertNull(spec.validate())
+        assertTrue(spec.threads.isEmpty())
+        assertEquals(LlamaEngine.DEFAULT_AUTOTUNE_PROMPT_TOKENS, spec.promptTokens)
+    }
+
+    @Test
+    fun `invalid candidates are rejected`() {
+        assertNotNull(AutotuneSpec(genTokens = 0).validate())
+        assertNotNull(AutotuneSpec(threads = listOf(0, 4)).validate())
+        assertNotNull(AutotuneSpec(batchSizes = listOf(256 to 512)).validate())
+        assertNull(AutotuneSpec(batchSizes = listOf(512 to 256)).validate())
+    }
+
+    @Test
+    fun `result parses best and trials`() {
+        val values = longArrayOf(
+            2, 1,
+            4, 6, 512, 256, 8, 8, 4250, 1130,
+            1, 4, 4, 512, 512, 1, 1, 3900, 1120,
+            4, 4, 6, 512, 256, 8, 8, 4250, 1130
+        )
+        val result = AutotuneResult.fromArray(values)
+
+        assertTrue(result.saved)
+        assertEquals(4, result.best.threads)
+        assertEquals(6, result.best.threadsBatch)
+        assertEquals(256, result.best.ubatchSize)
+        assertEquals(KvCacheType.Q8_0, result.best.kvCacheTypeV)
+        assertEquals(42.5, result.best.promptTokensPerSec, 0.001)
+        assertEquals(11.3, result.best.generationTokensPerSec, 0.001)
+
+        assertEquals(2, result.trials.size)
+        assertEquals(AutotuneTrial.Phase.THREADS, result.trials[0].phase)
+        assertEquals(KvCacheType.F16, result.trials[0].config.kvCacheTypeK)
+        assertEquals(AutotuneTrial.Phase.KV_CACHE, result.trials[1].phase)
+    }
+}
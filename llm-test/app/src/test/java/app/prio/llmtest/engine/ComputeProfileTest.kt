@@ -0,0 +1,58 @@
+package app.prio.llmtest.engine
+
+import app.prio.llmtest.engine.LlamaEngine.ComputeProfile
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for parsing native compute profiler reports.
+ */
+class ComputeProfileTest {
+
+    private val report = listOf(
+        "MUL_MAT\tq4_K\t3072x1\t0\t32\t9600\t410",
+        "MUL_MAT\tq4_K\t3072x1\t1\t32\t9400\t380",
+        "MUL_MAT\tq6_K\t32064x1\t-1\t32\t7000\t260",
+        "SOFT_MAX\tf32\t37x1x32\t0\t32\t500\t30",
+        "SAMPLE\t\t\t-1\t32\t1200\t90"
+    ).joinToString("\n", postfix = "\n")
+
+    @Test
+    fun `parse maps report columns`() {
+        val profile = ComputeProfile.parse(report)
+        assertEquals(5, profile.entries.size)
+        val first = profile.entries[0]
+        assertEquals("MUL_MAT", first.op)
+        assertEquals("q4_K", first.type)
+        assertEquals("3072x1", first.shape)
+        assertEquals(0, first.layer)
+        assertEquals(32L, first.count)
+        assertEquals(9600L, first.totalUs)
+        assertEquals(410L, first.maxUs)
+        assertEquals("", profile.entries[4].shape)
+        assertEquals(27_700L, profile.totalUs)
+    }
+
+    @Test
+    fun `byOp groups by op and weight type`() {
+        val byOp = ComputeProfile.parse(report).byOp()
+        assertEquals(
+            listOf("MUL_MAT q4_K" to 19_000L, "MUL_MAT q6_K" to 7_000L, "SAMPLE" to 1_200L, "SOFT_MAX f32" to 500L),
+            byOp
+        )
+    }
+
+    @Test
+    fun `byLayer sums in layer order`() {
+        val byLayer = ComputeProfile.parse(report).byLayer()
+        assertEquals(listOf(-1 to 8_200L, 0 to 10_100L, 1 to 9_400L), byLayer)
+    }
+
+    @Test
+    fun `malformed lines are skipped`() {
+        val profile = ComputeProfile.parse("garbage\n\nMUL_MAT\tf16\t64x1\t2\t1\t5\t5\n")
+        assertEquals(1, profile.entries.size)
+        assertEquals(2, profile.entries[0].layer)
+        assertTrue(ComputeProfile.parse("").entries.isEmpty())
+    }
+}
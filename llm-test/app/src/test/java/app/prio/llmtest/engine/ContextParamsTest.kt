@@ -0,0 +1,70 @@
+package app.prio.llmtest.engine
+
+import app.prio.llmtest.engine.LlamaEngine.ContextParams
+import app.prio.llmtest.engine.LlamaEngine.FlashAttention
+import app.prio.llmtest.engine.LlamaEngine.KvCacheType
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for LlamaEngine.ContextParams validation.
+ */
+class ContextParamsTest {
+    
+    @Test
+    fun `defaults are valid`() {
+        assertNull(ContextParams().validate(contextSize = 2048, threads = 4))
+    }
+    
+    @Test
+    fun `quantized KV with flash attention is valid`() {
+        val params = ContextParams(
+            kvCacheTypeK = KvCacheType.Q8_0,
+            kvCacheTypeV = KvCacheType.Q8_0,
+            flashAttention = FlashAttention.ENABLED
+        )
+        assertNull(params.validate(contextSize = 2048, threads = 4))
+    }
+    
+    @Test
+    fun `quantized V cache without flash attention is rejected`() {
+        val params = ContextParams(kvCacheTypeV = KvCacheType.Q4_0, flashAttention = FlashAttention.DISABLED)
+        assertNotNull(params.validate(contextSize = 2048, threads = 4))
+    }
+    
+    @Test
+    fun `quantized K cache alone does not need flash attention`() {
+        val params = ContextParams(kvCacheTypeK = KvCacheType.Q4_0, flashAttention = FlashAttention.DISABLED)
+        assertNull(params.validate(contextSize = 2048, threads = 4))
+    }
+    
+    @Test
+    fun `ubatch larger than batch is rejected`() {
+        val params = ContextParams(batchSize = 256, ubatchSize = 512)
+        assertNotNull(params.validate(contextSize = 2048, threads = 4))
+    }
+    
+    @Test
+    fun `out of range sequences and threads are rejected`() {
+        assertNotNull(ContextParams(maxSequences = 0).validate(contextSize = 2048, threads = 4))
+        assertNotNull(ContextParams(maxSequences = 65).validate(contextSize = 2048, threads = 4))
+        assertNotNull(ContextParams().validate(contextSize = 2048, threads = 0))
+        assertNotNull(ContextParams().validate(contextSize = 16, threads = 4))
+    }
+    
+    @Test
+    fun `unset fields are left to the tuned configuration`() {
+        assertNull(ContextParams().validate(contextSize = 2048, threads = null))
+        assertNull(ContextParams(ubatchSize = 1024).validate(contextSize = 2048, threads = null))
+        assertNull(ContextParams(kvCacheTypeK = null, flashAttention = FlashAttention.DISABLED)
+            .validate(contextSize = 2048, threads = null))
+        assertNotNull(ContextParams(batchSize = 0).validate(contextSize = 2048, threads = null))
+    }
+    
+    @Test
+    fun `ggml type ids match native enum`() {
+        assertEquals(1, KvCacheType.F16.ggmlType)
+        assertEquals(8, KvCacheType.Q8_0.ggmlType)
+        assertEquals(2, KvCacheType.Q4_0.ggmlType)
+    }
+}
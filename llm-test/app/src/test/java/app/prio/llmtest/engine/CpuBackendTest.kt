@@ -0,0 +1,31 @@
+package app.prio.llmtest.engine
+
+import app.prio.llmtest.engine.LlamaEngine.CpuBackend
+import app.prio.llmtest.engine.LlamaEngine.CpuVariant
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Contract tests for the CPU backend report array; variant selection is
+ * tested in src/test/cpp/cpu_backend_test.cpp.
+ */
+class CpuBackendTest {
+
+    @Test
+    fun `report parses variant and features`() {
+        val backend = CpuBackend.fromArray(longArrayOf(4, 7, 7, 1, 12))
+        assertEquals(CpuVariant.I8MM, backend.variant)
+        assertEquals(7, backend.cpuFeatures)
+        assertEquals(7, backend.variantFeatures)
+        assertEquals(1, backend.fallbacks)
+        assertEquals(12L, backend.loadTimeMs)
+    }
+
+    @Test
+    fun `variant ordinals match native values`() {
+        assertEquals(CpuVariant.STATIC, CpuBackend.fromArray(longArrayOf(1)).variant)
+        assertEquals(CpuVariant.SVE, CpuBackend.fromArray(longArrayOf(5)).variant)
+        assertEquals(CpuVariant.X86_64, CpuBackend.fromArray(longArrayOf(6)).variant)
+        assertEquals(CpuVariant.AVX512, CpuBackend.fromArray(longArrayOf(8)).variant)
+    }
+}
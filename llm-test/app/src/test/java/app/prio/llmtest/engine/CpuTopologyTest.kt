@@ -0,0 +1,59 @@
+package app.prio.llmtest.engine
+
+import app.prio.llmtest.engine.LlamaEngine.CpuPolicy
+import app.prio.llmtest.engine.LlamaEngine.CpuTopology
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for the CPU topology array layout and policy core selection;
+ * sysfs detection is tested in src/test/cpp/cpu_topology_test.cpp.
+ */
+class CpuTopologyTest {
+
+    // Tensor G4 layout: 1x X4, 3x A720, 4x A520
+    private val tensorG4 = CpuTopology.fromArray(
+        longArrayOf(
+            8, 3,
+            0, 2, 255, 1950000,
+            1, 2, 255, 1950000,
+            2, 2, 255, 1950000,
+            3, 2, 255, 1950000,
+            4, 1, 861, 2600000,
+            5, 1, 861, 2600000,
+            6, 1, 861, 2600000,
+            7, 0, 1024, 3100000
+        )
+    )
+
+    @Test
+    fun `fromArray parses cores and clusters`() {
+        assertEquals(8, tensorG4.cores.size)
+        assertEquals(3, tensorG4.clusterCount)
+        assertEquals(CpuTopology.Core(7, 0, 1024, 3100000), tensorG4.cores[7])
+    }
+
+    @Test
+    fun `performance policy excludes the slowest cluster`() {
+        assertEquals(listOf(4, 5, 6, 7), tensorG4.cpusFor(CpuPolicy.PERFORMANCE))
+        assertEquals(4, tensorG4.recommendedThreads(CpuPolicy.PERFORMANCE))
+    }
+
+    @Test
+    fun `efficiency policy uses the slowest cluster`() {
+        assertEquals(listOf(0, 1, 2, 3), tensorG4.cpusFor(CpuPolicy.EFFICIENCY))
+    }
+
+    @Test
+    fun `all policy does not pin`() {
+        assertTrue(tensorG4.cpusFor(CpuPolicy.ALL).isEmpty())
+        assertEquals(8, tensorG4.recommendedThreads(CpuPolicy.ALL))
+    }
+
+    @Test
+    fun `single cluster never pins`() {
+        val uniform = CpuTopology.fromArray(longArrayOf(2, 1, 0, 0, 0, 2000000, 1, 0, 0, 2000000))
+        assertTrue(uniform.cpusFor(CpuPolicy.PERFORMANCE).isEmpty())
+        assertEquals(2, uniform.recommendedThreads(CpuPolicy.PERFORMANCE))
+    }
+}
@@ -0,0 +1,46 @@
+package app.prio.llmtest.engine
+
+import app.prio.llmtest.engine.LlamaEngine.GenerationStats
+import app.prio.llmtest.engine.LlamaEngine.StopReason
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for decoding per-request generation stats.
+ */
+class GenerationStatsTest {
+
+    private val sample = longArrayOf(
+        2, 120, 100, 64,            // stop reason, prompt/cached/generated tokens
+        800, 40_000, 95_000,        // tokenize, prompt eval, first token
+        3_200_000, 3_300_000,       // generation, total
+        30_000, 48_000, 61_000, 90_000,
+        4096, 12, 1_850
+    )
+
+    @Test
+    fun `fromArray maps native indices`() {
+        val stats = GenerationStats.fromArray(sample)
+        assertEquals(StopReason.MAX_TOKENS, stats.stopReason)
+        assertEquals(120, stats.promptTokens)
+        assertEquals(100, stats.cachedPromptTokens)
+        assertEquals(64, stats.generatedTokens)
+        assertEquals(800L, stats.tokenizeUs)
+        assertEquals(40_000L, stats.promptEvalUs)
+        assertEquals(95_000L, stats.timeToFirstTokenUs)
+        assertEquals(3_200_000L, stats.generationUs)
+        assertEquals(3_300_000L, stats.totalUs)
+        assertEquals(48_000L, stats.tokenP50Us)
+        assertEquals(90_000L, stats.tokenMaxUs)
+        assertEquals(4096, stats.contextSize)
+        assertEquals(12L, stats.contextResizeMs)
+        assertEquals(1_850L, stats.profiledNodes)
+    }
+
+    @Test
+    fun `tokensPerSecond excludes prompt evaluation`() {
+        val stats = GenerationStats.fromArray(sample)
+        assertEquals(20.0, stats.tokensPerSecond, 1e-9)
+        assertEquals(500.0, stats.promptTokensPerSecond, 1e-9)
+    }
+}
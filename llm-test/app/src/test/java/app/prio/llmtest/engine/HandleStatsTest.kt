@@ -0,0 +1,22 @@
+package app.prio.llmtest.engine
+
+import app.prio.llmtest.engine.LlamaEngine.HandleStats
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Contract test for the handle table counters array; the table itself is
+ * tested in src/test/cpp/engine_handles_test.cpp.
+ */
+class HandleStatsTest {
+
+    @Test
+    fun `fromArray maps native indices`() {
+        val stats = HandleStats.fromArray(longArrayOf(2, 5, 3, 1, 120))
+        assertEquals(2, stats.live)
+        assertEquals(5L, stats.swaps)
+        assertEquals(3L, stats.staleLookups)
+        assertEquals(1L, stats.drained)
+        assertEquals(120L, stats.lastDrainMs)
+    }
+}
@@ -0,0 +1,30 @@
+package app.prio.llmtest.engine
+
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Contract test for the LlamaEngine.MemoryBreakdown array layout; the native
+ * accounting is tested in src/test/cpp/memory_stats_test.cpp.
+ */
+class MemoryBreakdownTest {
+    
+    @Test
+    fun `fromArray maps native indices in order`() {
+        val breakdown = LlamaEngine.MemoryBreakdown.fromArray(longArrayOf(100, 80, 30, 20, 500, 400, 250))
+        
+        assertEquals(100L, breakdown.weightsMappedBytes)
+        assertEquals(80L, breakdown.weightsResidentBytes)
+        assertEquals(30L, breakdown.kvCacheBytes)
+        assertEquals(20L, breakdown.computeBufferBytes)
+        assertEquals(500L, breakdown.processRssBytes)
+        assertEquals(400L, breakdown.processPssBytes)
+        assertEquals(250L, breakdown.processAnonymousBytes)
+    }
+    
+    @Test
+    fun `engineBytes counts resident weights not mapped size`() {
+        val breakdown = LlamaEngine.MemoryBreakdown.fromArray(longArrayOf(2_000, 500, 300, 100, 0, 0, 0))
+        assertEquals(900L, breakdown.engineBytes)
+    }
+}
@@ -0,0 +1,41 @@
+package app.prio.llmtest.engine
+
+import app.prio.llmtest.engine.LlamaEngine.LatencySummary
+import app.prio.llmtest.engine.LlamaEngine.PerformanceSnapshot
+import app.prio.llmtest.engine.LlamaEngine.Qos
+import app.prio.llmtest.engine.LlamaEngine.RequestMetrics
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for decoding native latency histogram snapshots.
+ */
+class PerformanceSnapshotTest {
+
+    /** One row where every histogram is [base]..[base]+7 and counters follow. */
+    private fun row(base: Long, counters: LongArray): LongArray =
+        LongArray(5 * LatencySummary.FIELDS) { base + it % LatencySummary.FIELDS } + counters
+
+    @Test
+    fun `fromArray maps rows and fields`() {
+        assertEquals(44, RequestMetrics.FIELDS)
+        val values = row(0, longArrayOf(10, 4, 1, 2)) +
+            row(100, longArrayOf(7, 3, 1, 0)) +
+            row(200, longArrayOf(3, 1, 0, 2))
+        val snapshot = PerformanceSnapshot.fromArray(values)
+
+        assertEquals(10L, snapshot.all.requests)
+        assertEquals(4L, snapshot.all.cacheHits)
+        assertEquals(1L, snapshot.all.cancelled)
+        assertEquals(2L, snapshot.all.failed)
+
+        val ttft = snapshot.interactive.timeToFirstTokenUs
+        assertEquals(100L, ttft.samples)
+        assertEquals(104L, ttft.p50)
+        assertEquals(106L, ttft.p95)
+        assertEquals(107L, ttft.p99)
+        assertEquals(203L, snapshot.background.endToEndUs.mean)
+        assertSame(snapshot.background, snapshot.forQos(Qos.BACKGROUND))
+        assertSame(snapshot.interactive, snapshot.forQos(Qos.INTERACTIVE))
+    }
+}
@@ -0,0 +1,26 @@
+package app.prio.llmtest.engine
+
+import app.prio.llmtest.engine.LlamaEngine.RepackCacheResult
+import app.prio.llmtest.engine.LlamaEngine.RepackCacheStats
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Contract test for the repack cache stats array layout; the cache itself is
+ * tested natively in src/test/cpp/repack_cache_test.cpp.
+ */
+class RepackCacheStatsTest {
+
+    @Test
+    fun `fromArray maps native indices`() {
+        val stats = RepackCacheStats.fromArray(longArrayOf(3, 1, 0, 2, 1, 128, 1_500_000_000, 40))
+        assertEquals(3L, stats.hits)
+        assertEquals(1L, stats.builds)
+        assertEquals(0L, stats.stale)
+        assertEquals(2L, stats.uncached)
+        assertEquals(RepackCacheResult.HIT, stats.lastResult)
+        assertEquals(128, stats.lastTensors)
+        assertEquals(1_500_000_000L, stats.lastBytes)
+        assertEquals(40L, stats.lastMs)
+    }
+}
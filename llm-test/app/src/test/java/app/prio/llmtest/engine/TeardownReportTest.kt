@@ -0,0 +1,41 @@
+package app.prio.llmtest.engine
+
+import app.prio.llmtest.engine.LlamaEngine.TeardownReport
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for the post-unload self-check report.
+ */
+class TeardownReportTest {
+
+    @Test
+    fun `fromArray maps native indices`() {
+        val report = TeardownReport.fromArray(longArrayOf(0, 2000, 1, 500, 100, 300, 0))
+        assertEquals(0L, report.modelMappedBytes)
+        assertEquals(2000L, report.registryBytes)
+        assertEquals(1, report.liveEngines)
+        assertEquals(500L, report.anonFreedBytes)
+        assertEquals(100L, report.heapTrimmedBytes)
+        assertEquals(300L, report.residualAnonBytes)
+        assertEquals(0, report.extraThreads)
+    }
+
+    @Test
+    fun `registry-held weights are not a leak`() {
+        val report = TeardownReport.fromArray(longArrayOf(0, 2_000_000_000, 0, 0, 0, 0, 0))
+        assertTrue(report.isClean)
+    }
+
+    @Test
+    fun `orphaned model mapping is a leak`() {
+        val report = TeardownReport.fromArray(longArrayOf(4096, 0, 0, 0, 0, 0, 0))
+        assertFalse(report.isClean)
+    }
+
+    @Test
+    fun `extra threads only count once every engine is gone`() {
+        assertTrue(TeardownReport.fromArray(longArrayOf(0, 0, 1, 0, 0, 0, 2)).isClean)
+        assertFalse(TeardownReport.fromArray(longArrayOf(0, 0, 0, 0, 0, 0, 2)).isClean)
+    }
+}
@@ -0,0 +1,58 @@
+package app.prio.llmtest.engine
+
+import app.prio.llmtest.engine.LlamaEngine.ThreadPoolConfig
+import app.prio.llmtest.engine.LlamaEngine.ThreadPoolStats
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for shared threadpool configuration and stats.
+ */
+class ThreadPoolConfigTest {
+
+    @Test
+    fun `defaults size pools automatically`() {
+        val config = ThreadPoolConfig()
+        assertNull(config.validate())
+        assertEquals(0, config.threads)
+        assertEquals(LlamaEngine.DEFAULT_THREADPOOL_POLL, config.poll)
+    }
+
+    @Test
+    fun `poll outside 0 to 100 is rejected`() {
+        assertNotNull(ThreadPoolConfig(poll = -1).validate())
+        assertNotNull(ThreadPoolConfig(poll = 101).validate())
+        assertNull(ThreadPoolConfig(poll = 0).validate())
+        assertNull(ThreadPoolConfig(poll = 100).validate())
+    }
+
+    @Test
+    fun `negative thread counts are rejected`() {
+        assertNotNull(ThreadPoolConfig(threads = -1).validate())
+        assertNotNull(ThreadPoolConfig(threadsBatch = -1).validate())
+    }
+
+    @Test
+    fun `stats parse native array`() {
+        val stats = ThreadPoolStats.fromArray(longArrayOf(4, 6, 50, 2, 100, 7, 35, 1, 4, 2, 20, 850, 1))
+        assertEquals(4, stats.threads)
+        assertEquals(6, stats.threadsBatch)
+        assertEquals(50, stats.poll)
+        assertEquals(2, stats.attachedContexts)
+        assertEquals(100L, stats.decodes)
+        assertEquals(7L, stats.contendedDecodes)
+        assertEquals(35L, stats.waitMs)
+        assertEquals(1, stats.cpuPolicy)
+        assertEquals(4, stats.pinnedCpus)
+        assertEquals(2, stats.backgroundThreads)
+        assertEquals(20L, stats.backgroundDecodes)
+        assertEquals(850L, stats.backgroundYieldMs)
+        assertTrue(stats.backgroundPaused)
+    }
+
+    @Test
+    fun `qos values match native`() {
+        assertEquals(0, LlamaEngine.Qos.INTERACTIVE.nativeValue)
+        assertEquals(1, LlamaEngine.Qos.BACKGROUND.nativeValue)
+    }
+}
@@ -0,0 +1,56 @@
+package app.prio.llmtest.engine
+
+import app.prio.llmtest.engine.LlamaEngine.AdaptiveThreads
+import app.prio.llmtest.engine.LlamaEngine.ThrottleDecision
+import app.prio.llmtest.engine.LlamaEngine.ThrottleReport
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for adaptive thread control config and report decoding; the
+ * controller itself is tested in src/test/cpp/thread_control_test.cpp.
+ */
+class ThrottleReportTest {
+
+    @Test
+    fun `fromArray parses header and decisions`() {
+        val report = ThrottleReport.fromArray(
+            longArrayOf(
+                2, 2, 150, 71000,
+                16, 1, 2, 3, 0, 180000, 68000,
+                32, 3, 1, 2, 50, 210000, 71000
+            )
+        )
+        assertEquals(2, report.finalThreads)
+        assertEquals(150L, report.totalPauseMs)
+        assertEquals(71000, report.lastTempMilliC)
+        assertEquals(2, report.decisions.size)
+
+        val first = report.decisions[0]
+        assertEquals(16, first.token)
+        assertEquals(ThrottleDecision.Action.THREADS_DOWN, first.action)
+        assertEquals(ThrottleDecision.Reason.SLOWDOWN, first.reason)
+        assertEquals(3, first.threads)
+
+        val second = report.decisions[1]
+        assertEquals(ThrottleDecision.Action.PAUSE_UP, second.action)
+        assertEquals(ThrottleDecision.Reason.THERMAL, second.reason)
+        assertEquals(50L, second.pauseMs)
+    }
+
+    @Test
+    fun `unknown action maps to NONE`() {
+        val report = ThrottleReport.fromArray(longArrayOf(1, 4, 0, -1, 8, 99, 99, 4, 0, 1000, -1))
+        assertEquals(ThrottleDecision.Action.NONE, report.decisions[0].action)
+        assertEquals(ThrottleDecision.Reason.NONE, report.decisions[0].reason)
+    }
+
+    @Test
+    fun `config validation`() {
+        assertNull(AdaptiveThreads().validate())
+        assertNull(AdaptiveThreads(targetTokensPerSec = 5f, maxTempC = 70f).validate())
+        assertNotNull(AdaptiveThreads(minThreads = 0).validate())
+        assertNotNull(AdaptiveThreads(windowTokens = 0).validate())
+        assertNotNull(AdaptiveThreads(targetTokensPerSec = -1f).validate())
+    }
+}
@@ -0,0 +1,46 @@
+package app.prio.llmtest.engine
+
+import app.prio.llmtest.engine.LlamaEngine.TrimLevel
+import app.prio.llmtest.engine.LlamaEngine.TrimResult
+import org.junit.Assert.*
+import org.junit.Test
+
+/**
+ * Unit tests for mapping onTrimMemory levels to engine trim levels.
+ */
+class TrimLevelTest {
+
+    @Test
+    fun `no trim below running moderate`() {
+        assertNull(TrimLevel.fromTrimMemory(0))
+    }
+
+    @Test
+    fun `running levels keep the context`() {
+        assertEquals(TrimLevel.DROP_PREFIX_CACHE, TrimLevel.fromTrimMemory(5))
+        assertEquals(TrimLevel.COMPRESS_KV, TrimLevel.fromTrimMemory(10))
+        assertEquals(TrimLevel.COMPRESS_KV, TrimLevel.fromTrimMemory(15))
+        assertEquals(TrimLevel.COMPRESS_KV, TrimLevel.fromTrimMemory(20))
+    }
+
+    @Test
+    fun `background levels release progressively more`() {
+        assertEquals(TrimLevel.RELEASE_CONTEXT, TrimLevel.fromTrimMemory(40))
+        assertEquals(TrimLevel.RELEASE_ALL, TrimLevel.fromTrimMemory(60))
+        assertEquals(TrimLevel.RELEASE_ALL, TrimLevel.fromTrimMemory(80))
+    }
+
+    @Test
+    fun `native values match memory_trim h`() {
+        assertEquals(listOf(1, 2, 3, 4), TrimLevel.values().map { it.nativeValue })
+    }
+
+    @Test
+    fun `result parses native array`() {
+        val result = TrimResult.fromArray(longArrayOf(3, 1000, 800, 120))
+        assertEquals(3, result.level)
+        assertEquals(1000L, result.bytesFreed)
+        assertEquals(800L, result.rssFreedBytes)
+        assertEquals(120L, result.restoreCostMs)
+    }
+}
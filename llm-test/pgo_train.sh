@@ -0,0 +1,51 @@
+#!/bin/bash
+# Train the PGO profile for the native library on a connected device.
+#
+# Builds llama_jni instrumented (-Pllama.pgo=generate), runs PgoTrainingTest
+# (classification + briefing workload), pulls the per-library .profraw files
+# and merges them into app/src/main/cpp/pgo/<abi>.profdata for
+# -Pllama.pgo=use builds.
+#
+# Requires the model in the app's files dir (see LlmInstrumentedTest) and
+# ANDROID_NDK_HOME pointing at the NDK the app builds with: .profraw files
+# must be merged by the llvm-profdata of the same clang.
+
+set -e
+
+ADB="${ADB:-adb}"
+PACKAGE="app.prio.llmtest"
+RUNNER="$PACKAGE.test/androidx.test.runner.AndroidJUnitRunner"
+PROFILE_DIR="files/pgo"
+OUT_DIR="app/src/main/cpp/pgo"
+
+cd "$(dirname "$0")"
+
+PROFDATA=$(ls "$ANDROID_NDK_HOME"/toolchains/llvm/prebuilt/*/bin/llvm-profdata 2>/dev/null | head -1)
+if [ -z "$PROFDATA" ]; then
+    echo "llvm-profdata not found; set ANDROID_NDK_HOME" >&2
+    exit 1
+fi
+ABI=$($ADB shell getprop ro.product.cpu.abi | tr -d '\r')
+
+echo "=== Building instrumented library ($ABI)"
+./gradlew :app:installDebug :app:installDebugAndroidTest -Pllama.pgo=generate
+
+echo "=== Running training workload"
+$ADB shell run-as $PACKAGE rm -rf $PROFILE_DIR
+$ADB shell am instrument -w -e class $PACKAGE.PgoTrainingTest $RUNNER
+
+echo "=== Pulling profiles"
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+for f in $($ADB shell run-as $PACKAGE ls $PROFILE_DIR | tr -d '\r'); do
+    $ADB exec-out run-as $PACKAGE cat "$PROFILE_DIR/$f" > "$TMP/$f"
+done
+if ! ls "$TMP"/*.profraw >/dev/null 2>&1; then
+    echo "No profiles written; check logcat for PgoTraining" >&2
+    exit 1
+fi
+
+mkdir -p "$OUT_DIR"
+"$PROFDATA" merge -o "$OUT_DIR/$ABI.profdata" "$TMP"/*.profraw
+echo "=== Wrote $OUT_DIR/$ABI.profdata"
+echo "Build with: ./gradlew :app:assembleRelease -Pllama.pgo=use"